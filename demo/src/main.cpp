@@ -1,8 +1,57 @@
 #include "Application.h"
 
-int main()
+#include <cstring>
+#include <cstdlib>
+
+// Usage: demo [--headless <frame count>] [--size <width> <height>] [--capture <directory>] [--depth-prepass] [--lights <count>] [--pipeline-statistics]
+//             [--present-mode fifo|mailbox|immediate] [--frames-in-flight <count>] [--swapchain-images <count>] [--max-fps <rate>]
+//             [--texture-streaming] [--texture-pack <manifest>]...
+int main(int argc, char** argv)
 {
-	sge::Application app;
+	sge::ApplicationSpec spec;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--headless") == 0 && i + 1 < argc)
+		{
+			spec.Vulkan.Headless = true;
+			spec.FrameCount = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		}
+		else if (strcmp(argv[i], "--size") == 0 && i + 2 < argc)
+		{
+			spec.Vulkan.Width = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+			spec.Vulkan.Height = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		}
+		else if (strcmp(argv[i], "--capture") == 0 && i + 1 < argc)
+			spec.CaptureDirectory = argv[++i];
+		else if (strcmp(argv[i], "--depth-prepass") == 0)
+			spec.Renderer.DepthPrepass = true;
+		else if (strcmp(argv[i], "--lights") == 0 && i + 1 < argc)
+			spec.LightCount = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		else if (strcmp(argv[i], "--pipeline-statistics") == 0)
+			spec.Vulkan.PipelineStatistics = true;
+		else if (strcmp(argv[i], "--present-mode") == 0 && i + 1 < argc)
+		{
+			const char* mode = argv[++i];
+			if (strcmp(mode, "fifo") == 0)
+				spec.Vulkan.PresentMode = VK_PRESENT_MODE_FIFO_KHR;
+			else if (strcmp(mode, "immediate") == 0)
+				spec.Vulkan.PresentMode = VK_PRESENT_MODE_IMMEDIATE_KHR;
+			else
+				spec.Vulkan.PresentMode = VK_PRESENT_MODE_MAILBOX_KHR;
+		}
+		else if (strcmp(argv[i], "--frames-in-flight") == 0 && i + 1 < argc)
+			spec.Vulkan.FramesInFlight = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		else if (strcmp(argv[i], "--swapchain-images") == 0 && i + 1 < argc)
+			spec.Vulkan.SwapchainImageCount = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		else if (strcmp(argv[i], "--max-fps") == 0 && i + 1 < argc)
+			spec.MaxFrameRate = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		else if (strcmp(argv[i], "--texture-streaming") == 0)
+			spec.Vulkan.TextureStreaming = true;
+		else if (strcmp(argv[i], "--texture-pack") == 0 && i + 1 < argc)
+			spec.TexturePacks.push_back(argv[++i]);
+	}
+
+	sge::Application app(spec);
 	int exitCode = app.Run();
 
 	return exitCode;
@@ -0,0 +1,2 @@
+:: First arg is Vulkan SDK directory, second arg is shaders directory, third arg is shader name
+%1/Bin/glslc.exe %2/%3.comp -o %2/%3.comp.spv
\ No newline at end of file
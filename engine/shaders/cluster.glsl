@@ -0,0 +1,34 @@
+// GLSL Header File
+
+// Cluster grid and limits, must match LightClusterer.h
+const uint CLUSTER_COUNT_X = 16;
+const uint CLUSTER_COUNT_Y = 9;
+const uint CLUSTER_COUNT_Z = 24;
+const uint CLUSTER_COUNT = CLUSTER_COUNT_X * CLUSTER_COUNT_Y * CLUSTER_COUNT_Z;
+const uint MAX_LIGHTS_PER_CLUSTER = 256;
+
+// Must match 'PointLightData' in LightClusterer.h
+struct PointLight
+{
+	vec3 Position;
+	// Distance at which the light's contribution reaches zero
+	float Radius;
+	vec3 Color;
+	float Intensity;
+};
+
+// Slices are spaced exponentially between the near and far plane, so clusters keep roughly the same shape at every depth
+float ClusterSliceDepth(uint slice, float zNear, float zFar)
+{
+	return zNear * pow(zFar / zNear, float(slice) / float(CLUSTER_COUNT_Z));
+}
+
+// 'viewDepth' is the distance along the view direction
+uint ClusterIndex(vec2 fragCoord, float viewDepth, vec2 screenSize, float zNear, float zFar)
+{
+	uvec2 tile = min(uvec2(fragCoord / screenSize * vec2(CLUSTER_COUNT_X, CLUSTER_COUNT_Y)), uvec2(CLUSTER_COUNT_X - 1, CLUSTER_COUNT_Y - 1));
+	float slice = log(max(viewDepth, zNear) / zNear) / log(zFar / zNear) * float(CLUSTER_COUNT_Z);
+	uint z = min(uint(slice), CLUSTER_COUNT_Z - 1);
+
+	return tile.x + tile.y * CLUSTER_COUNT_X + z * CLUSTER_COUNT_X * CLUSTER_COUNT_Y;
+}
\ No newline at end of file
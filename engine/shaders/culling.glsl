@@ -0,0 +1,53 @@
+// GLSL Header File
+
+// Declarations shared by cull.comp and meshlet.comp, which use the same descriptor set
+
+#include "object.glsl"
+
+struct DrawCommand
+{
+	uint IndexCount;
+	uint InstanceCount;
+	uint FirstIndex;
+	int VertexOffset;
+	uint FirstInstance;
+};
+
+// Must match 'MeshletData' in OcclusionCuller.h
+struct MeshletData
+{
+	// Local space bounding sphere, center and radius
+	vec4 Sphere;
+	// Axis of the cone containing every triangle's normal, and the sine of the cone's half angle (1 if it cannot cull)
+	vec4 Cone;
+	uint FirstIndex;
+	uint IndexCount;
+	uint ObjectIndex;
+};
+
+// Must match 'CullUniforms' in OcclusionCuller.h
+layout(set = 0, binding = 0) uniform CullUniforms
+{
+	mat4 viewProjection;
+	// Camera the depth pyramid was built with, when read by the early phase
+	mat4 previousViewProjection;
+	vec2 pyramidSize;
+	uint objectCount;
+	uint meshletCount;
+	vec4 cameraPosition;
+	// World space, pointing inwards
+	vec4 frustumPlanes[6];
+};
+
+layout(std430, set = 0, binding = 1) readonly buffer ObjectBuffer
+{
+	ObjectData objects[];
+};
+
+layout(push_constant) uniform PushConstant
+{
+	uint phase;
+};
+
+const uint PHASE_EARLY = 0;
+const uint PHASE_LATE = 1;
\ No newline at end of file
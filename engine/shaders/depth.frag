@@ -0,0 +1,6 @@
+#version 450
+
+// Depth only, color writes are masked off by the pipeline
+void main()
+{
+}
\ No newline at end of file
@@ -0,0 +1,26 @@
+#version 450
+
+#include "object.glsl"
+
+layout(location = 0) in vec3 v_Position;
+
+// Must produce the exact same depth as the shading pass, which tests against it with EQUAL
+invariant gl_Position;
+
+layout(binding = 0) uniform UniformBuffer
+{
+	mat4 View;
+	mat4 Projection;
+};
+
+layout(std430, binding = 1) readonly buffer ObjectBuffer
+{
+	ObjectData objects[];
+};
+
+void main()
+{
+	// Draws use the object's index as first instance
+	vec4 worldPos = objects[gl_InstanceIndex].Model * vec4(v_Position, 1.0f);
+	gl_Position = Projection * View * worldPos;
+}
\ No newline at end of file
@@ -0,0 +1,58 @@
+// GLSL Header File
+
+// Clustered point lights for the forward shading passes, see LightClusterer.h
+
+#include "cluster.glsl"
+#include "phong.glsl"
+
+// Must match 'ClusterUniforms' in cluster.comp
+layout(set = 0, binding = 2) uniform ClusterUniforms
+{
+	mat4 view;
+	mat4 inverseProjection;
+	vec4 cameraPosition;
+	vec2 screenSize;
+	float zNear;
+	float zFar;
+	uint lightCount;
+};
+
+layout(std430, set = 0, binding = 3) readonly buffer LightBuffer
+{
+	PointLight lights[];
+};
+
+layout(std430, set = 0, binding = 4) readonly buffer LightGrid
+{
+	uint clusterLightCounts[CLUSTER_COUNT];
+	uint clusterLightIndices[];
+};
+
+// Reaches zero at the light's radius, past which the clusters no longer include the light
+float Attenuation(float lightDistance, float radius)
+{
+	float ratio = lightDistance / radius;
+	float window = clamp(1.0f - ratio * ratio * ratio * ratio, 0.0f, 1.0f);
+	return window * window;
+}
+
+// Phong shading with the lights of the fragment's cluster, 'position' and 'normal' are in world space
+vec3 ShadeClustered(float ks, float kd, float ka, float a, vec3 position, vec3 normal, vec3 color)
+{
+	float viewDepth = (view * vec4(position, 1.0f)).z;
+	uint cluster = ClusterIndex(gl_FragCoord.xy, viewDepth, screenSize, zNear, zFar);
+	vec3 viewer = normalize(cameraPosition.xyz - position);
+
+	vec3 intensity = PhongAmbient(ka);
+	uint count = clusterLightCounts[cluster];
+	for (uint i = 0; i < count; i++)
+	{
+		PointLight light = lights[clusterLightIndices[cluster * MAX_LIGHTS_PER_CLUSTER + i]];
+		vec3 toLight = light.Position - position;
+		float lightDistance = length(toLight);
+		float attenuation = Attenuation(lightDistance, light.Radius) * light.Intensity;
+		intensity += attenuation * light.Color * PhongLight(ks, kd, a, toLight / lightDistance, viewer, normal, color);
+	}
+
+	return intensity;
+}
\ No newline at end of file
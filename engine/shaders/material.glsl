@@ -0,0 +1,30 @@
+// GLSL Header File
+
+// Per-material parameters, indexed by the material index of the object. Must match 'MaterialData' in MaterialTable.h.
+struct MaterialData
+{
+	// Phong parameters
+	float ks; // Specular reflection constant
+	float kd; // Diffuse reflection constant
+	float ka; // Ambient reflection constant
+	float a;  // Shininess constant
+
+	vec3 color;
+	// Indices into the bindless texture table
+	uint albedoIndex;
+	uint normalMapIndex;
+	uint flags;
+	// Layer and rectangle (offset in xy, size in zw) of the textures in their images, which the texture packer may share
+	uint albedoLayer;
+	uint normalMapLayer;
+	vec4 albedoRect;
+	vec4 normalMapRect;
+};
+
+// Flags
+const uint MATERIAL_NORMAL_MAP_XY = 1;
+
+layout(std430, set = 0, binding = 5) readonly buffer MaterialBuffer
+{
+	MaterialData materials[];
+};
\ No newline at end of file
@@ -0,0 +1,11 @@
+// Per-object data, indexed by the instance index of each draw. Must match 'ObjectData' in OcclusionCuller.h.
+struct ObjectData
+{
+	mat4 Model;
+	// Local space bounding box
+	vec4 BoundsMin;
+	vec4 BoundsMax;
+	uint IndexCount;
+	// Index into the material buffer, see material.glsl
+	uint MaterialIndex;
+};
\ No newline at end of file
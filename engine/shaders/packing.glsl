@@ -0,0 +1,12 @@
+// GLSL Header File
+
+// Inverse of 'OctEncode' in BufferLayout.cpp, for '_OctNormal' vertex attributes
+vec3 OctDecode(vec2 encoded)
+{
+	vec3 normal = vec3(encoded, 1.0f - abs(encoded.x) - abs(encoded.y));
+	// Unfold the lower hemisphere
+	float fold = max(-normal.z, 0.0f);
+	normal.x += normal.x >= 0.0f ? -fold : fold;
+	normal.y += normal.y >= 0.0f ? -fold : fold;
+	return normalize(normal);
+}
\ No newline at end of file
@@ -9,14 +9,18 @@
 const vec3 ambient = vec3(0.02f, 0.02f, 0.02f);
 const vec3 specular = vec3(1.0f, 1.0f, 1.0f);
 
-vec3 Phong(float ks, float kd, float ka, float a, vec3 pointLight, vec3 viewer, vec3 position, vec3 normal, vec3 color)
+vec3 PhongAmbient(float ka)
+{
+	return ka * ambient;
+}
+
+// Diffuse and specular reflection of a single light. 'dirToLight' and 'viewer' are the directions towards the light and the camera.
+vec3 PhongLight(float ks, float kd, float a, vec3 dirToLight, vec3 viewer, vec3 normal, vec3 color)
 {
-	vec3 dirToLight = normalize(pointLight - position);
 	float diffuseValue = max(dot(dirToLight, normal), 0.0f);
 	vec3 reflectionDir = -reflect(dirToLight, normal);
 	vec3 diffuseColor = diffuseValue * color;
 
-	float specularValue = ks * pow(dot(reflectionDir, viewer), a) * specular.x;
-	specularValue = max(specularValue, 0.0f);
-	return ka * ambient + kd * diffuseColor + vec3(specularValue);
+	float specularValue = ks * pow(max(dot(reflectionDir, viewer), 0.0f), a) * specular.x;
+	return kd * diffuseColor + vec3(specularValue);
 }
\ No newline at end of file
@@ -1,28 +1,39 @@
 #version 450
 
+#include "object.glsl"
+#include "packing.glsl"
+
 layout(location = 0) in vec3 v_Position;
-layout(location = 1) in vec3 v_Normal;
+// Octahedral encoded, see BufferLayout::Pack
+layout(location = 1) in vec2 v_Normal;
 
 layout(location = 0) out vec3 out_Position;
 layout(location = 1) out vec3 out_Normal;
+layout(location = 2) flat out uint out_MaterialIndex;
+
+// Must match the depth prepass, see depth.vert
+invariant gl_Position;
 
 layout(binding = 0) uniform UniformBuffer
 {
-	mat4 Model;
 	mat4 View;
 	mat4 Projection;
 };
 
+layout(std430, binding = 1) readonly buffer ObjectBuffer
+{
+	ObjectData objects[];
+};
+
 void main()
 {
-	mat4 normalTransform = transpose(inverse(Model));
-	out_Normal = normalize(vec4(normalTransform * vec4(v_Normal, 1.0f)).xyz);
-
-	vec4 worldPos = Model * vec4(v_Position, 1.0f);
-	float xOffset = -2.0f + gl_InstanceIndex;
-	worldPos.x += xOffset;
-	worldPos.y += 0.5f;
-	worldPos.z += 2.0f;
+	// Draws use the object's index as first instance
+	mat4 model = objects[gl_InstanceIndex].Model;
+	out_MaterialIndex = objects[gl_InstanceIndex].MaterialIndex;
+	mat4 normalTransform = transpose(inverse(model));
+	out_Normal = normalize(vec4(normalTransform * vec4(OctDecode(v_Normal), 1.0f)).xyz);
+
+	vec4 worldPos = model * vec4(v_Position, 1.0f);
 	out_Position = worldPos.xyz;
 	gl_Position = Projection * View * worldPos;
 }
\ No newline at end of file
@@ -1,36 +1,64 @@
 #version 450
+#extension GL_EXT_nonuniform_qualifier : require
 
-#include "phong.glsl"
+#include "lighting.glsl"
+#include "material.glsl"
+#include "variant.glsl"
 
 layout(location = 0) in vec3 out_Position;
 layout(location = 1) in vec2 out_TexCoord;
 layout(location = 2) in mat4 out_NormalTransform;
+layout(location = 6) flat in uint out_MaterialIndex;
 
 layout(location = 0) out vec4 fragColor;
 
-layout(binding = 1) uniform sampler2D textureSampler;
-layout(binding = 2) uniform sampler2D normalSampler;
+// Bindless texture table, every texture is an array with at least one layer
+layout(set = 2, binding = 0) uniform sampler2DArray textures[];
 
-layout(push_constant) uniform PushConstant
+// Packed textures only cover 'rect' of their layer, so they are repeated here instead of by the sampler. The gradients are
+// taken before wrapping, which keeps the seams from selecting the coarsest mip, and atlas lookups stay half a texel of the
+// coarser of the two sampled mips inside the rectangle so that filtering does not pick up the neighbouring textures.
+vec4 SampleTexture(uint index, uint layer, vec4 rect, vec2 uv)
 {
-	// Phong parameters
-	float ks; // Specular reflection constant
-	float kd; // Diffuse reflection constant
-	float ka; // Ambient reflection constant
-	float a;  // Shininess constant
-	
-	vec3 color;
-};
-
-const vec3 pointLight = { 0.0f, 0.0f, -2.0f };
-const vec3 viewer = { 0.0f, 0.0f, 0.0f };
+	// The material index is the same for every fragment of a draw, but draws of different materials may be batched
+	vec2 gradX = dFdx(uv) * rect.zw;
+	vec2 gradY = dFdy(uv) * rect.zw;
+	vec2 inset = vec2(0.0f);
+	if (any(lessThan(rect.zw, vec2(1.0f))))
+	{
+		// The level the gradients select, trilinear filtering also reads the next coarser one
+		vec2 size = vec2(textureSize(textures[nonuniformEXT(index)], 0).xy);
+		float lod = log2(max(length(gradX * size), length(gradY * size)));
+		int levels = textureQueryLevels(textures[nonuniformEXT(index)]);
+		int level = clamp(int(ceil(lod)), 0, levels - 1);
+		vec2 halfTexel = 0.5f / vec2(textureSize(textures[nonuniformEXT(index)], level).xy);
+		// Once the rectangle is narrower than a texel, lookups are clamped to its center
+		inset = mix(vec2(0.0f), min(halfTexel, 0.5f * rect.zw), lessThan(rect.zw, vec2(1.0f)));
+	}
+	vec2 packedUV = clamp(rect.xy + fract(uv) * rect.zw, rect.xy + inset, rect.xy + rect.zw - inset);
+	return textureGrad(textures[nonuniformEXT(index)], vec3(packedUV, float(layer)), gradX, gradY);
+}
 
 void main()
 {
-	vec3 normal = -texture(normalSampler, out_TexCoord).xyz;
+	MaterialData m = LoadMaterial(out_MaterialIndex);
+	// Without a normal map the surface is flat, which is what an unperturbed normal map texel stores
+	vec3 normal = vec3(0.5f, 0.5f, 1.0f);
+	if (HasFeature(FEATURE_NORMAL_MAP))
+	{
+		normal = SampleTexture(m.normalMapIndex, m.normalMapLayer, m.normalMapRect, out_TexCoord).xyz;
+		// Two channel normal maps are unit vectors, stored in the same [0, 1] range as the three channel ones
+		if ((m.flags & MATERIAL_NORMAL_MAP_XY) != 0)
+		{
+			vec2 xy = normal.xy * 2.0f - 1.0f;
+			normal.z = sqrt(max(1.0f - dot(xy, xy), 0.0f)) * 0.5f + 0.5f;
+		}
+	}
+	normal = -normal;
 	normal = normalize(vec4(out_NormalTransform * vec4(normal, 1.0f)).xyz);
-	vec3 surfaceColor = texture(textureSampler, out_TexCoord).xyz;
-	vec3 intensity = Phong(ks, kd, ka, a, pointLight, viewer, out_Position, normal, surfaceColor);
+	vec3 surfaceColor = HasFeature(FEATURE_ALBEDO_MAP) ? SampleTexture(m.albedoIndex, m.albedoLayer, m.albedoRect, out_TexCoord).xyz
+		: m.color;
+	vec3 intensity = ShadeClustered(m.ks, m.kd, m.ka, m.a, out_Position, normal, surfaceColor);
 
 	fragColor = vec4(intensity, 1.0f);
 }
\ No newline at end of file
@@ -1,28 +1,40 @@
 #version 450
 
+#include "object.glsl"
+
 layout(location = 0) in vec3 v_Position;
 layout(location = 1) in vec2 v_TexCoord;
 
 layout(location = 0) out vec3 out_Position;
 layout(location = 1) out vec2 out_TexCoord;
 layout(location = 2) out mat4 out_NormalTransform;
+layout(location = 6) flat out uint out_MaterialIndex;
+
+// Must match the depth prepass, see depth.vert
+invariant gl_Position;
 
 layout(binding = 0) uniform UniformBuffer
 {
-	mat4 Model;
 	mat4 View;
 	mat4 Projection;
 };
 
+layout(std430, binding = 1) readonly buffer ObjectBuffer
+{
+	ObjectData objects[];
+};
+
 void main()
 {
 	out_Position = v_Position;
 	out_TexCoord = v_TexCoord;
 
-	vec4 worldPos = Model * vec4(v_Position, 1.0f);
-	worldPos.z += 4.0f;
+	// Draws use the object's index as first instance
+	mat4 model = objects[gl_InstanceIndex].Model;
+	out_MaterialIndex = objects[gl_InstanceIndex].MaterialIndex;
+	vec4 worldPos = model * vec4(v_Position, 1.0f);
 	out_Position = worldPos.xyz;
-	out_NormalTransform = transpose(inverse(Model));
+	out_NormalTransform = transpose(inverse(model));
 
 	gl_Position = Projection * View * worldPos;
 }
\ No newline at end of file
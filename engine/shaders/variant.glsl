@@ -0,0 +1,35 @@
+// GLSL Header File
+
+// Specialization constants of the pipeline, set from the material's 'ShaderVariant'. Each variant is compiled separately,
+// so branches on them and the loads they replace are removed by the driver. Include after material.glsl.
+
+// Must match 'SHADER_FEATURE_*' in Pipeline.h
+const uint FEATURE_ALBEDO_MAP = 1;
+const uint FEATURE_NORMAL_MAP = 2;
+// The Phong parameters are the constants below instead of being read from the material buffer
+const uint FEATURE_CONSTANT_PHONG = 4;
+
+layout(constant_id = 0) const uint FEATURES = 0;
+// 'ShaderVariant::Values' in order
+layout(constant_id = 1) const float CONSTANT_KS = 1.0f;
+layout(constant_id = 2) const float CONSTANT_KD = 1.0f;
+layout(constant_id = 3) const float CONSTANT_KA = 1.0f;
+layout(constant_id = 4) const float CONSTANT_A = 1.0f;
+
+bool HasFeature(uint feature)
+{
+	return (FEATURES & feature) != 0;
+}
+
+MaterialData LoadMaterial(uint index)
+{
+	MaterialData m = materials[index];
+	if (HasFeature(FEATURE_CONSTANT_PHONG))
+	{
+		m.ks = CONSTANT_KS;
+		m.kd = CONSTANT_KD;
+		m.ka = CONSTANT_KA;
+		m.a = CONSTANT_A;
+	}
+	return m;
+}
\ No newline at end of file
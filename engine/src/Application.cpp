@@ -5,29 +5,35 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include <iostream>
+#include <chrono>
+#include <algorithm>
+#include <string>
 
 namespace sge
 {
-	Application::Application()
-		: m_Rotation(glm::scale(glm::identity<glm::mat4>(), glm::vec3(5.0f, 5.0f, 5.0f)))
+	Application::Application(const ApplicationSpec& spec)
+		: m_Spec(spec), m_Window(spec.Vulkan), m_Rotation(glm::scale(glm::identity<glm::mat4>(), glm::vec3(5.0f, 5.0f, 5.0f)))
 	{
 		m_Window.SetEventCallback(std::bind(Application::OnEvent_Static, this, std::placeholders::_1));
 		m_LayerStack.PushBack(new TestLayer("TEST LAYER 0"));
 		m_LayerStack.PushBack(new TestLayer("TEST LAYER 1"));
-		m_LayerStack.PushBack(new ImGuiLayer(m_Window.GetVulkanInstance()));
-		m_Renderer = std::make_unique<Renderer>(m_Window.GetVulkanInstance());
+		if (!m_Window.GetVulkanInstance()->IsHeadless())
+			m_LayerStack.PushBack(new ImGuiLayer(m_Window.GetVulkanInstance()));
+		m_Renderer = std::make_unique<Renderer>(m_Window.GetVulkanInstance(), spec.Renderer);
 		
 		TestUniformBuffer uBuffer = {
-			m_Rotation,
 			glm::lookAtRH(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 1.0f, 0.0f)),
 			vulkan::MakePerspective(glm::half_pi<float>(), 800.0f / 600.0f, 0.1f, 10.0f),
 		};
 		for (uint32_t i = 0; i < vulkan::MAX_FRAMES_IN_FLIGHT; i++)
 		{
-			m_UniformBuffers[i] = new vulkan::UniformBuffer(m_Window.GetVulkanInstance()->GetDevice(), m_Window.GetVulkanInstance()->GetPhysicalDevice(),
+			m_UniformBuffers[i] = new vulkan::UniformBuffer(m_Window.GetVulkanInstance()->GetDevice(), m_Window.GetVulkanInstance()->GetMemoryAllocator(),
 				&uBuffer, sizeof(TestUniformBuffer));
 		}
 
+		for (const std::string& texturePack : spec.TexturePacks)
+			m_Window.GetVulkanInstance()->LoadTexturePack(texturePack);
+
 		m_BunnyEntity = m_Scene.AddModel(m_Window.GetVulkanInstance(), "E:/C++/sigma-engine/engine/res/meshes/stanford_bunny",
 			"E:/C++/sigma-engine/engine/materials/solidColor.mat");
 
@@ -47,12 +53,33 @@ namespace sge
 		m_SquareEntity = m_Scene.AddModel(m_Window.GetVulkanInstance(), vertices, sizeof(vertices), indices, sizeof(indices),
 			"E:/C++/sigma-engine/engine/materials/texture.mat");
 
-		m_Scene.InitDescriptorSets(m_Window.GetVulkanInstance(), m_UniformBuffers);
-		m_Scene.InitPipelines(m_Window.GetVulkanInstance());
+		// Key light, plus small colored lights scattered in front of the camera for stress testing
+		m_Scene.AddPointLight(glm::vec3(0.0f, 2.0f, -1.0f), glm::vec3(1.0f), 15.0f);
+		uint32_t seed = 1;
+		auto random = [&seed]()
+		{
+			seed = seed * 1664525u + 1013904223u;
+			return static_cast<float>(seed >> 8) / static_cast<float>(1u << 24);
+		};
+		for (uint32_t i = 0; i < m_Spec.LightCount; i++)
+		{
+			glm::vec3 position(random() * 8.0f - 4.0f, random() * 4.0f - 2.0f, random() * 8.0f + 1.0f);
+			glm::vec3 color(random(), random(), random());
+			m_Scene.AddPointLight(position, color, 0.5f + random());
+		}
+
+		m_Scene.InitDescriptorSets(m_Window.GetVulkanInstance(), m_UniformBuffers, m_Renderer->GetObjectBuffers(), m_Renderer->GetLightClusterer());
+		m_Renderer->InitPipelines(m_Scene);
+
+		// Headless runs are used for benchmarks and image comparisons, so they should not start with missing draws
+		if (m_Window.GetVulkanInstance()->IsHeadless())
+			m_Window.GetVulkanInstance()->WaitForPipelines();
 	}
 
 	Application::~Application()
 	{
+		// Pipelines still compiling use the scene's shaders
+		m_Window.GetVulkanInstance()->WaitForPipelines();
 		m_Scene.Destroy(m_Window.GetVulkanInstance());
 
 		for (auto uniformBuffer : m_UniformBuffers)
@@ -66,28 +93,69 @@ namespace sge
 	{
 		m_Rotation = glm::rotate(m_Rotation, 0.0002f, glm::vec3(0.0f, 1.0f, 0.0f));
 
+		// The swap chain extent changes when the window is resized
+		VkExtent2D extent = m_Window.GetVulkanInstance()->GetSwapchainExtent();
+		float aspect = static_cast<float>(extent.width) / static_cast<float>(extent.height);
+
+		constexpr float zNear = 0.1f;
+		constexpr float zFar = 10.0f;
 		TestUniformBuffer uBuffer = {
-			m_Rotation,
 			glm::lookAtLH(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 1.0f, 0.0f)),
-			vulkan::MakePerspective(glm::half_pi<float>(), 800.0f / 600.0f, 0.1f, 10.0f),
+			vulkan::MakePerspective(glm::half_pi<float>(), aspect, zNear, zFar),
 		};
 		m_UniformBuffers[index]->Upload(m_Window.GetVulkanInstance()->GetDevice(), &uBuffer, m_UniformBuffers[index]->GetSize());
+		m_Renderer->SetCamera(uBuffer.View, uBuffer.Projection, zNear, zFar);
+
+		m_Scene.SetTransform(m_BunnyEntity, glm::translate(glm::identity<glm::mat4>(), glm::vec3(-2.0f, 0.5f, 2.0f)) * m_Rotation);
+		m_Scene.SetTransform(m_SquareEntity, glm::translate(glm::identity<glm::mat4>(), glm::vec3(0.0f, 0.0f, 4.0f)) * m_Rotation);
 	}
 
 	int Application::Run()
 	{
 		uint32_t imageIndex;
-		while (!m_Window.ShouldClose())
+		uint32_t frameCount = 0;
+		bool capture = m_Window.GetVulkanInstance()->IsHeadless() && !m_Spec.CaptureDirectory.empty();
+		auto startTime = std::chrono::steady_clock::now();
+		auto nextFrameTime = startTime;
+
+		while (!m_Window.ShouldClose() && (m_Spec.FrameCount == 0 || frameCount < m_Spec.FrameCount))
 		{
+			if (m_Spec.MaxFrameRate)
+			{
+				m_Window.GetVulkanInstance()->SleepUntil(nextFrameTime);
+				nextFrameTime = std::max(nextFrameTime + std::chrono::nanoseconds(1'000'000'000 / m_Spec.MaxFrameRate),
+					std::chrono::steady_clock::now());
+			}
+
+			// Waiting for the frame's previous use before sampling input instead of after keeps the input fresh,
+			// recording starts right away once it is sampled
+			m_Window.GetVulkanInstance()->WaitForFrame();
+			m_Window.PollEvents();
 			m_LayerStack.OnUpdate();
 			
 			imageIndex = m_Renderer->BeginFrame();
-			UpdateUniformBuffer(imageIndex);
+			// Uniform buffers are bound per frame in flight, not per swap chain image
+			UpdateUniformBuffer(m_Window.GetVulkanInstance()->GetCurrentFrame());
 			m_Renderer->DrawScene(m_Scene);
 			m_Renderer->EndFrame(imageIndex);
 
+			if (capture)
+			{
+				m_Window.GetVulkanInstance()->CaptureImage(imageIndex,
+					m_Spec.CaptureDirectory + "/frame" + std::to_string(frameCount) + ".png");
+			}
+
 			m_Window.OnUpdate();
+			frameCount++;
 		}
+
+		vkDeviceWaitIdle(m_Window.GetVulkanInstance()->GetDevice());
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+		if (frameCount)
+			SGE_INFOF("Rendered %u frames in %.3f s (%.3f ms per frame).", frameCount, seconds, 1000.0 * seconds / frameCount);
+		SGE_INFOF("Average input to GPU completion latency (estimate): %.3f ms.", m_Window.GetVulkanInstance()->GetLatencyMilliseconds());
+		for (const auto& scope : m_Window.GetVulkanInstance()->GetGpuProfiler()->GetResults())
+			SGE_INFOF("GPU %*s%s: %.3f ms.", static_cast<int>(2 * scope.Depth), "", scope.Name.c_str(), scope.Milliseconds);
 		SGE_INFO("Exiting program...");
 
 		return 0;
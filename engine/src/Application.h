@@ -10,16 +10,33 @@
 
 namespace sge
 {
+	// Model matrices are per object, see 'DrawableComponent::Transform'
 	struct TestUniformBuffer
 	{
-		glm::mat4 Model;
 		glm::mat4 View;
 		glm::mat4 Projection;
 	};
 	
+	struct ApplicationSpec
+	{
+		vulkan::InstanceSpec Vulkan;
+		// Number of frames to render before exiting, 0 runs until the window is closed
+		uint32_t FrameCount = 0;
+		// Headless only: if not empty, every frame is written to this directory as a PNG file
+		std::string CaptureDirectory;
+		// Additional point lights scattered around the scene
+		uint32_t LightCount = 0;
+		// Frames per second the main loop is limited to, 0 for no limit besides the frames in flight
+		uint32_t MaxFrameRate = 0;
+		// Manifests written by the texture packer, loaded before the scene's materials
+		std::vector<std::string> TexturePacks;
+		RendererSpec Renderer;
+	};
+
 	class SGE_API Application
 	{
 	private:
+		ApplicationSpec m_Spec;
 		Window m_Window;
 		LayerStack m_LayerStack;
 		std::unique_ptr<Renderer> m_Renderer;
@@ -31,7 +48,7 @@ namespace sge
 
 		Scene m_Scene;
 	public:
-		Application();
+		Application(const ApplicationSpec& spec = {});
 		~Application();
 		void UpdateUniformBuffer(uint32_t index);
 		void OnEvent(Event& event);
@@ -7,6 +7,7 @@
 #include <thread>
 #include <unordered_map>
 #include <map>
+#include <algorithm>
 
 namespace sge::file
 {
@@ -134,4 +135,90 @@ namespace sge::file
 
 		SGE_TRACE("Finished calculating normals.");
 	}
+
+	static uint32_t CRC32(const uint8_t* data, size_t size, uint32_t crc = 0)
+	{
+		crc = ~crc;
+		for (size_t i = 0; i < size; i++)
+		{
+			crc ^= data[i];
+			for (int k = 0; k < 8; k++)
+				crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+		}
+
+		return ~crc;
+	}
+
+	static void AppendBigEndian(std::vector<uint8_t>& out, uint32_t value)
+	{
+		out.push_back(static_cast<uint8_t>(value >> 24));
+		out.push_back(static_cast<uint8_t>(value >> 16));
+		out.push_back(static_cast<uint8_t>(value >> 8));
+		out.push_back(static_cast<uint8_t>(value));
+	}
+
+	static void AppendChunk(std::vector<uint8_t>& out, const char* type, const std::vector<uint8_t>& data)
+	{
+		AppendBigEndian(out, static_cast<uint32_t>(data.size()));
+		size_t typeOffset = out.size();
+		out.insert(out.end(), type, type + 4);
+		out.insert(out.end(), data.begin(), data.end());
+		AppendBigEndian(out, CRC32(out.data() + typeOffset, out.size() - typeOffset));
+	}
+
+	void WritePNG(const std::string& filepath, uint32_t width, uint32_t height, const uint8_t* pixels)
+	{
+		std::ofstream file(filepath, std::ios::binary);
+		SGE_ASSERTF(file.is_open(), "Could not open file '%s'.", filepath.c_str());
+
+		// Every scanline starts with filter type 0 (none)
+		size_t rowSize = static_cast<size_t>(width) * 4;
+		std::vector<uint8_t> raw;
+		raw.reserve((rowSize + 1) * height);
+		for (uint32_t y = 0; y < height; y++)
+		{
+			raw.push_back(0);
+			raw.insert(raw.end(), pixels + y * rowSize, pixels + (y + 1) * rowSize);
+		}
+
+		// zlib stream made of stored (uncompressed) deflate blocks
+		constexpr size_t maxBlockSize = 65535;
+		std::vector<uint8_t> zlib = { 0x78, 0x01 };
+		for (size_t offset = 0; offset < raw.size(); offset += maxBlockSize)
+		{
+			size_t blockSize = std::min(maxBlockSize, raw.size() - offset);
+			bool isLast = offset + blockSize == raw.size();
+
+			zlib.push_back(isLast ? 1 : 0);
+			zlib.push_back(static_cast<uint8_t>(blockSize));
+			zlib.push_back(static_cast<uint8_t>(blockSize >> 8));
+			zlib.push_back(static_cast<uint8_t>(~blockSize));
+			zlib.push_back(static_cast<uint8_t>(~blockSize >> 8));
+			zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + blockSize);
+		}
+
+		uint32_t a = 1, b = 0;
+		for (uint8_t byte : raw)
+		{
+			a = (a + byte) % 65521;
+			b = (b + a) % 65521;
+		}
+		AppendBigEndian(zlib, (b << 16) | a);
+
+		std::vector<uint8_t> header;
+		AppendBigEndian(header, width);
+		AppendBigEndian(header, height);
+		header.push_back(8); // Bit depth
+		header.push_back(6); // Color type RGBA
+		header.push_back(0); // Compression method
+		header.push_back(0); // Filter method
+		header.push_back(0); // No interlacing
+
+		std::vector<uint8_t> png = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+		AppendChunk(png, "IHDR", header);
+		AppendChunk(png, "IDAT", zlib);
+		AppendChunk(png, "IEND", {});
+
+		file.write(reinterpret_cast<const char*>(png.data()), png.size());
+	}
 } // namespace sge::file
\ No newline at end of file
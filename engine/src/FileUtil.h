@@ -12,4 +12,6 @@ namespace sge::file
 
 	MeshData LoadOBJFile(const std::string& filepath, size_t floatsPerVertex);
 	void CalculateNormals(std::vector<float>& vertices, const std::vector<uint32_t>& indices);
+	// Writes 8-bit RGBA pixels to an uncompressed PNG file
+	void WritePNG(const std::string& filepath, uint32_t width, uint32_t height, const uint8_t* pixels);
 } // namespace sge::file
\ No newline at end of file
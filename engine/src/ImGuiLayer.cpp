@@ -7,6 +7,8 @@
 #include <imgui/imgui.h>
 #include <imgui/imgui_internal.h>
 
+#include <algorithm>
+
 namespace sge
 {
 	ImGuiLayer::ImGuiLayer(vulkan::Instance* vulkanInstance)
@@ -40,7 +42,7 @@ namespace sge
 		vulkanInfo.Device = m_VulkanInstance->GetDevice();
 		vulkanInfo.Queue = m_VulkanInstance->GetGraphicsQueue();
 		vulkanInfo.QueueFamily = m_VulkanInstance->GetQueueFamilyIndices().GraphicsFamily.value();
-		vulkanInfo.DescriptorPool = m_VulkanInstance->GetDescriptorPool();
+		vulkanInfo.DescriptorPool = m_VulkanInstance->GetImGuiDescriptorPool();
 		vulkanInfo.MinImageCount = m_VulkanInstance->GetSwapchainImageCount();
 		vulkanInfo.ImageCount = m_VulkanInstance->GetSwapchainImageCount();
 		vulkanInfo.CheckVkResultFn = CheckVkResult;
@@ -95,15 +97,76 @@ namespace sge
 		{
 			ImGui::SetWindowSize({ 800.0f, 300.0f }, ImGuiCond_FirstUseEver);
 
-			vulkan::PushConstant& push = m_VulkanInstance->GetPushConstant();
-			ImGui::SliderFloat("Specular reflection constant", &push.ks, 0.0f, 1.0f, nullptr, 1.0f);
-			ImGui::SliderFloat("Diffuse reflection constant", &push.kd, 0.0f, 1.0f, nullptr, 1.0f);
-			ImGui::SliderFloat("Ambient reflection constant", &push.ka, 0.0f, 1.0f, nullptr, 1.0f);
-			ImGui::SliderFloat("Shininess constant", &push.a, 0.0f, 10.0f, nullptr, 1.0f);
+			// Edits a copy, the material table only uploads again when something changed
+			vulkan::MaterialTable* materials = m_VulkanInstance->GetMaterialTable();
+			if (materials->GetCount() > 0)
+			{
+				int maxIndex = static_cast<int>(materials->GetCount()) - 1;
+				m_SelectedMaterial = std::min(m_SelectedMaterial, maxIndex);
+				ImGui::SliderInt("Material", &m_SelectedMaterial, 0, maxIndex);
+
+				vulkan::MaterialData material = materials->Get(static_cast<uint32_t>(m_SelectedMaterial));
+				bool changed = false;
+				changed |= ImGui::SliderFloat("Specular reflection constant", &material.Ks, 0.0f, 1.0f, nullptr, 1.0f);
+				changed |= ImGui::SliderFloat("Diffuse reflection constant", &material.Kd, 0.0f, 1.0f, nullptr, 1.0f);
+				changed |= ImGui::SliderFloat("Ambient reflection constant", &material.Ka, 0.0f, 1.0f, nullptr, 1.0f);
+				changed |= ImGui::SliderFloat("Shininess constant", &material.A, 0.0f, 10.0f, nullptr, 1.0f);
+
+				ImGui::NewLine();
+				ImGui::PushItemWidth(200.0f);
+				changed |= ImGui::ColorPicker3("Colour", &material.Color.x);
+				ImGui::PopItemWidth();
+
+				if (changed)
+					materials->Set(static_cast<uint32_t>(m_SelectedMaterial), material);
+			}
+		}
+		ImGui::End();
 
-			ImGui::NewLine();
-			ImGui::PushItemWidth(200.0f);
-			ImGui::ColorPicker3("Colour", push.color);
+		if (ImGui::Begin("GPU profiler"))
+		{
+			ImGui::SetWindowSize({ 500.0f, 300.0f }, ImGuiCond_FirstUseEver);
+
+			// Results lag a few frames behind, the queries are read back without waiting on the GPU
+			const vulkan::GpuProfiler* profiler = m_VulkanInstance->GetGpuProfiler();
+			if (!profiler->IsEnabled())
+				ImGui::Text("Timestamps are not supported.");
+
+			double total = 0.0;
+			for (const auto& scope : profiler->GetResults())
+			{
+				if (scope.Depth == 0)
+					total += scope.Milliseconds;
+
+				const int indent = static_cast<int>(2 * scope.Depth);
+				ImGui::Text("%*s%-20s %8.3f ms", indent, "", scope.Name.c_str(), scope.Milliseconds);
+				if (scope.HasStatistics)
+				{
+					ImGui::Text("%*s  prims %llu, verts %llu, clipped prims %llu, frags %llu, compute %llu", indent, "",
+						static_cast<unsigned long long>(scope.InputPrimitives), static_cast<unsigned long long>(scope.VertexInvocations),
+						static_cast<unsigned long long>(scope.ClippingPrimitives), static_cast<unsigned long long>(scope.FragmentInvocations),
+						static_cast<unsigned long long>(scope.ComputeInvocations));
+				}
+			}
+
+			ImGui::Separator();
+			ImGui::Text("%-20s %8.3f ms", "Total", total);
+			ImGui::Text("%-20s %8.3f ms (%u frames in flight)", "Input latency (est.)", m_VulkanInstance->GetLatencyMilliseconds(),
+				m_VulkanInstance->GetFramesInFlight());
+			ImGui::Text("%-20s %8u", "Textures loading", m_VulkanInstance->GetTextureLoader()->GetPendingCount());
+
+			// Sizes of the allocations, not of the memory blocks they are placed in
+			ImGui::Separator();
+			const vulkan::MemoryAllocator* allocator = m_VulkanInstance->GetMemoryAllocator();
+			for (uint32_t i = 0; i < static_cast<uint32_t>(vulkan::MemoryCategory::Count); i++)
+			{
+				vulkan::MemoryCategory category = static_cast<vulkan::MemoryCategory>(i);
+				ImGui::Text("%-20s %8.1f MiB", vulkan::MemoryAllocator::GetCategoryName(category),
+					allocator->GetCategoryBytes(category) / (1024.0 * 1024.0));
+			}
+			const vulkan::MemoryBudget& budget = allocator->GetBudget();
+			ImGui::Text("%-20s %8.1f MiB of %.1f MiB%s", "Device local", budget.Usage / (1024.0 * 1024.0), budget.Budget / (1024.0 * 1024.0),
+				allocator->HasMemoryBudgetExtension() ? "" : " (estimated)");
 		}
 		ImGui::End();
 
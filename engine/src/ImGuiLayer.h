@@ -24,6 +24,8 @@ namespace sge
 	private:
 		vulkan::Instance* m_VulkanInstance;
 		char m_TextEntryBuffer[TEXT_ENTRY_SIZE];
+		// Material edited in the Phong shader controls
+		int m_SelectedMaterial = 0;
 	};
 
 } // namespace sge
\ No newline at end of file
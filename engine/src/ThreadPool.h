@@ -0,0 +1,39 @@
+#pragma once
+
+#include "base.h"
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+namespace sge
+{
+	// Fixed set of worker threads executing jobs in submission order.
+	// Jobs that are still queued when the pool is destroyed are executed before the workers exit.
+	class ThreadPool
+	{
+	public:
+		// A thread count of 0 uses one thread per hardware thread, minus one for the main thread
+		ThreadPool(uint32_t threadCount = 0);
+		~ThreadPool();
+
+		void Submit(std::function<void()>&& job);
+		// Blocks until every submitted job has finished
+		void Wait();
+	public:
+		inline uint32_t GetThreadCount() const { return static_cast<uint32_t>(m_Threads.size()); }
+	private:
+		void WorkerLoop();
+	private:
+		std::vector<std::jthread> m_Threads;
+		std::queue<std::function<void()>> m_Jobs;
+		std::mutex m_Mutex;
+		std::condition_variable m_JobAvailable;
+		std::condition_variable m_JobsFinished;
+		uint32_t m_ActiveJobs;
+		bool m_Stopping;
+	};
+} // namespace sge
\ No newline at end of file
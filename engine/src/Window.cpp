@@ -7,18 +7,23 @@
 
 namespace sge
 {
-	constexpr uint32_t windowWidth = 1200, windowHeight = 900;
-	
-	Window::Window()
+	Window::Window(const vulkan::InstanceSpec& spec)
 	{
+		if (spec.Headless)
+		{
+			SGE_INFO("Initializing Vulkan in headless mode...");
+			m_VulkanInstance = std::make_unique<vulkan::Instance>(nullptr, spec);
+			return;
+		}
+
 		SGE_ASSERTM(glfwInit(), "Failed to initialize glfw.");
 
 		glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-		glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
-		GLFWwindow* windowHandle = glfwCreateWindow(windowWidth, windowHeight, "Sigma Game Engine", nullptr, nullptr);
+		glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
+		GLFWwindow* windowHandle = glfwCreateWindow(spec.Width, spec.Height, "Sigma Game Engine", nullptr, nullptr);
 		SGE_ASSERTM(windowHandle, "Failed to create window.");
 		SGE_INFO("Initializing Vulkan...");
-		m_VulkanInstance = std::make_unique<vulkan::Instance>(windowHandle);
+		m_VulkanInstance = std::make_unique<vulkan::Instance>(windowHandle, spec);
 		
 		glfwSetWindowUserPointer(windowHandle, this);
 		InitEventCallbacks();
@@ -26,6 +31,9 @@ namespace sge
 
 	Window::~Window()
 	{
+		if (m_VulkanInstance->IsHeadless())
+			return;
+
 		glfwDestroyWindow(m_VulkanInstance->GetWindowHandle());
 		glfwTerminate();
 	}
@@ -82,10 +90,20 @@ namespace sge
 
 	void Window::OnUpdate()
 	{
-		glfwPollEvents();
+		if (m_VulkanInstance->IsHeadless())
+			return;
+
 		ImGuiPresent(); // TODO: Move this to renderer
 	}
 
+	void Window::PollEvents()
+	{
+		if (!m_VulkanInstance->IsHeadless())
+			glfwPollEvents();
+
+		m_VulkanInstance->MarkInputSampled();
+	}
+
 	void Window::OnFrameBufferResize()
 	{
 		m_VulkanInstance->SetFramebufferResized();
@@ -22,13 +22,16 @@ namespace sge
 
 		void ImGuiPresent();
 	public:
-		Window();
+		Window(const vulkan::InstanceSpec& spec);
 		~Window();
 		void OnUpdate();
+		// Samples input, called at the start of a frame
+		void PollEvents();
 		void OnEvent(Event& event);
 		void OnFrameBufferResize();
 
-		inline bool ShouldClose() const { return glfwWindowShouldClose(m_VulkanInstance->GetWindowHandle()); }
+		// Headless windows never close by themselves
+		inline bool ShouldClose() const { return !m_VulkanInstance->IsHeadless() && glfwWindowShouldClose(m_VulkanInstance->GetWindowHandle()); }
 		inline void SetEventCallback(const EventCallback& callback) { m_Eventcallback = callback; }
 		inline vulkan::Instance* GetVulkanInstance() const { return m_VulkanInstance.get(); }
 	};
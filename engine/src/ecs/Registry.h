@@ -18,6 +18,8 @@ namespace sge::ecs
 	{
 		EntityID Entity;
 		ComponentID ID;
+		// Size of the component following this info, so components of different classes can be skipped
+		size_t Size;
 	};
 
 	class Registry
@@ -36,6 +38,10 @@ namespace sge::ecs
 		template<typename ComponentClass>
 		void ForEach(const ForEachFunc<ComponentClass>& func);
 
+		// Returns null if the entity has no component of this class
+		template<typename ComponentClass>
+		ComponentClass* GetComponent(EntityID entity);
+
 	private:
 		static ComponentID HashString(const std::string& string);
 	private:
@@ -48,7 +54,7 @@ namespace sge::ecs
 	void Registry::AddComponent(EntityID entity, Args&&... args)
 	{
 		const std::string className = typeid(ComponentClass).name();
-		SGE_WARNF("Component class name: '%s'.", className.c_str());
+		SGE_TRACEF("Component class name: '%s'.", className.c_str());
 
 		size_t oldSize = m_Size;
 		m_Size += sizeof(ComponentInfo) + sizeof(ComponentClass);
@@ -59,6 +65,7 @@ namespace sge::ecs
 		ComponentInfo info = {
 			.Entity	= entity,
 			.ID		= HashString(className),
+			.Size	= sizeof(ComponentClass),
 		};
 
 		memcpy(m_Components + oldSize, &info, sizeof(ComponentInfo));
@@ -79,7 +86,25 @@ namespace sge::ecs
 			i += sizeof(ComponentInfo);
 			if (info->ID == classID)
 				func(reinterpret_cast<ComponentClass*>(m_Components + i));
-			i += sizeof(ComponentClass);
+			i += info->Size;
 		}
 	}
+
+	template<typename ComponentClass>
+	ComponentClass* Registry::GetComponent(EntityID entity)
+	{
+		const std::string className = typeid(ComponentClass).name();
+		ComponentID classID = HashString(className);
+
+		for (size_t i = 0; i < m_Size;)
+		{
+			ComponentInfo* info = (ComponentInfo*)(m_Components + i);
+			i += sizeof(ComponentInfo);
+			if (info->ID == classID && info->Entity == entity)
+				return reinterpret_cast<ComponentClass*>(m_Components + i);
+			i += info->Size;
+		}
+
+		return nullptr;
+	}
 } // namespace sge::ecs
\ No newline at end of file
@@ -1,13 +1,25 @@
 #include "Material.h"
 
 #include <fstream>
+#include <string>
+#include <vector>
 
 namespace sge
 {
+	// Features that materials can declare, the texture features are set for the textures they have
+	static uint32_t ParseShaderFeature(const std::string& name)
+	{
+		if (name == "constant_phong")
+			return vulkan::SHADER_FEATURE_CONSTANT_PHONG;
+
+		SGE_WARNF("Unknown shader feature '%s'.", name.c_str());
+		return 0;
+	}
+
 	// TODO: Test if material exists already before loading it
 
 	Material::Material(vulkan::Instance* vulkanInstance, const std::string& filepath)
-		: m_PipelineIndex(-1), m_Shader(nullptr), m_Albedo(nullptr), m_NormalMap(nullptr)
+		: m_PipelineIndex(-1), m_Shader(nullptr), m_Albedo(nullptr), m_NormalMap(nullptr), m_MaterialIndex(0)
 	{
 		std::ifstream file(filepath);
 		SGE_ASSERTF(file.is_open(), "Could not open file '%s'.", filepath.c_str());
@@ -16,28 +28,92 @@ namespace sge
 		std::string fragPath;
 		std::getline(file, fragPath);
 
-		m_Shader = new vulkan::Shader(vulkanInstance->GetDevice(), vulkanInstance->GetDescriptorPool(), vertPath, fragPath);
+		m_Shader = new vulkan::Shader(vulkanInstance->GetDevice(), vertPath, fragPath);
+		// Registered first, so loading textures can update it
+		m_MaterialIndex = vulkanInstance->RegisterMaterial({});
+		vulkan::MaterialData data;
+
+		// The remaining lines are the albedo and the normal map, in that order, and the shader variant: 'feature <name>'
+		// enables a feature and 'constant <value>' appends a specialization constant
+		std::vector<std::string> texturePaths;
+		std::string line;
+		while (std::getline(file, line))
+		{
+			if (line.rfind("feature ", 0) == 0)
+				m_Variant.Features |= ParseShaderFeature(line.substr(8));
+			else if (line.rfind("constant ", 0) == 0)
+				m_Variant.Values.push_back(std::stof(line.substr(9)));
+			else if (!line.empty())
+				texturePaths.push_back(line);
+		}
+
+		if ((m_Variant.Features & vulkan::SHADER_FEATURE_CONSTANT_PHONG) && m_Variant.Values.size() < 4)
+		{
+			SGE_WARNF("Material '%s' has constant Phong parameters but fewer than 4 constants.", filepath.c_str());
+			m_Variant.Features &= ~vulkan::SHADER_FEATURE_CONSTANT_PHONG;
+		}
+		if (m_Variant.Features & vulkan::SHADER_FEATURE_CONSTANT_PHONG)
+		{
+			// Kept in the table as well for anything that reads the parameters without the variant
+			data.Ks = m_Variant.Values[0];
+			data.Kd = m_Variant.Values[1];
+			data.Ka = m_Variant.Values[2];
+			data.A = m_Variant.Values[3];
+		}
 
-		// Check if material has albedo or normal map
-		if (!file.eof())
+		if (texturePaths.size() > 0)
 		{
-			std::string albedoPath;
-			std::getline(file, albedoPath);
-			m_Albedo = new vulkan::Texture(vulkanInstance->GetDevice(), vulkanInstance->GetPhysicalDevice(),
-				vulkanInstance->GetCommandPool(), vulkanInstance->GetGraphicsQueue(), albedoPath);
+			const std::string& albedoPath = texturePaths[0];
+			m_Variant.Features |= vulkan::SHADER_FEATURE_ALBEDO_MAP;
+			// Packed textures share their array with other materials and are not streamed
+			if (const vulkan::PackedTexture* packed = vulkanInstance->FindPackedTexture(albedoPath))
+			{
+				data.AlbedoIndex = packed->TableIndex;
+				data.AlbedoLayer = packed->Layer;
+				data.AlbedoRect = packed->Rect;
+			}
+			else
+			{
+				m_Albedo = vulkanInstance->LoadTextureAsync(albedoPath);
+				data.AlbedoIndex = vulkanInstance->RegisterTexture(m_Albedo);
+			}
 		}
 
-		if (!file.eof())
+		if (texturePaths.size() > 1)
 		{
-			std::string normalMapPath;
-			std::getline(file, normalMapPath);
-			m_NormalMap = new vulkan::Texture(vulkanInstance->GetDevice(), vulkanInstance->GetPhysicalDevice(),
-				vulkanInstance->GetCommandPool(), vulkanInstance->GetGraphicsQueue(), normalMapPath);
+			const std::string& normalMapPath = texturePaths[1];
+			m_Variant.Features |= vulkan::SHADER_FEATURE_NORMAL_MAP;
+			if (const vulkan::PackedTexture* packed = vulkanInstance->FindPackedTexture(normalMapPath))
+			{
+				data.NormalMapIndex = packed->TableIndex;
+				data.NormalMapLayer = packed->Layer;
+				data.NormalMapRect = packed->Rect;
+				if (packed->Format == VK_FORMAT_BC5_UNORM_BLOCK)
+					data.Flags |= vulkan::MATERIAL_NORMAL_MAP_XY;
+			}
+			else
+			{
+				// The format is only known once the texture is decoded
+				m_NormalMap = vulkanInstance->LoadTextureAsync(normalMapPath,
+					[vulkanInstance, materialIndex = m_MaterialIndex](vulkan::Texture* texture)
+					{
+						if (texture->GetFormat() != VK_FORMAT_BC5_UNORM_BLOCK)
+							return;
+
+						vulkan::MaterialData material = vulkanInstance->GetMaterialTable()->Get(materialIndex);
+						material.Flags |= vulkan::MATERIAL_NORMAL_MAP_XY;
+						vulkanInstance->GetMaterialTable()->Set(materialIndex, material);
+					});
+				data.NormalMapIndex = vulkanInstance->RegisterTexture(m_NormalMap);
+			}
 		}
+
+		vulkanInstance->GetMaterialTable()->Set(m_MaterialIndex, data);
 	}
 
 	void Material::Destroy(vulkan::Instance* vulkanInstance)
 	{
+		vulkanInstance->WaitForTextureLoads();
 		m_Shader->Destroy(vulkanInstance->GetDevice());
 		delete m_Shader;
 
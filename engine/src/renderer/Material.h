@@ -14,8 +14,13 @@ namespace sge
 	private:
 		int m_PipelineIndex;
 		vulkan::Shader* m_Shader;
+		// Texture features follow from the textures, the rest is declared in the material file
+		vulkan::ShaderVariant m_Variant;
+		// Null if there is none or if it is part of a texture pack, which owns it
 		vulkan::Texture* m_Albedo;
 		vulkan::Texture* m_NormalMap;
+		// Slot in the instance's material table holding the parameters and texture indices
+		uint32_t m_MaterialIndex;
 
 		friend class Renderer;
 		friend class Scene;
@@ -1,7 +1,12 @@
 #include "Mesh.h"
+#include "Meshlet.h"
 #include "FileUtil.h"
 
+#include <glm/common.hpp>
+#include <glm/gtc/packing.hpp>
+
 #include <fstream>
+#include <cstring>
 
 namespace sge
 {
@@ -9,23 +14,82 @@ namespace sge
 	//		 in a custom binary format after first use.
 
 	/*
-	* Custom binary format:
+	* Custom binary format, holding the buffers as they are uploaded:
 	* 
 	* struct
 	* {
 	*	  struct Layout
 	*	  {
 	*		   uint32_t AttribCount;
-	*		   enum AttributeType Attribs[AttribCount];
+	*		   enum AttributeType Attribs[AttribCount]; // The packed layout, position first
 	*	  };
 	* 
-	*     size_t VerticesSize;
-	*	  float Vertices[VerticesSize];
-	*	  size_t IndicesSize;
-	*	  uint32_t Indices[IndicesSize];
+	*     uint64_t VerticesSize; // In bytes
+	*	  uint8_t Vertices[VerticesSize];
+	*	  enum VkIndexType IndexType; // VK_INDEX_TYPE_UINT16 or VK_INDEX_TYPE_UINT32
+	*	  uint64_t IndicesSize; // In bytes
+	*	  uint16_t or uint32_t Indices[];
 	* };
 	*/
 
+	template<typename T>
+	static void WriteValue(std::ofstream& file, const T& value)
+	{
+		file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+	template<typename T>
+	static T ReadValue(std::ifstream& file)
+	{
+		T value = {};
+		file.read(reinterpret_cast<char*>(&value), sizeof(T));
+		return value;
+	}
+
+	// Decodes the positions of packed vertices, which are the first attribute of every vertex
+	static std::vector<float> UnpackPositions(const uint8_t* vertices, size_t size, const vulkan::BufferLayout& layout)
+	{
+		const vulkan::AttributeType type = layout.GetAttributes()[0].Type;
+		SGE_ASSERTM(type == vulkan::_Half4 || type == vulkan::_Vec3, "Unsupported position attribute.");
+
+		const size_t vertexCount = size / layout.GetStride();
+		std::vector<float> positions(3 * vertexCount);
+		for (size_t i = 0; i < vertexCount; i++)
+		{
+			const uint8_t* vertex = vertices + i * layout.GetStride();
+			if (type == vulkan::_Half4)
+			{
+				glm::uint64 packed;
+				memcpy(&packed, vertex, sizeof(packed));
+				glm::vec4 position = glm::unpackHalf4x16(packed);
+				positions[3 * i] = position.x;
+				positions[3 * i + 1] = position.y;
+				positions[3 * i + 2] = position.z;
+			}
+			else
+				memcpy(&positions[3 * i], vertex, 3 * sizeof(float));
+		}
+
+		return positions;
+	}
+
+	// Geometry lives in device local memory, so it is copied to a host visible buffer first
+	static void WriteBufferContents(std::ofstream& file, vulkan::Instance* vulkanInstance, VkBuffer buffer, size_t size)
+	{
+		vulkan::Buffer readbackBuffer(vulkanInstance->GetDevice(), vulkanInstance->GetMemoryAllocator(), VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			size, vulkan::MemoryUsage::GpuToCpu);
+
+		VkCommandBuffer commandBuffer = vulkan::BeginOneTimeCommandBuffer(vulkanInstance->GetDevice(), vulkanInstance->GetCommandPool());
+		VkBufferCopy bufferCopy = {};
+		bufferCopy.size = size;
+		vkCmdCopyBuffer(commandBuffer, buffer, readbackBuffer.GetBufferHandle(), 1, &bufferCopy);
+		vulkan::EndOneTimeCommandBuffer(vulkanInstance->GetDevice(), vulkanInstance->GetCommandPool(), commandBuffer,
+			vulkanInstance->GetGraphicsQueue());
+
+		file.write(reinterpret_cast<const char*>(readbackBuffer.GetData()), size);
+		readbackBuffer.Destroy(vulkanInstance->GetDevice());
+	}
+
 	void Mesh::Serialize(vulkan::Instance* vulkanInstance)
 	{
 		const std::string filepath = /*m_Name +*/  ".svb";
@@ -34,26 +98,22 @@ namespace sge
 		SGE_ASSERTF(file.is_open(), "Could not open file '%s'", filepath.c_str());
 
 		const auto* layout = m_VertexBuffer->GetLayout();
+		WriteValue(file, static_cast<uint32_t>(layout->GetAttributes().size()));
 		for (auto& attribute : layout->GetAttributes())
-			file << attribute.Type;
+			WriteValue(file, attribute.Type);
 
-		size_t size = m_VertexBuffer->GetCount() * layout->GetStride();
-		file << size;
-		
-		void* data;
-		vkMapMemory(vulkanInstance->GetDevice(), m_VertexBuffer->GetDeviceMemory(), 0, size, 0, &data);
-		file.write(static_cast<const char*>(data), size);
-		vkUnmapMemory(vulkanInstance->GetDevice(), m_VertexBuffer->GetDeviceMemory());
+		uint64_t size = m_VertexBuffer->GetCount() * layout->GetStride();
+		WriteValue(file, size);
+		WriteBufferContents(file, vulkanInstance, m_VertexBuffer->GetBufferHandle(), size);
 
-		size = m_IndexBuffer->GetCount() * sizeof(uint32_t);
-		file << size;
-		
-		vkMapMemory(vulkanInstance->GetDevice(), m_IndexBuffer->GetDeviceMemory(), 0, size, 0, &data);
-		file.write(static_cast<const char*>(data), size);
+		WriteValue(file, m_IndexBuffer->GetIndexType());
+		size = m_IndexBuffer->GetCount() * m_IndexBuffer->GetIndexSize();
+		WriteValue(file, size);
+		WriteBufferContents(file, vulkanInstance, m_IndexBuffer->GetBufferHandle(), size);
 	}
 
 	Mesh::Mesh(vulkan::Instance* vulkanInstance, const std::string& name)
-		: m_VertexBuffer(nullptr), m_IndexBuffer(nullptr)
+		: m_VertexBuffer(nullptr), m_IndexBuffer(nullptr), m_PositionBuffer(nullptr), m_BoundsMin(0.0f), m_BoundsMax(0.0f)
 	{
 		std::string filepath = name + ".svb";
 		std::ifstream file(filepath, std::ios::binary);
@@ -61,37 +121,43 @@ namespace sge
 		// Check if binary exists
 		if (file.is_open())
 		{
-			// Load from binary
+			// Load from binary, the vertices are already packed
 			vulkan::BufferLayout layout;
-			std::vector<float> vertices;
-			std::vector<uint32_t> indices;
 			
 			// Layout
-			uint32_t attribCount;
-			file >> attribCount;
-			layout.Resize(attribCount);
-			std::vector<vulkan::AttributeType> attribs(attribCount);
-			file.read((char*)attribs.data(), attribCount * sizeof(vulkan::Attribute));
-			
-			for (const auto attrib : attribs)
-				layout.AddAttribute(attrib);
+			const uint32_t attribCount = ReadValue<uint32_t>(file);
+			for (uint32_t i = 0; i < attribCount; i++)
+				layout.AddAttribute(ReadValue<vulkan::AttributeType>(file));
 
 			// Vertices
-			size_t size;
-			file >> size;
-			vertices.resize(size / sizeof(float));
-			file.read((char*)vertices.data(), size);
+			std::vector<uint8_t> vertices(ReadValue<uint64_t>(file));
+			file.read(reinterpret_cast<char*>(vertices.data()), vertices.size());
 
-			// Indices
-			file >> size;
-			indices.resize(size / sizeof(uint32_t));
-			file.read((char*)vertices.data(), size);
+			// Indices, widened to 32 bits. The index buffer narrows them again if they fit.
+			const VkIndexType indexType = ReadValue<VkIndexType>(file);
+			const uint64_t indicesSize = ReadValue<uint64_t>(file);
+			std::vector<uint32_t> indices;
+			if (indexType == VK_INDEX_TYPE_UINT16)
+			{
+				std::vector<uint16_t> narrowIndices(indicesSize / sizeof(uint16_t));
+				file.read(reinterpret_cast<char*>(narrowIndices.data()), indicesSize);
+				indices.assign(narrowIndices.begin(), narrowIndices.end());
+			}
+			else
+			{
+				indices.resize(indicesSize / sizeof(uint32_t));
+				file.read(reinterpret_cast<char*>(indices.data()), indicesSize);
+			}
+			SGE_ASSERTF(!file.fail(), "File '%s' is truncated.", filepath.c_str());
 
 			// Create buffers
-			m_VertexBuffer = new vulkan::VertexBuffer(vulkanInstance->GetDevice(), vulkanInstance->GetPhysicalDevice(),
-				vulkanInstance->GetCommandPool(), vulkanInstance->GetGraphicsQueue(), vertices.data(), vertices.size() * layout.GetStride(), layout);
-			m_IndexBuffer = new vulkan::IndexBuffer(vulkanInstance->GetDevice(), vulkanInstance->GetPhysicalDevice(),
-				vulkanInstance->GetCommandPool(), vulkanInstance->GetGraphicsQueue(), indices.data(), size);
+			m_VertexBuffer = new vulkan::VertexBuffer(vulkanInstance->GetDevice(), vulkanInstance->GetMemoryAllocator(),
+				*vulkanInstance->GetUploadContext(), vertices.data(), vertices.size(), layout);
+			m_IndexBuffer = new vulkan::IndexBuffer(vulkanInstance->GetDevice(), vulkanInstance->GetMemoryAllocator(),
+				*vulkanInstance->GetUploadContext(), indices.data(), indices.size() * sizeof(uint32_t));
+			std::vector<float> positions = UnpackPositions(vertices.data(), vertices.size(), layout);
+			const vulkan::BufferLayout positionLayout = { vulkan::_Vec3 };
+			InitDerivedData(vulkanInstance, positions.data(), positions.size() * sizeof(float), positionLayout, indices.data(), indices.size());
 		}
 		else
 		{
@@ -100,32 +166,64 @@ namespace sge
 			auto [vertices, indices] = file::LoadOBJFile(filepath, 6);
 			file::CalculateNormals(vertices, indices);
 			vulkan::BufferLayout vbLayout = { vulkan::_Vec3, vulkan::_Vec3 }; // Hard coded for now
-			m_VertexBuffer = new vulkan::VertexBuffer(vulkanInstance->GetDevice(), vulkanInstance->GetPhysicalDevice(),
-				vulkanInstance->GetCommandPool(), vulkanInstance->GetGraphicsQueue(), vertices.data(), vertices.size() * sizeof(float), vbLayout);
-			m_IndexBuffer = new vulkan::IndexBuffer(vulkanInstance->GetDevice(), vulkanInstance->GetPhysicalDevice(),
-				vulkanInstance->GetCommandPool(), vulkanInstance->GetGraphicsQueue(), indices.data(), indices.size() * sizeof(uint32_t));
+			// Half float positions and octahedral normals, 12 instead of 24 bytes per vertex
+			vulkan::BufferLayout packedLayout = { vulkan::_Half4, vulkan::_OctNormal };
+			std::vector<uint8_t> packedVertices = vbLayout.Pack(vertices.data(), vertices.size() * sizeof(float), packedLayout);
+			m_VertexBuffer = new vulkan::VertexBuffer(vulkanInstance->GetDevice(), vulkanInstance->GetMemoryAllocator(),
+				*vulkanInstance->GetUploadContext(), packedVertices.data(), packedVertices.size(), packedLayout);
+			m_IndexBuffer = new vulkan::IndexBuffer(vulkanInstance->GetDevice(), vulkanInstance->GetMemoryAllocator(),
+				*vulkanInstance->GetUploadContext(), indices.data(), indices.size() * sizeof(uint32_t));
+			InitDerivedData(vulkanInstance, vertices.data(), vertices.size() * sizeof(float), vbLayout, indices.data(), indices.size());
 		}
 	}
 
 	Mesh::Mesh(vulkan::Instance* vulkanInstance, const float* vertices, size_t verticesSize, const uint32_t* indices, size_t indicesSize)
-		: m_VertexBuffer(nullptr), m_IndexBuffer(nullptr)
+		: m_VertexBuffer(nullptr), m_IndexBuffer(nullptr), m_PositionBuffer(nullptr), m_BoundsMin(0.0f), m_BoundsMax(0.0f)
 	{
 		vulkan::BufferLayout vbLayout = { vulkan::_Vec3, vulkan::_Vec2 };
-		m_VertexBuffer = new vulkan::VertexBuffer(vulkanInstance->GetDevice(), vulkanInstance->GetPhysicalDevice(), vulkanInstance->GetCommandPool(),
-			vulkanInstance->GetGraphicsQueue(), vertices, verticesSize, vbLayout);
-		m_IndexBuffer = new vulkan::IndexBuffer(vulkanInstance->GetDevice(), vulkanInstance->GetPhysicalDevice(), vulkanInstance->GetCommandPool(),
-			vulkanInstance->GetGraphicsQueue(), indices, indicesSize);
+		vulkan::BufferLayout packedLayout = { vulkan::_Half4, vulkan::_Half2 };
+		std::vector<uint8_t> packedVertices = vbLayout.Pack(vertices, verticesSize, packedLayout);
+		m_VertexBuffer = new vulkan::VertexBuffer(vulkanInstance->GetDevice(), vulkanInstance->GetMemoryAllocator(), *vulkanInstance->GetUploadContext(),
+			packedVertices.data(), packedVertices.size(), packedLayout);
+		m_IndexBuffer = new vulkan::IndexBuffer(vulkanInstance->GetDevice(), vulkanInstance->GetMemoryAllocator(), *vulkanInstance->GetUploadContext(),
+			indices, indicesSize);
+		InitDerivedData(vulkanInstance, vertices, verticesSize, vbLayout, indices, indicesSize / sizeof(uint32_t));
+	}
+
+	void Mesh::InitDerivedData(vulkan::Instance* vulkanInstance, const float* vertices, size_t verticesSize, const vulkan::BufferLayout& layout,
+		const uint32_t* indices, size_t indexCount)
+	{
+		std::vector<float> positions = layout.ExtractAttribute(vertices, verticesSize, 0);
+
+		m_BoundsMin = glm::vec3(0.0f);
+		m_BoundsMax = glm::vec3(0.0f);
+		for (size_t i = 0; i + 2 < positions.size(); i += 3)
+		{
+			glm::vec3 position(positions[i], positions[i + 1], positions[i + 2]);
+			m_BoundsMin = i == 0 ? position : glm::min(m_BoundsMin, position);
+			m_BoundsMax = i == 0 ? position : glm::max(m_BoundsMax, position);
+		}
+
+		// Quantized the same way as the positions in 'm_VertexBuffer', so both passes produce the same depth
+		const vulkan::BufferLayout floatLayout = { vulkan::_Vec3 };
+		std::vector<uint8_t> packedPositions = floatLayout.Pack(positions.data(), positions.size() * sizeof(float), GetPositionLayout());
+		m_PositionBuffer = new vulkan::VertexBuffer(vulkanInstance->GetDevice(), vulkanInstance->GetMemoryAllocator(), *vulkanInstance->GetUploadContext(),
+			packedPositions.data(), packedPositions.size(), GetPositionLayout());
+
+		m_Meshlets = BuildMeshlets(positions, indices, indexCount);
 	}
 
 	Mesh::~Mesh()
 	{
 		delete m_VertexBuffer;
 		delete m_IndexBuffer;
+		delete m_PositionBuffer;
 	}
 
 	void Mesh::Destroy(vulkan::Instance* vulkanInstance)
 	{
 		m_VertexBuffer->Destroy(vulkanInstance->GetDevice());
 		m_IndexBuffer->Destroy(vulkanInstance->GetDevice());
+		m_PositionBuffer->Destroy(vulkanInstance->GetDevice());
 	}
 } // namespace sge
\ No newline at end of file
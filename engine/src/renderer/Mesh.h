@@ -3,6 +3,9 @@
 #include "vulkan/Instance.h"
 #include "vulkan/Buffer.h"
 #include "vulkan/BufferLayout.h"
+#include "vulkan/OcclusionCuller.h"
+
+#include <glm/vec3.hpp>
 
 #include <string>
 
@@ -18,10 +21,25 @@ namespace sge
 		~Mesh();
 		void Destroy(vulkan::Instance* vulkanInstance);
 		void Serialize(vulkan::Instance* vulkanInstance);
+	public:
+		// Layout of the position-only stream used by the depth prepass
+		static inline vulkan::BufferLayout GetPositionLayout() { return { vulkan::_Half4 }; }
+	private:
+		// Splits the positions out of the interleaved vertices into 'm_PositionBuffer', calculates the bounds and builds
+		// the meshlets. Assumes the position is the first attribute of every vertex.
+		void InitDerivedData(vulkan::Instance* vulkanInstance, const float* vertices, size_t verticesSize, const vulkan::BufferLayout& layout,
+			const uint32_t* indices, size_t indexCount);
 	private:
 		//std::string m_Name;
 		vulkan::VertexBuffer* m_VertexBuffer;
 		vulkan::IndexBuffer* m_IndexBuffer;
+		// Position-only copy of the vertices, used by the depth prepass
+		vulkan::VertexBuffer* m_PositionBuffer;
+		// Local space bounding box, used for culling
+		glm::vec3 m_BoundsMin;
+		glm::vec3 m_BoundsMax;
+		// Ranges of the index buffer with their culling bounds, drawn with one indirect command each
+		std::vector<vulkan::MeshletData> m_Meshlets;
 
 		friend class Renderer;
 		friend class Scene;
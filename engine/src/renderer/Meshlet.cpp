@@ -0,0 +1,116 @@
+#include "Meshlet.h"
+
+#include <glm/geometric.hpp>
+#include <glm/common.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace sge
+{
+	static glm::vec3 GetPosition(const std::vector<float>& positions, uint32_t index)
+	{
+		return glm::vec3(positions[3 * index], positions[3 * index + 1], positions[3 * index + 2]);
+	}
+
+	// Bounding sphere and normal cone of the triangles in [firstIndex, firstIndex + indexCount)
+	static vulkan::MeshletData MakeMeshlet(const std::vector<float>& positions, const uint32_t* indices, uint32_t firstIndex, uint32_t indexCount)
+	{
+		vulkan::MeshletData meshlet = {};
+		meshlet.FirstIndex = firstIndex;
+		meshlet.IndexCount = indexCount;
+
+		glm::vec3 boundsMin = GetPosition(positions, indices[firstIndex]);
+		glm::vec3 boundsMax = boundsMin;
+		for (uint32_t i = firstIndex; i < firstIndex + indexCount; i++)
+		{
+			glm::vec3 position = GetPosition(positions, indices[i]);
+			boundsMin = glm::min(boundsMin, position);
+			boundsMax = glm::max(boundsMax, position);
+		}
+
+		glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+		float radius = 0.0f;
+		for (uint32_t i = firstIndex; i < firstIndex + indexCount; i++)
+			radius = std::max(radius, glm::length(GetPosition(positions, indices[i]) - center));
+		meshlet.Sphere = glm::vec4(center, radius);
+
+		// Front faces are clockwise on screen, which makes this cross product point out of the front face
+		std::vector<glm::vec3> normals;
+		normals.reserve(indexCount / 3);
+		glm::vec3 normalSum(0.0f);
+		for (uint32_t i = firstIndex; i + 2 < firstIndex + indexCount; i += 3)
+		{
+			glm::vec3 a = GetPosition(positions, indices[i]);
+			glm::vec3 b = GetPosition(positions, indices[i + 1]);
+			glm::vec3 c = GetPosition(positions, indices[i + 2]);
+			glm::vec3 normal = glm::cross(c - a, b - a);
+
+			float length = glm::length(normal);
+			if (length == 0.0f)
+				continue;
+
+			normals.push_back(normal / length);
+			normalSum += normal / length;
+		}
+
+		// A cutoff of 1 never culls
+		meshlet.Cone = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+		float sumLength = glm::length(normalSum);
+		if (sumLength == 0.0f)
+			return meshlet;
+
+		glm::vec3 axis = normalSum / sumLength;
+		float minDot = 1.0f;
+		for (const glm::vec3& normal : normals)
+			minDot = std::min(minDot, glm::dot(axis, normal));
+
+		// Normals spread over more than a hemisphere, some triangle always faces the camera
+		if (minDot <= 0.0f)
+			return meshlet;
+
+		meshlet.Cone = glm::vec4(axis, std::sqrt(1.0f - minDot * minDot));
+		return meshlet;
+	}
+
+	std::vector<vulkan::MeshletData> BuildMeshlets(const std::vector<float>& positions, const uint32_t* indices, size_t indexCount)
+	{
+		std::vector<vulkan::MeshletData> meshlets;
+		if (indexCount < 3)
+			return meshlets;
+
+		// Index of the last meshlet that used each vertex, to count the unique vertices of the current one
+		std::vector<uint32_t> vertexMeshlets(positions.size() / 3, UINT32_MAX);
+		uint32_t vertexCount = 0;
+		uint32_t firstIndex = 0;
+		const uint32_t triangleIndexCount = static_cast<uint32_t>(indexCount - indexCount % 3);
+
+		for (uint32_t i = 0; i < triangleIndexCount; i += 3)
+		{
+			uint32_t meshletIndex = static_cast<uint32_t>(meshlets.size());
+			uint32_t newVertices = 0;
+			for (uint32_t j = 0; j < 3; j++)
+				newVertices += vertexMeshlets[indices[i + j]] != meshletIndex;
+
+			if (vertexCount + newVertices > MESHLET_MAX_VERTICES || (i - firstIndex) / 3 == MESHLET_MAX_TRIANGLES)
+			{
+				meshlets.push_back(MakeMeshlet(positions, indices, firstIndex, i - firstIndex));
+				meshletIndex++;
+				firstIndex = i;
+				vertexCount = 0;
+			}
+
+			for (uint32_t j = 0; j < 3; j++)
+			{
+				if (vertexMeshlets[indices[i + j]] != meshletIndex)
+				{
+					vertexMeshlets[indices[i + j]] = meshletIndex;
+					vertexCount++;
+				}
+			}
+		}
+
+		meshlets.push_back(MakeMeshlet(positions, indices, firstIndex, triangleIndexCount - firstIndex));
+		return meshlets;
+	}
+} // namespace sge
\ No newline at end of file
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "vulkan/OcclusionCuller.h"
+
+#include <vector>
+
+namespace sge
+{
+	constexpr uint32_t MESHLET_MAX_VERTICES = 64;
+	constexpr uint32_t MESHLET_MAX_TRIANGLES = 124;
+
+	// Splits a triangle list into meshlets of consecutive triangles, so every meshlet is a range of the index buffer and
+	// the indices do not need to be reordered. 'positions' holds three floats per vertex. The object index of the
+	// returned meshlets is left at 0.
+	std::vector<vulkan::MeshletData> BuildMeshlets(const std::vector<float>& positions, const uint32_t* indices, size_t indexCount);
+} // namespace sge
\ No newline at end of file
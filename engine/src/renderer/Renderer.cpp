@@ -2,46 +2,386 @@
 #include "vulkan/Pipeline.h"
 
 #include <imgui/backends/imgui_impl_vulkan.h>
+#include <glm/matrix.hpp>
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
 
 namespace sge
 {
-	Renderer::Renderer(vulkan::Instance* vulkanInstance)
-		: m_VulkanInstance(vulkanInstance)
+	Renderer::Renderer(vulkan::Instance* vulkanInstance, const RendererSpec& spec)
+		: m_Spec(spec), m_VulkanInstance(vulkanInstance), m_DepthShader(nullptr), m_DepthPipelineIndex(vulkan::INVALID_PIPELINE), m_OcclusionCuller(nullptr), m_LightClusterer(nullptr), m_TextureStreamer(nullptr), m_Backbuffer(vulkan::INVALID_RESOURCE), m_Depth(vulkan::INVALID_RESOURCE),
+		m_DepthPyramid(vulkan::INVALID_RESOURCE), m_EarlyDraws(vulkan::INVALID_RESOURCE), m_LateDraws(vulkan::INVALID_RESOURCE),
+		m_EarlyMeshletDraws(vulkan::INVALID_RESOURCE), m_LateMeshletDraws(vulkan::INVALID_RESOURCE),
+		m_Visibility(vulkan::INVALID_RESOURCE), m_LightGrid(vulkan::INVALID_RESOURCE), m_SwapchainVersion(vulkanInstance->GetSwapchainVersion()),
+		m_View(1.0f), m_Projection(1.0f), m_NearPlane(0.1f), m_FarPlane(10.0f), m_ViewProjection(1.0f), m_PreviousViewProjection(1.0f), m_Scene(nullptr), m_ImageIndex(0)
+	{
+		m_OcclusionCuller = new vulkan::OcclusionCuller(m_VulkanInstance->GetDevice(), m_VulkanInstance->GetMemoryAllocator(),
+			m_VulkanInstance->GetDescriptorAllocator(), m_VulkanInstance->GetCommandPool(), m_VulkanInstance->GetGraphicsQueue(), m_VulkanInstance->GetPipelineCache(),
+			m_VulkanInstance->GetDepthImageView(), m_VulkanInstance->GetSwapchainExtent(), "E:/C++/sigma-engine/engine/shaders");
+		m_LightClusterer = new vulkan::LightClusterer(m_VulkanInstance->GetDevice(), m_VulkanInstance->GetMemoryAllocator(),
+			m_VulkanInstance->GetDescriptorAllocator(), m_VulkanInstance->GetPipelineCache(), "E:/C++/sigma-engine/engine/shaders");
+		if (m_VulkanInstance->IsTextureStreamingEnabled())
+			m_TextureStreamer = new TextureStreamer(m_VulkanInstance);
+
+		InitRenderGraph();
+	}
+
+	Renderer::~Renderer()
 	{
+		vkDeviceWaitIdle(m_VulkanInstance->GetDevice());
+		m_RenderGraph.Destroy(m_VulkanInstance->GetDevice());
+		m_OcclusionCuller->Destroy(m_VulkanInstance->GetDevice());
+		delete m_OcclusionCuller;
+		m_LightClusterer->Destroy(m_VulkanInstance->GetDevice());
+		delete m_LightClusterer;
+		if (m_TextureStreamer)
+		{
+			m_TextureStreamer->Destroy();
+			delete m_TextureStreamer;
+		}
+
+		if (m_DepthShader)
+		{
+			m_DepthShader->Destroy(m_VulkanInstance->GetDevice());
+			delete m_DepthShader;
+		}
+	}
+
+	void Renderer::InitPipelines(Scene& scene)
+	{
+		vulkan::PipelineState mainState;
+		if (m_Spec.DepthPrepass)
+		{
+			m_DepthShader = new vulkan::Shader(m_VulkanInstance->GetDevice(),
+				"E:/C++/sigma-engine/engine/shaders/depth.vert.spv", "E:/C++/sigma-engine/engine/shaders/depth.frag.spv");
+
+			const vulkan::BufferLayout positionLayout = Mesh::GetPositionLayout();
+			vulkan::PipelineState depthState;
+			depthState.ColorWrite = VK_FALSE;
+			// Without the depth pipeline, shading would run with an EQUAL test against a cleared depth buffer and draw nothing,
+			// so it is compiled right away
+			m_DepthPipelineIndex = m_VulkanInstance->CreateFallbackPipeline(m_DepthShader, &positionLayout, depthState);
+
+			// Depth is complete after the prepass, the shading pass only keeps the fragments that wrote it
+			mainState.DepthCompareOp = VK_COMPARE_OP_EQUAL;
+			mainState.DepthWrite = VK_FALSE;
+		}
+
+		scene.InitPipelines(m_VulkanInstance, mainState);
+	}
+
+	void Renderer::InitRenderGraph()
+	{
+		VkFormat depthFormat = vulkan::FindDepthFormat(m_VulkanInstance->GetPhysicalDevice());
+		VkImageAspectFlags depthAspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+		if (vulkan::HasStencilComponent(depthFormat))
+			depthAspect |= VK_IMAGE_ASPECT_STENCIL_BIT;
+
+		// The swap chain image changes every frame, see 'BeginFrame'. Headless images are copied from instead of presented.
+		vulkan::ResourceUsage backbufferUsage = m_VulkanInstance->IsHeadless() ? vulkan::ResourceUsage::TransferSrc : vulkan::ResourceUsage::Present;
+		m_Backbuffer = m_RenderGraph.ImportImage("Backbuffer", m_VulkanInstance->GetSwapchainImage(0),
+			m_VulkanInstance->GetSwapchainImageView(0), VK_IMAGE_ASPECT_COLOR_BIT, vulkan::ResourceUsage::None, backbufferUsage);
+		// The depth image is shared by all frames in flight, so it is left as an attachment for the next frame to wait on
+		m_Depth = m_RenderGraph.ImportImage("Depth", m_VulkanInstance->GetDepthImage(), m_VulkanInstance->GetDepthImageView(),
+			depthAspect, vulkan::ResourceUsage::None, vulkan::ResourceUsage::DepthAttachment);
+
+		// The depth pyramid keeps its contents between frames, the next frame's early cull phase reads it
+		m_DepthPyramid = m_RenderGraph.ImportImage("DepthPyramid", m_OcclusionCuller->GetDepthPyramid(), m_OcclusionCuller->GetDepthPyramidView(),
+			VK_IMAGE_ASPECT_COLOR_BIT, vulkan::ResourceUsage::SampledCompute, vulkan::ResourceUsage::SampledCompute);
+		m_EarlyDraws = m_RenderGraph.ImportBuffer("EarlyDraws", m_OcclusionCuller->GetDrawBuffer(vulkan::CullPhase::Early),
+			vulkan::ResourceUsage::None, vulkan::ResourceUsage::None);
+		m_LateDraws = m_RenderGraph.ImportBuffer("LateDraws", m_OcclusionCuller->GetDrawBuffer(vulkan::CullPhase::Late),
+			vulkan::ResourceUsage::None, vulkan::ResourceUsage::None);
+		m_EarlyMeshletDraws = m_RenderGraph.ImportBuffer("EarlyMeshletDraws", m_OcclusionCuller->GetMeshletDrawBuffer(vulkan::CullPhase::Early),
+			vulkan::ResourceUsage::None, vulkan::ResourceUsage::None);
+		m_LateMeshletDraws = m_RenderGraph.ImportBuffer("LateMeshletDraws", m_OcclusionCuller->GetMeshletDrawBuffer(vulkan::CullPhase::Late),
+			vulkan::ResourceUsage::None, vulkan::ResourceUsage::None);
+		m_Visibility = m_RenderGraph.ImportBuffer("Visibility", m_OcclusionCuller->GetVisibilityBuffer(),
+			vulkan::ResourceUsage::None, vulkan::ResourceUsage::None);
+		m_LightGrid = m_RenderGraph.ImportBuffer("LightGrid", m_LightClusterer->GetLightGrid()->GetBufferHandle(),
+			vulkan::ResourceUsage::None, vulkan::ResourceUsage::None);
+
+		// Assigns the lights to the clusters the shading passes read
+		m_RenderGraph.AddPass("LightAssign",
+		[this](vulkan::PassBuilder& builder)
+		{
+			builder.Write(m_LightGrid, vulkan::ResourceUsage::StorageWriteCompute);
+		},
+		[this](VkCommandBuffer commandBuffer)
+		{
+			m_LightClusterer->RecordAssign(commandBuffer, m_VulkanInstance->GetCurrentFrame());
+		});
+
+		// Objects that were visible in the previous frame's depth pyramid, then the meshlets of those objects
+		m_RenderGraph.AddPass("EarlyCull",
+		[this](vulkan::PassBuilder& builder)
+		{
+			builder.Read(m_DepthPyramid, vulkan::ResourceUsage::SampledCompute);
+			builder.Write(m_EarlyDraws, vulkan::ResourceUsage::StorageWriteCompute);
+			builder.Write(m_EarlyMeshletDraws, vulkan::ResourceUsage::StorageWriteCompute);
+			builder.Write(m_Visibility, vulkan::ResourceUsage::StorageWriteCompute);
+		},
+		[this](VkCommandBuffer commandBuffer)
+		{
+			m_OcclusionCuller->RecordCull(commandBuffer, m_VulkanInstance->GetCurrentFrame(), vulkan::CullPhase::Early);
+		});
+
+		m_RenderGraph.AddPass("Main",
+		[this](vulkan::PassBuilder& builder)
+		{
+			builder.Read(m_EarlyMeshletDraws, vulkan::ResourceUsage::IndirectRead);
+			builder.Read(m_LightGrid, vulkan::ResourceUsage::StorageReadGraphics);
+			builder.Write(m_Backbuffer, vulkan::ResourceUsage::ColorAttachment);
+			builder.Write(m_Depth, vulkan::ResourceUsage::DepthAttachment);
+		},
+		[this](VkCommandBuffer commandBuffer)
+		{
+			m_VulkanInstance->BeginRenderPass(commandBuffer, m_ImageIndex);
+			// Rasterization order makes the prepass draws complete before the shading draws in the same subpass
+			if (m_Spec.DepthPrepass)
+				DrawDepth(*m_Scene, vulkan::CullPhase::Early);
+			DrawDrawables(*m_Scene, vulkan::CullPhase::Early);
+			m_VulkanInstance->EndRenderPass(commandBuffer);
+		});
+
+		m_RenderGraph.AddPass("BuildDepthPyramid",
+		[this](vulkan::PassBuilder& builder)
+		{
+			builder.Read(m_Depth, vulkan::ResourceUsage::SampledCompute);
+			builder.Write(m_DepthPyramid, vulkan::ResourceUsage::StorageWriteCompute);
+		},
+		[this](VkCommandBuffer commandBuffer)
+		{
+			m_OcclusionCuller->RecordBuildPyramid(m_VulkanInstance->GetDevice(), commandBuffer, m_VulkanInstance->GetFrameDescriptorAllocator());
+		});
+
+		// Objects the early phase rejected, tested against this frame's depth
+		m_RenderGraph.AddPass("LateCull",
+		[this](vulkan::PassBuilder& builder)
+		{
+			builder.Read(m_DepthPyramid, vulkan::ResourceUsage::SampledCompute);
+			builder.Read(m_Visibility, vulkan::ResourceUsage::StorageReadCompute);
+			builder.Write(m_LateDraws, vulkan::ResourceUsage::StorageWriteCompute);
+			builder.Write(m_LateMeshletDraws, vulkan::ResourceUsage::StorageWriteCompute);
+		},
+		[this](VkCommandBuffer commandBuffer)
+		{
+			m_OcclusionCuller->RecordCull(commandBuffer, m_VulkanInstance->GetCurrentFrame(), vulkan::CullPhase::Late);
+		});
+
+		m_RenderGraph.AddPass("Late",
+		[this](vulkan::PassBuilder& builder)
+		{
+			builder.Read(m_LateMeshletDraws, vulkan::ResourceUsage::IndirectRead);
+			builder.Read(m_LightGrid, vulkan::ResourceUsage::StorageReadGraphics);
+			builder.Write(m_Backbuffer, vulkan::ResourceUsage::ColorAttachment);
+			builder.Write(m_Depth, vulkan::ResourceUsage::DepthAttachment);
+		},
+		[this](VkCommandBuffer commandBuffer)
+		{
+			m_VulkanInstance->BeginRenderPass(commandBuffer, m_ImageIndex, false);
+
+			if (m_Spec.DepthPrepass)
+				DrawDepth(*m_Scene, vulkan::CullPhase::Late);
+			DrawDrawables(*m_Scene, vulkan::CullPhase::Late);
+
+			// ImGui, not used in headless mode
+			if (ImGui::GetCurrentContext())
+			{
+				ImGui::Render();
+				ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), commandBuffer);
+			}
+
+			m_VulkanInstance->EndRenderPass(commandBuffer);
+		});
+
+		// The late phase added depth the pyramid above does not have, the next frame's early phase tests against all of it
+		m_RenderGraph.AddPass("RebuildDepthPyramid",
+		[this](vulkan::PassBuilder& builder)
+		{
+			builder.Read(m_Depth, vulkan::ResourceUsage::SampledCompute);
+			builder.Write(m_DepthPyramid, vulkan::ResourceUsage::StorageWriteCompute);
+		},
+		[this](VkCommandBuffer commandBuffer)
+		{
+			m_OcclusionCuller->RecordBuildPyramid(m_VulkanInstance->GetDevice(), commandBuffer, m_VulkanInstance->GetFrameDescriptorAllocator());
+		});
+
+		m_RenderGraph.Compile(m_VulkanInstance->GetDevice(), m_VulkanInstance->GetMemoryAllocator(), m_VulkanInstance->GetSwapchainExtent());
 	}
 
 	uint32_t Renderer::BeginFrame()
 	{
+		m_VulkanInstance->UpdatePipelines();
+		m_VulkanInstance->GetUploadContext()->BeginFrame();
+		m_VulkanInstance->UpdateTextureLoads();
+
+		// The swap chain is recreated when it is out of date, after which acquiring is retried
 		uint32_t imageIndex = m_VulkanInstance->AcquireNextSwapchainImage();
+		while (imageIndex == UINT_MAX)
+			imageIndex = m_VulkanInstance->AcquireNextSwapchainImage();
 
-		if (imageIndex == UINT_MAX)
-			SGE_DEBUG_BREAKM("Swapchain needs to be recreated.");
+		// The depth image, the depth pyramid and transient images depend on the swap chain extent. Recreating the swap chain
+		// waited for the device to be idle.
+		if (m_SwapchainVersion != m_VulkanInstance->GetSwapchainVersion())
+		{
+			m_SwapchainVersion = m_VulkanInstance->GetSwapchainVersion();
+			m_RenderGraph.SetImportedImage(m_Depth, m_VulkanInstance->GetDepthImage(), m_VulkanInstance->GetDepthImageView());
+			m_OcclusionCuller->Resize(m_VulkanInstance->GetDevice(), m_VulkanInstance->GetCommandPool(), m_VulkanInstance->GetGraphicsQueue(),
+				m_VulkanInstance->GetDepthImageView(), m_VulkanInstance->GetSwapchainExtent());
+			m_RenderGraph.SetImportedImage(m_DepthPyramid, m_OcclusionCuller->GetDepthPyramid(), m_OcclusionCuller->GetDepthPyramidView());
+			m_RenderGraph.Compile(m_VulkanInstance->GetDevice(), m_VulkanInstance->GetMemoryAllocator(), m_VulkanInstance->GetSwapchainExtent());
+		}
 		
-		VkCommandBuffer commandBuffer = m_VulkanInstance->GetCurrentCommandBuffer();
+		m_VulkanInstance->BeginCommandBuffer(m_VulkanInstance->GetCurrentCommandBuffer());
+		// The frame's fence was waited on while acquiring, so the profiler can read this frame's previous results
+		m_VulkanInstance->GetGpuProfiler()->BeginFrame(m_VulkanInstance->GetDevice(), m_VulkanInstance->GetCurrentCommandBuffer(),
+			m_VulkanInstance->GetCurrentFrame());
+
+		// Moved buffers are copied before anything of this frame draws with them
+		vulkan::MemoryAllocator* allocator = m_VulkanInstance->GetMemoryAllocator();
+		allocator->BeginFrame(m_VulkanInstance->GetDevice());
+		if (m_Spec.DefragmentBudget > 0)
+			allocator->Defragment(m_VulkanInstance->GetDevice(), m_VulkanInstance->GetCurrentCommandBuffer(), m_Spec.DefragmentBudget);
 
-		m_VulkanInstance->BeginRenderPass(commandBuffer, imageIndex);
+		m_ImageIndex = imageIndex;
+		m_RenderGraph.SetImportedImage(m_Backbuffer, m_VulkanInstance->GetSwapchainImage(imageIndex),
+			m_VulkanInstance->GetSwapchainImageView(imageIndex));
 
 		return imageIndex;
 	}
 	
 	void Renderer::EndFrame(uint32_t imageIndex)
 	{
-		m_VulkanInstance->EndRenderPass(m_VulkanInstance->GetCurrentCommandBuffer());
-
-		// ImGui
-		ImGui::Render();
-		ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), m_VulkanInstance->GetCurrentCommandBuffer());
+		m_VulkanInstance->EndCommandBuffer(m_VulkanInstance->GetCurrentCommandBuffer());
 
 		m_VulkanInstance->Present(&imageIndex);
 	}
 
+	void Renderer::SetCamera(const glm::mat4& view, const glm::mat4& projection, float zNear, float zFar)
+	{
+		m_View = view;
+		m_Projection = projection;
+		m_NearPlane = zNear;
+		m_FarPlane = zFar;
+		m_ViewProjection = projection * view;
+	}
+
 	void Renderer::DrawScene(Scene& scene)
 	{
+		// Object and meshlet indices follow the registry order, which 'DrawDrawables' iterates in as well
+		m_Objects.clear();
+		m_Meshlets.clear();
 		scene.m_Registry.ForEach<DrawableComponent>(
 		[this](DrawableComponent* drawableComp)
 		{
-			DrawMesh(drawableComp->Mesh, drawableComp->Material, 1);
+			for (vulkan::MeshletData meshlet : drawableComp->Mesh.m_Meshlets)
+			{
+				meshlet.ObjectIndex = static_cast<uint32_t>(m_Objects.size());
+				m_Meshlets.push_back(meshlet);
+			}
+
+			vulkan::ObjectData object = {};
+			object.Model = drawableComp->Transform;
+			object.BoundsMin = glm::vec4(drawableComp->Mesh.m_BoundsMin, 1.0f);
+			object.BoundsMax = glm::vec4(drawableComp->Mesh.m_BoundsMax, 1.0f);
+			object.IndexCount = drawableComp->Mesh.m_IndexBuffer->GetCount();
+			object.MaterialIndex = drawableComp->Material.m_MaterialIndex;
+			m_Objects.push_back(object);
+
+			if (m_TextureStreamer)
+				RequestTextureMips(*drawableComp);
 		});
+
+		// The new images are written to this frame's texture table before any draw of the frame is recorded
+		if (m_TextureStreamer)
+			m_TextureStreamer->Update();
+		m_VulkanInstance->UpdateTextureTable();
+
+		m_OcclusionCuller->Update(m_VulkanInstance->GetDevice(), m_VulkanInstance->GetCurrentFrame(), m_Objects, m_Meshlets,
+			m_ViewProjection, m_PreviousViewProjection, glm::vec3(glm::inverse(m_View)[3]));
+
+		m_VulkanInstance->GetMaterialTable()->Update(m_VulkanInstance->GetDevice(), m_VulkanInstance->GetCurrentFrame());
+
+		m_Lights.clear();
+		scene.m_Registry.ForEach<PointLightComponent>(
+		[this](PointLightComponent* lightComp)
+		{
+			vulkan::PointLightData light = {};
+			light.Position = lightComp->Position;
+			light.Radius = lightComp->Radius;
+			light.Color = lightComp->Color;
+			light.Intensity = lightComp->Intensity;
+			m_Lights.push_back(light);
+		});
+
+		m_LightClusterer->Update(m_VulkanInstance->GetDevice(), m_VulkanInstance->GetCurrentFrame(), m_Lights, m_View, m_Projection,
+			m_NearPlane, m_FarPlane, m_VulkanInstance->GetSwapchainExtent());
+
+		m_Scene = &scene;
+		m_RenderGraph.Execute(m_VulkanInstance->GetCurrentCommandBuffer(), m_VulkanInstance->GetGpuProfiler());
+		m_Scene = nullptr;
+
+		m_PreviousViewProjection = m_ViewProjection;
+	}
+
+	void Renderer::DrawDrawables(Scene& scene, vulkan::CullPhase phase)
+	{
+		VkBuffer drawBuffer = m_OcclusionCuller->GetMeshletDrawBuffer(phase);
+		VkDeviceSize offset = 0;
+
+		scene.m_Registry.ForEach<DrawableComponent>(
+		[this, drawBuffer, &offset](DrawableComponent* drawableComp)
+		{
+			uint32_t meshletCount = static_cast<uint32_t>(drawableComp->Mesh.m_Meshlets.size());
+			m_VulkanInstance->DrawIndexedIndirect(m_VulkanInstance->GetCurrentCommandBuffer(), drawableComp->Material.m_PipelineIndex,
+				drawableComp->Mesh.m_VertexBuffer, drawableComp->Mesh.m_IndexBuffer, drawBuffer, offset, meshletCount);
+			offset += meshletCount * sizeof(VkDrawIndexedIndirectCommand);
+		});
+	}
+
+	void Renderer::DrawDepth(Scene& scene, vulkan::CullPhase phase)
+	{
+		VkBuffer drawBuffer = m_OcclusionCuller->GetMeshletDrawBuffer(phase);
+		VkDeviceSize offset = 0;
+
+		scene.m_Registry.ForEach<DrawableComponent>(
+		[this, drawBuffer, &offset](DrawableComponent* drawableComp)
+		{
+			uint32_t meshletCount = static_cast<uint32_t>(drawableComp->Mesh.m_Meshlets.size());
+			m_VulkanInstance->DrawIndexedIndirect(m_VulkanInstance->GetCurrentCommandBuffer(), m_DepthPipelineIndex,
+				drawableComp->Mesh.m_PositionBuffer, drawableComp->Mesh.m_IndexBuffer, drawBuffer, offset, meshletCount);
+			offset += meshletCount * sizeof(VkDrawIndexedIndirectCommand);
+		});
+	}
+
+	void Renderer::RequestTextureMips(const DrawableComponent& drawable)
+	{
+		// Bounding sphere of the drawable in world space
+		const glm::mat4& transform = drawable.Transform;
+		glm::vec3 center = transform * glm::vec4(0.5f * (drawable.Mesh.m_BoundsMin + drawable.Mesh.m_BoundsMax), 1.0f);
+		float scale = std::max({ glm::length(glm::vec3(transform[0])), glm::length(glm::vec3(transform[1])),
+			glm::length(glm::vec3(transform[2])) });
+		float radius = 0.5f * glm::length(drawable.Mesh.m_BoundsMax - drawable.Mesh.m_BoundsMin) * scale;
+
+		// Projected diameter in pixels, the texture is assumed to be mapped once across the mesh
+		float distance = glm::length(center - glm::vec3(glm::inverse(m_View)[3]));
+		float pixels = FLT_MAX;
+		if (distance > radius)
+			pixels = radius * m_Projection[1][1] * m_VulkanInstance->GetSwapchainExtent().height / distance;
+
+		for (vulkan::Texture* texture : { drawable.Material.m_Albedo, drawable.Material.m_NormalMap })
+		{
+			if (!texture)
+				continue;
+
+			float texels = static_cast<float>(std::max(texture->GetWidth(), texture->GetHeight()));
+			uint32_t mip = texels > pixels ? static_cast<uint32_t>(std::floor(std::log2(texels / pixels))) : 0;
+			m_TextureStreamer->Request(texture, std::min(mip, texture->GetMipCount() - 1));
+		}
 	}
 
 	void Renderer::DrawMesh(const Mesh& mesh, const Material& material, uint32_t instanceCount)
@@ -1,24 +1,90 @@
 #pragma once
 
 #include "vulkan/Instance.h"
+#include "vulkan/RenderGraph.h"
+#include "vulkan/OcclusionCuller.h"
+#include "vulkan/LightClusterer.h"
 #include "Scene.h"
 #include "Mesh.h"
 #include "Material.h"
+#include "TextureStreamer.h"
+
+#include <glm/mat4x4.hpp>
 
 namespace sge
 {
+	struct RendererSpec
+	{
+		// Lay down depth with a position-only pass first, so the shading pass runs each pixel's fragment shader once
+		bool DepthPrepass = false;
+		// Bytes of vertex and index buffers moved per frame to empty sparsely used memory blocks, 0 disables defragmentation
+		VkDeviceSize DefragmentBudget = 4ull << 20;
+	};
+
 	class Renderer
 	{
 	public:
-		Renderer(vulkan::Instance* vulkanInstance);
-		~Renderer() {}
+		Renderer(vulkan::Instance* vulkanInstance, const RendererSpec& spec = {});
+		~Renderer();
+		// Creates the renderer's own pipelines and the scene's material pipelines, call after 'Scene::InitDescriptorSets'
+		void InitPipelines(Scene& scene);
 
 		uint32_t BeginFrame();
 		void EndFrame(uint32_t imageIndex);
 
+		// Camera used for culling and light clustering, set before 'DrawScene'
+		void SetCamera(const glm::mat4& view, const glm::mat4& projection, float zNear, float zFar);
 		void DrawScene(Scene& scene);
+		// Not culled, instance 'i' uses the transform of object 'i' in the current frame
 		void DrawMesh(const Mesh& mesh, const Material& material, uint32_t instanceCount);
+	public:
+		// Per-frame object data, bound to the scene's descriptor sets
+		inline const vulkan::FrameGroup<vulkan::StorageBuffer*>& GetObjectBuffers() const { return m_OcclusionCuller->GetObjectBuffers(); }
+		// Lights and light grid, bound to the scene's descriptor sets
+		inline const vulkan::LightClusterer& GetLightClusterer() const { return *m_LightClusterer; }
+	private:
+		void InitRenderGraph();
+		// Draws the meshlets of every drawable with their commands in the culler's meshlet draw buffer for 'phase'
+		void DrawDrawables(Scene& scene, vulkan::CullPhase phase);
+		// Same draws as 'DrawDrawables', depth only with the meshes' position streams
+		void DrawDepth(Scene& scene, vulkan::CullPhase phase);
+		// Requests the mips of the drawable's textures that match its size on screen
+		void RequestTextureMips(const DrawableComponent& drawable);
 	private:
+		RendererSpec m_Spec;
 		vulkan::Instance* m_VulkanInstance;
+		vulkan::Shader* m_DepthShader;
+		uint32_t m_DepthPipelineIndex;
+		vulkan::OcclusionCuller* m_OcclusionCuller;
+		vulkan::LightClusterer* m_LightClusterer;
+		// Null unless texture streaming is enabled on the instance
+		TextureStreamer* m_TextureStreamer;
+		vulkan::RenderGraph m_RenderGraph;
+		vulkan::ResourceID m_Backbuffer;
+		vulkan::ResourceID m_Depth;
+		vulkan::ResourceID m_DepthPyramid;
+		vulkan::ResourceID m_EarlyDraws;
+		vulkan::ResourceID m_LateDraws;
+		vulkan::ResourceID m_EarlyMeshletDraws;
+		vulkan::ResourceID m_LateMeshletDraws;
+		vulkan::ResourceID m_Visibility;
+		vulkan::ResourceID m_LightGrid;
+		// Swap chain version the graph was compiled for
+		uint32_t m_SwapchainVersion;
+
+		glm::mat4 m_View;
+		glm::mat4 m_Projection;
+		float m_NearPlane;
+		float m_FarPlane;
+		glm::mat4 m_ViewProjection;
+		// Camera of the last drawn frame, which built the depth pyramid the early cull phase reads
+		glm::mat4 m_PreviousViewProjection;
+		std::vector<vulkan::ObjectData> m_Objects;
+		std::vector<vulkan::MeshletData> m_Meshlets;
+		std::vector<vulkan::PointLightData> m_Lights;
+
+		// Valid while the graph is being executed
+		Scene* m_Scene;
+		uint32_t m_ImageIndex;
 	};
 } // namespace sge
\ No newline at end of file
@@ -1,7 +1,7 @@
 #include "Scene.h"
 
-#include <list>
-#include <unordered_set>
+#include <cstdlib>
+#include <vector>
 
 namespace sge
 {
@@ -28,6 +28,21 @@ namespace sge
 		return entity;
 	}
 
+	ecs::EntityID Scene::AddPointLight(const glm::vec3& position, const glm::vec3& color, float radius, float intensity)
+	{
+		ecs::EntityID entity = m_Registry.NewEntityID();
+		m_Registry.AddComponent<PointLightComponent>(entity, position, color, radius, intensity);
+
+		return entity;
+	}
+
+	void Scene::SetTransform(ecs::EntityID entity, const glm::mat4& transform)
+	{
+		DrawableComponent* drawableComp = m_Registry.GetComponent<DrawableComponent>(entity);
+		SGE_ASSERTM(drawableComp, "Entity is not drawable.");
+		drawableComp->Transform = transform;
+	}
+
 	void Scene::Destroy(vulkan::Instance* vulkanInstance)
 	{
 		m_Registry.ForEach<DrawableComponent>(
@@ -38,79 +53,73 @@ namespace sge
 		});
 	}
 
-	void Scene::InitDescriptorSets(vulkan::Instance* vulkanInstance, vulkan::FrameGroup<vulkan::UniformBuffer*>& uniformBuffers)
+	void Scene::InitDescriptorSets(vulkan::Instance* vulkanInstance, vulkan::FrameGroup<vulkan::UniformBuffer*>& uniformBuffers,
+		const vulkan::FrameGroup<vulkan::StorageBuffer*>& objectBuffers, const vulkan::LightClusterer& lightClusterer)
 	{
-		std::vector<VkDescriptorSetLayoutBinding> bindings;
-		vulkanInstance->AddLayoutBindingUniformBuffer(bindings);
-
-		// Record which descriptors have already been created
-		std::unordered_set<void*> assets;
-
+		// Textures live in the bindless texture table, so the per-frame set only holds the uniform buffer, the object data,
+		// the clustered lights and the material table. Its layout is the union of what the materials' shaders declare.
+		vulkan::ShaderReflection reflection;
 		m_Registry.ForEach<DrawableComponent>(
-		[&](DrawableComponent* drawableComp)
+		[&reflection](DrawableComponent* drawableComp)
 		{
-			if (drawableComp->Material.m_Albedo && !assets.contains(drawableComp->Material.m_Albedo))
-			{
-				vulkanInstance->AddLayoutBindingTexture(bindings);
-				assets.insert(drawableComp->Material.m_Albedo);
-			}
-
-			if (drawableComp->Material.m_NormalMap && !assets.contains(drawableComp->Material.m_NormalMap))
-			{
-				vulkanInstance->AddLayoutBindingTexture(bindings);
-				assets.insert(drawableComp->Material.m_NormalMap);
-			}
+			reflection.Merge(drawableComp->Material.m_Shader->GetReflection());
 		});
+		const auto& bindings = reflection.Sets[vulkan::DESCRIPTOR_SET_FRAME];
 
 		vulkanInstance->AllocateDescriptorSets(bindings);
 
-		for (uint32_t frameIndex = 0; frameIndex < vulkan::MAX_FRAMES_IN_FLIGHT; frameIndex++)
+		// The descriptor type of every binding the scene provides, indexed by binding number, see 'culling.glsl', 'lighting.glsl'
+		// and 'material.glsl'. A binding the scene cannot fill would be read uninitialized, so it is a hard error in every build.
+		constexpr VkDescriptorType providedTypes[] = {
+			VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+			VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+			VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+			VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+			VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+			VK_DESCRIPTOR_TYPE_STORAGE_BUFFER
+		};
+		for (const auto& binding : bindings)
 		{
-			std::vector<VkWriteDescriptorSet> descriptorWrites;
-
-			// Use list to prevent image and buffer info from being freed too early
-			std::list<void*> infos;
-			
-			auto bufferInfo = vulkanInstance->GetBufferInfo(uniformBuffers[frameIndex]);
-			infos.push_back(bufferInfo);
-			vulkanInstance->AddDescriptorWrite(descriptorWrites, bufferInfo, frameIndex);
-
-			m_Registry.ForEach<DrawableComponent>(
-			[&](void* comp)
+			if (binding.binding >= std::size(providedTypes) || binding.descriptorType != providedTypes[binding.binding]
+				|| binding.descriptorCount != 1)
 			{
-				auto drawableComp = reinterpret_cast<DrawableComponent*>(comp);
-				
-				if (drawableComp->Material.m_Albedo)
-				{
-					auto albedoInfo = vulkanInstance->GetImageInfo(drawableComp->Material.m_Albedo);
-					infos.push_back(albedoInfo);
-					vulkanInstance->AddDescriptorWrite(descriptorWrites, albedoInfo, frameIndex);
-				}
-
-				if (drawableComp->Material.m_NormalMap)
-				{
-					auto normalMapInfo = vulkanInstance->GetImageInfo(drawableComp->Material.m_NormalMap);
-					infos.push_back(normalMapInfo);
-					vulkanInstance->AddDescriptorWrite(descriptorWrites, normalMapInfo, frameIndex);
-				}
-			});
-			
-			if (!descriptorWrites.empty())
-				vkUpdateDescriptorSets(vulkanInstance->GetDevice(), static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+				SGE_ERRORF("Shaders declare frame descriptor set binding %u, which the scene does not provide.", binding.binding);
+				std::abort();
+			}
+		}
 
-			for (auto info : infos)
-				delete info;
+		for (uint32_t frameIndex = 0; frameIndex < vulkan::MAX_FRAMES_IN_FLIGHT; frameIndex++)
+		{
+			const vulkan::DescriptorInfo provided[] = {
+				vulkan::GetDescriptorInfo(uniformBuffers[frameIndex]),
+				vulkan::GetDescriptorInfo(objectBuffers[frameIndex]),
+				vulkan::GetDescriptorInfo(lightClusterer.GetUniformBuffers()[frameIndex]),
+				vulkan::GetDescriptorInfo(lightClusterer.GetLightBuffers()[frameIndex]),
+				vulkan::GetDescriptorInfo(lightClusterer.GetLightGrid()),
+				vulkan::GetDescriptorInfo(vulkanInstance->GetMaterialTable()->GetBuffers()[frameIndex])
+			};
+
+			// One element per reflected binding, in the order of the update template
+			std::vector<vulkan::DescriptorInfo> infos;
+			infos.reserve(bindings.size());
+			for (const auto& binding : bindings)
+				infos.push_back(provided[binding.binding]);
+			vulkanInstance->UpdateDescriptorSet(frameIndex, infos.data());
 		}
 	}
 
-	void Scene::InitPipelines(vulkan::Instance* vulkanInstance)
+	void Scene::InitPipelines(vulkan::Instance* vulkanInstance, const vulkan::PipelineState& state)
 	{
 		m_Registry.ForEach<DrawableComponent>(
-		[vulkanInstance](DrawableComponent* drawableComp)
+		[vulkanInstance, &state](DrawableComponent* drawableComp)
 		{
+			// The first material of each vertex layout provides its fallback, the shader without any features, which is
+			// cheap to compile and drawn while the material's own variant compiles
+			vulkanInstance->CreateFallbackPipeline(drawableComp->Material.m_Shader, drawableComp->Mesh.m_VertexBuffer->GetLayout(),
+				state);
 			drawableComp->Material.m_PipelineIndex = vulkanInstance->CreatePipeline(
 			drawableComp->Material.m_Shader,
-			drawableComp->Mesh.m_VertexBuffer->GetLayout());
+			drawableComp->Mesh.m_VertexBuffer->GetLayout(), state, drawableComp->Material.m_Variant);
 		});
 	}
 } // namespace sge
\ No newline at end of file
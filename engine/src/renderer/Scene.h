@@ -4,6 +4,10 @@
 
 #include "Mesh.h"
 #include "Material.h"
+#include "vulkan/LightClusterer.h"
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
 
 namespace sge
 {
@@ -12,15 +16,30 @@ namespace sge
 	{
 		Mesh Mesh;
 		Material Material;
+		glm::mat4 Transform;
 
 		DrawableComponent(vulkan::Instance* vulkanInstance, const std::string& meshName, const std::string& materialPath)
-			: Mesh(vulkanInstance, meshName), Material(vulkanInstance, materialPath)
+			: Mesh(vulkanInstance, meshName), Material(vulkanInstance, materialPath), Transform(1.0f)
 		{
 		}
 
 		DrawableComponent(vulkan::Instance* vulkanInstance, const float* vertices, size_t verticesSize, const uint32_t* indices, size_t indicesSize,
 			const std::string& materialPath)
-			: Mesh(vulkanInstance, vertices, verticesSize, indices, indicesSize), Material(vulkanInstance, materialPath)
+			: Mesh(vulkanInstance, vertices, verticesSize, indices, indicesSize), Material(vulkanInstance, materialPath), Transform(1.0f)
+		{
+		}
+	};
+
+	struct PointLightComponent
+	{
+		glm::vec3 Position;
+		glm::vec3 Color;
+		// Distance at which the light's contribution reaches zero, bounds the clusters the light is assigned to
+		float Radius;
+		float Intensity;
+
+		PointLightComponent(const glm::vec3& position, const glm::vec3& color, float radius, float intensity)
+			: Position(position), Color(color), Radius(radius), Intensity(intensity)
 		{
 		}
 	};
@@ -32,9 +51,14 @@ namespace sge
 		ecs::EntityID AddModel(vulkan::Instance* vulkanInstance, const std::string& meshName, const std::string& materialPath);
 		ecs::EntityID AddModel(vulkan::Instance* vulkanInstance, const float* vertices, size_t verticesSize,
 			const uint32_t* indices, size_t indicesSize, const std::string& materialPath);
+		ecs::EntityID AddPointLight(const glm::vec3& position, const glm::vec3& color, float radius, float intensity = 1.0f);
+		void SetTransform(ecs::EntityID entity, const glm::mat4& transform);
 		void Destroy(vulkan::Instance* vulkanInstance);
-		void InitDescriptorSets(vulkan::Instance* vulkanInstance, vulkan::FrameGroup<vulkan::UniformBuffer*>& uniformBuffers); // Uniform buffer as argument is temporary
-		void InitPipelines(vulkan::Instance* vulkanInstance);
+		// Uniform buffer as argument is temporary, the object buffers come from 'Renderer::GetObjectBuffers' and the
+		// light clusterer from 'Renderer::GetLightClusterer'
+		void InitDescriptorSets(vulkan::Instance* vulkanInstance, vulkan::FrameGroup<vulkan::UniformBuffer*>& uniformBuffers,
+			const vulkan::FrameGroup<vulkan::StorageBuffer*>& objectBuffers, const vulkan::LightClusterer& lightClusterer);
+		void InitPipelines(vulkan::Instance* vulkanInstance, const vulkan::PipelineState& state = {});
 	private:
 		ecs::Registry m_Registry;
 		
@@ -0,0 +1,124 @@
+#include "TextureStreamer.h"
+
+#include <algorithm>
+
+namespace sge
+{
+	TextureStreamer::TextureStreamer(vulkan::Instance* vulkanInstance)
+		: m_VulkanInstance(vulkanInstance), m_FrameNumber(0)
+	{
+	}
+
+	void TextureStreamer::Destroy()
+	{
+		for (const RetiredImage& retired : m_RetiredImages)
+			vulkan::Texture::DestroyRetiredImage(m_VulkanInstance->GetDevice(), m_VulkanInstance->GetMemoryAllocator(), retired.Image);
+		m_RetiredImages.clear();
+		m_Entries.clear();
+
+#ifdef DEBUG
+		m_CleanedUp = true;
+#endif // DEBUG
+	}
+
+	void TextureStreamer::Request(vulkan::Texture* texture, uint32_t mip)
+	{
+		if (!texture || !texture->IsStreamed())
+			return;
+
+		Entry& entry = m_Entries[texture];
+		entry.RequestedMip = std::min(entry.RequestedMip, mip);
+	}
+
+	void TextureStreamer::Update()
+	{
+		m_FrameNumber++;
+
+		// A retired image can still be in the descriptor sets of frames that have not picked up the new image,
+		// and in command buffers of frames that are in flight
+		auto firstLive = std::remove_if(m_RetiredImages.begin(), m_RetiredImages.end(),
+			[this](const RetiredImage& retired)
+			{
+				if (m_FrameNumber - retired.Frame < 2 * vulkan::MAX_FRAMES_IN_FLIGHT)
+					return false;
+
+				vulkan::Texture::DestroyRetiredImage(m_VulkanInstance->GetDevice(), m_VulkanInstance->GetMemoryAllocator(), retired.Image);
+				return true;
+			});
+		m_RetiredImages.erase(firstLive, m_RetiredImages.end());
+
+		// Memory of the retired images is still counted as used, evicting for it again would drop more mips than needed
+		const vulkan::MemoryAllocator* allocator = m_VulkanInstance->GetMemoryAllocator();
+		VkDeviceSize excess = allocator->GetExcessBytes();
+		VkDeviceSize pendingBytes = 0;
+		for (const RetiredImage& retired : m_RetiredImages)
+			pendingBytes += retired.FreedBytes;
+		if (excess > pendingBytes)
+			Evict(excess - pendingBytes);
+
+		VkDeviceSize headroom = excess > 0 ? 0 : allocator->GetHeadroomBytes();
+		for (auto& [texture, entry] : m_Entries)
+		{
+			uint32_t requestedMip = std::min(entry.RequestedMip, texture->GetMaxResidentMip());
+			uint32_t residentMip = texture->GetResidentMip();
+			entry.RequestedMip = UINT32_MAX;
+
+			if (requestedMip <= residentMip)
+				entry.LastUsedFrame = m_FrameNumber;
+
+			if (!m_VulkanInstance->GetUploadContext()->HasBudget())
+				continue;
+
+			// Finer mips are streamed in directly at the requested level if they fit in memory, coarser ones only after the delay
+			if (requestedMip < residentMip)
+			{
+				// Each finer mip is four times the size of the one below it
+				VkDeviceSize growth = (texture->GetMemorySize() << (2 * (residentMip - requestedMip))) - texture->GetMemorySize();
+				if (growth > headroom)
+					continue;
+
+				headroom -= growth;
+				SetResidentMip(texture, requestedMip);
+				entry.LastUsedFrame = m_FrameNumber;
+			}
+			else if (requestedMip > residentMip && m_FrameNumber - entry.LastUsedFrame > TEXTURE_EVICTION_DELAY)
+			{
+				SetResidentMip(texture, requestedMip);
+				entry.LastUsedFrame = m_FrameNumber;
+			}
+		}
+	}
+
+	void TextureStreamer::Evict(VkDeviceSize bytes)
+	{
+		std::vector<std::pair<uint64_t, vulkan::Texture*>> candidates;
+		for (const auto& [texture, entry] : m_Entries)
+		{
+			if (texture->GetResidentMip() < texture->GetMaxResidentMip())
+				candidates.push_back({ entry.LastUsedFrame, texture });
+		}
+		std::sort(candidates.begin(), candidates.end());
+
+		SGE_TRACEF("Over the memory budget by %llu bytes, evicting texture mips.", static_cast<unsigned long long>(bytes));
+
+		VkDeviceSize freedBytes = 0;
+		for (const auto& [lastUsedFrame, texture] : candidates)
+		{
+			if (freedBytes >= bytes || !m_VulkanInstance->GetUploadContext()->HasBudget())
+				break;
+
+			SetResidentMip(texture, texture->GetResidentMip() + 1);
+			freedBytes += m_RetiredImages.back().FreedBytes;
+		}
+	}
+
+	void TextureStreamer::SetResidentMip(vulkan::Texture* texture, uint32_t mip)
+	{
+		SGE_TRACEF("Streaming texture mip %u (was %u).", mip, texture->GetResidentMip());
+
+		vulkan::RetiredImage retired = texture->SetResidentMip(m_VulkanInstance->GetDevice(), *m_VulkanInstance->GetUploadContext(), mip);
+		VkDeviceSize freedBytes = retired.Memory.Size > texture->GetMemorySize() ? retired.Memory.Size - texture->GetMemorySize() : 0;
+		m_RetiredImages.push_back({ retired, m_FrameNumber, freedBytes });
+		m_VulkanInstance->RefreshTexture(texture);
+	}
+} // namespace sge
\ No newline at end of file
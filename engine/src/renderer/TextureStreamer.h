@@ -0,0 +1,67 @@
+#pragma once
+
+#include "vulkan/Instance.h"
+#include "vulkan/Texture.h"
+
+#include <vector>
+#include <unordered_map>
+
+namespace sge
+{
+	// Frames a mip has to go unrequested before the texture drops to a coarser one
+	constexpr uint64_t TEXTURE_EVICTION_DELAY = 120;
+
+	// Keeps the finest mip each streamed texture was requested at resident. Textures start at their coarsest
+	// resident mip, finer mips are uploaded as soon as they are requested and evicted after they have not been
+	// requested for 'TEXTURE_EVICTION_DELAY' frames. New images are only uploaded while the frame's upload budget lasts.
+	// When device local memory is above the memory allocator's pressure threshold, the least recently used textures drop
+	// their finest mip each frame until enough memory is freed, and finer mips are only uploaded if they fit below it.
+	class TextureStreamer
+	{
+	public:
+		TextureStreamer(vulkan::Instance* vulkanInstance);
+#ifdef DEBUG
+		~TextureStreamer()
+		{
+			SGE_ASSERTM(m_CleanedUp, "Texture streamer was not cleaned up.");
+		}
+#endif // DEBUG
+		// Call when the device is idle
+		void Destroy();
+
+		// 'mip' is the finest mip needed this frame, ignored for textures that are not streamed
+		void Request(vulkan::Texture* texture, uint32_t mip);
+		// Records uploads and evictions of mips for this frame's requests into the upload context, call once per frame
+		// before the uploads are flushed
+		void Update();
+	private:
+		struct Entry
+		{
+			// Finest mip requested this frame, 'UINT32_MAX' if none
+			uint32_t RequestedMip = UINT32_MAX;
+			// Last frame the resident mip (or a finer one) was requested
+			uint64_t LastUsedFrame = 0;
+		};
+
+		struct RetiredImage
+		{
+			vulkan::RetiredImage Image;
+			uint64_t Frame;
+			// Bytes the replacement image is smaller by, freed along with this image
+			VkDeviceSize FreedBytes;
+		};
+
+		// Drops one mip of the least recently used textures until about 'bytes' will be freed
+		void Evict(VkDeviceSize bytes);
+		void SetResidentMip(vulkan::Texture* texture, uint32_t mip);
+	private:
+		vulkan::Instance* m_VulkanInstance;
+		std::unordered_map<vulkan::Texture*, Entry> m_Entries;
+		// Images replaced by a streamed mip, destroyed once no frame in flight can reference them
+		std::vector<RetiredImage> m_RetiredImages;
+		uint64_t m_FrameNumber;
+#ifdef DEBUG
+		bool m_CleanedUp = false;
+#endif // DEBUG
+	};
+} // namespace sge
\ No newline at end of file
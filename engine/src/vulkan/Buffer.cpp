@@ -1,12 +1,14 @@
 #include "Buffer.h"
 #include "BufferLayout.h"
+#include "UploadContext.h"
 
 #include "Util.h"
 
 namespace sge::vulkan
 {
-	Buffer::Buffer(VkDevice device, VkPhysicalDevice physicalDevice, VkBufferUsageFlags usageFlags, size_t size)
-		: m_BufferHandle(nullptr)
+	Buffer::Buffer(VkDevice device, MemoryAllocator* allocator, VkBufferUsageFlags usageFlags, size_t size, MemoryUsage memoryUsage,
+		MemoryCategory category)
+		: m_BufferHandle(nullptr), m_UsageFlags(usageFlags), m_Size(size), m_Allocator(allocator)
 	{
 		VkBufferCreateInfo bufferInfo = {};
 		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -17,59 +19,53 @@ namespace sge::vulkan
 		if (vkCreateBuffer(device, &bufferInfo, nullptr, &m_BufferHandle) != VK_SUCCESS)
 			SGE_DEBUG_BREAKM("Failed to create Vulkan buffer.");
 
-		VkMemoryRequirements memoryRequirements;
-		vkGetBufferMemoryRequirements(device, m_BufferHandle, &memoryRequirements);
-
-		VkMemoryAllocateInfo allocInfo = {};
-		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocInfo.allocationSize = size;
-		allocInfo.memoryTypeIndex = FindMemoryType(physicalDevice, memoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
-			| VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-		
-		if (vkAllocateMemory(device, &allocInfo, nullptr, &m_DeviceMemory) != VK_SUCCESS)
-			SGE_DEBUG_BREAKM("Failed to allocate memory for Vulkan buffer.");
-
-		vkBindBufferMemory(device, m_BufferHandle, m_DeviceMemory, 0);
+		m_Allocation = m_Allocator->AllocateBuffer(device, m_BufferHandle, memoryUsage, category);
 	}
 	
 	void Buffer::Destroy(VkDevice device)
 	{
 		vkDestroyBuffer(device, m_BufferHandle, nullptr);
-		vkFreeMemory(device, m_DeviceMemory, nullptr);
+		m_Allocator->Free(device, m_Allocation);
 
 #ifdef DEBUG
 		m_CleanedUp = true;
 #endif // DEBUG
 	}
 
-	void Buffer::CopyBuffer(VkDevice device, VkCommandPool commandPool, VkQueue transferQueue, VkBuffer dest, VkBuffer source, size_t size)
+	VkBuffer Buffer::Move(VkDevice device, VkCommandBuffer commandBuffer, const Allocation& allocation)
 	{
-		VkCommandBuffer commandBuffer = BeginOneTimeCommandBuffer(device, commandPool);
+		VkBufferCreateInfo bufferInfo = {};
+		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.size = m_Size;
+		bufferInfo.usage = m_UsageFlags;
+		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		VkBuffer buffer;
+		if (vkCreateBuffer(device, &bufferInfo, nullptr, &buffer) != VK_SUCCESS)
+			SGE_DEBUG_BREAKM("Failed to create Vulkan buffer.");
+
+		vkBindBufferMemory(device, buffer, allocation.Memory, allocation.Offset);
 
 		VkBufferCopy bufferCopy = {};
-		bufferCopy.size = size;
+		bufferCopy.size = m_Size;
+		vkCmdCopyBuffer(commandBuffer, m_BufferHandle, buffer, 1, &bufferCopy);
 
-		vkCmdCopyBuffer(commandBuffer, source, dest, 1, &bufferCopy);
-		
-		EndOneTimeCommandBuffer(device, commandPool, commandBuffer, transferQueue);
+		VkBuffer previous = m_BufferHandle;
+		m_BufferHandle = buffer;
+		m_Allocation = allocation;
+		return previous;
 	}
 
-	// Note: 'transferQueue' can be a graphics queue because graphics queues support transfer operations
-	VertexBuffer::VertexBuffer(VkDevice device, VkPhysicalDevice physicalDevice, VkCommandPool commandPool, VkQueue transferQueue,
-		const float* vertexData, size_t size, const BufferLayout& layout)
-		: Buffer(device, physicalDevice, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, size), m_Layout(layout)
+	// Static geometry lives in device local memory, the transfer source usage lets 'MemoryAllocator::Defragment' move it
+	VertexBuffer::VertexBuffer(VkDevice device, MemoryAllocator* allocator, UploadContext& uploads, const void* vertexData, size_t size,
+		const BufferLayout& layout)
+		: Buffer(device, allocator, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			size, MemoryUsage::GpuOnly, MemoryCategory::Geometry), m_Layout(layout)
 	{
 		m_Count = static_cast<uint32_t>(size / m_Layout.GetStride());
 
-		Buffer stagingBuffer(device, physicalDevice, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, size);
-		void* data;
-		vkMapMemory(device, stagingBuffer.GetDeviceMemory(), 0, size, 0, &data);
-		memcpy(data, vertexData, size);
-		vkUnmapMemory(device, stagingBuffer.GetDeviceMemory());
-
-		CopyBuffer(device, commandPool, transferQueue, m_BufferHandle, stagingBuffer.GetBufferHandle(), size);
-
-		stagingBuffer.Destroy(device);
+		uploads.CopyBuffer(device, m_BufferHandle, vertexData, size);
+		m_Allocator->SetMovable(m_Allocation, this, 4);
 	}
 
 	void VertexBuffer::Bind(VkCommandBuffer commandBuffer)
@@ -78,61 +74,73 @@ namespace sge::vulkan
 		vkCmdBindVertexBuffers(commandBuffer, 0, 1, &m_BufferHandle, &offsets);
 	}
 
-	IndexBuffer::IndexBuffer(VkDevice device, VkPhysicalDevice physicalDevice, VkCommandPool commandPool, VkQueue transferQueue, const uint32_t* indexData, size_t size)
-		: Buffer(device, physicalDevice, VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, size)
+	static VkIndexType ChooseIndexType(const uint32_t* indexData, size_t count)
 	{
-		m_Count = static_cast<uint32_t>(size / sizeof(uint32_t));
+		for (size_t i = 0; i < count; i++)
+		{
+			if (indexData[i] > UINT16_MAX)
+				return VK_INDEX_TYPE_UINT32;
+		}
 
-		Buffer stagingBuffer(device, physicalDevice, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, size);
-		void* data;
-		vkMapMemory(device, stagingBuffer.GetDeviceMemory(), 0, size, 0, &data);
-		memcpy(data, indexData, size);
-		vkUnmapMemory(device, stagingBuffer.GetDeviceMemory());
+		return VK_INDEX_TYPE_UINT16;
+	}
 
-		CopyBuffer(device, commandPool, transferQueue, m_BufferHandle, stagingBuffer.GetBufferHandle(), size);
+	IndexBuffer::IndexBuffer(VkDevice device, MemoryAllocator* allocator, UploadContext& uploads, const uint32_t* indexData, size_t size)
+		: IndexBuffer(device, allocator, uploads, indexData, size, ChooseIndexType(indexData, size / sizeof(uint32_t)))
+	{
+	}
+
+	IndexBuffer::IndexBuffer(VkDevice device, MemoryAllocator* allocator, UploadContext& uploads, const uint32_t* indexData, size_t size,
+		VkIndexType indexType)
+		: Buffer(device, allocator, VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			indexType == VK_INDEX_TYPE_UINT16 ? size / 2 : size, MemoryUsage::GpuOnly, MemoryCategory::Geometry), m_IndexType(indexType)
+	{
+		m_Count = static_cast<uint32_t>(size / sizeof(uint32_t));
+		const size_t bufferSize = m_Count * GetIndexSize();
+
+		StagingAllocation staging = uploads.Allocate(device, bufferSize, 4);
+		if (m_IndexType == VK_INDEX_TYPE_UINT16)
+		{
+			auto* indices = reinterpret_cast<uint16_t*>(staging.Data);
+			for (uint32_t i = 0; i < m_Count; i++)
+				indices[i] = static_cast<uint16_t>(indexData[i]);
+		}
+		else
+			memcpy(staging.Data, indexData, bufferSize);
 
-		stagingBuffer.Destroy(device);
+		VkBufferCopy bufferCopy = {};
+		bufferCopy.srcOffset = staging.Offset;
+		bufferCopy.size = bufferSize;
+		vkCmdCopyBuffer(uploads.GetCommandBuffer(device), staging.Buffer, m_BufferHandle, 1, &bufferCopy);
+		uploads.ReleaseBuffer(device, m_BufferHandle);
+		m_Allocator->SetMovable(m_Allocation, this, 4);
 	}
 
 	void IndexBuffer::Bind(VkCommandBuffer commandBuffer)
 	{
-		vkCmdBindIndexBuffer(commandBuffer, m_BufferHandle, 0, VK_INDEX_TYPE_UINT32);
+		vkCmdBindIndexBuffer(commandBuffer, m_BufferHandle, 0, m_IndexType);
 	}
 
-	UniformBuffer::UniformBuffer(VkDevice device, VkPhysicalDevice physicalDevice, const void* uniformData, size_t size)
-		: Buffer(device, physicalDevice, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, size), m_Size(size)
+	UniformBuffer::UniformBuffer(VkDevice device, MemoryAllocator* allocator, const void* uniformData, size_t size)
+		: Buffer(device, allocator, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, size, MemoryUsage::CpuToGpu, MemoryCategory::Uniforms)
 	{
 		Upload(device, uniformData, size);
 	}
 
 	void UniformBuffer::Upload(VkDevice device, const void* uniformData, size_t size)
 	{
-		void* data;
-		vkMapMemory(device, m_DeviceMemory, 0, size, 0, &data);
-		memcpy(data, uniformData, size);
-		vkUnmapMemory(device, m_DeviceMemory);
+		memcpy(m_Allocation.Data, uniformData, size);
+	}
+
+	StorageBuffer::StorageBuffer(VkDevice device, MemoryAllocator* allocator, size_t size, VkBufferUsageFlags additionalUsage,
+		MemoryUsage memoryUsage)
+		: Buffer(device, allocator, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | additionalUsage, size, memoryUsage, MemoryCategory::Uniforms)
+	{
 	}
 
-	VkDescriptorPool CreateDescriptorPool(VkDevice device)
+	void StorageBuffer::Upload(VkDevice device, const void* data, size_t size)
 	{
-		constexpr uint32_t descriptorCount = 1000;
-
-		VkDescriptorPoolSize poolSizes[2] = {};
-		poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		poolSizes[0].descriptorCount = descriptorCount;
-		poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		poolSizes[1].descriptorCount = descriptorCount;
-		
-		VkDescriptorPoolCreateInfo poolInfo = {};
-		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-		poolInfo.poolSizeCount = 2;
-		poolInfo.pPoolSizes = poolSizes;
-		poolInfo.maxSets = descriptorCount;
-
-		VkDescriptorPool descriptorPool;
-		if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS)
-			SGE_DEBUG_BREAKM("Failed to create Vulkan descriptor pool.");
-
-		return descriptorPool;
+		SGE_ASSERTM(m_Allocation.Data, "Storage buffer is not host visible.");
+		memcpy(m_Allocation.Data, data, size);
 	}
 } // namespace sge::vulkan
\ No newline at end of file
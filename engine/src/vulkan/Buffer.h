@@ -2,21 +2,29 @@
 
 #include "base.h"
 #include "BufferLayout.h"
+#include "MemoryAllocator.h"
 
 #include <vulkan/vulkan.h>
 
 namespace sge::vulkan
 {
+	class UploadContext;
+
 	class Buffer
 	{
 	protected:
 		VkBuffer m_BufferHandle;
-		VkDeviceMemory m_DeviceMemory;
+		VkBufferUsageFlags m_UsageFlags;
+		size_t m_Size;
+		MemoryAllocator* m_Allocator;
+		Allocation m_Allocation;
 #ifdef DEBUG
 		bool m_CleanedUp = false;
 #endif //DEBUG
 	public:
-		Buffer(VkDevice device, VkPhysicalDevice physicalDevice, VkBufferUsageFlags usageFlags, size_t size);
+		// Host visible memory ('MemoryUsage::CpuToGpu' or 'MemoryUsage::GpuToCpu') stays mapped, see 'GetData'
+		Buffer(VkDevice device, MemoryAllocator* allocator, VkBufferUsageFlags usageFlags, size_t size,
+			MemoryUsage memoryUsage = MemoryUsage::CpuToGpu, MemoryCategory category = MemoryCategory::Other);
 #ifdef DEBUG
 		~Buffer()
 		{
@@ -24,11 +32,14 @@ namespace sge::vulkan
 		}
 #endif
 		void Destroy(VkDevice device);
-	public:
-		static void CopyBuffer(VkDevice device, VkCommandPool commandPool, VkQueue transferQueue, VkBuffer dest, VkBuffer source, size_t size);
+		// Replaces the buffer with a copy bound to 'allocation', recording the copy into 'commandBuffer'. Returns the previous
+		// buffer, which must be destroyed once the copy and the work recorded before it are done. Used by 'MemoryAllocator::Defragment'.
+		VkBuffer Move(VkDevice device, VkCommandBuffer commandBuffer, const Allocation& allocation);
 	public:
 		inline VkBuffer GetBufferHandle() const { return m_BufferHandle; }
-		inline VkDeviceMemory GetDeviceMemory() const { return m_DeviceMemory; }
+		inline size_t GetSize() const { return m_Size; }
+		// Null unless the memory is host visible
+		inline uint8_t* GetData() const { return m_Allocation.Data; }
 	};
 
 	class VertexBuffer : public Buffer
@@ -37,8 +48,9 @@ namespace sge::vulkan
 		BufferLayout m_Layout;
 		uint32_t m_Count;
 	public:
-		VertexBuffer(VkDevice device, VkPhysicalDevice physicalDevice, VkCommandPool commandPool, VkQueue transferQueue, const float* vertexData,
-			size_t size, const BufferLayout& layout);
+		// 'vertexData' is in the format of 'layout', which may have packed attributes. The copy is recorded into 'uploads'.
+		VertexBuffer(VkDevice device, MemoryAllocator* allocator, UploadContext& uploads, const void* vertexData, size_t size,
+			const BufferLayout& layout);
 		void Bind(VkCommandBuffer commandBuffer);
 	public:
 		inline uint32_t GetCount() const { return m_Count; }
@@ -49,23 +61,34 @@ namespace sge::vulkan
 	{
 	private:
 		uint32_t m_Count;
+		VkIndexType m_IndexType;
 	public:
-		IndexBuffer(VkDevice device, VkPhysicalDevice physicalDevice, VkCommandPool commandPool, VkQueue transferQueue, const uint32_t* indexData, size_t size);
+		// Stored as 16-bit indices if every index fits, 'size' is the size of the 32-bit 'indexData'
+		IndexBuffer(VkDevice device, MemoryAllocator* allocator, UploadContext& uploads, const uint32_t* indexData, size_t size);
 		void Bind(VkCommandBuffer commandBuffer);
+	private:
+		IndexBuffer(VkDevice device, MemoryAllocator* allocator, UploadContext& uploads, const uint32_t* indexData, size_t size,
+			VkIndexType indexType);
 	public:
 		inline uint32_t GetCount() const { return m_Count; }
+		inline VkIndexType GetIndexType() const { return m_IndexType; }
+		inline size_t GetIndexSize() const { return m_IndexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t); }
 	};
 	
 	class UniformBuffer : public Buffer
 	{
 	public:
-		UniformBuffer(VkDevice device, VkPhysicalDevice physicalDevice, const void* uniformData, size_t size);
+		UniformBuffer(VkDevice device, MemoryAllocator* allocator, const void* uniformData, size_t size);
 		void Upload(VkDevice device, const void* uniformData, size_t size);
-	public:
-		inline size_t GetSize() const { return m_Size; }
-	private:
-		size_t m_Size;
 	};
 
-	VkDescriptorPool CreateDescriptorPool(VkDevice device);
+	// Buffer that shaders can read and write, 'additionalUsage' e.g. for indirect draw arguments. Only host visible buffers
+	// can be uploaded to, buffers that only the GPU writes should use 'MemoryUsage::GpuOnly'.
+	class StorageBuffer : public Buffer
+	{
+	public:
+		StorageBuffer(VkDevice device, MemoryAllocator* allocator, size_t size, VkBufferUsageFlags additionalUsage = 0,
+			MemoryUsage memoryUsage = MemoryUsage::CpuToGpu);
+		void Upload(VkDevice device, const void* data, size_t size);
+	};
 } // namespace sge::vulkan
\ No newline at end of file
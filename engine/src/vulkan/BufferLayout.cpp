@@ -1,4 +1,13 @@
 #include "BufferLayout.h"
+#include "base.h"
+
+#include <glm/gtc/packing.hpp>
+#include <glm/common.hpp>
+#include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
+
+#include <cstring>
+#include <cmath>
 
 namespace sge::vulkan
 {
@@ -12,11 +21,77 @@ namespace sge::vulkan
 			return 2 * sizeof(float);
 		case _Vec3:
 			return 3 * sizeof(float);
+		case _Half2:
+			return 2 * sizeof(uint16_t);
+		case _Half4:
+			return 4 * sizeof(uint16_t);
+		case _OctNormal:
+			return 2 * sizeof(int16_t);
+		case _Color8:
+			return 4 * sizeof(uint8_t);
 		default:
 			return 0;
 		}
 	};
 
+	static glm::vec2 OctEncode(glm::vec3 normal)
+	{
+		float length1 = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+		if (length1 == 0.0f)
+			return glm::vec2(0.0f);
+
+		normal /= length1;
+		glm::vec2 encoded(normal.x, normal.y);
+
+		// The lower hemisphere is folded over the diagonals
+		if (normal.z < 0.0f)
+		{
+			glm::vec2 sign(encoded.x >= 0.0f ? 1.0f : -1.0f, encoded.y >= 0.0f ? 1.0f : -1.0f);
+			encoded = (1.0f - glm::abs(glm::vec2(encoded.y, encoded.x))) * sign;
+		}
+
+		return encoded;
+	}
+
+	// Writes one attribute with 'componentCount' floats from 'source' to 'destination' as 'type'
+	static void PackAttribute(const float* source, size_t componentCount, AttributeType type, uint8_t* destination)
+	{
+		glm::vec4 value(0.0f, 0.0f, 0.0f, 1.0f);
+		for (size_t i = 0; i < componentCount && i < 4; i++)
+			value[static_cast<glm::length_t>(i)] = source[i];
+
+		switch (type)
+		{
+		case _Half2:
+		{
+			uint32_t packed = glm::packHalf2x16(glm::vec2(value));
+			memcpy(destination, &packed, sizeof(packed));
+			break;
+		}
+		case _Half4:
+		{
+			glm::uint64 packed = glm::packHalf4x16(value);
+			memcpy(destination, &packed, sizeof(packed));
+			break;
+		}
+		case _OctNormal:
+		{
+			uint32_t packed = glm::packSnorm2x16(OctEncode(glm::vec3(value)));
+			memcpy(destination, &packed, sizeof(packed));
+			break;
+		}
+		case _Color8:
+		{
+			uint32_t packed = glm::packUnorm4x8(value);
+			memcpy(destination, &packed, sizeof(packed));
+			break;
+		}
+		default:
+			memcpy(destination, source, SizeofAttribute(type));
+			break;
+		}
+	}
+
 	BufferLayout::BufferLayout()
 		: m_Stride(0) {}
 
@@ -59,8 +134,11 @@ namespace sge::vulkan
 		return attributeDescriptions;
 	}
 
-	bool BufferLayout::operator==(const BufferLayout& other)
+	bool BufferLayout::operator==(const BufferLayout& other) const
 	{
+		if (m_Attribs.size() != other.m_Attribs.size())
+			return false;
+
 		for (size_t i = 0; i < m_Attribs.size(); i++)
 		{
 			if (m_Attribs[i].Type != other.m_Attribs[i].Type)
@@ -69,4 +147,39 @@ namespace sge::vulkan
 
 		return true;
 	}
+
+	std::vector<float> BufferLayout::ExtractAttribute(const float* vertexData, size_t size, size_t attributeIndex) const
+	{
+		const Attribute& attribute = m_Attribs[attributeIndex];
+		const size_t componentCount = SizeofAttribute(attribute.Type) / sizeof(float);
+		const size_t vertexCount = size / m_Stride;
+
+		std::vector<float> stream(vertexCount * componentCount);
+		const auto* bytes = reinterpret_cast<const uint8_t*>(vertexData);
+		for (size_t i = 0; i < vertexCount; i++)
+			memcpy(stream.data() + i * componentCount, bytes + i * m_Stride + attribute.Offset, componentCount * sizeof(float));
+
+		return stream;
+	}
+
+	std::vector<uint8_t> BufferLayout::Pack(const float* vertexData, size_t size, const BufferLayout& packedLayout) const
+	{
+		SGE_ASSERTM(m_Attribs.size() == packedLayout.m_Attribs.size(), "Packed layout has a different number of attributes.");
+
+		const size_t vertexCount = size / m_Stride;
+		std::vector<uint8_t> packed(vertexCount * packedLayout.m_Stride);
+
+		const auto* bytes = reinterpret_cast<const uint8_t*>(vertexData);
+		for (size_t i = 0; i < vertexCount; i++)
+		{
+			for (size_t j = 0; j < m_Attribs.size(); j++)
+			{
+				const auto* source = reinterpret_cast<const float*>(bytes + i * m_Stride + m_Attribs[j].Offset);
+				uint8_t* destination = packed.data() + i * packedLayout.m_Stride + packedLayout.m_Attribs[j].Offset;
+				PackAttribute(source, SizeofAttribute(m_Attribs[j].Type) / sizeof(float), packedLayout.m_Attribs[j].Type, destination);
+			}
+		}
+
+		return packed;
+	}
 } // namespace sge::vulkan
\ No newline at end of file
@@ -10,7 +10,16 @@ namespace sge::vulkan
 	{
 		_Float = VK_FORMAT_R32_SFLOAT,
 		_Vec2 = VK_FORMAT_R32G32_SFLOAT,
-		_Vec3 = VK_FORMAT_R32G32B32_SFLOAT
+		_Vec3 = VK_FORMAT_R32G32B32_SFLOAT,
+
+		// Packed types, produced from the float types above by 'BufferLayout::Pack'
+		_Half2 = VK_FORMAT_R16G16_SFLOAT,
+		// A _Vec3 with w = 1, read as vec3 or vec4 by shaders
+		_Half4 = VK_FORMAT_R16G16B16A16_SFLOAT,
+		// Unit vector in octahedral encoding, decoded with 'OctDecode' in shaders/packing.glsl
+		_OctNormal = VK_FORMAT_R16G16_SNORM,
+		// Color from a _Vec3 (alpha = 1) or _Vec2
+		_Color8 = VK_FORMAT_R8G8B8A8_UNORM
 	};
 	
 	struct Attribute
@@ -27,7 +36,12 @@ namespace sge::vulkan
 		void AddAttribute(AttributeType attribType);
 		VkVertexInputBindingDescription GetBindingDescription() const;
 		std::vector<VkVertexInputAttributeDescription> GetAttributeDescriptions() const;
-		bool operator==(const BufferLayout& other);
+		bool operator==(const BufferLayout& other) const;
+		// Copies one attribute out of interleaved vertex data into a tightly packed stream
+		std::vector<float> ExtractAttribute(const float* vertexData, size_t size, size_t attributeIndex) const;
+		// Converts vertex data in this float layout to 'packedLayout', which has the same number of attributes.
+		// Every attribute is either copied or quantized to its packed type.
+		std::vector<uint8_t> Pack(const float* vertexData, size_t size, const BufferLayout& packedLayout) const;
 	public:
 		inline size_t GetStride() const { return m_Stride; }
 		inline const std::vector<Attribute>& GetAttributes() const { return m_Attribs; }
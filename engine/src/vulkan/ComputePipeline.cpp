@@ -0,0 +1,65 @@
+#include "ComputePipeline.h"
+#include "Util.h"
+
+namespace sge::vulkan
+{
+	ComputePipeline::ComputePipeline(VkDevice device, const std::string& filepath, const std::vector<VkDescriptorSetLayout>& descriptorSetLayouts,
+		uint32_t pushConstantSize, VkPipelineCache pipelineCache)
+		: m_PipelineHandle(nullptr), m_Layout(nullptr)
+	{
+		auto binary = LoadShaderBinary(filepath);
+
+		VkShaderModuleCreateInfo moduleInfo = {};
+		moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+		moduleInfo.codeSize = binary.size();
+		moduleInfo.pCode = reinterpret_cast<const uint32_t*>(binary.data());
+
+		VkShaderModule shaderModule;
+		if (vkCreateShaderModule(device, &moduleInfo, nullptr, &shaderModule) != VK_SUCCESS)
+			SGE_DEBUG_BREAKM("Failed to create Vulkan shader module.");
+
+		VkPushConstantRange pushConstantRange = {};
+		pushConstantRange.offset = 0;
+		pushConstantRange.size = pushConstantSize;
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+		VkPipelineLayoutCreateInfo layoutInfo = {};
+		layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		layoutInfo.pushConstantRangeCount = pushConstantSize ? 1 : 0;
+		layoutInfo.pPushConstantRanges = &pushConstantRange;
+		layoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
+		layoutInfo.pSetLayouts = descriptorSetLayouts.data();
+
+		if (vkCreatePipelineLayout(device, &layoutInfo, nullptr, &m_Layout) != VK_SUCCESS)
+			SGE_DEBUG_BREAKM("Failed to create Vulkan compute pipeline layout.");
+
+		VkComputePipelineCreateInfo createInfo = {};
+		createInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		createInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		createInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+		createInfo.stage.module = shaderModule;
+		createInfo.stage.pName = "main";
+		createInfo.layout = m_Layout;
+
+		if (vkCreateComputePipelines(device, pipelineCache, 1, &createInfo, nullptr, &m_PipelineHandle) != VK_SUCCESS)
+			SGE_DEBUG_BREAKM("Failed to create Vulkan compute pipeline.");
+
+		// The module is not needed once the pipeline is created
+		vkDestroyShaderModule(device, shaderModule, nullptr);
+	}
+
+	void ComputePipeline::Destroy(VkDevice device)
+	{
+		vkDestroyPipeline(device, m_PipelineHandle, nullptr);
+		vkDestroyPipelineLayout(device, m_Layout, nullptr);
+
+#ifdef DEBUG
+		m_CleanedUp = true;
+#endif // DEBUG
+	}
+
+	void ComputePipeline::Bind(VkCommandBuffer commandBuffer)
+	{
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_PipelineHandle);
+	}
+} // namespace sge::vulkan
\ No newline at end of file
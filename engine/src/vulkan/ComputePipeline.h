@@ -0,0 +1,35 @@
+#pragma once
+
+#include "base.h"
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+#include <string>
+
+namespace sge::vulkan
+{
+	class ComputePipeline
+	{
+	private:
+		VkPipeline m_PipelineHandle;
+		VkPipelineLayout m_Layout;
+#ifdef DEBUG
+		bool m_CleanedUp = false;
+#endif // DEBUG
+	public:
+		// 'filepath' is a SPIR-V binary, push constants are visible to the compute stage only
+		ComputePipeline(VkDevice device, const std::string& filepath, const std::vector<VkDescriptorSetLayout>& descriptorSetLayouts,
+			uint32_t pushConstantSize, VkPipelineCache pipelineCache);
+#ifdef DEBUG
+		~ComputePipeline()
+		{
+			SGE_ASSERTM(m_CleanedUp, "Vulkan compute pipeline was not cleaned up.");
+		}
+#endif // DEBUG
+		void Destroy(VkDevice device);
+		void Bind(VkCommandBuffer commandBuffer);
+	public:
+		inline VkPipelineLayout GetLayout() const { return m_Layout; }
+	};
+} // namespace sge::vulkan
\ No newline at end of file
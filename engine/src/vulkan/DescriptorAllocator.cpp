@@ -0,0 +1,160 @@
+#include "DescriptorAllocator.h"
+#include "Buffer.h"
+
+#include <algorithm>
+
+namespace sge::vulkan
+{
+	// Descriptors of each type per set in a pool. Pools that run out of one type are skipped like full ones.
+	static constexpr struct
+	{
+		VkDescriptorType Type;
+		uint32_t PerSet;
+	} POOL_SIZE_RATIOS[] = {
+		{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2 },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 4 },
+		{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2 },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1 }
+	};
+
+	DescriptorAllocator::DescriptorAllocator(uint32_t setsPerPool, VkDescriptorPoolCreateFlags flags)
+		: m_SetsPerPool(setsPerPool), m_Flags(flags)
+	{
+	}
+
+	void DescriptorAllocator::Destroy(VkDevice device)
+	{
+		for (VkDescriptorPool pool : m_ReadyPools)
+			vkDestroyDescriptorPool(device, pool, nullptr);
+		for (VkDescriptorPool pool : m_FullPools)
+			vkDestroyDescriptorPool(device, pool, nullptr);
+		m_ReadyPools.clear();
+		m_FullPools.clear();
+
+#ifdef DEBUG
+		m_CleanedUp = true;
+#endif // DEBUG
+	}
+
+	VkDescriptorSet DescriptorAllocator::Allocate(VkDevice device, VkDescriptorSetLayout layout,
+		const std::vector<VkDescriptorPoolSize>& setSizes)
+	{
+		VkDescriptorSetAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocInfo.descriptorPool = GetPool(device);
+		allocInfo.descriptorSetCount = 1;
+		allocInfo.pSetLayouts = &layout;
+
+		VkDescriptorSet set = nullptr;
+		VkResult result = vkAllocateDescriptorSets(device, &allocInfo, &set);
+		if ((result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL) && !setSizes.empty())
+		{
+			// Exactly large enough, so it is full right away
+			VkDescriptorPool pool = CreatePool(device, setSizes, 1);
+			m_FullPools.push_back(pool);
+
+			allocInfo.descriptorPool = pool;
+			result = vkAllocateDescriptorSets(device, &allocInfo, &set);
+		}
+		else if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL)
+		{
+			// Retried once, a fresh pool always has room for a set unless its layout is larger than a whole pool
+			m_FullPools.push_back(m_ReadyPools.back());
+			m_ReadyPools.pop_back();
+
+			allocInfo.descriptorPool = GetPool(device);
+			result = vkAllocateDescriptorSets(device, &allocInfo, &set);
+		}
+
+		if (result != VK_SUCCESS)
+			SGE_DEBUG_BREAKM("Failed to allocate Vulkan descriptor set.");
+
+		return set;
+	}
+
+	void DescriptorAllocator::Reset(VkDevice device)
+	{
+		for (VkDescriptorPool pool : m_ReadyPools)
+			vkResetDescriptorPool(device, pool, 0);
+		for (VkDescriptorPool pool : m_FullPools)
+		{
+			vkResetDescriptorPool(device, pool, 0);
+			m_ReadyPools.push_back(pool);
+		}
+		m_FullPools.clear();
+	}
+
+	VkDescriptorPool DescriptorAllocator::GetPool(VkDevice device)
+	{
+		if (!m_ReadyPools.empty())
+			return m_ReadyPools.back();
+
+		std::vector<VkDescriptorPoolSize> poolSizes;
+		for (const auto& ratio : POOL_SIZE_RATIOS)
+			poolSizes.push_back({ ratio.Type, ratio.PerSet * m_SetsPerPool });
+
+		VkDescriptorPool pool = CreatePool(device, poolSizes, m_SetsPerPool);
+		SGE_TRACEF("Descriptor pool created with %u sets.", m_SetsPerPool);
+		m_SetsPerPool = std::min(m_SetsPerPool + m_SetsPerPool / 2, MAX_DESCRIPTOR_SETS_PER_POOL);
+		m_ReadyPools.push_back(pool);
+		return pool;
+	}
+
+	VkDescriptorPool DescriptorAllocator::CreatePool(VkDevice device, const std::vector<VkDescriptorPoolSize>& poolSizes, uint32_t maxSets)
+	{
+		VkDescriptorPoolCreateInfo poolInfo = {};
+		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolInfo.flags = m_Flags;
+		poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+		poolInfo.pPoolSizes = poolSizes.data();
+		poolInfo.maxSets = maxSets;
+
+		VkDescriptorPool pool;
+		if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &pool) != VK_SUCCESS)
+			SGE_DEBUG_BREAKM("Failed to create Vulkan descriptor pool.");
+
+		return pool;
+	}
+
+	VkDescriptorUpdateTemplate CreateDescriptorUpdateTemplate(VkDevice device, VkDescriptorSetLayout layout,
+		const std::vector<VkDescriptorSetLayoutBinding>& bindings)
+	{
+		std::vector<VkDescriptorUpdateTemplateEntry> entries;
+		size_t offset = 0;
+		for (const auto& binding : bindings)
+		{
+			VkDescriptorUpdateTemplateEntry entry = {};
+			entry.dstBinding = binding.binding;
+			entry.dstArrayElement = 0;
+			entry.descriptorCount = binding.descriptorCount;
+			entry.descriptorType = binding.descriptorType;
+			entry.offset = offset;
+			entry.stride = sizeof(DescriptorInfo);
+			entries.push_back(entry);
+
+			offset += binding.descriptorCount * sizeof(DescriptorInfo);
+		}
+
+		VkDescriptorUpdateTemplateCreateInfo templateInfo = {};
+		templateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO;
+		templateInfo.descriptorUpdateEntryCount = static_cast<uint32_t>(entries.size());
+		templateInfo.pDescriptorUpdateEntries = entries.data();
+		templateInfo.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET;
+		templateInfo.descriptorSetLayout = layout;
+
+		VkDescriptorUpdateTemplate updateTemplate;
+		if (vkCreateDescriptorUpdateTemplate(device, &templateInfo, nullptr, &updateTemplate) != VK_SUCCESS)
+			SGE_DEBUG_BREAKM("Failed to create Vulkan descriptor update template.");
+
+		return updateTemplate;
+	}
+
+	DescriptorInfo GetDescriptorInfo(const Buffer* buffer)
+	{
+		DescriptorInfo info = {};
+		info.Buffer.buffer = buffer->GetBufferHandle();
+		info.Buffer.offset = 0;
+		info.Buffer.range = buffer->GetSize();
+		return info;
+	}
+} // namespace sge::vulkan
\ No newline at end of file
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "base.h"
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+
+namespace sge::vulkan
+{
+	class Buffer;
+
+	// Sets in the first pool of an allocator, each further pool holds half as many more, up to 'MAX_DESCRIPTOR_SETS_PER_POOL'
+	constexpr uint32_t DESCRIPTOR_SETS_PER_POOL = 64;
+	constexpr uint32_t MAX_DESCRIPTOR_SETS_PER_POOL = 4096;
+
+	// Descriptor set numbers of the graphics pipelines, ordered by how often the sets change. Every graphics pipeline layout
+	// has the same set layouts, so switching pipelines keeps the bound sets valid and only sets that change are rebound.
+	// The pass and object sets are empty for now, objects are indexed in a storage buffer of the frame set.
+	constexpr uint32_t DESCRIPTOR_SET_FRAME = 0;
+	constexpr uint32_t DESCRIPTOR_SET_PASS = 1;
+	constexpr uint32_t DESCRIPTOR_SET_MATERIAL = 2;
+	constexpr uint32_t DESCRIPTOR_SET_OBJECT = 3;
+	constexpr uint32_t DESCRIPTOR_SET_COUNT = 4;
+
+	// One descriptor of the data read by 'vkUpdateDescriptorSetWithTemplate', see 'CreateDescriptorUpdateTemplate'
+	union DescriptorInfo
+	{
+		VkDescriptorBufferInfo Buffer;
+		VkDescriptorImageInfo Image;
+	};
+
+	// Allocates descriptor sets from a chain of pools. When a pool runs out of sets or descriptors the next one is used, and a
+	// new one is created if there is none, so allocating never fails because a fixed pool is exhausted. Sets are not freed
+	// one by one, 'Reset' returns all of them at once, e.g. for sets that are only used by one frame.
+	class DescriptorAllocator
+	{
+	public:
+		// 'flags' are passed to every pool, e.g. 'VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT' so that sets with update-after-bind
+		// layouts can be allocated too
+		DescriptorAllocator(uint32_t setsPerPool = DESCRIPTOR_SETS_PER_POOL, VkDescriptorPoolCreateFlags flags = 0);
+#ifdef DEBUG
+		~DescriptorAllocator()
+		{
+			SGE_ASSERTM(m_CleanedUp, "Descriptor allocator was not cleaned up.");
+		}
+#endif // DEBUG
+		void Destroy(VkDevice device);
+
+		// 'setSizes' lists the descriptors of sets that are larger than the pools are sized for, e.g. large arrays. Such a set gets
+		// a pool of its own if it does not fit the current one, which keeps serving the other sets.
+		VkDescriptorSet Allocate(VkDevice device, VkDescriptorSetLayout layout, const std::vector<VkDescriptorPoolSize>& setSizes = {});
+		// Frees every set, the GPU must be done with all of them. The pools are kept for the next allocations.
+		void Reset(VkDevice device);
+	public:
+		inline uint32_t GetPoolCount() const { return static_cast<uint32_t>(m_ReadyPools.size() + m_FullPools.size()); }
+	private:
+		// Returns the pool to allocate from, creating one if every pool is full
+		VkDescriptorPool GetPool(VkDevice device);
+		VkDescriptorPool CreatePool(VkDevice device, const std::vector<VkDescriptorPoolSize>& poolSizes, uint32_t maxSets);
+	private:
+		// Pools that may have space left, the last one is allocated from
+		std::vector<VkDescriptorPool> m_ReadyPools;
+		std::vector<VkDescriptorPool> m_FullPools;
+		// Sets in the next pool that is created
+		uint32_t m_SetsPerPool;
+		VkDescriptorPoolCreateFlags m_Flags;
+#ifdef DEBUG
+		bool m_CleanedUp = false;
+#endif // DEBUG
+	};
+
+	// Writes every binding of 'bindings' in one call, reading an array of 'DescriptorInfo' with one element per descriptor in
+	// binding order. Cheaper than building a 'VkWriteDescriptorSet' per binding each time a set is updated.
+	VkDescriptorUpdateTemplate CreateDescriptorUpdateTemplate(VkDevice device, VkDescriptorSetLayout layout,
+		const std::vector<VkDescriptorSetLayoutBinding>& bindings);
+	// Whole buffer
+	DescriptorInfo GetDescriptorInfo(const Buffer* buffer);
+} // namespace sge::vulkan
\ No newline at end of file
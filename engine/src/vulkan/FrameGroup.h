@@ -1,10 +1,13 @@
 #pragma once
 
 #include <array>
+#include <cstdint>
 
 namespace sge::vulkan
 {
-	constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 2;
+	// Per-frame resources are created for this many frames, the number actually in flight is chosen at startup,
+	// see 'InstanceSpec::FramesInFlight'
+	constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 3;
 
 	template<typename T>
 	using FrameGroup = std::array<T, MAX_FRAMES_IN_FLIGHT>;
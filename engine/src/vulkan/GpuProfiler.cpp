@@ -0,0 +1,201 @@
+#include "GpuProfiler.h"
+
+namespace sge::vulkan
+{
+	// Results are written in the order of the flag bits
+	constexpr VkQueryPipelineStatisticFlags STATISTICS_FLAGS = VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT
+		| VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT
+		| VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT
+		| VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT
+		| VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+	constexpr uint32_t STATISTICS_COUNT = 5;
+
+	GpuProfiler::GpuProfiler(VkInstance instance, VkDevice device, VkPhysicalDevice physicalDevice, uint32_t queueFamilyIndex, bool pipelineStatistics,
+		bool debugLabels)
+		: m_TimestampPeriod(0.0f), m_TimestampMask(0), m_PipelineStatistics(pipelineStatistics), m_CurrentFrame(0),
+		m_BeginLabel(nullptr), m_EndLabel(nullptr)
+	{
+		m_TimestampPools.fill(nullptr);
+		m_StatisticsPools.fill(nullptr);
+
+		// The loader may return these even when VK_EXT_debug_utils is not enabled, and calling them is invalid then.
+		// Both stay null without the extension, which disables the labels.
+		if (debugLabels)
+		{
+			m_BeginLabel = (PFN_vkCmdBeginDebugUtilsLabelEXT)vkGetInstanceProcAddr(instance, "vkCmdBeginDebugUtilsLabelEXT");
+			m_EndLabel = (PFN_vkCmdEndDebugUtilsLabelEXT)vkGetInstanceProcAddr(instance, "vkCmdEndDebugUtilsLabelEXT");
+			if (!m_BeginLabel || !m_EndLabel)
+			{
+				m_BeginLabel = nullptr;
+				m_EndLabel = nullptr;
+			}
+		}
+
+		uint32_t queueFamilyCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+		std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
+
+		const uint32_t validBits = queueFamilies[queueFamilyIndex].timestampValidBits;
+		if (validBits == 0)
+		{
+			SGE_WARN("Queue does not support timestamps, GPU profiling is disabled.");
+			m_PipelineStatistics = false;
+			return;
+		}
+
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+		m_TimestampPeriod = properties.limits.timestampPeriod;
+		m_TimestampMask = validBits == 64 ? UINT64_MAX : (1ull << validBits) - 1;
+
+		for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+		{
+			VkQueryPoolCreateInfo poolInfo = {};
+			poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+			poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+			poolInfo.queryCount = 2 * MAX_GPU_SCOPES;
+
+			if (vkCreateQueryPool(device, &poolInfo, nullptr, &m_TimestampPools[i]) != VK_SUCCESS)
+				SGE_DEBUG_BREAKM("Failed to create Vulkan timestamp query pool.");
+
+			if (!m_PipelineStatistics)
+				continue;
+
+			poolInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+			poolInfo.queryCount = MAX_GPU_SCOPES;
+			poolInfo.pipelineStatistics = STATISTICS_FLAGS;
+
+			if (vkCreateQueryPool(device, &poolInfo, nullptr, &m_StatisticsPools[i]) != VK_SUCCESS)
+				SGE_DEBUG_BREAKM("Failed to create Vulkan pipeline statistics query pool.");
+		}
+	}
+
+	void GpuProfiler::Destroy(VkDevice device)
+	{
+		for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+		{
+			if (m_TimestampPools[i])
+				vkDestroyQueryPool(device, m_TimestampPools[i], nullptr);
+			if (m_StatisticsPools[i])
+				vkDestroyQueryPool(device, m_StatisticsPools[i], nullptr);
+		}
+
+#ifdef DEBUG
+		m_CleanedUp = true;
+#endif // DEBUG
+	}
+
+	void GpuProfiler::BeginFrame(VkDevice device, VkCommandBuffer commandBuffer, uint32_t frameIndex)
+	{
+		SGE_ASSERTM(m_OpenScopes.empty(), "GPU profiler scope was not ended.");
+		m_CurrentFrame = frameIndex;
+		if (!IsEnabled())
+			return;
+
+		ReadResults(device, frameIndex);
+		m_Scopes[frameIndex].clear();
+
+		vkCmdResetQueryPool(commandBuffer, m_TimestampPools[frameIndex], 0, 2 * MAX_GPU_SCOPES);
+		if (m_PipelineStatistics)
+			vkCmdResetQueryPool(commandBuffer, m_StatisticsPools[frameIndex], 0, MAX_GPU_SCOPES);
+	}
+
+	void GpuProfiler::BeginScope(VkCommandBuffer commandBuffer, const std::string& name)
+	{
+		if (m_BeginLabel)
+		{
+			VkDebugUtilsLabelEXT label = {};
+			label.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_LABEL_EXT;
+			label.pLabelName = name.c_str();
+			m_BeginLabel(commandBuffer, &label);
+		}
+
+		std::vector<GpuScopeResult>& scopes = m_Scopes[m_CurrentFrame];
+		// Scopes past the limit are still labeled and balanced, just not measured
+		const uint32_t index = static_cast<uint32_t>(scopes.size());
+		m_OpenScopes.push_back(index);
+		if (!IsEnabled() || index >= MAX_GPU_SCOPES)
+			return;
+
+		GpuScopeResult scope = {};
+		scope.Name = name;
+		scope.Depth = static_cast<uint32_t>(m_OpenScopes.size() - 1);
+		// Queries of the same type cannot be nested, so only outer scopes collect statistics
+		scope.HasStatistics = m_PipelineStatistics && scope.Depth == 0;
+		scopes.push_back(scope);
+
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_TimestampPools[m_CurrentFrame], 2 * index);
+		if (scope.HasStatistics)
+			vkCmdBeginQuery(commandBuffer, m_StatisticsPools[m_CurrentFrame], index, 0);
+	}
+
+	void GpuProfiler::EndScope(VkCommandBuffer commandBuffer)
+	{
+		SGE_ASSERTM(!m_OpenScopes.empty(), "GPU profiler scope ended without being begun.");
+		const uint32_t index = m_OpenScopes.back();
+		m_OpenScopes.pop_back();
+
+		if (IsEnabled() && index < MAX_GPU_SCOPES)
+		{
+			if (m_Scopes[m_CurrentFrame][index].HasStatistics)
+				vkCmdEndQuery(commandBuffer, m_StatisticsPools[m_CurrentFrame], index);
+			vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_TimestampPools[m_CurrentFrame], 2 * index + 1);
+		}
+
+		if (m_EndLabel)
+			m_EndLabel(commandBuffer);
+	}
+
+	void GpuProfiler::ReadResults(VkDevice device, uint32_t frameIndex)
+	{
+		std::vector<GpuScopeResult>& scopes = m_Scopes[frameIndex];
+		if (scopes.empty())
+			return;
+
+		// Each query is followed by its availability, queries that are not available are skipped instead of waited on
+		const uint32_t queryCount = 2 * static_cast<uint32_t>(scopes.size());
+		std::vector<uint64_t> timestamps(2 * queryCount);
+		VkResult result = vkGetQueryPoolResults(device, m_TimestampPools[frameIndex], 0, queryCount, timestamps.size() * sizeof(uint64_t),
+			timestamps.data(), 2 * sizeof(uint64_t), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+		if (result != VK_SUCCESS && result != VK_NOT_READY)
+			return;
+
+		std::vector<uint64_t> statistics;
+		if (m_PipelineStatistics)
+		{
+			statistics.resize((STATISTICS_COUNT + 1) * scopes.size());
+			result = vkGetQueryPoolResults(device, m_StatisticsPools[frameIndex], 0, static_cast<uint32_t>(scopes.size()),
+				statistics.size() * sizeof(uint64_t), statistics.data(), (STATISTICS_COUNT + 1) * sizeof(uint64_t),
+				VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+			if (result != VK_SUCCESS && result != VK_NOT_READY)
+				statistics.clear();
+		}
+
+		m_Results.clear();
+		for (size_t i = 0; i < scopes.size(); i++)
+		{
+			const uint64_t* begin = &timestamps[4 * i];
+			const uint64_t* end = &timestamps[4 * i + 2];
+			if (!begin[1] || !end[1])
+				continue;
+
+			GpuScopeResult scope = scopes[i];
+			const uint64_t ticks = (end[0] - begin[0]) & m_TimestampMask;
+			scope.Milliseconds = static_cast<double>(ticks) * m_TimestampPeriod * 1e-6;
+
+			const uint64_t* values = statistics.empty() ? nullptr : &statistics[(STATISTICS_COUNT + 1) * i];
+			scope.HasStatistics = scope.HasStatistics && values && values[STATISTICS_COUNT];
+			if (scope.HasStatistics)
+			{
+				scope.InputPrimitives = values[0];
+				scope.VertexInvocations = values[1];
+				scope.ClippingPrimitives = values[2];
+				scope.FragmentInvocations = values[3];
+				scope.ComputeInvocations = values[4];
+			}
+
+			m_Results.push_back(scope);
+		}
+	}
+} // namespace sge::vulkan
\ No newline at end of file
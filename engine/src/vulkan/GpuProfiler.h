@@ -0,0 +1,103 @@
+#pragma once
+
+#include "FrameGroup.h"
+#include "base.h"
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+#include <string>
+
+namespace sge::vulkan
+{
+	constexpr uint32_t MAX_GPU_SCOPES = 64;
+
+	struct GpuScopeResult
+	{
+		std::string Name;
+		// Nesting level, 0 for scopes that were not opened inside another scope
+		uint32_t Depth;
+		double Milliseconds;
+		// Pipeline statistics, only collected for scopes at depth 0 when enabled
+		bool HasStatistics;
+		uint64_t InputPrimitives;
+		uint64_t VertexInvocations;
+		uint64_t ClippingPrimitives;
+		uint64_t FragmentInvocations;
+		uint64_t ComputeInvocations;
+	};
+
+	// Measures named scopes of a frame's command buffer with pairs of timestamp queries. Every frame in flight has its own
+	// query pools, which are read back when the frame's fence has been waited on, so the results are those of the last frame
+	// that used the same slot and reading them never stalls. Scopes are also emitted as debug labels when VK_EXT_debug_utils
+	// is enabled.
+	class GpuProfiler
+	{
+	public:
+		// Pipeline statistics require the 'pipelineStatisticsQuery' device feature to be enabled, debug labels require
+		// VK_EXT_debug_utils to be enabled on 'instance'
+		GpuProfiler(VkInstance instance, VkDevice device, VkPhysicalDevice physicalDevice, uint32_t queueFamilyIndex, bool pipelineStatistics,
+			bool debugLabels);
+#ifdef DEBUG
+		~GpuProfiler()
+		{
+			SGE_ASSERTM(m_CleanedUp, "GPU profiler was not cleaned up.");
+		}
+#endif // DEBUG
+		void Destroy(VkDevice device);
+
+		// Reads the results of the frame's previous use and resets its queries. Must be recorded outside a render pass,
+		// after the frame's fence was waited on.
+		void BeginFrame(VkDevice device, VkCommandBuffer commandBuffer, uint32_t frameIndex);
+		// Scopes at depth 0 must begin and end outside a render pass when pipeline statistics are enabled
+		void BeginScope(VkCommandBuffer commandBuffer, const std::string& name);
+		void EndScope(VkCommandBuffer commandBuffer);
+	public:
+		inline bool IsEnabled() const { return m_TimestampPeriod > 0.0f; }
+		inline bool HasPipelineStatistics() const { return m_PipelineStatistics; }
+		// Results in the order the scopes were opened
+		inline const std::vector<GpuScopeResult>& GetResults() const { return m_Results; }
+	private:
+		void ReadResults(VkDevice device, uint32_t frameIndex);
+	private:
+		FrameGroup<VkQueryPool> m_TimestampPools;
+		FrameGroup<VkQueryPool> m_StatisticsPools;
+		// Nanoseconds per timestamp tick, 0 if the queue does not support timestamps
+		float m_TimestampPeriod;
+		uint64_t m_TimestampMask;
+		bool m_PipelineStatistics;
+
+		// Scopes recorded into each frame's queries
+		FrameGroup<std::vector<GpuScopeResult>> m_Scopes;
+		// Indices into the current frame's scopes of the scopes that are still open
+		std::vector<uint32_t> m_OpenScopes;
+		uint32_t m_CurrentFrame;
+		std::vector<GpuScopeResult> m_Results;
+
+		PFN_vkCmdBeginDebugUtilsLabelEXT m_BeginLabel;
+		PFN_vkCmdEndDebugUtilsLabelEXT m_EndLabel;
+#ifdef DEBUG
+		bool m_CleanedUp = false;
+#endif // DEBUG
+	};
+
+	// RAII helper for 'GpuProfiler' scopes, does nothing if 'profiler' is null
+	class GpuScope
+	{
+	public:
+		GpuScope(GpuProfiler* profiler, VkCommandBuffer commandBuffer, const std::string& name)
+			: m_Profiler(profiler), m_CommandBuffer(commandBuffer)
+		{
+			if (m_Profiler)
+				m_Profiler->BeginScope(m_CommandBuffer, name);
+		}
+		~GpuScope()
+		{
+			if (m_Profiler)
+				m_Profiler->EndScope(m_CommandBuffer);
+		}
+	private:
+		GpuProfiler* m_Profiler;
+		VkCommandBuffer m_CommandBuffer;
+	};
+} // namespace sge::vulkan
\ No newline at end of file
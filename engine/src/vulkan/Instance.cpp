@@ -9,23 +9,51 @@
 #include <imgui/backends/imgui_impl_vulkan.h>
 
 #include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include <utility>
 
 #define SGE_CALL_VERBOSE(func) func; SGE_TRACE(#func)
 
 namespace sge::vulkan
 {
-	Instance::Instance(GLFWwindow* window)
-		: m_InstanceHandle(nullptr), m_WindowHandle(window),
+	static VkDescriptorPool CreateImGuiDescriptorPool(VkDevice device)
+	{
+		// ImGui only allocates the set of its font texture
+		constexpr uint32_t maxSets = 16;
+
+		VkDescriptorPoolSize poolSize = {};
+		poolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		poolSize.descriptorCount = maxSets;
+
+		VkDescriptorPoolCreateInfo poolInfo = {};
+		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+		poolInfo.poolSizeCount = 1;
+		poolInfo.pPoolSizes = &poolSize;
+		poolInfo.maxSets = maxSets;
+
+		VkDescriptorPool descriptorPool;
+		if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS)
+			SGE_DEBUG_BREAKM("Failed to create Vulkan descriptor pool.");
+
+		return descriptorPool;
+	}
+
+	Instance::Instance(GLFWwindow* window, const InstanceSpec& spec)
+		: m_Spec(spec), m_InstanceHandle(nullptr), m_WindowHandle(window),
 #ifdef SGE_USING_VALIDATION_LAYERS
 		m_DebugMessenger(nullptr),
 #endif // SGE_USING_VALIDATION_LAYERS
-		m_Surface(nullptr), m_PhysicalDevice(nullptr), m_Device(nullptr), m_Swapchain(nullptr),
+		m_Surface(nullptr), m_PhysicalDevice(nullptr), m_Device(nullptr), m_SupportsMultiDrawIndirect(false), m_SupportsPipelineStatistics(false), m_SupportsMemoryBudget(false), m_DebugUtilsEnabled(false), m_PipelineCache(nullptr), m_PipelineCompiler(nullptr), m_TextureTable(nullptr), m_TextureLoader(nullptr), m_TexturePacks(nullptr), m_UploadContext(nullptr), m_MaterialTable(nullptr), m_MemoryAllocator(nullptr), m_GpuProfiler(nullptr), m_Swapchain(nullptr),
 		//m_FramebufferResized(false),
-		m_RenderPass(nullptr),
-		m_GraphicsQueue(nullptr), m_PresentQueue(nullptr), m_CommandPool(nullptr),
-		m_CurrentFrame(0),
-		m_PushConstant({ 1.0f, 1.0f, 1.0f, 1.0f, { 0.6f, 0.0f, 0.0f } }),
-		m_DescriptorSetLayout(nullptr)
+		m_RenderPass(nullptr), m_LoadRenderPass(nullptr),
+		m_GraphicsQueue(nullptr), m_PresentQueue(nullptr), m_TransferQueue(nullptr), m_ComputeQueue(nullptr), m_CommandPool(nullptr),
+		m_FramesInFlight(std::clamp(spec.FramesInFlight, 1u, MAX_FRAMES_IN_FLIGHT)), m_CurrentFrame(0), m_Latency(0.0), m_SwapchainVersion(0),
+		m_DescriptorSetLayout(nullptr), m_EmptySetLayout(nullptr), m_DescriptorUpdateTemplate(nullptr), m_ImGuiDescriptorPool(nullptr),
+		m_DescriptorAllocator(nullptr), m_FrameDescriptorAllocators({}),
+		m_BoundPipelineLayout(nullptr)
 	{
 		SGE_CALL_VERBOSE(InitInstance());
 
@@ -33,7 +61,8 @@ namespace sge::vulkan
 		SGE_CALL_VERBOSE(InitDebugMessenger());
 #endif // SGE_USING_VALIDATION_LAYERS
 
-		SGE_CALL_VERBOSE(InitSurface());
+		if (!m_Spec.Headless)
+			SGE_CALL_VERBOSE(InitSurface());
 
 		SGE_CALL_VERBOSE(InitPhysicalDevice());
 
@@ -43,8 +72,27 @@ namespace sge::vulkan
 
 		SGE_CALL_VERBOSE(InitLogicalDevice());
 
-		m_Swapchain = new Swapchain(m_Device, m_Surface, m_WindowHandle, QuerySwapchainSupport(m_PhysicalDevice, m_Surface), m_QueueFamilyIndices);
-		SGE_TRACE("Vulkan swap chain created.");
+		m_MemoryAllocator = new MemoryAllocator(m_Device, m_PhysicalDevice, m_SupportsMemoryBudget, m_Spec.MemoryPressureThreshold);
+		SGE_TRACE("Vulkan memory allocator created.");
+
+		m_PipelineCache = new PipelineCache(m_Device, m_PhysicalDevice, m_Spec.PipelineCachePath);
+		SGE_TRACE("Vulkan pipeline cache created.");
+		m_GpuProfiler = new GpuProfiler(m_InstanceHandle, m_Device, m_PhysicalDevice, m_QueueFamilyIndices.GraphicsFamily.value(),
+			m_Spec.PipelineStatistics && m_SupportsPipelineStatistics, m_DebugUtilsEnabled);
+		SGE_TRACE("GPU profiler created.");
+		m_PipelineCompiler = new ThreadPool();
+		SGE_TRACEF("Pipeline compiler using %u threads.", m_PipelineCompiler->GetThreadCount());
+
+		// Headless instances render into one offscreen image per frame in flight
+		if (m_Spec.Headless)
+			m_Swapchain = new Swapchain(m_Device, m_MemoryAllocator, { m_Spec.Width, m_Spec.Height }, m_FramesInFlight);
+		else
+		{
+			m_Swapchain = new Swapchain(m_Device, m_Surface, m_WindowHandle, QuerySwapchainSupport(m_PhysicalDevice, m_Surface), m_QueueFamilyIndices,
+				m_Spec.PresentMode, m_Spec.SwapchainImageCount);
+		}
+		SGE_INFOF("Vulkan swap chain created with %u images, present mode %d, %u frames in flight.", m_Swapchain->GetImageCount(),
+			static_cast<int>(m_Swapchain->GetPresentMode()), m_FramesInFlight);
 		m_Swapchain->InitImageViews(m_Device);
 		SGE_TRACE("Vulkan image views created.");
 		SGE_CALL_VERBOSE(InitRenderPass());
@@ -52,7 +100,27 @@ namespace sge::vulkan
 		SGE_CALL_VERBOSE(InitCommandPool());
 		SGE_CALL_VERBOSE(InitDepthResources());
 
-		m_DescriptorPool = CreateDescriptorPool(m_Device);
+		m_UploadContext = new UploadContext(m_Device, m_MemoryAllocator, GetTransferFamily(), m_TransferQueue,
+			m_QueueFamilyIndices.GraphicsFamily.value(), m_GraphicsQueue, m_Spec.UploadRingSize, m_Spec.UploadBudget);
+		SGE_TRACE("Upload context created.");
+		m_ImGuiDescriptorPool = CreateImGuiDescriptorPool(m_Device);
+		// The texture table's sets are update-after-bind, so every pool has to be
+		m_DescriptorAllocator = new DescriptorAllocator(DESCRIPTOR_SETS_PER_POOL, VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT);
+		for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+			m_FrameDescriptorAllocators[i] = new DescriptorAllocator();
+
+		VkDescriptorSetLayoutCreateInfo emptyLayoutInfo = {};
+		emptyLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		if (vkCreateDescriptorSetLayout(m_Device, &emptyLayoutInfo, nullptr, &m_EmptySetLayout) != VK_SUCCESS)
+			SGE_DEBUG_BREAKM("Failed to create Vulkan descriptor set layout.");
+
+		m_TextureTable = new TextureTable(m_Device, m_PhysicalDevice, m_DescriptorAllocator);
+		SGE_TRACE("Vulkan bindless texture table created.");
+		m_TextureLoader = new TextureLoader(m_Device, m_PhysicalDevice, m_MemoryAllocator, m_UploadContext, m_TextureTable);
+		SGE_TRACE("Texture loader created.");
+		m_TexturePacks = new TexturePackTable();
+		m_MaterialTable = new MaterialTable(m_Device, m_MemoryAllocator);
+		SGE_TRACE("Vulkan material table created.");
 		for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
 			m_DescriptorSets[i] = nullptr;
 
@@ -66,19 +134,59 @@ namespace sge::vulkan
 	{
 		vkDeviceWaitIdle(m_Device);
 
-		for (auto& pipeline : m_Pipelines)
-			pipeline.Destroy(m_Device);
+		// Finishes queued compilations before joining the threads
+		delete m_PipelineCompiler;
+		UpdatePipelines();
+
+		for (auto pipeline : m_Pipelines)
+		{
+			pipeline->Destroy(m_Device);
+			delete pipeline;
+		}
+
+		for (const auto& [key, layout] : m_PipelineLayouts)
+			vkDestroyPipelineLayout(m_Device, layout, nullptr);
+
+		m_PipelineCache->Destroy(m_Device);
+		delete m_PipelineCache;
+
+		m_GpuProfiler->Destroy(m_Device);
+		delete m_GpuProfiler;
 
 		m_Swapchain->Destroy(m_Device);
 		delete m_Swapchain;
 
+		vkDestroyRenderPass(m_Device, m_RenderPass, nullptr);
+		vkDestroyRenderPass(m_Device, m_LoadRenderPass, nullptr);
+
 		// Depth resources
 		vkDestroyImageView(m_Device, m_DepthImageView, nullptr);
 		vkDestroyImage(m_Device, m_DepthImage, nullptr);
-		vkFreeMemory(m_Device, m_DepthImageMemory, nullptr);
+		m_MemoryAllocator->Free(m_Device, m_DepthImageMemory);
 
-		vkDestroyDescriptorPool(m_Device, m_DescriptorPool, nullptr);
+		vkDestroyDescriptorPool(m_Device, m_ImGuiDescriptorPool, nullptr);
+		m_DescriptorAllocator->Destroy(m_Device);
+		delete m_DescriptorAllocator;
+		for (DescriptorAllocator* frameAllocator : m_FrameDescriptorAllocators)
+		{
+			frameAllocator->Destroy(m_Device);
+			delete frameAllocator;
+		}
+		vkDestroyDescriptorUpdateTemplate(m_Device, m_DescriptorUpdateTemplate, nullptr);
 		vkDestroyDescriptorSetLayout(m_Device, m_DescriptorSetLayout, nullptr);
+		vkDestroyDescriptorSetLayout(m_Device, m_EmptySetLayout, nullptr);
+		m_TextureLoader->Destroy(m_Device);
+		delete m_TextureLoader;
+		m_TexturePacks->Destroy(m_Device);
+		delete m_TexturePacks;
+		m_TextureTable->Destroy(m_Device);
+		delete m_TextureTable;
+		m_MaterialTable->Destroy(m_Device);
+		delete m_MaterialTable;
+		m_UploadContext->Destroy(m_Device);
+		delete m_UploadContext;
+		m_MemoryAllocator->Destroy(m_Device);
+		delete m_MemoryAllocator;
 
 		for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
 		{
@@ -95,13 +203,79 @@ namespace sge::vulkan
 		vkDestroyCommandPool(m_Device, m_CommandPool, nullptr);
 
 		vkDestroyDevice(m_Device, nullptr);
-		vkDestroySurfaceKHR(m_InstanceHandle, m_Surface, nullptr);
+		if (m_Surface)
+			vkDestroySurfaceKHR(m_InstanceHandle, m_Surface, nullptr);
 		vkDestroyInstance(m_InstanceHandle, nullptr);
 	}
 
+	void Instance::WaitForFrame()
+	{
+		PollFrameCompletion();
+		vkWaitForFences(m_Device, 1, &m_InFlightFences[m_CurrentFrame], VK_TRUE, UINT64_MAX);
+		if (m_InputTimes[m_CurrentFrame] != std::chrono::steady_clock::time_point())
+			RecordLatency(m_CurrentFrame);
+	}
+
+	void Instance::SleepUntil(std::chrono::steady_clock::time_point time)
+	{
+		// Frames finish in the order they were submitted, so waiting for the oldest one notices each completion right away
+		while (true)
+		{
+			uint32_t oldest = m_FramesInFlight;
+			for (uint32_t i = 0; i < m_FramesInFlight; i++)
+			{
+				if (m_InputTimes[i] != std::chrono::steady_clock::time_point()
+					&& (oldest == m_FramesInFlight || m_InputTimes[i] < m_InputTimes[oldest]))
+					oldest = i;
+			}
+
+			auto now = std::chrono::steady_clock::now();
+			if (oldest == m_FramesInFlight || now >= time)
+				break;
+
+			uint64_t timeout = std::chrono::duration_cast<std::chrono::nanoseconds>(time - now).count();
+			if (vkWaitForFences(m_Device, 1, &m_InFlightFences[oldest], VK_TRUE, timeout) != VK_SUCCESS)
+				break;
+			RecordLatency(oldest);
+		}
+
+		std::this_thread::sleep_until(time);
+	}
+
+	void Instance::MarkInputSampled()
+	{
+		m_SampledInputTime = std::chrono::steady_clock::now();
+	}
+
+	void Instance::PollFrameCompletion()
+	{
+		for (uint32_t i = 0; i < m_FramesInFlight; i++)
+		{
+			if (m_InputTimes[i] != std::chrono::steady_clock::time_point() && vkGetFenceStatus(m_Device, m_InFlightFences[i]) == VK_SUCCESS)
+				RecordLatency(i);
+		}
+	}
+
+	void Instance::RecordLatency(uint32_t frameIndex)
+	{
+		auto& inputTime = m_InputTimes[frameIndex];
+		double latency = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - inputTime).count();
+		m_Latency = m_Latency == 0.0 ? latency : 0.9 * m_Latency + 0.1 * latency;
+		inputTime = std::chrono::steady_clock::time_point();
+	}
+
 	uint32_t Instance::AcquireNextSwapchainImage()
 	{
 		vkWaitForFences(m_Device, 1, &m_InFlightFences[m_CurrentFrame], VK_TRUE, UINT64_MAX);
+		// The frame's previous command buffer is done with its transient sets
+		m_FrameDescriptorAllocators[m_CurrentFrame]->Reset(m_Device);
+
+		// Offscreen images are used in the same order as the frames in flight
+		if (m_Spec.Headless)
+		{
+			vkResetFences(m_Device, 1, &m_InFlightFences[m_CurrentFrame]);
+			return m_CurrentFrame;
+		}
 
 		uint32_t imageIndex;
 		VkResult result = vkAcquireNextImageKHR(m_Device, m_Swapchain->GetSwapchainHandle(), UINT64_MAX, m_ImageAvailableSemaphores[m_CurrentFrame], nullptr, &imageIndex);
@@ -137,8 +311,28 @@ namespace sge::vulkan
 
 	void Instance::Present(uint32_t* imageIndex)
 	{
+		// The frame may use anything uploaded while it was recorded, the upload submission's last barrier makes it visible
+		m_UploadContext->Flush(m_Device);
+
+		// The fence of this submission is the first one that signals after the input was sampled
+		m_InputTimes[m_CurrentFrame] = std::exchange(m_SampledInputTime, std::chrono::steady_clock::time_point());
+
 		VkSubmitInfo submitInfo = {};
 		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+
+		if (m_Spec.Headless)
+		{
+			// Nothing to wait for or present, the fence alone paces the frames in flight
+			submitInfo.commandBufferCount = 1;
+			submitInfo.pCommandBuffers = &m_CommandBuffers[m_CurrentFrame];
+
+			if (vkQueueSubmit(m_GraphicsQueue, 1, &submitInfo, m_InFlightFences[m_CurrentFrame]) != VK_SUCCESS)
+				SGE_DEBUG_BREAKM("Failed to submit Vulkan draw command buffer.");
+
+			m_CurrentFrame = (m_CurrentFrame + 1) % m_FramesInFlight;
+			return;
+		}
+
 		VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
 		submitInfo.waitSemaphoreCount = 1;
 		submitInfo.pWaitSemaphores = &m_ImageAvailableSemaphores[m_CurrentFrame];
@@ -170,7 +364,39 @@ namespace sge::vulkan
 		else
 			SGE_ASSERTM(result == VK_SUCCESS, "Failed to present swap chain image.");
 
-		m_CurrentFrame = (m_CurrentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+		m_CurrentFrame = (m_CurrentFrame + 1) % m_FramesInFlight;
+	}
+
+	void Instance::CaptureImage(uint32_t imageIndex, const std::string& filepath)
+	{
+		SGE_ASSERTM(m_Spec.Headless, "Only headless instances can capture images.");
+
+		VkExtent2D extent = m_Swapchain->GetExtent();
+		size_t size = static_cast<size_t>(extent.width) * extent.height * 4;
+		Buffer readbackBuffer(m_Device, m_MemoryAllocator, VK_BUFFER_USAGE_TRANSFER_DST_BIT, size, MemoryUsage::GpuToCpu);
+
+		// The render graph leaves offscreen images in 'VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL'
+		VkCommandBuffer commandBuffer = BeginOneTimeCommandBuffer(m_Device, m_CommandPool);
+
+		VkBufferImageCopy region = {};
+		region.bufferOffset = 0;
+		region.bufferRowLength = 0;
+		region.bufferImageHeight = 0;
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.mipLevel = 0;
+		region.imageSubresource.baseArrayLayer = 0;
+		region.imageSubresource.layerCount = 1;
+		region.imageOffset = { 0, 0, 0 };
+		region.imageExtent = { extent.width, extent.height, 1 };
+
+		vkCmdCopyImageToBuffer(commandBuffer, m_Swapchain->ImageAt(imageIndex), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			readbackBuffer.GetBufferHandle(), 1, &region);
+
+		EndOneTimeCommandBuffer(m_Device, m_CommandPool, commandBuffer, m_GraphicsQueue);
+
+		file::WritePNG(filepath, extent.width, extent.height, readbackBuffer.GetData());
+
+		readbackBuffer.Destroy(m_Device);
 	}
 
 	void Instance::InitInstance()
@@ -183,7 +409,11 @@ namespace sge::vulkan
 		appInfo.engineVersion = VK_MAKE_API_VERSION(0, 1, 0, 0);
 		appInfo.apiVersion = VK_API_VERSION_1_3;
 
-		std::vector<const char*> requiredExtensions = GetRequiredExtensions();
+		std::vector<const char*> requiredExtensions = GetRequiredExtensions(m_Spec.Headless);
+		m_DebugUtilsEnabled = std::any_of(requiredExtensions.begin(), requiredExtensions.end(), [](const char* extension)
+		{
+			return strcmp(extension, VK_EXT_DEBUG_UTILS_EXTENSION_NAME) == 0;
+		});
 
 		VkInstanceCreateInfo createInfo = {};
 		createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -235,8 +465,10 @@ namespace sge::vulkan
 	void Instance::InitPhysicalDevice()
 	{
 		m_DeviceExtensions = {
-			VK_KHR_SWAPCHAIN_EXTENSION_NAME
+			VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME
 		};
+		if (!m_Spec.Headless)
+			m_DeviceExtensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
 		uint32_t deviceCount = 0;
 		vkEnumeratePhysicalDevices(m_InstanceHandle, &deviceCount, nullptr);
 		if (deviceCount == 0)
@@ -247,7 +479,7 @@ namespace sge::vulkan
 
 		for (const auto device : physicalDevices)
 		{
-			if (IsSuitablePhysicalDevice(device, m_Surface, m_DeviceExtensions, m_QueueFamilyIndices))
+			if (IsSuitablePhysicalDevice(device, m_Surface, m_DeviceExtensions, m_QueueFamilyIndices) && SupportsBindlessTextures(device))
 			{
 				m_PhysicalDevice = device;
 				break;
@@ -255,31 +487,70 @@ namespace sge::vulkan
 		}
 		if (!m_PhysicalDevice)
 			SGE_DEBUG_BREAKM("No suitable GPUs found.");
+
+		// Optional, the memory allocator estimates the budget without it
+		m_SupportsMemoryBudget = CheckDeviceExtensionSupport(m_PhysicalDevice, { VK_EXT_MEMORY_BUDGET_EXTENSION_NAME });
+		if (m_SupportsMemoryBudget)
+			m_DeviceExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
 	}
 
 	void Instance::InitLogicalDevice()
 	{
+		if (!m_Spec.DedicatedQueues)
+		{
+			m_QueueFamilyIndices.TransferFamily.reset();
+			m_QueueFamilyIndices.ComputeFamily.reset();
+		}
+
+		// A family may only be listed once
+		std::vector<uint32_t> queueFamilies = { m_QueueFamilyIndices.GraphicsFamily.value() };
+		for (const std::optional<uint32_t>& family : { m_QueueFamilyIndices.PresentFamily, m_QueueFamilyIndices.TransferFamily,
+			m_QueueFamilyIndices.ComputeFamily })
+		{
+			if (family.has_value() && std::find(queueFamilies.begin(), queueFamilies.end(), family.value()) == queueFamilies.end())
+				queueFamilies.push_back(family.value());
+		}
+
 		std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-		VkDeviceQueueCreateInfo graphicsQueueCreateInfo = {};
-		graphicsQueueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-		graphicsQueueCreateInfo.queueFamilyIndex = static_cast<uint32_t>(m_QueueFamilyIndices.GraphicsFamily.value());
-		graphicsQueueCreateInfo.queueCount = 1;
 		float queuePriority = 1.0f;
-		graphicsQueueCreateInfo.pQueuePriorities = &queuePriority;
-		queueCreateInfos.push_back(graphicsQueueCreateInfo);
-
-		VkDeviceQueueCreateInfo presentQueueCreateInfo = {};
-		presentQueueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-		presentQueueCreateInfo.queueFamilyIndex = static_cast<uint32_t>(m_QueueFamilyIndices.PresentFamily.value());
-		presentQueueCreateInfo.queueCount = 1;
-		presentQueueCreateInfo.pQueuePriorities = &queuePriority;
-		queueCreateInfos.push_back(presentQueueCreateInfo);
+		for (uint32_t family : queueFamilies)
+		{
+			VkDeviceQueueCreateInfo queueCreateInfo = {};
+			queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+			queueCreateInfo.queueFamilyIndex = family;
+			queueCreateInfo.queueCount = 1;
+			queueCreateInfo.pQueuePriorities = &queuePriority;
+			queueCreateInfos.push_back(queueCreateInfo);
+		}
 
 		VkPhysicalDeviceFeatures features = {};
 		features.samplerAnisotropy = VK_TRUE;
+		// Indirect draws pass the object index as first instance, required by 'IsSuitablePhysicalDevice'
+		features.drawIndirectFirstInstance = VK_TRUE;
+		// Meshlets of a mesh are drawn with a single indirect call when possible
+		VkPhysicalDeviceFeatures supportedFeatures;
+		vkGetPhysicalDeviceFeatures(m_PhysicalDevice, &supportedFeatures);
+		m_SupportsMultiDrawIndirect = supportedFeatures.multiDrawIndirect == VK_TRUE;
+		features.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+		m_SupportsPipelineStatistics = supportedFeatures.pipelineStatisticsQuery == VK_TRUE;
+		if (m_Spec.PipelineStatistics)
+			features.pipelineStatisticsQuery = supportedFeatures.pipelineStatisticsQuery;
+		// Textures use the BC files of the texture compressor when possible, see 'Texture'
+		features.textureCompressionBC = supportedFeatures.textureCompressionBC;
+
+		// Bindless texture table
+		VkPhysicalDeviceDescriptorIndexingFeatures indexingFeatures = {};
+		indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+		indexingFeatures.runtimeDescriptorArray = VK_TRUE;
+		// Batched draws of different materials index the texture table with 'nonuniformEXT'
+		indexingFeatures.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+		indexingFeatures.descriptorBindingPartiallyBound = VK_TRUE;
+		indexingFeatures.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+		indexingFeatures.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
 
 		VkDeviceCreateInfo deviceCreateInfo = {};
 		deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+		deviceCreateInfo.pNext = &indexingFeatures;
 		deviceCreateInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
 		deviceCreateInfo.pQueueCreateInfos = queueCreateInfos.data();
 		deviceCreateInfo.pEnabledFeatures = &features;
@@ -295,12 +566,16 @@ namespace sge::vulkan
 
 		vkGetDeviceQueue(m_Device, m_QueueFamilyIndices.GraphicsFamily.value(), 0, &m_GraphicsQueue);
 		vkGetDeviceQueue(m_Device, m_QueueFamilyIndices.PresentFamily.value(), 0, &m_PresentQueue);
+
+		// Without dedicated families the graphics queue does the work
+		vkGetDeviceQueue(m_Device, GetTransferFamily(), 0, &m_TransferQueue);
+		vkGetDeviceQueue(m_Device, GetComputeFamily(), 0, &m_ComputeQueue);
+		SGE_INFOF("Vulkan queue families: graphics %u, transfer %u, compute %u.", m_QueueFamilyIndices.GraphicsFamily.value(),
+			GetTransferFamily(), GetComputeFamily());
 	}
 
 	void Instance::ReInitSwapchain()
 	{
-		SGE_DEBUG_BREAK(); // TODO: Make this work
-
 		// If window is minimized, wait until it isn't
 		int width = 0, height = 0;
 		glfwGetFramebufferSize(m_WindowHandle, &width, &height);
@@ -312,31 +587,29 @@ namespace sge::vulkan
 
 		vkDeviceWaitIdle(m_Device);
 
-		//DestroySwapchain();
-		m_Swapchain->Destroy(m_Device);
+		SGE_TRACE("Recreating Vulkan swap chain...");
 
-		std::cout << "Recreating Vulkan swap chain...\n";
+		// Only the swap chain, its framebuffers and the depth image depend on the window size. Pipelines use dynamic
+		// viewport and scissor state, and the render pass only depends on the formats, which do not change.
+		Swapchain* oldSwapchain = m_Swapchain;
+		m_Swapchain = new Swapchain(m_Device, m_Surface, m_WindowHandle, QuerySwapchainSupport(m_PhysicalDevice, m_Surface), m_QueueFamilyIndices,
+			m_Spec.PresentMode, m_Spec.SwapchainImageCount, oldSwapchain->GetSwapchainHandle());
+		SGE_ASSERTM(m_Swapchain->GetImageFormat() == oldSwapchain->GetImageFormat(), "Swap chain image format changed.");
 
-		delete m_Swapchain;
-		m_Swapchain = new Swapchain(m_Device, m_Surface, m_WindowHandle, QuerySwapchainSupport(m_PhysicalDevice, m_Surface), m_QueueFamilyIndices);
+		oldSwapchain->Destroy(m_Device);
+		delete oldSwapchain;
 
 		m_Swapchain->InitImageViews(m_Device);
 
-		InitRenderPass();
-		std::cout << "Vulkan render pass created.\n";
-
-		for (auto& pipeline : m_Pipelines)
-			pipeline.Destroy(m_Device);
-
-		InitCommandPool();
-		std::cout << "Vulkan command pool created.\n";
+		vkDestroyImageView(m_Device, m_DepthImageView, nullptr);
+		vkDestroyImage(m_Device, m_DepthImage, nullptr);
+		m_MemoryAllocator->Free(m_Device, m_DepthImageMemory);
+		InitDepthResources();
 
 		m_Swapchain->InitFramebuffers(m_Device, m_RenderPass, m_DepthImageView);
-		std::cout << "Vulkan framebuffers created.\n";
-		InitCommandBuffers();
-		std::cout << "Vulkan command buffer created.\n";
-		InitSyncObjects();
-		std::cout << "Vulkan semaphores and fences created.\n";
+		m_SwapchainVersion++;
+
+		SGE_TRACEF("Vulkan swap chain recreated (%ux%u).", m_Swapchain->GetExtent().width, m_Swapchain->GetExtent().height);
 	}
 
 	void Instance::InitRenderPass()
@@ -348,8 +621,8 @@ namespace sge::vulkan
 		colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
 		colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 		colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-		colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+		colorAttachment.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		colorAttachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
 		VkAttachmentReference colorAttachmentRef = {};
 		colorAttachmentRef.attachment = 0;
@@ -363,7 +636,7 @@ namespace sge::vulkan
 		depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
 		depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 		depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-		depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		depthAttachment.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 		depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 
 		VkAttachmentReference depthAttachmentRef = {};
@@ -376,14 +649,7 @@ namespace sge::vulkan
 		subpass.pColorAttachments = &colorAttachmentRef;
 		subpass.pDepthStencilAttachment = &depthAttachmentRef;
 
-		VkSubpassDependency dependency = {};
-		dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-		dependency.dstSubpass = 0;
-		dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-		dependency.srcAccessMask = 0;
-		dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-		dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-
+		// No external subpass dependency, the render graph inserts barriers before and after the pass
 		VkAttachmentDescription attachments[2] = { colorAttachment, depthAttachment };
 
 		VkRenderPassCreateInfo createInfo = {};
@@ -392,11 +658,17 @@ namespace sge::vulkan
 		createInfo.pAttachments = attachments;
 		createInfo.subpassCount = 1;
 		createInfo.pSubpasses = &subpass;
-		createInfo.dependencyCount = 1;
-		createInfo.pDependencies = &dependency;
 
 		if (vkCreateRenderPass(m_Device, &createInfo, nullptr, &m_RenderPass) != VK_SUCCESS)
 			SGE_DEBUG_BREAKM("Failed to create Vulkan render pass.");
+
+		// Same pass, but continuing on what earlier passes rendered. Only load operations differ, so it is compatible
+		// with the framebuffers and pipelines created for 'm_RenderPass'.
+		attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+		attachments[1].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+
+		if (vkCreateRenderPass(m_Device, &createInfo, nullptr, &m_LoadRenderPass) != VK_SUCCESS)
+			SGE_DEBUG_BREAKM("Failed to create Vulkan render pass.");
 	}
 
 	void Instance::InitDepthResources()
@@ -404,9 +676,9 @@ namespace sge::vulkan
 		uint32_t indices[2] = { m_QueueFamilyIndices.GraphicsFamily.value(), m_QueueFamilyIndices.PresentFamily.value() };
 
 		VkFormat depthFormat = FindDepthFormat(m_PhysicalDevice);
-		CreateImage(m_Device, m_PhysicalDevice, m_Swapchain->GetExtent().width, m_Swapchain->GetExtent().height,
-			depthFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &m_DepthImage, &m_DepthImageMemory);
+		CreateImage(m_Device, m_MemoryAllocator, m_Swapchain->GetExtent().width, m_Swapchain->GetExtent().height,
+			depthFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, // Sampled to build the depth pyramid
+			MemoryUsage::GpuOnly, MemoryCategory::Attachments, &m_DepthImage, &m_DepthImageMemory);
 
 		m_DepthImageView = CreateImageView(m_Device, m_DepthImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT);
 	}
@@ -436,23 +708,32 @@ namespace sge::vulkan
 			SGE_DEBUG_BREAKM("Failed to create Vulkan command buffer.");
 	}
 
-	void Instance::BeginRenderPass(VkCommandBuffer commandBuffer, uint32_t imageIndex)
+	void Instance::BeginCommandBuffer(VkCommandBuffer commandBuffer)
 	{
-		vkResetCommandBuffer(m_CommandBuffers[m_CurrentFrame], 0);
+		vkResetCommandBuffer(commandBuffer, 0);
 
 		VkCommandBufferBeginInfo cmdBeginInfo = {};
 		cmdBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 
 		if (vkBeginCommandBuffer(commandBuffer, &cmdBeginInfo) != VK_SUCCESS)
 			SGE_DEBUG_BREAKM("Failed to begin recording Vulkan command buffer.");
+	}
 
+	void Instance::EndCommandBuffer(VkCommandBuffer commandBuffer)
+	{
+		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+			SGE_DEBUG_BREAKM("Failed to record command buffer.");
+	}
+
+	void Instance::BeginRenderPass(VkCommandBuffer commandBuffer, uint32_t imageIndex, bool clear)
+	{
 		VkClearValue clearValues[2] = {};
 		clearValues[0].color = { 0.0f, 0.0f, 0.0f, 1.0f };
 		clearValues[1].depthStencil = { 1.0f, 0 };
 
 		VkRenderPassBeginInfo renderBeginInfo = {};
 		renderBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-		renderBeginInfo.renderPass = m_RenderPass;
+		renderBeginInfo.renderPass = clear ? m_RenderPass : m_LoadRenderPass;
 		renderBeginInfo.framebuffer = m_Swapchain->FramebufferAt(imageIndex);
 		renderBeginInfo.renderArea.offset = { 0, 0 };
 		renderBeginInfo.renderArea.extent = m_Swapchain->GetExtent();
@@ -460,42 +741,215 @@ namespace sge::vulkan
 		renderBeginInfo.pClearValues = clearValues;
 
 		vkCmdBeginRenderPass(commandBuffer, &renderBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+		// Other passes and ImGui bind their own sets in between, so each pass binds the sets again with its first draw
+		m_BoundPipelineLayout = nullptr;
+
+		VkViewport viewport = {};
+		viewport.x = 0.0f;
+		viewport.y = 0.0f;
+		viewport.width = static_cast<float>(m_Swapchain->GetExtent().width);
+		viewport.height = static_cast<float>(m_Swapchain->GetExtent().height);
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+
+		VkRect2D scissor = {};
+		scissor.offset = { 0, 0 };
+		scissor.extent = m_Swapchain->GetExtent();
+		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
 	}
 
 	void Instance::EndRenderPass(VkCommandBuffer commandBuffer)
 	{
 		vkCmdEndRenderPass(commandBuffer);
-		
-		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
-			SGE_DEBUG_BREAKM("Failed to record command buffer.");
 	}
 
 	void Instance::DrawIndexed(VkCommandBuffer commandBuffer, uint32_t pipelineIndex, VertexBuffer* vertexBuffer, IndexBuffer* indexBuffer, Shader* shader,
 		uint32_t instanceCount)
 	{
-		Pipeline* p = &m_Pipelines[pipelineIndex];
+		if (BindDraw(commandBuffer, pipelineIndex, vertexBuffer, indexBuffer))
+			vkCmdDrawIndexed(commandBuffer, indexBuffer->GetCount(), instanceCount, 0, 0, 0);
+	}
+
+	void Instance::DrawIndexedIndirect(VkCommandBuffer commandBuffer, uint32_t pipelineIndex, VertexBuffer* vertexBuffer, IndexBuffer* indexBuffer,
+		VkBuffer drawBuffer, VkDeviceSize offset, uint32_t drawCount)
+	{
+		if (!BindDraw(commandBuffer, pipelineIndex, vertexBuffer, indexBuffer))
+			return;
+
+		constexpr uint32_t stride = static_cast<uint32_t>(sizeof(VkDrawIndexedIndirectCommand));
+		if (m_SupportsMultiDrawIndirect)
+		{
+			vkCmdDrawIndexedIndirect(commandBuffer, drawBuffer, offset, drawCount, stride);
+			return;
+		}
+
+		for (uint32_t i = 0; i < drawCount; i++)
+			vkCmdDrawIndexedIndirect(commandBuffer, drawBuffer, offset + i * stride, 1, stride);
+	}
+
+	bool Instance::BindDraw(VkCommandBuffer commandBuffer, uint32_t pipelineIndex, VertexBuffer* vertexBuffer, IndexBuffer* indexBuffer)
+	{
+		Pipeline* p = m_Pipelines[pipelineIndex];
+		if (!p)
+		{
+			uint32_t fallbackIndex = m_PipelineFallbacks[pipelineIndex];
+			if (fallbackIndex == INVALID_PIPELINE)
+				return false;
+
+			p = m_Pipelines[fallbackIndex];
+		}
 
 		p->Bind(commandBuffer);
 		vertexBuffer->Bind(commandBuffer);
 		indexBuffer->Bind(commandBuffer);
 
-		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, p->GetLayout(),
-			0, 1, &m_DescriptorSets[m_CurrentFrame], 0, nullptr);
+		// Set 0 holds the per-frame uniforms, set 'TEXTURE_TABLE_SET' the bindless texture table. Neither changes during a pass,
+		// and pipelines with the same layout are compatible for every set, so they are only bound again when the layout changes.
+		if (p->GetLayout() != m_BoundPipelineLayout)
+		{
+			VkDescriptorSet textureTable = m_TextureTable->GetDescriptorSet(m_CurrentFrame);
+			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, p->GetLayout(),
+				DESCRIPTOR_SET_FRAME, 1, &m_DescriptorSets[m_CurrentFrame], 0, nullptr);
+			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, p->GetLayout(),
+				TEXTURE_TABLE_SET, 1, &textureTable, 0, nullptr);
+			m_BoundPipelineLayout = p->GetLayout();
+		}
 
-		vkCmdPushConstants(commandBuffer, p->GetLayout(), VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0,
-			static_cast<uint32_t>(sizeof(PushConstant)), &m_PushConstant);
+		return true;
+	}
 
-		vkCmdDrawIndexed(commandBuffer, indexBuffer->GetCount(), instanceCount, 0, 0, 0);
+	uint32_t Instance::CreatePipeline(Shader* shader, const BufferLayout* layout, const PipelineState& state,
+		const ShaderVariant& variant)
+	{
+		return AddPipeline(shader, layout, state, variant, true);
 	}
 
-	uint32_t Instance::CreatePipeline(Shader* shader, const BufferLayout* layout)
+	uint32_t Instance::AddPipeline(Shader* shader, const BufferLayout* layout, const PipelineState& state, const ShaderVariant& variant,
+		bool background)
 	{
+		uint64_t key = HashPipelineKey(shader, *layout, state, variant);
+		auto it = m_PipelineIndices.find(key);
+		if (it != m_PipelineIndices.end())
+			return it->second;
+
+		// The set layouts are shared by every pipeline, so the shader has to fit them
+		const ShaderReflection& reflection = shader->GetReflection();
+		VkDescriptorSetLayoutBinding textureTableBinding = {};
+		textureTableBinding.binding = 0;
+		textureTableBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		textureTableBinding.descriptorCount = m_TextureTable->GetCapacity();
+		textureTableBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+		SGE_ASSERTM(FitsSetLayout(reflection.Sets[DESCRIPTOR_SET_FRAME], m_DescriptorSetBindings),
+			"Shader does not fit the layout of the frame descriptor set.");
+		SGE_ASSERTM(FitsSetLayout(reflection.Sets[TEXTURE_TABLE_SET], { textureTableBinding }),
+			"Shader does not fit the layout of the texture table.");
+		SGE_ASSERTM(reflection.Sets[DESCRIPTOR_SET_PASS].empty() && reflection.Sets[DESCRIPTOR_SET_OBJECT].empty(),
+			"Shader uses the pass or object descriptor set, which nothing binds yet.");
+		VkPipelineLayout pipelineLayout = GetPipelineLayout(reflection.PushConstants);
+
+		uint32_t fallbackIndex = INVALID_PIPELINE;
+		for (const FallbackPipeline& fallback : m_FallbackPipelines)
+		{
+			if (fallback.Layout == *layout && fallback.State == state)
+			{
+				fallbackIndex = fallback.Index;
+				break;
+			}
+		}
+
 		uint32_t index = static_cast<uint32_t>(m_Pipelines.size());
-		m_Pipelines.emplace_back(m_Device, m_RenderPass, shader, m_Swapchain, *layout, m_DescriptorSetLayout);
+		m_Pipelines.push_back(nullptr);
+		m_PipelineFallbacks.push_back(fallbackIndex);
+		m_PipelineIndices[key] = index;
+
+		if (!background)
+		{
+			m_Pipelines[index] = new Pipeline(m_Device, m_RenderPass, shader, *layout, pipelineLayout, state, variant,
+				m_PipelineCache->GetHandle());
+			return index;
+		}
+
+		// The pipeline cache is internally synchronized, so it can be shared by all compiler threads
+		m_PipelineCompiler->Submit(
+		[this, index, shader, layout = *layout, pipelineLayout, state, variant]()
+		{
+			Pipeline* pipeline = new Pipeline(m_Device, m_RenderPass, shader, layout, pipelineLayout, state, variant,
+				m_PipelineCache->GetHandle());
+
+			std::lock_guard<std::mutex> lock(m_CompiledPipelinesMutex);
+			m_CompiledPipelines.emplace_back(index, pipeline);
+		});
 		
 		return index;
 	}
 
+	VkPipelineLayout Instance::GetPipelineLayout(const VkPushConstantRange& pushConstants)
+	{
+		SGE_ASSERTM(m_DescriptorSetLayout, "Pipelines can only be created after the descriptor sets were allocated.");
+
+		uint64_t key = HashBytes(&pushConstants, sizeof(pushConstants));
+		auto it = m_PipelineLayouts.find(key);
+		if (it != m_PipelineLayouts.end())
+			return it->second;
+
+		std::array<VkDescriptorSetLayout, DESCRIPTOR_SET_COUNT> setLayouts = {};
+		setLayouts[DESCRIPTOR_SET_FRAME] = m_DescriptorSetLayout;
+		setLayouts[DESCRIPTOR_SET_PASS] = m_EmptySetLayout;
+		setLayouts[TEXTURE_TABLE_SET] = m_TextureTable->GetLayout();
+		setLayouts[DESCRIPTOR_SET_OBJECT] = m_EmptySetLayout;
+
+		VkPipelineLayoutCreateInfo layoutInfo = {};
+		layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		layoutInfo.setLayoutCount = DESCRIPTOR_SET_COUNT;
+		layoutInfo.pSetLayouts = setLayouts.data();
+		layoutInfo.pushConstantRangeCount = pushConstants.size ? 1 : 0;
+		layoutInfo.pPushConstantRanges = &pushConstants;
+
+		VkPipelineLayout layout;
+		if (vkCreatePipelineLayout(m_Device, &layoutInfo, nullptr, &layout) != VK_SUCCESS)
+			SGE_DEBUG_BREAKM("Failed to create Vulkan pipeline layout.");
+
+		m_PipelineLayouts[key] = layout;
+		return layout;
+	}
+
+	uint32_t Instance::CreateFallbackPipeline(Shader* shader, const BufferLayout* layout, const PipelineState& state,
+		const ShaderVariant& variant)
+	{
+		for (const FallbackPipeline& fallback : m_FallbackPipelines)
+		{
+			if (fallback.Layout == *layout && fallback.State == state)
+				return fallback.Index;
+		}
+
+		uint32_t index = AddPipeline(shader, layout, state, variant, false);
+		// Created with 'CreatePipeline' before and still compiling, the other pipelines in the queue are not waited for
+		while (!m_Pipelines[index])
+		{
+			std::this_thread::yield();
+			UpdatePipelines();
+		}
+
+		m_FallbackPipelines.push_back({ *layout, state, index });
+		return index;
+	}
+
+	void Instance::UpdatePipelines()
+	{
+		std::lock_guard<std::mutex> lock(m_CompiledPipelinesMutex);
+		for (const auto& [index, pipeline] : m_CompiledPipelines)
+			m_Pipelines[index] = pipeline;
+
+		m_CompiledPipelines.clear();
+	}
+
+	void Instance::WaitForPipelines()
+	{
+		m_PipelineCompiler->Wait();
+		UpdatePipelines();
+	}
+
 	void Instance::InitSyncObjects()
 	{
 		m_ImageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
@@ -518,29 +972,7 @@ namespace sge::vulkan
 		}
 	}
 
-	void Instance::AddLayoutBindingUniformBuffer(std::vector<VkDescriptorSetLayoutBinding>& bindings)
-	{
-		VkDescriptorSetLayoutBinding binding = {};
-		binding.binding = static_cast<uint32_t>(bindings.size());
-		binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		binding.descriptorCount = 1;
-		binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-
-		bindings.push_back(binding);
-	}
-
-	void Instance::AddLayoutBindingTexture(std::vector<VkDescriptorSetLayoutBinding>& bindings)
-	{
-		VkDescriptorSetLayoutBinding binding = {};
-		binding.binding = static_cast<uint32_t>(bindings.size());
-		binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		binding.descriptorCount = 1;
-		binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-
-		bindings.push_back(binding);
-	}
-
-	void Instance::AllocateDescriptorSets(std::vector<VkDescriptorSetLayoutBinding>& bindings)
+	void Instance::AllocateDescriptorSets(const std::vector<VkDescriptorSetLayoutBinding>& bindings)
 	{
 		VkDescriptorSetLayoutCreateInfo layoutInfo = {};
 		layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
@@ -553,66 +985,15 @@ namespace sge::vulkan
 		if (vkCreateDescriptorSetLayout(m_Device, &layoutInfo, nullptr, &m_DescriptorSetLayout) != VK_SUCCESS)
 			SGE_DEBUG_BREAKM("Failed to create Vulkan descriptor set layout.");
 
-		// Set all layouts to newly created one
-		FrameGroup<VkDescriptorSetLayout> layouts;
+		m_DescriptorSetBindings = bindings;
 		for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
-			layouts[i] = m_DescriptorSetLayout;
-
-		VkDescriptorSetAllocateInfo allocInfo = {};
-		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-		allocInfo.descriptorSetCount = MAX_FRAMES_IN_FLIGHT;
-		allocInfo.pSetLayouts = layouts.data();
-		allocInfo.descriptorPool = m_DescriptorPool;
-
-		if (vkAllocateDescriptorSets(m_Device, &allocInfo, m_DescriptorSets.data()) != VK_SUCCESS)
-			SGE_DEBUG_BREAKM("Failed to allocate Vulkan descriptor sets.");
-	}
+			m_DescriptorSets[i] = m_DescriptorAllocator->Allocate(m_Device, m_DescriptorSetLayout);
 
-	void Instance::AddDescriptorWrite(std::vector<VkWriteDescriptorSet>& descriptorWrites, VkDescriptorBufferInfo* bufferInfo,
-		uint32_t frameIndex)
-	{
-		VkWriteDescriptorSet write = {};
-		write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		write.dstSet = m_DescriptorSets[frameIndex];
-		write.dstBinding = static_cast<uint32_t>(descriptorWrites.size());
-		write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		write.descriptorCount = 1;
-		write.pBufferInfo = bufferInfo;
-
-		descriptorWrites.push_back(write);
-	}
-
-	void Instance::AddDescriptorWrite(std::vector<VkWriteDescriptorSet>& descriptorWrites, VkDescriptorImageInfo* imageInfo,
-		uint32_t frameIndex)
-	{
-		VkWriteDescriptorSet write = {};
-		write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		write.dstSet = m_DescriptorSets[frameIndex];
-		write.dstBinding = static_cast<uint32_t>(descriptorWrites.size());
-		write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		write.descriptorCount = 1;
-		write.pImageInfo = imageInfo;
-
-		descriptorWrites.push_back(write);
+		m_DescriptorUpdateTemplate = CreateDescriptorUpdateTemplate(m_Device, m_DescriptorSetLayout, bindings);
 	}
 
-	VkDescriptorBufferInfo* Instance::GetBufferInfo(UniformBuffer* uniformBuffer)
+	void Instance::UpdateDescriptorSet(uint32_t frameIndex, const DescriptorInfo* infos)
 	{
-		VkDescriptorBufferInfo bufferInfo = {};
-		bufferInfo.buffer = uniformBuffer->GetBufferHandle();
-		bufferInfo.offset = 0;
-		bufferInfo.range = uniformBuffer->GetSize();
-
-		return new VkDescriptorBufferInfo(bufferInfo);
-	}
-
-	VkDescriptorImageInfo* Instance::GetImageInfo(Texture* texture)
-	{
-		VkDescriptorImageInfo imageInfo = {};
-		imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		imageInfo.imageView = texture->GetImageView();
-		imageInfo.sampler = texture->GetSampler();
-
-		return new VkDescriptorImageInfo(imageInfo);
+		vkUpdateDescriptorSetWithTemplate(m_Device, m_DescriptorSets[frameIndex], m_DescriptorUpdateTemplate, infos);
 	}
 } // namespace sge::vulkan
\ No newline at end of file
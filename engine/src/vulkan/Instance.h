@@ -1,10 +1,20 @@
 #pragma once
 
 #include "Pipeline.h"
+#include "PipelineCache.h"
 #include "Swapchain.h"
 #include "Buffer.h"
+#include "DescriptorAllocator.h"
+#include "ShaderReflection.h"
 #include "Texture.h"
+#include "TextureTable.h"
+#include "TextureLoader.h"
+#include "TexturePackTable.h"
+#include "UploadContext.h"
+#include "MaterialTable.h"
+#include "GpuProfiler.h"
 #include "FrameGroup.h"
+#include "ThreadPool.h"
 #include "base.h"
 
 #define GLFW_INCLUDE_VULKAN
@@ -16,25 +26,48 @@
 #include <vector>
 #include <array>
 #include <memory>
+#include <unordered_map>
+#include <mutex>
+#include <chrono>
 
-// TODO: Fix 'ReInitSwapchain'
 // Maybe rename this class to 'GraphicsContext'
 
 namespace sge::vulkan
 {
-	struct PushConstant
+	struct InstanceSpec
 	{
-		float ks; // Specular reflection constant
-		float kd; // Diffuse reflection constant
-		float ka; // Ambient reflection constant
-		float a;  // Shininess constant
-		
-		float color[3];
+		// Render into offscreen images instead of a window surface, e.g. for benchmarks on machines without a display
+		bool Headless = false;
+		// Size of the offscreen images, the window size is used otherwise
+		uint32_t Width = 1200;
+		uint32_t Height = 900;
+		// Pipeline cache file, loaded on startup and written on shutdown
+		std::string PipelineCachePath = "pipeline_cache.bin";
+		// Collect pipeline statistics in the GPU profiler, if the device supports them
+		bool PipelineStatistics = false;
+		// Frames the CPU may record ahead of the GPU, at most 'MAX_FRAMES_IN_FLIGHT'. Fewer frames lower the latency,
+		// more frames keep the GPU busy when frame times vary.
+		uint32_t FramesInFlight = 2;
+		// FIFO waits for vertical blank, MAILBOX replaces queued images and IMMEDIATE may tear. Falls back to FIFO.
+		VkPresentModeKHR PresentMode = VK_PRESENT_MODE_MAILBOX_KHR;
+		// 0 uses one more image than the surface's minimum
+		uint32_t SwapchainImageCount = 0;
+		// Keep textures' mip chains on the CPU and only upload the mips that are visible on screen
+		bool TextureStreaming = false;
+		// Staging memory shared by all uploads, larger uploads get their own staging buffer
+		VkDeviceSize UploadRingSize = 64ull << 20;
+		// Bytes per frame that deferrable uploads (texture loads and streamed mips) may use
+		VkDeviceSize UploadBudget = 16ull << 20;
+		// Upload on a transfer only queue and run async compute on a compute only queue, if the device has them
+		bool DedicatedQueues = true;
+		// Fraction of the device local memory budget above which streamed textures drop their least recently used mips
+		float MemoryPressureThreshold = 0.9f;
 	};
 
 	class Instance
 	{
 	private:
+		InstanceSpec m_Spec;
 		VkInstance m_InstanceHandle;
 		GLFWwindow* m_WindowHandle;
 #ifdef SGE_USING_VALIDATION_LAYERS
@@ -46,22 +79,72 @@ namespace sge::vulkan
 		QueueFamilyIndices m_QueueFamilyIndices;
 		std::vector<const char*> m_DeviceExtensions;
 		VkDevice m_Device;
+		bool m_SupportsMultiDrawIndirect;
+		bool m_SupportsPipelineStatistics;
+		bool m_SupportsMemoryBudget;
+		// Whether the instance was created with VK_EXT_debug_utils, which the GPU profiler's debug labels need
+		bool m_DebugUtilsEnabled;
 		VkQueue m_GraphicsQueue;
 		VkQueue m_PresentQueue;
+		// The graphics queue on devices without dedicated families
+		VkQueue m_TransferQueue;
+		VkQueue m_ComputeQueue;
 		
 		VkRenderPass m_RenderPass;
+		// Loads the attachments instead of clearing them
+		VkRenderPass m_LoadRenderPass;
 		
-		std::vector<Pipeline> m_Pipelines;
+		// Null while the pipeline is still being compiled
+		std::vector<Pipeline*> m_Pipelines;
+		// Pipeline drawn instead of each pipeline while it is compiling, 'INVALID_PIPELINE' to skip the draw
+		std::vector<uint32_t> m_PipelineFallbacks;
+		struct FallbackPipeline
+		{
+			BufferLayout Layout;
+			PipelineState State;
+			uint32_t Index;
+		};
+		// Fallbacks are only used for pipelines with the same vertex layout and state, so they draw into the same pass the same way
+		std::vector<FallbackPipeline> m_FallbackPipelines;
+		// Pipeline key hash to index into 'm_Pipelines'
+		std::unordered_map<uint64_t, uint32_t> m_PipelineIndices;
+		// Push constant range hash to pipeline layout. All graphics pipeline layouts have the same set layouts, so pipelines
+		// with the same push constants share one and the bound sets stay valid when switching between them.
+		std::unordered_map<uint64_t, VkPipelineLayout> m_PipelineLayouts;
+		// Layout the sets were last bound with in the current render pass, see 'BindDraw'
+		VkPipelineLayout m_BoundPipelineLayout;
+		PipelineCache* m_PipelineCache;
+		// Pipelines are compiled on these threads, finished ones are swapped in by 'UpdatePipelines'
+		ThreadPool* m_PipelineCompiler;
+		std::mutex m_CompiledPipelinesMutex;
+		std::vector<std::pair<uint32_t, Pipeline*>> m_CompiledPipelines;
 		
 		//FrameGroup<UniformBuffer*> m_UniformBuffers;
 		//glm::mat4x4 m_Rotation;
 
 		// Use same layout for all the descriptor sets in the same framegroup
 		VkDescriptorSetLayout m_DescriptorSetLayout;
+		std::vector<VkDescriptorSetLayoutBinding> m_DescriptorSetBindings;
+		// Layout of the pass and object sets, which no shader uses yet
+		VkDescriptorSetLayout m_EmptySetLayout;
 		// In the future, make this an array of framegroups of descriptor sets
 		FrameGroup<VkDescriptorSet> m_DescriptorSets;
+		// Writes all of a frame's set 0 at once, see 'UpdateDescriptorSet'
+		VkDescriptorUpdateTemplate m_DescriptorUpdateTemplate;
 
-		VkDescriptorPool m_DescriptorPool;
+		// Only used by ImGui, which frees its font set itself. Every other set comes from the descriptor allocators.
+		VkDescriptorPool m_ImGuiDescriptorPool;
+		// Sets that live until the instance is destroyed
+		DescriptorAllocator* m_DescriptorAllocator;
+		// Sets that are only used by one frame's command buffer, reset once that frame's fence is signaled
+		FrameGroup<DescriptorAllocator*> m_FrameDescriptorAllocators;
+		TextureTable* m_TextureTable;
+		TextureLoader* m_TextureLoader;
+		TexturePackTable* m_TexturePacks;
+		UploadContext* m_UploadContext;
+		MaterialTable* m_MaterialTable;
+		MemoryAllocator* m_MemoryAllocator;
+		GpuProfiler* m_GpuProfiler;
 		Swapchain* m_Swapchain;
 		
 		VkCommandPool m_CommandPool;
@@ -72,14 +155,21 @@ namespace sge::vulkan
 		std::vector<VkSemaphore> m_RenderFinishedSemaphores;
 		std::vector<VkFence> m_InFlightFences;
 
+		uint32_t m_FramesInFlight;
 		uint32_t m_CurrentFrame;
+		// When the input of the frame that is recorded was sampled, moved to 'm_InputTimes' when the frame is submitted
+		std::chrono::steady_clock::time_point m_SampledInputTime;
+		// When the input each submitted frame is based on was sampled, reset once the frame's fence was seen signaled
+		FrameGroup<std::chrono::steady_clock::time_point> m_InputTimes;
+		// Moving average of the input to GPU completion latency in milliseconds
+		double m_Latency;
+		// Incremented every time the swap chain is recreated
+		uint32_t m_SwapchainVersion;
 
 		// Depth resources
 		VkImage m_DepthImage;
-		VkDeviceMemory m_DepthImageMemory;
+		Allocation m_DepthImageMemory;
 		VkImageView m_DepthImageView;
-
-		PushConstant m_PushConstant;
 	private:
 		void InitInstance();
 #ifdef SGE_USING_VALIDATION_LAYERS
@@ -95,29 +185,94 @@ namespace sge::vulkan
 
 		void InitCommandBuffers();
 		void InitSyncObjects();
+
+		// Created the first time it is needed, set 0 must have been allocated
+		VkPipelineLayout GetPipelineLayout(const VkPushConstantRange& pushConstants);
+		// Compiled on the pipeline compiler's threads if 'background' is true, otherwise right away
+		uint32_t AddPipeline(Shader* shader, const BufferLayout* layout, const PipelineState& state, const ShaderVariant& variant,
+			bool background);
+		// Records the latency of every submitted frame whose fence is signaled
+		void PollFrameCompletion();
+		void RecordLatency(uint32_t frameIndex);
+		// Binds everything a draw needs, returns false if the draw must be skipped
+		bool BindDraw(VkCommandBuffer commandBuffer, uint32_t pipelineIndex, VertexBuffer* vertexBuffer, IndexBuffer* indexBuffer);
 	public:
-		Instance(GLFWwindow* window);
+		// 'window' is null for headless instances
+		Instance(GLFWwindow* window, const InstanceSpec& spec);
 		~Instance();
-		void BeginRenderPass(VkCommandBuffer commandBuffer, uint32_t imageIndex);
+		void BeginCommandBuffer(VkCommandBuffer commandBuffer);
+		void EndCommandBuffer(VkCommandBuffer commandBuffer);
+		// The render pass expects its attachments to already be in attachment layouts and leaves them there,
+		// transitions are done by the render graph. Passes that continue on earlier passes' results do not clear.
+		void BeginRenderPass(VkCommandBuffer commandBuffer, uint32_t imageIndex, bool clear = true);
 		void EndRenderPass(VkCommandBuffer commandBuffer);
 		//void DrawFrame();
 		void Present(uint32_t* imageIndex);
+		// Blocks until the current frame's previous submission finished, after which 'AcquireNextSwapchainImage' does not
+		// wait anymore. Calling this right before sampling input keeps the input as recent as possible.
+		void WaitForFrame();
+		// Sleeps until 'time' like 'std::this_thread::sleep_until', but waits on the fences of the frames in flight meanwhile so
+		// that their completion is timed when it happens
+		void SleepUntil(std::chrono::steady_clock::time_point time);
+		// Marks when the input of the current frame was sampled. The latency is measured when the frame's fence is first seen
+		// signaled, so it is an estimate that ends with the GPU work and does not include presenting or the display's delay.
+		void MarkInputSampled();
+		// Material parameters are read from the material table with the material index of each instance's object
 		void DrawIndexed(VkCommandBuffer commandBuffer, uint32_t pipelineIndex, VertexBuffer* vertexBuffer, IndexBuffer* indexBuffer, Shader* shader,
 			uint32_t instanceCount);
-		uint32_t CreatePipeline(Shader* shader, const BufferLayout* layout);
+		// Draws 'drawCount' consecutive 'VkDrawIndexedIndirectCommand's at 'offset' in 'drawBuffer', e.g. written by a culling shader.
+		// Falls back to one call per command without multi-draw indirect support.
+		void DrawIndexedIndirect(VkCommandBuffer commandBuffer, uint32_t pipelineIndex, VertexBuffer* vertexBuffer, IndexBuffer* indexBuffer,
+			VkBuffer drawBuffer, VkDeviceSize offset, uint32_t drawCount = 1);
+		// Returns the index of an existing pipeline if one with the same shader, layout, state and variant was created before.
+		// New pipelines are compiled in the background; until then draws use the fallback pipeline registered for
+		// the same vertex layout, or are skipped if there is none.
+		uint32_t CreatePipeline(Shader* shader, const BufferLayout* layout, const PipelineState& state = {},
+			const ShaderVariant& variant = {});
+		// Compiles a pipeline on the calling thread and uses it as fallback for pipelines with the same vertex layout and state
+		// created afterwards. Only waits for this pipeline if it is already compiling in the background. Returns the existing
+		// fallback if one was registered for the layout and state before.
+		uint32_t CreateFallbackPipeline(Shader* shader, const BufferLayout* layout, const PipelineState& state = {},
+			const ShaderVariant& variant = {});
+		// Swaps in pipelines that finished compiling, called once per frame
+		void UpdatePipelines();
+		// Blocks until all pipelines are compiled, e.g. before destroying the shaders they use
+		void WaitForPipelines();
 		void ReInitSwapchain();
 		uint32_t AcquireNextSwapchainImage();
+		// Headless only: writes a rendered image to a PNG file, waiting for the GPU to finish with it
+		void CaptureImage(uint32_t imageIndex, const std::string& filepath);
 
 		// Descriptor set functions
-		static void AddLayoutBindingUniformBuffer(std::vector<VkDescriptorSetLayoutBinding>& bindings);
-		static void AddLayoutBindingTexture(std::vector<VkDescriptorSetLayoutBinding>& bindings);
-		void AllocateDescriptorSets(std::vector<VkDescriptorSetLayoutBinding>& bindings);
-		void AddDescriptorWrite(std::vector<VkWriteDescriptorSet>& descriptorWrites, VkDescriptorBufferInfo* bufferInfo, uint32_t frameIndex);
-		void AddDescriptorWrite(std::vector<VkWriteDescriptorSet>& descriptorWrites, VkDescriptorImageInfo* imageInfo, uint32_t frameIndex);
-
-		// Note: 'GetBufferInfo' and 'GetImageInfo' return pointers which must be freed with 'delete'
-		VkDescriptorBufferInfo* GetBufferInfo(UniformBuffer* uniformBuffer);
-		VkDescriptorImageInfo* GetImageInfo(Texture* texture);
+		// Creates the layout of set 0 ('DESCRIPTOR_SET_FRAME') and allocates one set per frame in flight. 'bindings' usually
+		// come from the reflection of every shader that uses the set, see 'ShaderReflection'.
+		void AllocateDescriptorSets(const std::vector<VkDescriptorSetLayoutBinding>& bindings);
+		// Writes every binding of the frame's set 0, 'infos' holds one element per descriptor in binding order
+		void UpdateDescriptorSet(uint32_t frameIndex, const DescriptorInfo* infos);
+
+		// Returns the texture's stable index in the bindless texture table
+		inline uint32_t RegisterTexture(Texture* texture) { return m_TextureTable->Register(m_Device, texture); }
+		// Points the texture's table entry to its current image view, for frames recorded after 'UpdateTextureTable'
+		inline void RefreshTexture(Texture* texture) { m_TextureTable->Refresh(texture); }
+		inline void UpdateTextureTable() { m_TextureTable->Update(m_Device, m_CurrentFrame); }
+		// Decodes and uploads the texture in the background, see 'TextureLoader'. Textures are streamed if enabled in the spec.
+		inline Texture* LoadTextureAsync(const std::string& filepath, const TextureLoadedFunc& onLoaded = {})
+		{
+			return m_TextureLoader->LoadAsync(m_Device, m_PhysicalDevice, filepath, m_Spec.TextureStreaming, onLoaded);
+		}
+		// Loads a pack written by the texture packer, call before creating the materials that use its textures
+		inline bool LoadTexturePack(const std::string& filepath)
+		{
+			return m_TexturePacks->Load(m_Device, m_PhysicalDevice, *m_TextureLoader, *m_TextureTable, filepath);
+		}
+		// Null if the texture is not part of a loaded pack
+		inline const PackedTexture* FindPackedTexture(const std::string& filepath) const { return m_TexturePacks->Find(filepath); }
+		// Uploads decoded textures and finishes completed uploads, called once per frame
+		inline void UpdateTextureLoads() { m_TextureLoader->Update(m_Device); }
+		// Blocks until every texture is resident, e.g. before destroying textures that may still be loading
+		inline void WaitForTextureLoads() { m_TextureLoader->WaitIdle(m_Device); }
+		// Returns the material's index in the material table, which objects pass to the shaders
+		inline uint32_t RegisterMaterial(const MaterialData& material) { return m_MaterialTable->Register(material); }
 	public:
 		inline VkInstance GetInstanceHandle() const { return m_InstanceHandle; }
 #ifdef SGE_USING_VALIDATION_LAYERS
@@ -126,6 +281,8 @@ namespace sge::vulkan
 #endif // SGE_USING_VALIDATION_LAYERS
 		inline void SetFramebufferResized() { m_Swapchain->SetFramebufferResized(true); }
 		
+		inline bool IsHeadless() const { return m_Spec.Headless; }
+		inline bool IsTextureStreamingEnabled() const { return m_Spec.TextureStreaming; }
 		inline GLFWwindow* GetWindowHandle() const { return m_WindowHandle; }
 		inline VkDevice GetDevice() const { return m_Device; }
 		inline VkPhysicalDevice GetPhysicalDevice() const { return m_PhysicalDevice; }
@@ -133,12 +290,34 @@ namespace sge::vulkan
 		inline VkRenderPass GetRenderPass() const { return m_RenderPass; }
 		inline VkSurfaceKHR GetSurface() const { return m_Surface; }
 		inline VkQueue GetGraphicsQueue() const { return m_GraphicsQueue; }
+		inline VkQueue GetTransferQueue() const { return m_TransferQueue; }
+		inline VkQueue GetComputeQueue() const { return m_ComputeQueue; }
+		inline uint32_t GetTransferFamily() const { return m_QueueFamilyIndices.TransferFamily.value_or(m_QueueFamilyIndices.GraphicsFamily.value()); }
+		inline uint32_t GetComputeFamily() const { return m_QueueFamilyIndices.ComputeFamily.value_or(m_QueueFamilyIndices.GraphicsFamily.value()); }
+		inline VkPipelineCache GetPipelineCache() const { return m_PipelineCache->GetHandle(); }
 		inline const QueueFamilyIndices& GetQueueFamilyIndices() const { return m_QueueFamilyIndices; }
 		inline uint32_t GetSwapchainImageCount() const { return m_Swapchain->GetImageCount(); }
-		inline VkDescriptorPool GetDescriptorPool() const { return m_DescriptorPool; }
+		inline VkImage GetSwapchainImage(uint32_t imageIndex) const { return m_Swapchain->ImageAt(imageIndex); }
+		inline VkImageView GetSwapchainImageView(uint32_t imageIndex) const { return m_Swapchain->ImageViewAt(imageIndex); }
+		inline VkImage GetDepthImage() const { return m_DepthImage; }
+		inline VkImageView GetDepthImageView() const { return m_DepthImageView; }
+		inline VkDescriptorPool GetImGuiDescriptorPool() const { return m_ImGuiDescriptorPool; }
+		inline DescriptorAllocator* GetDescriptorAllocator() const { return m_DescriptorAllocator; }
+		inline DescriptorAllocator* GetFrameDescriptorAllocator() const { return m_FrameDescriptorAllocators[m_CurrentFrame]; }
 		inline VkCommandPool GetCommandPool() const { return m_CommandPool; }
-		inline PushConstant& GetPushConstant() { return m_PushConstant; }
+		inline MaterialTable* GetMaterialTable() const { return m_MaterialTable; }
+		inline const TextureLoader* GetTextureLoader() const { return m_TextureLoader; }
+		// Uploads recorded into it are submitted before the next frame, see 'Present'
+		inline UploadContext* GetUploadContext() const { return m_UploadContext; }
+		// Every buffer and image of the instance and the renderer is placed by it
+		inline MemoryAllocator* GetMemoryAllocator() const { return m_MemoryAllocator; }
+		inline GpuProfiler* GetGpuProfiler() const { return m_GpuProfiler; }
 		inline VkCommandBuffer GetCurrentCommandBuffer() const { return m_CommandBuffers[m_CurrentFrame]; }
 		inline uint32_t GetCurrentFrame() const { return m_CurrentFrame; }
+		inline uint32_t GetFramesInFlight() const { return m_FramesInFlight; }
+		inline VkPresentModeKHR GetPresentMode() const { return m_Swapchain->GetPresentMode(); }
+		inline double GetLatencyMilliseconds() const { return m_Latency; }
+		inline uint32_t GetSwapchainVersion() const { return m_SwapchainVersion; }
+		inline bool IsPipelineReady(uint32_t pipelineIndex) const { return m_Pipelines[pipelineIndex] != nullptr; }
 	};
 } // namespace sge::vulkan
\ No newline at end of file
@@ -0,0 +1,204 @@
+#include "Ktx2.h"
+
+#include <fstream>
+#include <algorithm>
+#include <cstring>
+
+namespace sge::vulkan
+{
+	static constexpr uint8_t KTX2_IDENTIFIER[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+
+	struct Ktx2Header
+	{
+		uint32_t VkFormat;
+		uint32_t TypeSize;
+		uint32_t PixelWidth;
+		uint32_t PixelHeight;
+		uint32_t PixelDepth;
+		uint32_t LayerCount;
+		uint32_t FaceCount;
+		uint32_t LevelCount;
+		uint32_t SupercompressionScheme;
+		// Index
+		uint32_t DfdByteOffset;
+		uint32_t DfdByteLength;
+		uint32_t KvdByteOffset;
+		uint32_t KvdByteLength;
+	};
+	static_assert(sizeof(Ktx2Header) == 52);
+
+	// The header is followed by the (unaligned) supercompression global data offset and length, which are always 0 here
+	constexpr size_t KTX2_LEVEL_INDEX_OFFSET = sizeof(KTX2_IDENTIFIER) + sizeof(Ktx2Header) + 2 * sizeof(uint64_t);
+
+	struct Ktx2Level
+	{
+		uint64_t ByteOffset;
+		uint64_t ByteLength;
+		uint64_t UncompressedByteLength;
+	};
+
+	// Khronos data format descriptor values, see the Khronos Data Format Specification
+	constexpr uint8_t KHR_DF_MODEL_BC1A = 128;
+	constexpr uint8_t KHR_DF_MODEL_BC5 = 132;
+	constexpr uint8_t KHR_DF_MODEL_BC7 = 134;
+	constexpr uint8_t KHR_DF_PRIMARIES_BT709 = 1;
+	constexpr uint8_t KHR_DF_TRANSFER_LINEAR = 1;
+	constexpr uint8_t KHR_DF_TRANSFER_SRGB = 2;
+
+	bool LoadKtx2(const std::string& filepath, Ktx2Texture& texture)
+	{
+		std::ifstream file(filepath, std::ios::binary | std::ios::ate);
+		if (!file.is_open())
+			return false;
+
+		std::vector<uint8_t> data(static_cast<size_t>(file.tellg()));
+		file.seekg(0);
+		file.read(reinterpret_cast<char*>(data.data()), data.size());
+
+		Ktx2Header header;
+		if (data.size() < KTX2_LEVEL_INDEX_OFFSET || memcmp(data.data(), KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0)
+		{
+			SGE_WARNF("'%s' is not a KTX2 file.", filepath.c_str());
+			return false;
+		}
+		memcpy(&header, data.data() + sizeof(KTX2_IDENTIFIER), sizeof(Ktx2Header));
+
+		if (header.PixelDepth > 1 || header.FaceCount != 1 || header.SupercompressionScheme != 0)
+		{
+			SGE_WARNF("KTX2 file '%s' is not a 2D texture without supercompression.", filepath.c_str());
+			return false;
+		}
+
+		texture.Format = static_cast<VkFormat>(header.VkFormat);
+		texture.Width = header.PixelWidth;
+		texture.Height = header.PixelHeight;
+		// 0 for textures that are not arrays
+		texture.LayerCount = std::max(header.LayerCount, 1u);
+		texture.Levels.clear();
+
+		const uint32_t levelCount = std::max(header.LevelCount, 1u);
+		if (data.size() < KTX2_LEVEL_INDEX_OFFSET + levelCount * sizeof(Ktx2Level))
+		{
+			SGE_WARNF("KTX2 file '%s' is truncated.", filepath.c_str());
+			return false;
+		}
+
+		for (uint32_t i = 0; i < levelCount; i++)
+		{
+			Ktx2Level level;
+			memcpy(&level, data.data() + KTX2_LEVEL_INDEX_OFFSET + i * sizeof(Ktx2Level), sizeof(Ktx2Level));
+
+			size_t expectedSize = texture.LayerCount
+				* GetImageSize(texture.Format, std::max(texture.Width >> i, 1u), std::max(texture.Height >> i, 1u));
+			if (level.ByteLength != expectedSize || level.ByteOffset + level.ByteLength > data.size())
+			{
+				SGE_WARNF("Mip level %u of KTX2 file '%s' is invalid.", i, filepath.c_str());
+				return false;
+			}
+
+			texture.Levels.emplace_back(data.begin() + level.ByteOffset, data.begin() + level.ByteOffset + level.ByteLength);
+		}
+
+		return true;
+	}
+
+	static std::vector<uint32_t> BuildDataFormatDescriptor(VkFormat format)
+	{
+		struct Sample
+		{
+			uint32_t BitOffset;
+			uint32_t BitLength;
+			uint32_t Channel;
+		};
+
+		uint8_t model;
+		std::vector<Sample> samples;
+		switch (format)
+		{
+		case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+			model = KHR_DF_MODEL_BC1A;
+			samples = { { 0, 64, 0 } };
+			break;
+		case VK_FORMAT_BC5_UNORM_BLOCK:
+			model = KHR_DF_MODEL_BC5;
+			samples = { { 0, 64, 0 }, { 64, 64, 1 } };
+			break;
+		case VK_FORMAT_BC7_UNORM_BLOCK:
+		case VK_FORMAT_BC7_SRGB_BLOCK:
+			model = KHR_DF_MODEL_BC7;
+			samples = { { 0, 128, 0 } };
+			break;
+		default:
+			SGE_DEBUG_BREAKM("Unsupported KTX2 format.");
+			return {};
+		}
+
+		bool srgb = format == VK_FORMAT_BC1_RGB_SRGB_BLOCK || format == VK_FORMAT_BC7_SRGB_BLOCK;
+		uint32_t blockByteLength = 24 + 16 * static_cast<uint32_t>(samples.size());
+
+		// Total size, then one basic descriptor block
+		std::vector<uint32_t> dfd = {
+			4 + blockByteLength,
+			0,
+			2 | (blockByteLength << 16),
+			static_cast<uint32_t>(model | (KHR_DF_PRIMARIES_BT709 << 8) | ((srgb ? KHR_DF_TRANSFER_SRGB : KHR_DF_TRANSFER_LINEAR) << 16)),
+			3 | (3 << 8), // 4x4 texel blocks, stored as size - 1
+			GetBlockSize(format),
+			0
+		};
+		for (const Sample& sample : samples)
+			dfd.insert(dfd.end(), { sample.BitOffset | ((sample.BitLength - 1) << 16) | (sample.Channel << 24), 0, 0, UINT32_MAX });
+
+		return dfd;
+	}
+
+	void WriteKtx2(const std::string& filepath, const Ktx2Texture& texture)
+	{
+		std::ofstream file(filepath, std::ios::binary);
+		SGE_ASSERTF(file.is_open(), "Could not open file '%s'.", filepath.c_str());
+
+		const uint32_t levelCount = static_cast<uint32_t>(texture.Levels.size());
+		std::vector<uint32_t> dfd = BuildDataFormatDescriptor(texture.Format);
+
+		Ktx2Header header = {};
+		header.VkFormat = static_cast<uint32_t>(texture.Format);
+		header.TypeSize = 1;
+		header.PixelWidth = texture.Width;
+		header.PixelHeight = texture.Height;
+		header.LayerCount = texture.LayerCount > 1 ? texture.LayerCount : 0;
+		header.FaceCount = 1;
+		header.LevelCount = levelCount;
+		header.DfdByteOffset = static_cast<uint32_t>(KTX2_LEVEL_INDEX_OFFSET + levelCount * sizeof(Ktx2Level));
+		header.DfdByteLength = static_cast<uint32_t>(dfd.size() * sizeof(uint32_t));
+
+		// Levels are stored smallest first, each aligned to the block size
+		const uint64_t alignment = GetBlockSize(texture.Format);
+		std::vector<Ktx2Level> levels(levelCount);
+		uint64_t offset = header.DfdByteOffset + header.DfdByteLength;
+		for (uint32_t i = levelCount; i-- > 0;)
+		{
+			offset = (offset + alignment - 1) / alignment * alignment;
+			levels[i] = { offset, texture.Levels[i].size(), texture.Levels[i].size() };
+			offset += texture.Levels[i].size();
+		}
+
+		file.write(reinterpret_cast<const char*>(KTX2_IDENTIFIER), sizeof(KTX2_IDENTIFIER));
+		file.write(reinterpret_cast<const char*>(&header), sizeof(Ktx2Header));
+		const uint64_t supercompressionData[2] = {};
+		file.write(reinterpret_cast<const char*>(supercompressionData), sizeof(supercompressionData));
+		file.write(reinterpret_cast<const char*>(levels.data()), levels.size() * sizeof(Ktx2Level));
+		file.write(reinterpret_cast<const char*>(dfd.data()), header.DfdByteLength);
+
+		uint64_t position = header.DfdByteOffset + header.DfdByteLength;
+		const char padding[16] = {};
+		for (uint32_t i = levelCount; i-- > 0;)
+		{
+			file.write(padding, levels[i].ByteOffset - position);
+			file.write(reinterpret_cast<const char*>(texture.Levels[i].data()), texture.Levels[i].size());
+			position = levels[i].ByteOffset + levels[i].ByteLength;
+		}
+
+		SGE_INFOF("Wrote '%s' (%llu bytes).", filepath.c_str(), static_cast<unsigned long long>(position));
+	}
+} // namespace sge::vulkan
\ No newline at end of file
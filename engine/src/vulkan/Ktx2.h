@@ -0,0 +1,28 @@
+#pragma once
+
+#include "TextureCompression.h"
+#include "base.h"
+
+#include <vulkan/vulkan.h>
+
+#include <string>
+
+namespace sge::vulkan
+{
+	// Mip levels of a 2D texture or 2D texture array as stored in a KTX2 file, level 0 first. Each level holds every
+	// layer, one after the other.
+	struct Ktx2Texture
+	{
+		VkFormat Format = VK_FORMAT_UNDEFINED;
+		uint32_t Width = 0;
+		uint32_t Height = 0;
+		uint32_t LayerCount = 1;
+		MipChain Levels;
+	};
+
+	// Only single face 2D textures and texture arrays without supercompression are supported. Returns false if the file
+	// is missing or is not such a texture.
+	bool LoadKtx2(const std::string& filepath, Ktx2Texture& texture);
+	// 'texture.Format' has to be one of the block compressed formats of 'CompressImage'
+	void WriteKtx2(const std::string& filepath, const Ktx2Texture& texture);
+} // namespace sge::vulkan
\ No newline at end of file
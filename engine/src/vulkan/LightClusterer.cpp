@@ -0,0 +1,116 @@
+#include "LightClusterer.h"
+
+#include <glm/matrix.hpp>
+
+namespace sge::vulkan
+{
+	constexpr uint32_t ASSIGN_GROUP_SIZE = 64;
+
+	LightClusterer::LightClusterer(VkDevice device, MemoryAllocator* allocator, DescriptorAllocator* descriptorAllocator,
+		VkPipelineCache pipelineCache, const std::string& shaderDirectory)
+		: m_AssignPipeline(nullptr), m_SetLayout(nullptr), m_LightGrid(nullptr)
+	{
+		// Descriptor set layout, see 'cluster.comp'
+		VkDescriptorSetLayoutBinding bindings[3] = {};
+		for (uint32_t binding = 0; binding < 3; binding++)
+		{
+			bindings[binding].binding = binding;
+			bindings[binding].descriptorType = binding == 0 ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			bindings[binding].descriptorCount = 1;
+			bindings[binding].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		}
+
+		VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+		layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		layoutInfo.bindingCount = 3;
+		layoutInfo.pBindings = bindings;
+
+		if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &m_SetLayout) != VK_SUCCESS)
+			SGE_DEBUG_BREAKM("Failed to create Vulkan descriptor set layout.");
+
+		m_AssignPipeline = new ComputePipeline(device, shaderDirectory + "/cluster.comp.spv", { m_SetLayout }, 0, pipelineCache);
+
+		for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+			m_DescriptorSets[i] = descriptorAllocator->Allocate(device, m_SetLayout);
+
+		// Buffers. The light grid is only written by the GPU.
+		m_LightGrid = new StorageBuffer(device, allocator, CLUSTER_COUNT * (1 + MAX_LIGHTS_PER_CLUSTER) * sizeof(uint32_t), 0,
+			MemoryUsage::GpuOnly);
+
+		ClusterUniforms uniforms = {};
+		for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+		{
+			m_UniformBuffers[i] = new UniformBuffer(device, allocator, &uniforms, sizeof(ClusterUniforms));
+			m_LightBuffers[i] = new StorageBuffer(device, allocator, MAX_LIGHTS * sizeof(PointLightData));
+
+			VkDescriptorBufferInfo bufferInfos[3] = {};
+			bufferInfos[0] = { m_UniformBuffers[i]->GetBufferHandle(), 0, VK_WHOLE_SIZE };
+			bufferInfos[1] = { m_LightBuffers[i]->GetBufferHandle(), 0, VK_WHOLE_SIZE };
+			bufferInfos[2] = { m_LightGrid->GetBufferHandle(), 0, VK_WHOLE_SIZE };
+
+			VkWriteDescriptorSet writes[3] = {};
+			for (uint32_t binding = 0; binding < 3; binding++)
+			{
+				writes[binding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+				writes[binding].dstSet = m_DescriptorSets[i];
+				writes[binding].dstBinding = binding;
+				writes[binding].descriptorType = bindings[binding].descriptorType;
+				writes[binding].descriptorCount = 1;
+				writes[binding].pBufferInfo = &bufferInfos[binding];
+			}
+
+			vkUpdateDescriptorSets(device, 3, writes, 0, nullptr);
+		}
+	}
+
+	void LightClusterer::Destroy(VkDevice device)
+	{
+		for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+		{
+			m_UniformBuffers[i]->Destroy(device);
+			delete m_UniformBuffers[i];
+			m_LightBuffers[i]->Destroy(device);
+			delete m_LightBuffers[i];
+		}
+
+		m_LightGrid->Destroy(device);
+		delete m_LightGrid;
+
+		// The descriptor sets are freed with the allocator
+		vkDestroyDescriptorSetLayout(device, m_SetLayout, nullptr);
+
+		m_AssignPipeline->Destroy(device);
+		delete m_AssignPipeline;
+
+#ifdef DEBUG
+		m_CleanedUp = true;
+#endif // DEBUG
+	}
+
+	void LightClusterer::Update(VkDevice device, uint32_t frameIndex, const std::vector<PointLightData>& lights, const glm::mat4& view,
+		const glm::mat4& projection, float zNear, float zFar, VkExtent2D extent)
+	{
+		SGE_ASSERTM(lights.size() <= MAX_LIGHTS, "Too many lights.");
+
+		if (!lights.empty())
+			m_LightBuffers[frameIndex]->Upload(device, lights.data(), lights.size() * sizeof(PointLightData));
+
+		ClusterUniforms uniforms = {};
+		uniforms.View = view;
+		uniforms.InverseProjection = glm::inverse(projection);
+		uniforms.CameraPosition = glm::inverse(view)[3];
+		uniforms.ScreenSize = glm::vec2(static_cast<float>(extent.width), static_cast<float>(extent.height));
+		uniforms.Near = zNear;
+		uniforms.Far = zFar;
+		uniforms.LightCount = static_cast<uint32_t>(lights.size());
+		m_UniformBuffers[frameIndex]->Upload(device, &uniforms, sizeof(ClusterUniforms));
+	}
+
+	void LightClusterer::RecordAssign(VkCommandBuffer commandBuffer, uint32_t frameIndex)
+	{
+		// Runs without lights as well, so every cluster's light count is reset
+		m_AssignPipeline->Bind(commandBuffer);
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_AssignPipeline->GetLayout(), 0, 1, &m_DescriptorSets[frameIndex], 0, nullptr);
+		vkCmdDispatch(commandBuffer, (CLUSTER_COUNT + ASSIGN_GROUP_SIZE - 1) / ASSIGN_GROUP_SIZE, 1, 1);
+	}
+} // namespace sge::vulkan
\ No newline at end of file
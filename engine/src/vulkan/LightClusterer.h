@@ -0,0 +1,90 @@
+#pragma once
+
+#include "ComputePipeline.h"
+#include "Buffer.h"
+#include "FrameGroup.h"
+#include "DescriptorAllocator.h"
+#include "base.h"
+
+#include <vulkan/vulkan.h>
+#include <glm/mat4x4.hpp>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+#include <vector>
+#include <string>
+
+namespace sge::vulkan
+{
+	// Cluster grid and limits. Must match 'shaders/cluster.glsl'.
+	constexpr uint32_t CLUSTER_COUNT_X = 16;
+	constexpr uint32_t CLUSTER_COUNT_Y = 9;
+	constexpr uint32_t CLUSTER_COUNT_Z = 24;
+	constexpr uint32_t CLUSTER_COUNT = CLUSTER_COUNT_X * CLUSTER_COUNT_Y * CLUSTER_COUNT_Z;
+	constexpr uint32_t MAX_LIGHTS = 4096;
+	constexpr uint32_t MAX_LIGHTS_PER_CLUSTER = 256;
+
+	// Must match 'PointLight' in 'shaders/cluster.glsl'
+	struct PointLightData
+	{
+		glm::vec3 Position;
+		// Distance at which the light's contribution reaches zero
+		float Radius;
+		glm::vec3 Color;
+		float Intensity;
+	};
+
+	// Clustered forward lighting. The view frustum is split into a grid of clusters, screen space tiles in x and y and
+	// exponential depth slices in z. A compute pass assigns every light to the clusters its sphere touches, after which
+	// the fragment shaders only loop over the lights of the fragment's cluster.
+	class LightClusterer
+	{
+	public:
+		// The descriptor sets are allocated from 'descriptorAllocator' and live as long as it does
+		LightClusterer(VkDevice device, MemoryAllocator* allocator, DescriptorAllocator* descriptorAllocator, VkPipelineCache pipelineCache,
+			const std::string& shaderDirectory);
+#ifdef DEBUG
+		~LightClusterer()
+		{
+			SGE_ASSERTM(m_CleanedUp, "Light clusterer was not cleaned up.");
+		}
+#endif // DEBUG
+		void Destroy(VkDevice device);
+
+		// 'zNear' and 'zFar' must be the planes of 'projection', the cluster slices span them
+		void Update(VkDevice device, uint32_t frameIndex, const std::vector<PointLightData>& lights, const glm::mat4& view,
+			const glm::mat4& projection, float zNear, float zFar, VkExtent2D extent);
+		// Expects the light grid to be writable by compute shaders
+		void RecordAssign(VkCommandBuffer commandBuffer, uint32_t frameIndex);
+	public:
+		// Bound to the scene's descriptor sets, read by the fragment shaders
+		inline const FrameGroup<UniformBuffer*>& GetUniformBuffers() const { return m_UniformBuffers; }
+		inline const FrameGroup<StorageBuffer*>& GetLightBuffers() const { return m_LightBuffers; }
+		inline StorageBuffer* GetLightGrid() const { return m_LightGrid; }
+	private:
+		// Must match 'ClusterUniforms' in 'shaders/cluster.glsl'
+		struct ClusterUniforms
+		{
+			glm::mat4 View;
+			glm::mat4 InverseProjection;
+			glm::vec4 CameraPosition;
+			glm::vec2 ScreenSize;
+			float Near;
+			float Far;
+			uint32_t LightCount;
+		};
+
+		ComputePipeline* m_AssignPipeline;
+		VkDescriptorSetLayout m_SetLayout;
+		FrameGroup<VkDescriptorSet> m_DescriptorSets;
+
+		FrameGroup<UniformBuffer*> m_UniformBuffers;
+		FrameGroup<StorageBuffer*> m_LightBuffers;
+		// Light count and light indices of every cluster. Only written by the GPU, so it is shared by all frames in flight.
+		StorageBuffer* m_LightGrid;
+#ifdef DEBUG
+		bool m_CleanedUp = false;
+#endif // DEBUG
+	};
+} // namespace sge::vulkan
\ No newline at end of file
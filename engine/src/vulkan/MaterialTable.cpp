@@ -0,0 +1,51 @@
+#include "MaterialTable.h"
+
+namespace sge::vulkan
+{
+	MaterialTable::MaterialTable(VkDevice device, MemoryAllocator* allocator)
+		: m_Version(0)
+	{
+		for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+		{
+			m_Buffers[i] = new StorageBuffer(device, allocator, MAX_MATERIALS * sizeof(MaterialData));
+			m_BufferVersions[i] = 0;
+		}
+	}
+
+	void MaterialTable::Destroy(VkDevice device)
+	{
+		for (auto buffer : m_Buffers)
+		{
+			buffer->Destroy(device);
+			delete buffer;
+		}
+
+#ifdef DEBUG
+		m_CleanedUp = true;
+#endif // DEBUG
+	}
+
+	uint32_t MaterialTable::Register(const MaterialData& material)
+	{
+		SGE_ASSERTM(m_Materials.size() < MAX_MATERIALS, "Material table is full.");
+
+		m_Materials.push_back(material);
+		m_Version++;
+		return static_cast<uint32_t>(m_Materials.size() - 1);
+	}
+
+	void MaterialTable::Set(uint32_t index, const MaterialData& material)
+	{
+		m_Materials[index] = material;
+		m_Version++;
+	}
+
+	void MaterialTable::Update(VkDevice device, uint32_t frameIndex)
+	{
+		if (m_BufferVersions[frameIndex] == m_Version || m_Materials.empty())
+			return;
+
+		m_Buffers[frameIndex]->Upload(device, m_Materials.data(), m_Materials.size() * sizeof(MaterialData));
+		m_BufferVersions[frameIndex] = m_Version;
+	}
+} // namespace sge::vulkan
\ No newline at end of file
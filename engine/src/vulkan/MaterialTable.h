@@ -0,0 +1,74 @@
+#pragma once
+
+#include "Buffer.h"
+#include "FrameGroup.h"
+#include "TextureTable.h"
+#include "base.h"
+
+#include <vulkan/vulkan.h>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+#include <vector>
+
+namespace sge::vulkan
+{
+	constexpr uint32_t MAX_MATERIALS = 1024;
+
+	// 'MaterialData::Flags', must match 'shaders/material.glsl'
+	// The normal map only stores X and Y (BC5), Z is reconstructed in the shader
+	constexpr uint32_t MATERIAL_NORMAL_MAP_XY = 1;
+
+	// Must match 'MaterialData' in 'shaders/material.glsl'
+	struct MaterialData
+	{
+		// Phong parameters
+		float Ks = 1.0f; // Specular reflection constant
+		float Kd = 1.0f; // Diffuse reflection constant
+		float Ka = 1.0f; // Ambient reflection constant
+		float A = 1.0f;  // Shininess constant
+		glm::vec3 Color = { 0.6f, 0.0f, 0.0f };
+		// Indices into the bindless texture table
+		uint32_t AlbedoIndex = INVALID_TEXTURE_INDEX;
+		uint32_t NormalMapIndex = INVALID_TEXTURE_INDEX;
+		uint32_t Flags = 0;
+		// Where the textures are in their images, see 'PackedTexture'. Layer 0 and the whole layer for unpacked textures.
+		uint32_t AlbedoLayer = 0;
+		uint32_t NormalMapLayer = 0;
+		glm::vec4 AlbedoRect = { 0.0f, 0.0f, 1.0f, 1.0f };
+		glm::vec4 NormalMapRect = { 0.0f, 0.0f, 1.0f, 1.0f };
+	};
+
+	// Parameters of every material in a storage buffer (set 0, binding 5) that the fragment shaders index with the
+	// object's material index. Materials are uploaded when they are added or changed instead of being pushed per draw.
+	class MaterialTable
+	{
+	public:
+		MaterialTable(VkDevice device, MemoryAllocator* allocator);
+		void Destroy(VkDevice device);
+#ifdef DEBUG
+		~MaterialTable()
+		{
+			SGE_ASSERTM(m_CleanedUp, "Material table was not cleaned up.");
+		}
+#endif // DEBUG
+		uint32_t Register(const MaterialData& material);
+		void Set(uint32_t index, const MaterialData& material);
+		// Uploads the materials to the frame's buffer if they changed since it was last used
+		void Update(VkDevice device, uint32_t frameIndex);
+	public:
+		inline const FrameGroup<StorageBuffer*>& GetBuffers() const { return m_Buffers; }
+		inline const MaterialData& Get(uint32_t index) const { return m_Materials[index]; }
+		inline uint32_t GetCount() const { return static_cast<uint32_t>(m_Materials.size()); }
+	private:
+		// One buffer per frame in flight, so changing a material does not affect frames the GPU is still reading
+		FrameGroup<StorageBuffer*> m_Buffers;
+		std::vector<MaterialData> m_Materials;
+		// Incremented on every change, compared with the version each frame's buffer holds
+		uint32_t m_Version;
+		FrameGroup<uint32_t> m_BufferVersions;
+#ifdef DEBUG
+		bool m_CleanedUp = false;
+#endif // DEBUG
+	};
+} // namespace sge::vulkan
\ No newline at end of file
@@ -0,0 +1,711 @@
+#include "MemoryAllocator.h"
+#include "Buffer.h"
+#include "FrameGroup.h"
+
+#include <array>
+#include <unordered_map>
+#include <algorithm>
+
+namespace sge::vulkan
+{
+	// Offsets and sizes inside a block are multiples of this, which covers the alignment of almost every resource
+	constexpr VkDeviceSize MIN_ALLOCATION_ALIGNMENT = 256;
+	constexpr uint32_t MIN_ALLOCATION_ALIGNMENT_LOG2 = 8;
+	// Every power of two size class is split into 2^TLSF_SL_BITS linear classes
+	constexpr uint32_t TLSF_SL_BITS = 4;
+	constexpr uint32_t TLSF_SL_COUNT = 1 << TLSF_SL_BITS;
+	// Sizes below 2^TLSF_FL_SHIFT share the first class, which is split into multiples of the minimum alignment
+	constexpr uint32_t TLSF_FL_SHIFT = MIN_ALLOCATION_ALIGNMENT_LOG2 + TLSF_SL_BITS;
+	constexpr uint32_t TLSF_FL_COUNT = 64 - TLSF_FL_SHIFT + 1;
+	constexpr uint32_t INVALID_NODE = UINT32_MAX;
+
+	static VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	static uint32_t HighestBit(uint64_t value)
+	{
+		uint32_t bit = 0;
+		while (value >>= 1)
+			bit++;
+		return bit;
+	}
+
+	static uint32_t LowestBit(uint64_t value)
+	{
+		uint32_t bit = 0;
+		while (!(value & 1))
+		{
+			value >>= 1;
+			bit++;
+		}
+		return bit;
+	}
+
+	// Free ranges are kept in lists by size class, found through two levels of bitmaps. A range from the first non-empty
+	// class that is at least as large as the request always fits, neighbouring free ranges are merged when freeing.
+	class TlsfHeap
+	{
+	public:
+		TlsfHeap(VkDeviceSize size)
+			: m_FirstLevelBitmap(0), m_SecondLevelBitmaps({}), m_UsedSize(0), m_AllocationCount(0)
+		{
+			for (auto& heads : m_FreeHeads)
+				heads.fill(INVALID_NODE);
+
+			uint32_t node = NewNode();
+			m_Nodes[node].Offset = 0;
+			m_Nodes[node].Size = size - size % MIN_ALLOCATION_ALIGNMENT;
+			InsertFree(node);
+		}
+
+		// Returns 'INVALID_NODE' if no free range is large enough
+		uint32_t Allocate(VkDeviceSize size, VkDeviceSize alignment)
+		{
+			size = AlignUp(std::max(size, VkDeviceSize(1)), MIN_ALLOCATION_ALIGNMENT);
+			alignment = std::max(alignment, MIN_ALLOCATION_ALIGNMENT);
+
+			// Offsets are multiples of the minimum alignment, so this is the largest padding a range can need
+			uint32_t node = FindFree(size + alignment - MIN_ALLOCATION_ALIGNMENT);
+			if (node == INVALID_NODE)
+				return INVALID_NODE;
+			RemoveFree(node);
+
+			// The padding in front stays free
+			VkDeviceSize padding = AlignUp(m_Nodes[node].Offset, alignment) - m_Nodes[node].Offset;
+			if (padding > 0)
+			{
+				uint32_t front = NewNode();
+				uint32_t previous = m_Nodes[node].PreviousPhysical;
+				m_Nodes[front].Offset = m_Nodes[node].Offset;
+				m_Nodes[front].Size = padding;
+				m_Nodes[front].PreviousPhysical = previous;
+				m_Nodes[front].NextPhysical = node;
+				if (previous != INVALID_NODE)
+					m_Nodes[previous].NextPhysical = front;
+
+				m_Nodes[node].PreviousPhysical = front;
+				m_Nodes[node].Offset += padding;
+				m_Nodes[node].Size -= padding;
+				InsertFree(front);
+			}
+
+			if (m_Nodes[node].Size > size)
+			{
+				uint32_t back = NewNode();
+				uint32_t next = m_Nodes[node].NextPhysical;
+				m_Nodes[back].Offset = m_Nodes[node].Offset + size;
+				m_Nodes[back].Size = m_Nodes[node].Size - size;
+				m_Nodes[back].PreviousPhysical = node;
+				m_Nodes[back].NextPhysical = next;
+				if (next != INVALID_NODE)
+					m_Nodes[next].PreviousPhysical = back;
+
+				m_Nodes[node].NextPhysical = back;
+				m_Nodes[node].Size = size;
+				InsertFree(back);
+			}
+
+			m_UsedSize += size;
+			m_AllocationCount++;
+			return node;
+		}
+
+		void Free(uint32_t node)
+		{
+			SGE_ASSERTM(!m_Nodes[node].IsFree, "Memory is freed twice.");
+			m_UsedSize -= m_Nodes[node].Size;
+			m_AllocationCount--;
+
+			uint32_t previous = m_Nodes[node].PreviousPhysical;
+			if (previous != INVALID_NODE && m_Nodes[previous].IsFree)
+			{
+				RemoveFree(previous);
+				Merge(previous, node);
+				node = previous;
+			}
+
+			uint32_t next = m_Nodes[node].NextPhysical;
+			if (next != INVALID_NODE && m_Nodes[next].IsFree)
+			{
+				RemoveFree(next);
+				Merge(node, next);
+			}
+
+			InsertFree(node);
+		}
+	public:
+		inline VkDeviceSize GetOffset(uint32_t node) const { return m_Nodes[node].Offset; }
+		inline VkDeviceSize GetUsedSize() const { return m_UsedSize; }
+		inline bool IsEmpty() const { return m_AllocationCount == 0; }
+	private:
+		struct Node
+		{
+			VkDeviceSize Offset = 0;
+			VkDeviceSize Size = 0;
+			// Neighbouring ranges in the block
+			uint32_t PreviousPhysical = INVALID_NODE;
+			uint32_t NextPhysical = INVALID_NODE;
+			// Neighbours in the free list of the size class
+			uint32_t PreviousFree = INVALID_NODE;
+			uint32_t NextFree = INVALID_NODE;
+			bool IsFree = false;
+		};
+
+		// Size class containing 'size'
+		static void Mapping(VkDeviceSize size, uint32_t& firstLevel, uint32_t& secondLevel)
+		{
+			if (size < (1ull << TLSF_FL_SHIFT))
+			{
+				firstLevel = 0;
+				secondLevel = static_cast<uint32_t>(size >> MIN_ALLOCATION_ALIGNMENT_LOG2);
+				return;
+			}
+
+			uint32_t highestBit = HighestBit(size);
+			firstLevel = highestBit - TLSF_FL_SHIFT + 1;
+			secondLevel = static_cast<uint32_t>(size >> (highestBit - TLSF_SL_BITS)) & (TLSF_SL_COUNT - 1);
+		}
+
+		// Head of the first free list whose ranges are all at least 'size'
+		uint32_t FindFree(VkDeviceSize size) const
+		{
+			// Rounding up to the next class skips the class of 'size' itself, which may hold smaller ranges
+			if (size >= (1ull << TLSF_FL_SHIFT))
+				size += (1ull << (HighestBit(size) - TLSF_SL_BITS)) - 1;
+
+			uint32_t firstLevel, secondLevel;
+			Mapping(size, firstLevel, secondLevel);
+			if (firstLevel >= TLSF_FL_COUNT)
+				return INVALID_NODE;
+
+			uint32_t secondLevelMap = m_SecondLevelBitmaps[firstLevel] & (~0u << secondLevel);
+			if (!secondLevelMap)
+			{
+				uint64_t firstLevelMap = firstLevel + 1 < 64 ? m_FirstLevelBitmap & (~0ull << (firstLevel + 1)) : 0;
+				if (!firstLevelMap)
+					return INVALID_NODE;
+
+				firstLevel = LowestBit(firstLevelMap);
+				secondLevelMap = m_SecondLevelBitmaps[firstLevel];
+			}
+
+			return m_FreeHeads[firstLevel][LowestBit(secondLevelMap)];
+		}
+
+		void InsertFree(uint32_t node)
+		{
+			uint32_t firstLevel, secondLevel;
+			Mapping(m_Nodes[node].Size, firstLevel, secondLevel);
+
+			uint32_t head = m_FreeHeads[firstLevel][secondLevel];
+			m_Nodes[node].IsFree = true;
+			m_Nodes[node].PreviousFree = INVALID_NODE;
+			m_Nodes[node].NextFree = head;
+			if (head != INVALID_NODE)
+				m_Nodes[head].PreviousFree = node;
+
+			m_FreeHeads[firstLevel][secondLevel] = node;
+			m_SecondLevelBitmaps[firstLevel] |= 1u << secondLevel;
+			m_FirstLevelBitmap |= 1ull << firstLevel;
+		}
+
+		void RemoveFree(uint32_t node)
+		{
+			uint32_t firstLevel, secondLevel;
+			Mapping(m_Nodes[node].Size, firstLevel, secondLevel);
+
+			uint32_t previous = m_Nodes[node].PreviousFree;
+			uint32_t next = m_Nodes[node].NextFree;
+			if (previous != INVALID_NODE)
+				m_Nodes[previous].NextFree = next;
+			if (next != INVALID_NODE)
+				m_Nodes[next].PreviousFree = previous;
+
+			if (m_FreeHeads[firstLevel][secondLevel] == node)
+			{
+				m_FreeHeads[firstLevel][secondLevel] = next;
+				if (next == INVALID_NODE)
+				{
+					m_SecondLevelBitmaps[firstLevel] &= ~(1u << secondLevel);
+					if (!m_SecondLevelBitmaps[firstLevel])
+						m_FirstLevelBitmap &= ~(1ull << firstLevel);
+				}
+			}
+
+			m_Nodes[node].IsFree = false;
+		}
+
+		// Appends 'second' to its physical predecessor 'first' and recycles it
+		void Merge(uint32_t first, uint32_t second)
+		{
+			uint32_t next = m_Nodes[second].NextPhysical;
+			m_Nodes[first].Size += m_Nodes[second].Size;
+			m_Nodes[first].NextPhysical = next;
+			if (next != INVALID_NODE)
+				m_Nodes[next].PreviousPhysical = first;
+
+			m_Nodes[second] = {};
+			m_UnusedNodes.push_back(second);
+		}
+
+		uint32_t NewNode()
+		{
+			if (!m_UnusedNodes.empty())
+			{
+				uint32_t node = m_UnusedNodes.back();
+				m_UnusedNodes.pop_back();
+				return node;
+			}
+
+			m_Nodes.emplace_back();
+			return static_cast<uint32_t>(m_Nodes.size() - 1);
+		}
+	private:
+		std::vector<Node> m_Nodes;
+		std::vector<uint32_t> m_UnusedNodes;
+		uint64_t m_FirstLevelBitmap;
+		std::array<uint32_t, TLSF_FL_COUNT> m_SecondLevelBitmaps;
+		std::array<std::array<uint32_t, TLSF_SL_COUNT>, TLSF_FL_COUNT> m_FreeHeads;
+		VkDeviceSize m_UsedSize;
+		uint32_t m_AllocationCount;
+	};
+
+	struct MovableBuffer
+	{
+		Buffer* Owner;
+		VkDeviceSize Size;
+		VkDeviceSize Alignment;
+		MemoryCategory Category;
+	};
+
+	struct MemoryBlock
+	{
+		VkDeviceMemory Memory;
+		VkDeviceSize Size;
+		// Null unless the memory is host visible
+		uint8_t* Data;
+		uint32_t MemoryType;
+		bool Linear;
+		TlsfHeap Heap;
+		// Allocation node to the buffer bound to it
+		std::unordered_map<uint32_t, MovableBuffer> Movables;
+	};
+
+	static Allocation MakeAllocation(MemoryBlock* block, uint32_t node, VkDeviceSize size, MemoryCategory category)
+	{
+		Allocation allocation;
+		allocation.Memory = block->Memory;
+		allocation.Offset = block->Heap.GetOffset(node);
+		allocation.Size = size;
+		allocation.Data = block->Data ? block->Data + allocation.Offset : nullptr;
+		allocation.Category = category;
+		allocation.MemoryType = block->MemoryType;
+		allocation.Block = block;
+		allocation.Node = node;
+		return allocation;
+	}
+
+	MemoryAllocator::MemoryAllocator(VkDevice device, VkPhysicalDevice physicalDevice, bool memoryBudget, float pressureThreshold,
+		VkDeviceSize blockSize)
+		: m_PhysicalDevice(physicalDevice), m_MemoryProperties({}), m_HasMemoryBudget(memoryBudget), m_PressureThreshold(pressureThreshold),
+		m_BlockSize(blockSize), m_FrameNumber(0), m_ReservedBytes(0), m_UsedBytes(0), m_CategoryBytes({}), m_HeapReservedBytes({}),
+		m_HeapUsedBytes({})
+	{
+		vkGetPhysicalDeviceMemoryProperties(physicalDevice, &m_MemoryProperties);
+		UpdateBudget();
+		SGE_INFOF("Device local memory budget: %llu MiB%s.", static_cast<unsigned long long>(m_Budget.Budget >> 20),
+			m_HasMemoryBudget ? "" : " (estimated, VK_EXT_memory_budget is not supported)");
+	}
+
+	void MemoryAllocator::Destroy(VkDevice device)
+	{
+		for (const MovedBuffer& moved : m_MovedBuffers)
+		{
+			vkDestroyBuffer(device, moved.Buffer, nullptr);
+			Free(device, moved.Memory);
+		}
+		m_MovedBuffers.clear();
+
+		if (m_UsedBytes > 0)
+			SGE_WARNF("%llu bytes of device memory were not freed.", static_cast<unsigned long long>(m_UsedBytes));
+
+		for (MemoryBlock* block : m_Blocks)
+		{
+			vkFreeMemory(device, block->Memory, nullptr);
+			delete block;
+		}
+		m_Blocks.clear();
+
+#ifdef DEBUG
+		m_CleanedUp = true;
+#endif // DEBUG
+	}
+
+	uint32_t MemoryAllocator::FindMemoryType(uint32_t memoryTypeBits, MemoryUsage usage) const
+	{
+		VkMemoryPropertyFlags required = 0;
+		VkMemoryPropertyFlags preferred = 0;
+		switch (usage)
+		{
+		case MemoryUsage::GpuOnly:
+			preferred = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+			break;
+		case MemoryUsage::CpuToGpu:
+			required = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+			break;
+		case MemoryUsage::GpuToCpu:
+			required = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+			preferred = VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+			break;
+		}
+
+		// Types are ordered by performance, so the first match is the best one
+		for (VkMemoryPropertyFlags flags : { required | preferred, required })
+		{
+			for (uint32_t i = 0; i < m_MemoryProperties.memoryTypeCount; i++)
+			{
+				if ((memoryTypeBits & (1u << i)) && (m_MemoryProperties.memoryTypes[i].propertyFlags & flags) == flags)
+					return i;
+			}
+		}
+
+		SGE_DEBUG_BREAKM("Failed to find suitable memory type.");
+		return UINT32_MAX;
+	}
+
+	const char* MemoryAllocator::GetCategoryName(MemoryCategory category)
+	{
+		switch (category)
+		{
+		case MemoryCategory::Geometry:
+			return "Geometry";
+		case MemoryCategory::Textures:
+			return "Textures";
+		case MemoryCategory::Uniforms:
+			return "Uniforms";
+		case MemoryCategory::Attachments:
+			return "Attachments";
+		default:
+			return "Other";
+		}
+	}
+
+	Allocation MemoryAllocator::Allocate(VkDevice device, const VkMemoryRequirements& requirements, MemoryUsage usage, MemoryCategory category,
+		bool linear)
+	{
+		uint32_t memoryType = FindMemoryType(requirements.memoryTypeBits, usage);
+
+		if (requirements.size > m_BlockSize / 2)
+		{
+			Allocation allocation;
+			allocation.Size = requirements.size;
+			allocation.Category = category;
+			allocation.MemoryType = memoryType;
+
+			VkMemoryAllocateInfo allocInfo = {};
+			allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+			allocInfo.allocationSize = requirements.size;
+			allocInfo.memoryTypeIndex = memoryType;
+
+			if (vkAllocateMemory(device, &allocInfo, nullptr, &allocation.Memory) != VK_SUCCESS)
+				SGE_DEBUG_BREAKM("Failed to allocate Vulkan memory.");
+
+			if (IsHostVisible(memoryType))
+				vkMapMemory(device, allocation.Memory, 0, VK_WHOLE_SIZE, 0, reinterpret_cast<void**>(&allocation.Data));
+
+			Track(memoryType, category, requirements.size, requirements.size);
+			return allocation;
+		}
+
+		Allocation allocation = AllocateFromBlocks(m_Blocks, memoryType, linear, requirements.size, requirements.alignment, category);
+		if (allocation.Memory)
+			return allocation;
+
+		MemoryBlock* block = CreateBlock(device, memoryType, linear);
+		uint32_t node = block->Heap.Allocate(requirements.size, requirements.alignment);
+		Track(memoryType, category, requirements.size, 0);
+		return MakeAllocation(block, node, requirements.size, category);
+	}
+
+	Allocation MemoryAllocator::AllocateBuffer(VkDevice device, VkBuffer buffer, MemoryUsage usage, MemoryCategory category)
+	{
+		VkMemoryRequirements memoryRequirements;
+		vkGetBufferMemoryRequirements(device, buffer, &memoryRequirements);
+
+		Allocation allocation = Allocate(device, memoryRequirements, usage, category, true);
+		vkBindBufferMemory(device, buffer, allocation.Memory, allocation.Offset);
+		return allocation;
+	}
+
+	void MemoryAllocator::Free(VkDevice device, const Allocation& allocation)
+	{
+		if (!allocation.Memory)
+			return;
+
+		MemoryBlock* block = allocation.Block;
+		if (!block)
+		{
+			// Freeing the memory unmaps it
+			vkFreeMemory(device, allocation.Memory, nullptr);
+			Track(allocation.MemoryType, allocation.Category, -static_cast<int64_t>(allocation.Size), -static_cast<int64_t>(allocation.Size));
+			return;
+		}
+
+		Track(allocation.MemoryType, allocation.Category, -static_cast<int64_t>(allocation.Size), 0);
+
+		block->Movables.erase(allocation.Node);
+		block->Heap.Free(allocation.Node);
+		if (!block->Heap.IsEmpty())
+			return;
+
+		// One empty block per memory type is kept, so that usage going up and down does not allocate memory every time
+		for (const MemoryBlock* other : m_Blocks)
+		{
+			if (other != block && other->MemoryType == block->MemoryType && other->Linear == block->Linear)
+			{
+				DestroyBlock(device, block);
+				return;
+			}
+		}
+	}
+
+	void MemoryAllocator::SetMovable(const Allocation& allocation, Buffer* owner, VkDeviceSize alignment)
+	{
+		if (allocation.Block)
+			allocation.Block->Movables[allocation.Node] = { owner, allocation.Size, alignment, allocation.Category };
+	}
+
+	VkDeviceSize MemoryAllocator::Defragment(VkDevice device, VkCommandBuffer commandBuffer, VkDeviceSize maxBytes)
+	{
+		// Blocks that are at most half full are emptied into fuller ones. Blocks with moves that are not freed yet are left alone,
+		// their used size still counts the previous copies, and moving into them could move the same buffers back.
+		auto isCandidate = [](const MemoryBlock* block)
+		{
+			return !block->Movables.empty() && block->Heap.GetUsedSize() <= block->Size / 2;
+		};
+		auto hasPendingMoves = [this](const MemoryBlock* block)
+		{
+			return std::any_of(m_MovedBuffers.begin(), m_MovedBuffers.end(),
+				[block](const MovedBuffer& moved) { return moved.Memory.Block == block; });
+		};
+		auto isDestination = [&](const MemoryBlock* block, const MemoryBlock* source)
+		{
+			return block != source && block->MemoryType == source->MemoryType && block->Linear == source->Linear
+				&& block->Heap.GetUsedSize() > source->Heap.GetUsedSize() && !isCandidate(block) && !hasPendingMoves(block);
+		};
+
+		// The least used candidate that has somewhere to move its buffers to
+		MemoryBlock* source = nullptr;
+		for (MemoryBlock* block : m_Blocks)
+		{
+			if (!isCandidate(block) || hasPendingMoves(block))
+				continue;
+			if (source && block->Heap.GetUsedSize() >= source->Heap.GetUsedSize())
+				continue;
+
+			bool hasDestination = std::any_of(m_Blocks.begin(), m_Blocks.end(),
+				[&](const MemoryBlock* other) { return isDestination(other, block); });
+			if (hasDestination)
+				source = block;
+		}
+
+		if (!source)
+			return 0;
+
+		std::vector<MemoryBlock*> destinations;
+		for (MemoryBlock* block : m_Blocks)
+		{
+			if (isDestination(block, source))
+				destinations.push_back(block);
+		}
+
+		VkDeviceSize movedBytes = 0;
+		// Stops once every movable buffer left the source, it is freed with the last previous copy
+		for (auto it = source->Movables.begin(); it != source->Movables.end() && movedBytes < maxBytes;)
+		{
+			const MovableBuffer movable = it->second;
+			Allocation destination = AllocateFromBlocks(destinations, source->MemoryType, source->Linear, movable.Size, movable.Alignment,
+				movable.Category);
+			// The destinations are full
+			if (!destination.Memory)
+				break;
+
+			Allocation previous = MakeAllocation(source, it->first, movable.Size, movable.Category);
+			VkBuffer previousBuffer = movable.Owner->Move(device, commandBuffer, destination);
+			destination.Block->Movables[destination.Node] = movable;
+			it = source->Movables.erase(it);
+
+			m_MovedBuffers.push_back({ previousBuffer, previous, m_FrameNumber });
+			movedBytes += movable.Size;
+		}
+
+		if (movedBytes > 0)
+		{
+			// Moved buffers are only read as vertices and indices
+			VkMemoryBarrier barrier = {};
+			barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0, 1, &barrier,
+				0, nullptr, 0, nullptr);
+			SGE_TRACEF("Defragmentation moved %llu bytes.", static_cast<unsigned long long>(movedBytes));
+		}
+
+		return movedBytes;
+	}
+
+	void MemoryAllocator::BeginFrame(VkDevice device)
+	{
+		m_FrameNumber++;
+
+		// Frames recorded before the move may still read the previous buffers
+		auto firstLive = std::remove_if(m_MovedBuffers.begin(), m_MovedBuffers.end(), [this, device](const MovedBuffer& moved)
+		{
+			if (m_FrameNumber - moved.Frame <= MAX_FRAMES_IN_FLIGHT)
+				return false;
+
+			vkDestroyBuffer(device, moved.Buffer, nullptr);
+			Free(device, moved.Memory);
+			return true;
+		});
+		m_MovedBuffers.erase(firstLive, m_MovedBuffers.end());
+
+		UpdateBudget();
+	}
+
+	Allocation MemoryAllocator::AllocateFromBlocks(const std::vector<MemoryBlock*>& blocks, uint32_t memoryType, bool linear,
+		VkDeviceSize size, VkDeviceSize alignment, MemoryCategory category)
+	{
+		for (MemoryBlock* block : blocks)
+		{
+			if (block->MemoryType != memoryType || block->Linear != linear)
+				continue;
+
+			uint32_t node = block->Heap.Allocate(size, alignment);
+			if (node != INVALID_NODE)
+			{
+				Track(memoryType, category, size, 0);
+				return MakeAllocation(block, node, size, category);
+			}
+		}
+
+		return {};
+	}
+
+	MemoryBlock* MemoryAllocator::CreateBlock(VkDevice device, uint32_t memoryType, bool linear)
+	{
+		VkMemoryAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize = m_BlockSize;
+		allocInfo.memoryTypeIndex = memoryType;
+
+		VkDeviceMemory memory;
+		if (vkAllocateMemory(device, &allocInfo, nullptr, &memory) != VK_SUCCESS)
+			SGE_DEBUG_BREAKM("Failed to allocate Vulkan memory block.");
+
+		uint8_t* data = nullptr;
+		if (IsHostVisible(memoryType))
+			vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, reinterpret_cast<void**>(&data));
+
+		MemoryBlock* block = new MemoryBlock{ memory, m_BlockSize, data, memoryType, linear, TlsfHeap(m_BlockSize), {} };
+		m_Blocks.push_back(block);
+		Track(memoryType, MemoryCategory::Other, 0, m_BlockSize);
+		SGE_TRACEF("Allocated memory block %u of memory type %u.", static_cast<uint32_t>(m_Blocks.size()), memoryType);
+
+		return block;
+	}
+
+	void MemoryAllocator::DestroyBlock(VkDevice device, MemoryBlock* block)
+	{
+		vkFreeMemory(device, block->Memory, nullptr);
+		Track(block->MemoryType, MemoryCategory::Other, 0, -static_cast<int64_t>(block->Size));
+		m_Blocks.erase(std::find(m_Blocks.begin(), m_Blocks.end(), block));
+		delete block;
+	}
+
+	bool MemoryAllocator::IsHostVisible(uint32_t memoryType) const
+	{
+		return m_MemoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+	}
+
+	void MemoryAllocator::Track(uint32_t memoryType, MemoryCategory category, int64_t used, int64_t reserved)
+	{
+		uint32_t heap = m_MemoryProperties.memoryTypes[memoryType].heapIndex;
+		m_UsedBytes += used;
+		m_ReservedBytes += reserved;
+		m_CategoryBytes[static_cast<size_t>(category)] += used;
+		m_HeapUsedBytes[heap] += used;
+		m_HeapReservedBytes[heap] += reserved;
+	}
+
+	void MemoryAllocator::UpdateBudget()
+	{
+		VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties = {};
+		budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+		if (m_HasMemoryBudget)
+		{
+			VkPhysicalDeviceMemoryProperties2 properties = {};
+			properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+			properties.pNext = &budgetProperties;
+			vkGetPhysicalDeviceMemoryProperties2(m_PhysicalDevice, &properties);
+		}
+
+		m_Budget = {};
+		for (uint32_t i = 0; i < m_MemoryProperties.memoryHeapCount; i++)
+		{
+			if (!(m_MemoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT))
+				continue;
+
+			if (m_HasMemoryBudget)
+			{
+				// The driver counts whole blocks, their free ranges are available to this process
+				VkDeviceSize unused = std::min(m_HeapReservedBytes[i] - m_HeapUsedBytes[i], budgetProperties.heapUsage[i]);
+				m_Budget.Usage += budgetProperties.heapUsage[i] - unused;
+				m_Budget.Budget += budgetProperties.heapBudget[i];
+			}
+			else
+			{
+				// Leaves room for other processes and the driver's own allocations
+				m_Budget.Usage += m_HeapUsedBytes[i];
+				m_Budget.Budget += m_MemoryProperties.memoryHeaps[i].size / 5 * 4;
+			}
+		}
+	}
+
+	LinearPool::LinearPool(VkDevice device, MemoryAllocator* allocator, const VkMemoryRequirements& requirements, MemoryUsage usage,
+		MemoryCategory category, bool linear)
+		: m_Allocator(allocator), m_Offset(0)
+	{
+		m_Memory = allocator->Allocate(device, requirements, usage, category, linear);
+	}
+
+	void LinearPool::Destroy(VkDevice device)
+	{
+		m_Allocator->Free(device, m_Memory);
+
+#ifdef DEBUG
+		m_CleanedUp = true;
+#endif // DEBUG
+	}
+
+	Allocation LinearPool::Allocate(VkDeviceSize size, VkDeviceSize alignment)
+	{
+		// 'm_Memory.Offset' itself is aligned to the largest alignment in the pool's requirements
+		VkDeviceSize offset = AlignUp(m_Offset, alignment);
+		if (offset + size > m_Memory.Size)
+			return {};
+
+		m_Offset = offset + size;
+
+		Allocation allocation;
+		allocation.Memory = m_Memory.Memory;
+		allocation.Offset = m_Memory.Offset + offset;
+		allocation.Size = size;
+		allocation.Data = m_Memory.Data ? m_Memory.Data + offset : nullptr;
+		allocation.Category = m_Memory.Category;
+		allocation.MemoryType = m_Memory.MemoryType;
+		return allocation;
+	}
+} // namespace sge::vulkan
\ No newline at end of file
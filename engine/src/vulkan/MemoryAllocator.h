@@ -0,0 +1,195 @@
+#pragma once
+
+#include "base.h"
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+#include <array>
+
+namespace sge::vulkan
+{
+	class Buffer;
+	struct MemoryBlock;
+
+	// Size of the device memory blocks that allocations are placed in. Allocations larger than half a block get their own memory.
+	constexpr VkDeviceSize MEMORY_BLOCK_SIZE = 64ull << 20;
+
+	enum class MemoryUsage
+	{
+		// Only accessed by the GPU, e.g. static geometry, textures and attachments. Placed in device local memory.
+		GpuOnly,
+		// Written by the CPU and read by the GPU, e.g. uniforms
+		CpuToGpu,
+		// Written by the GPU and read back by the CPU, cached on the host if possible
+		GpuToCpu
+	};
+
+	// What memory is used for, tracked separately so that the budget can be broken down
+	enum class MemoryCategory
+	{
+		// Vertex and index buffers
+		Geometry,
+		// Sampled images
+		Textures,
+		// Uniform and storage buffers
+		Uniforms,
+		// Render targets and other images written by the GPU, including the render graph's transients
+		Attachments,
+		// Staging and readback memory
+		Other,
+		Count
+	};
+
+	// Device local memory of every device local heap. With 'VK_EXT_memory_budget' both numbers come from the driver and include
+	// other processes, otherwise the usage is this allocator's and the budget is a fraction of the heap size.
+	struct MemoryBudget
+	{
+		// Free ranges inside the allocator's blocks are not counted, new allocations are placed there first
+		VkDeviceSize Usage = 0;
+		VkDeviceSize Budget = 0;
+	};
+
+	// Range of device memory. Host visible allocations stay mapped for their whole lifetime, 'Data' points at 'Offset'.
+	struct Allocation
+	{
+		VkDeviceMemory Memory = nullptr;
+		VkDeviceSize Offset = 0;
+		VkDeviceSize Size = 0;
+		uint8_t* Data = nullptr;
+		MemoryCategory Category = MemoryCategory::Other;
+		uint32_t MemoryType = 0;
+		// Null for allocations with their own memory
+		MemoryBlock* Block = nullptr;
+		uint32_t Node = 0;
+	};
+
+	// Places allocations in large blocks of device memory, one set of blocks per memory type, which keeps the number of
+	// 'vkAllocateMemory' calls far below 'maxMemoryAllocationCount'. Each block is managed by a TLSF allocator (two level
+	// segregated fit), so allocating and freeing take constant time. Buffers and optimal tiling images never share a block,
+	// which keeps them apart by more than 'bufferImageGranularity'.
+	class MemoryAllocator
+	{
+	public:
+		// 'memoryBudget' is true if 'VK_EXT_memory_budget' is enabled on the device. Usage above 'pressureThreshold' times the budget
+		// is reported by 'GetExcessBytes'.
+		MemoryAllocator(VkDevice device, VkPhysicalDevice physicalDevice, bool memoryBudget, float pressureThreshold,
+			VkDeviceSize blockSize = MEMORY_BLOCK_SIZE);
+#ifdef DEBUG
+		~MemoryAllocator()
+		{
+			SGE_ASSERTM(m_CleanedUp, "Memory allocator was not cleaned up.");
+		}
+#endif // DEBUG
+		// Call when the device is idle, after every allocation was freed
+		void Destroy(VkDevice device);
+
+		// 'linear' is true for buffers and linear tiling images
+		Allocation Allocate(VkDevice device, const VkMemoryRequirements& requirements, MemoryUsage usage, MemoryCategory category,
+			bool linear);
+		// Allocates memory for 'buffer' and binds it
+		Allocation AllocateBuffer(VkDevice device, VkBuffer buffer, MemoryUsage usage, MemoryCategory category);
+		// Frees right away, the GPU must be done with the memory
+		void Free(VkDevice device, const Allocation& allocation);
+
+		// Lets 'Defragment' move the buffer bound to 'allocation', which must not be referenced by any descriptor
+		void SetMovable(const Allocation& allocation, Buffer* owner, VkDeviceSize alignment);
+		// Moves up to 'maxBytes' of movable buffers out of the least used block into fuller blocks of the same memory type,
+		// recording the copies into 'commandBuffer', so that the block can be freed once it is empty. Returns the bytes moved.
+		VkDeviceSize Defragment(VkDevice device, VkCommandBuffer commandBuffer, VkDeviceSize maxBytes);
+		// Frees the buffers replaced by 'Defragment' once no frame in flight uses them and queries the budget, call once per frame
+		void BeginFrame(VkDevice device);
+
+		uint32_t FindMemoryType(uint32_t memoryTypeBits, MemoryUsage usage) const;
+		static const char* GetCategoryName(MemoryCategory category);
+	public:
+		inline VkDeviceSize GetBlockSize() const { return m_BlockSize; }
+		inline uint32_t GetBlockCount() const { return static_cast<uint32_t>(m_Blocks.size()); }
+		// Bytes of device memory allocated, including the unused parts of blocks
+		inline VkDeviceSize GetReservedBytes() const { return m_ReservedBytes; }
+		// Bytes in use by allocations
+		inline VkDeviceSize GetUsedBytes() const { return m_UsedBytes; }
+		// Bytes in use by allocations of 'category', in any memory type
+		inline VkDeviceSize GetCategoryBytes(MemoryCategory category) const { return m_CategoryBytes[static_cast<size_t>(category)]; }
+		// As of the last 'BeginFrame'
+		inline const MemoryBudget& GetBudget() const { return m_Budget; }
+		inline bool HasMemoryBudgetExtension() const { return m_HasMemoryBudget; }
+		// Bytes that have to be freed to get back below the pressure threshold, 0 if usage is below it
+		inline VkDeviceSize GetExcessBytes() const
+		{
+			VkDeviceSize limit = static_cast<VkDeviceSize>(m_PressureThreshold * m_Budget.Budget);
+			return m_Budget.Usage > limit ? m_Budget.Usage - limit : 0;
+		}
+		// Bytes that can be allocated before usage reaches the pressure threshold
+		inline VkDeviceSize GetHeadroomBytes() const
+		{
+			VkDeviceSize limit = static_cast<VkDeviceSize>(m_PressureThreshold * m_Budget.Budget);
+			return limit > m_Budget.Usage ? limit - m_Budget.Usage : 0;
+		}
+	private:
+		struct MovedBuffer
+		{
+			VkBuffer Buffer;
+			Allocation Memory;
+			uint64_t Frame;
+		};
+
+		// Tries the existing blocks in 'blocks' only
+		Allocation AllocateFromBlocks(const std::vector<MemoryBlock*>& blocks, uint32_t memoryType, bool linear, VkDeviceSize size,
+			VkDeviceSize alignment, MemoryCategory category);
+		MemoryBlock* CreateBlock(VkDevice device, uint32_t memoryType, bool linear);
+		void DestroyBlock(VkDevice device, MemoryBlock* block);
+		bool IsHostVisible(uint32_t memoryType) const;
+		// Keeps the per category and per heap counters up to date, 'reserved' is the change of memory allocated from the device
+		void Track(uint32_t memoryType, MemoryCategory category, int64_t used, int64_t reserved);
+		void UpdateBudget();
+	private:
+		VkPhysicalDevice m_PhysicalDevice;
+		VkPhysicalDeviceMemoryProperties m_MemoryProperties;
+		bool m_HasMemoryBudget;
+		float m_PressureThreshold;
+		VkDeviceSize m_BlockSize;
+		std::vector<MemoryBlock*> m_Blocks;
+		std::vector<MovedBuffer> m_MovedBuffers;
+		uint64_t m_FrameNumber;
+		VkDeviceSize m_ReservedBytes;
+		VkDeviceSize m_UsedBytes;
+		std::array<VkDeviceSize, static_cast<size_t>(MemoryCategory::Count)> m_CategoryBytes;
+		std::array<VkDeviceSize, VK_MAX_MEMORY_HEAPS> m_HeapReservedBytes;
+		std::array<VkDeviceSize, VK_MAX_MEMORY_HEAPS> m_HeapUsedBytes;
+		MemoryBudget m_Budget;
+#ifdef DEBUG
+		bool m_CleanedUp = false;
+#endif // DEBUG
+	};
+
+	// Bump allocator over a single allocation, for data that shares one lifetime, e.g. the render graph's transient images.
+	// Everything in it is freed together with the pool.
+	class LinearPool
+	{
+	public:
+		// 'requirements' are the combined requirements of everything that will be placed in the pool
+		LinearPool(VkDevice device, MemoryAllocator* allocator, const VkMemoryRequirements& requirements, MemoryUsage usage,
+			MemoryCategory category, bool linear);
+#ifdef DEBUG
+		~LinearPool()
+		{
+			SGE_ASSERTM(m_CleanedUp, "Linear memory pool was not cleaned up.");
+		}
+#endif // DEBUG
+		void Destroy(VkDevice device);
+
+		// Returns an allocation with a null 'Memory' if the pool is full
+		Allocation Allocate(VkDeviceSize size, VkDeviceSize alignment);
+	public:
+		inline VkDeviceSize GetSize() const { return m_Memory.Size; }
+		inline VkDeviceSize GetUsedBytes() const { return m_Offset; }
+	private:
+		MemoryAllocator* m_Allocator;
+		Allocation m_Memory;
+		VkDeviceSize m_Offset;
+#ifdef DEBUG
+		bool m_CleanedUp = false;
+#endif // DEBUG
+	};
+} // namespace sge::vulkan
\ No newline at end of file
@@ -0,0 +1,406 @@
+#include "OcclusionCuller.h"
+#include "Util.h"
+
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace sge::vulkan
+{
+	constexpr uint32_t CULL_GROUP_SIZE = 64;
+	constexpr uint32_t PYRAMID_GROUP_SIZE = 8;
+
+	static VkDescriptorSetLayoutBinding MakeBinding(uint32_t binding, VkDescriptorType type)
+	{
+		VkDescriptorSetLayoutBinding layoutBinding = {};
+		layoutBinding.binding = binding;
+		layoutBinding.descriptorType = type;
+		layoutBinding.descriptorCount = 1;
+		layoutBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+		return layoutBinding;
+	}
+
+	static VkDescriptorSetLayout CreateSetLayout(VkDevice device, const std::vector<VkDescriptorSetLayoutBinding>& bindings)
+	{
+		VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+		layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+		layoutInfo.pBindings = bindings.data();
+
+		VkDescriptorSetLayout layout;
+		if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &layout) != VK_SUCCESS)
+			SGE_DEBUG_BREAKM("Failed to create Vulkan descriptor set layout.");
+
+		return layout;
+	}
+
+	OcclusionCuller::OcclusionCuller(VkDevice device, MemoryAllocator* allocator, DescriptorAllocator* descriptorAllocator, VkCommandPool commandPool,
+		VkQueue queue, VkPipelineCache pipelineCache, VkImageView depthImageView, VkExtent2D extent, const std::string& shaderDirectory)
+		: m_CullPipeline(nullptr), m_MeshletPipeline(nullptr), m_PyramidCopyPipeline(nullptr), m_PyramidPipeline(nullptr),
+		m_CullSetLayout(nullptr), m_PyramidCopySetLayout(nullptr), m_PyramidSetLayout(nullptr),
+		m_ObjectCounts({}), m_MeshletCounts({}), m_EarlyDraws(nullptr), m_LateDraws(nullptr),
+		m_EarlyMeshletDraws(nullptr), m_LateMeshletDraws(nullptr), m_Visibility(nullptr), m_Allocator(allocator),
+		m_Sampler(nullptr), m_DepthImageView(nullptr), m_Pyramid(nullptr), m_PyramidView(nullptr), m_PyramidLevelViews({}),
+		m_PyramidExtent({ 0, 0 }), m_PyramidLevels(0)
+	{
+		// Descriptor set layouts, see 'culling.glsl', 'hizcopy.comp' and 'hiz.comp'. The object and meshlet culling shaders share a set.
+		m_CullSetLayout = CreateSetLayout(device, {
+			MakeBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER),
+			MakeBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER),
+			MakeBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER),
+			MakeBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER),
+			MakeBinding(4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER),
+			MakeBinding(5, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER),
+			MakeBinding(6, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER),
+			MakeBinding(7, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER),
+			MakeBinding(8, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER)
+		});
+		m_PyramidCopySetLayout = CreateSetLayout(device, {
+			MakeBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER),
+			MakeBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE)
+		});
+		m_PyramidSetLayout = CreateSetLayout(device, {
+			MakeBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE),
+			MakeBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE)
+		});
+
+		m_CullPipeline = new ComputePipeline(device, shaderDirectory + "/cull.comp.spv", { m_CullSetLayout }, sizeof(uint32_t), pipelineCache);
+		m_MeshletPipeline = new ComputePipeline(device, shaderDirectory + "/meshlet.comp.spv", { m_CullSetLayout }, sizeof(uint32_t), pipelineCache);
+		m_PyramidCopyPipeline = new ComputePipeline(device, shaderDirectory + "/hizcopy.comp.spv", { m_PyramidCopySetLayout }, 0, pipelineCache);
+		m_PyramidPipeline = new ComputePipeline(device, shaderDirectory + "/hiz.comp.spv", { m_PyramidSetLayout }, 0, pipelineCache);
+
+		// The pyramid's sets are allocated every frame, see 'RecordBuildPyramid'
+		for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+			m_CullSets[i] = descriptorAllocator->Allocate(device, m_CullSetLayout);
+
+		// Buffers. Draw commands and visibility are only written by the GPU, so they are shared by all frames in flight and
+		// live in device local memory; the render graph orders their use.
+		const size_t drawBufferSize = MAX_OBJECTS * sizeof(VkDrawIndexedIndirectCommand);
+		m_EarlyDraws = new StorageBuffer(device, allocator, drawBufferSize, VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, MemoryUsage::GpuOnly);
+		m_LateDraws = new StorageBuffer(device, allocator, drawBufferSize, VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, MemoryUsage::GpuOnly);
+		m_Visibility = new StorageBuffer(device, allocator, MAX_OBJECTS * sizeof(uint32_t), 0, MemoryUsage::GpuOnly);
+		const size_t meshletDrawBufferSize = MAX_MESHLETS * sizeof(VkDrawIndexedIndirectCommand);
+		m_EarlyMeshletDraws = new StorageBuffer(device, allocator, meshletDrawBufferSize, VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+			MemoryUsage::GpuOnly);
+		m_LateMeshletDraws = new StorageBuffer(device, allocator, meshletDrawBufferSize, VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+			MemoryUsage::GpuOnly);
+
+		CullUniforms uniforms = {};
+		for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+		{
+			m_UniformBuffers[i] = new UniformBuffer(device, allocator, &uniforms, sizeof(CullUniforms));
+			m_ObjectBuffers[i] = new StorageBuffer(device, allocator, MAX_OBJECTS * sizeof(ObjectData));
+			m_MeshletBuffers[i] = new StorageBuffer(device, allocator, MAX_MESHLETS * sizeof(MeshletData));
+
+			// Binding 5 is the depth pyramid, written in 'InitPyramid'
+			constexpr uint32_t bufferBindings[8] = { 0, 1, 2, 3, 4, 6, 7, 8 };
+			VkDescriptorBufferInfo bufferInfos[8] = {};
+			bufferInfos[0] = { m_UniformBuffers[i]->GetBufferHandle(), 0, VK_WHOLE_SIZE };
+			bufferInfos[1] = { m_ObjectBuffers[i]->GetBufferHandle(), 0, VK_WHOLE_SIZE };
+			bufferInfos[2] = { m_EarlyDraws->GetBufferHandle(), 0, VK_WHOLE_SIZE };
+			bufferInfos[3] = { m_LateDraws->GetBufferHandle(), 0, VK_WHOLE_SIZE };
+			bufferInfos[4] = { m_Visibility->GetBufferHandle(), 0, VK_WHOLE_SIZE };
+			bufferInfos[5] = { m_MeshletBuffers[i]->GetBufferHandle(), 0, VK_WHOLE_SIZE };
+			bufferInfos[6] = { m_EarlyMeshletDraws->GetBufferHandle(), 0, VK_WHOLE_SIZE };
+			bufferInfos[7] = { m_LateMeshletDraws->GetBufferHandle(), 0, VK_WHOLE_SIZE };
+
+			VkWriteDescriptorSet writes[8] = {};
+			for (uint32_t j = 0; j < 8; j++)
+			{
+				writes[j].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+				writes[j].dstSet = m_CullSets[i];
+				writes[j].dstBinding = bufferBindings[j];
+				writes[j].descriptorType = j == 0 ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+				writes[j].descriptorCount = 1;
+				writes[j].pBufferInfo = &bufferInfos[j];
+			}
+
+			vkUpdateDescriptorSets(device, 8, writes, 0, nullptr);
+		}
+
+		// Both the depth image and the pyramid are read with 'texelFetch', so filtering does not matter
+		VkSamplerCreateInfo samplerInfo = {};
+		samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+		samplerInfo.minFilter = VK_FILTER_NEAREST;
+		samplerInfo.magFilter = VK_FILTER_NEAREST;
+		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+		samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+
+		if (vkCreateSampler(device, &samplerInfo, nullptr, &m_Sampler) != VK_SUCCESS)
+			SGE_DEBUG_BREAKM("Failed to create Vulkan sampler.");
+
+		InitPyramid(device, commandPool, queue, depthImageView, extent);
+	}
+
+	void OcclusionCuller::Destroy(VkDevice device)
+	{
+		DestroyPyramid(device);
+		vkDestroySampler(device, m_Sampler, nullptr);
+
+		for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+		{
+			m_UniformBuffers[i]->Destroy(device);
+			delete m_UniformBuffers[i];
+			m_ObjectBuffers[i]->Destroy(device);
+			delete m_ObjectBuffers[i];
+			m_MeshletBuffers[i]->Destroy(device);
+			delete m_MeshletBuffers[i];
+		}
+
+		for (StorageBuffer* buffer : { m_EarlyDraws, m_LateDraws, m_Visibility, m_EarlyMeshletDraws, m_LateMeshletDraws })
+		{
+			buffer->Destroy(device);
+			delete buffer;
+		}
+
+		// The descriptor sets are freed with the allocators
+		vkDestroyDescriptorSetLayout(device, m_CullSetLayout, nullptr);
+		vkDestroyDescriptorSetLayout(device, m_PyramidCopySetLayout, nullptr);
+		vkDestroyDescriptorSetLayout(device, m_PyramidSetLayout, nullptr);
+
+		m_CullPipeline->Destroy(device);
+		delete m_CullPipeline;
+		m_MeshletPipeline->Destroy(device);
+		delete m_MeshletPipeline;
+		m_PyramidCopyPipeline->Destroy(device);
+		delete m_PyramidCopyPipeline;
+		m_PyramidPipeline->Destroy(device);
+		delete m_PyramidPipeline;
+
+#ifdef DEBUG
+		m_CleanedUp = true;
+#endif // DEBUG
+	}
+
+	void OcclusionCuller::Resize(VkDevice device, VkCommandPool commandPool, VkQueue queue, VkImageView depthImageView, VkExtent2D extent)
+	{
+		DestroyPyramid(device);
+		InitPyramid(device, commandPool, queue, depthImageView, extent);
+	}
+
+	void OcclusionCuller::InitPyramid(VkDevice device, VkCommandPool commandPool, VkQueue queue, VkImageView depthImageView, VkExtent2D extent)
+	{
+		// Level 0 has the size of the depth image, so depth texels map to pyramid texels directly
+		m_DepthImageView = depthImageView;
+		m_PyramidExtent = extent;
+		m_PyramidLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(extent.width, extent.height)))) + 1;
+		SGE_ASSERTM(m_PyramidLevels <= MAX_DEPTH_PYRAMID_LEVELS, "Depth pyramid has too many levels.");
+
+		CreateImage(device, m_Allocator, extent.width, extent.height, VK_FORMAT_R32_SFLOAT, VK_IMAGE_TILING_OPTIMAL,
+			VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+			MemoryUsage::GpuOnly, MemoryCategory::Attachments, &m_Pyramid, &m_PyramidMemory, m_PyramidLevels);
+
+		m_PyramidView = CreateImageView(device, m_Pyramid, VK_FORMAT_R32_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT, 0, m_PyramidLevels);
+		for (uint32_t level = 0; level < m_PyramidLevels; level++)
+			m_PyramidLevelViews[level] = CreateImageView(device, m_Pyramid, VK_FORMAT_R32_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT, level, 1);
+
+		// Until the first pyramid is built nothing may be culled, so it starts out at the far plane. The pyramid is then
+		// left readable by compute shaders, which is the state the render graph expects it in at the start of a frame.
+		VkCommandBuffer commandBuffer = BeginOneTimeCommandBuffer(device, commandPool);
+
+		VkImageMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = m_Pyramid;
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.levelCount = m_PyramidLevels;
+		barrier.subresourceRange.layerCount = 1;
+
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+			0, nullptr, 0, nullptr, 1, &barrier);
+
+		VkClearColorValue farPlane = { { 1.0f, 1.0f, 1.0f, 1.0f } };
+		vkCmdClearColorImage(commandBuffer, m_Pyramid, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &farPlane, 1, &barrier.subresourceRange);
+
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+			0, nullptr, 0, nullptr, 1, &barrier);
+
+		EndOneTimeCommandBuffer(device, commandPool, commandBuffer, queue);
+
+		// The cull sets read the whole pyramid
+		std::vector<VkDescriptorImageInfo> imageInfos;
+		// Writes point into this vector, so it must not reallocate
+		imageInfos.reserve(MAX_FRAMES_IN_FLIGHT);
+		std::vector<VkWriteDescriptorSet> writes;
+		for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+			AddImageWrite(imageInfos, writes, m_CullSets[i], 5, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, m_PyramidView,
+				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+		vkUpdateDescriptorSets(device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+	}
+
+	void OcclusionCuller::AddImageWrite(std::vector<VkDescriptorImageInfo>& imageInfos, std::vector<VkWriteDescriptorSet>& writes,
+		VkDescriptorSet set, uint32_t binding, VkDescriptorType type, VkImageView view, VkImageLayout layout) const
+	{
+		imageInfos.push_back({ type == VK_DESCRIPTOR_TYPE_STORAGE_IMAGE ? nullptr : m_Sampler, view, layout });
+
+		VkWriteDescriptorSet write = {};
+		write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write.dstSet = set;
+		write.dstBinding = binding;
+		write.descriptorType = type;
+		write.descriptorCount = 1;
+		write.pImageInfo = &imageInfos.back();
+		writes.push_back(write);
+	}
+
+	void OcclusionCuller::DestroyPyramid(VkDevice device)
+	{
+		for (uint32_t level = 0; level < m_PyramidLevels; level++)
+			vkDestroyImageView(device, m_PyramidLevelViews[level], nullptr);
+		vkDestroyImageView(device, m_PyramidView, nullptr);
+		vkDestroyImage(device, m_Pyramid, nullptr);
+		m_Allocator->Free(device, m_PyramidMemory);
+
+		m_PyramidLevels = 0;
+	}
+
+	void OcclusionCuller::Update(VkDevice device, uint32_t frameIndex, const std::vector<ObjectData>& objects, const std::vector<MeshletData>& meshlets,
+		const glm::mat4& viewProjection, const glm::mat4& previousViewProjection, const glm::vec3& cameraPosition)
+	{
+		SGE_ASSERTM(objects.size() <= MAX_OBJECTS, "Too many objects to cull.");
+		SGE_ASSERTM(meshlets.size() <= MAX_MESHLETS, "Too many meshlets to cull.");
+
+		m_ObjectCounts[frameIndex] = static_cast<uint32_t>(objects.size());
+		if (!objects.empty())
+			m_ObjectBuffers[frameIndex]->Upload(device, objects.data(), objects.size() * sizeof(ObjectData));
+		m_MeshletCounts[frameIndex] = static_cast<uint32_t>(meshlets.size());
+		if (!meshlets.empty())
+			m_MeshletBuffers[frameIndex]->Upload(device, meshlets.data(), meshlets.size() * sizeof(MeshletData));
+
+		CullUniforms uniforms = {};
+		uniforms.ViewProjection = viewProjection;
+		uniforms.PreviousViewProjection = previousViewProjection;
+		uniforms.PyramidWidth = static_cast<float>(m_PyramidExtent.width);
+		uniforms.PyramidHeight = static_cast<float>(m_PyramidExtent.height);
+		uniforms.ObjectCount = m_ObjectCounts[frameIndex];
+		uniforms.MeshletCount = m_MeshletCounts[frameIndex];
+		uniforms.CameraPosition = glm::vec4(cameraPosition, 1.0f);
+
+		// Planes from the rows of the view projection matrix, for a depth range of [0, 1]
+		auto row = [&viewProjection](int i) { return glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]); };
+		uniforms.FrustumPlanes[0] = row(3) + row(0);
+		uniforms.FrustumPlanes[1] = row(3) - row(0);
+		uniforms.FrustumPlanes[2] = row(3) + row(1);
+		uniforms.FrustumPlanes[3] = row(3) - row(1);
+		uniforms.FrustumPlanes[4] = row(2);
+		uniforms.FrustumPlanes[5] = row(3) - row(2);
+		for (glm::vec4& plane : uniforms.FrustumPlanes)
+			plane /= glm::length(glm::vec3(plane));
+		m_UniformBuffers[frameIndex]->Upload(device, &uniforms, sizeof(CullUniforms));
+	}
+
+	void OcclusionCuller::RecordCull(VkCommandBuffer commandBuffer, uint32_t frameIndex, CullPhase phase)
+	{
+		if (m_ObjectCounts[frameIndex] == 0)
+			return;
+
+		uint32_t phaseIndex = static_cast<uint32_t>(phase);
+
+		m_CullPipeline->Bind(commandBuffer);
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_CullPipeline->GetLayout(), 0, 1, &m_CullSets[frameIndex], 0, nullptr);
+		vkCmdPushConstants(commandBuffer, m_CullPipeline->GetLayout(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(uint32_t), &phaseIndex);
+		vkCmdDispatch(commandBuffer, (m_ObjectCounts[frameIndex] + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+
+		if (m_MeshletCounts[frameIndex] == 0)
+			return;
+
+		// The meshlet culling reads the object draw commands written above
+		VkBufferMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.buffer = GetDrawBuffer(phase);
+		barrier.size = VK_WHOLE_SIZE;
+
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+			0, nullptr, 1, &barrier, 0, nullptr);
+
+		m_MeshletPipeline->Bind(commandBuffer);
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_MeshletPipeline->GetLayout(), 0, 1, &m_CullSets[frameIndex], 0, nullptr);
+		vkCmdPushConstants(commandBuffer, m_MeshletPipeline->GetLayout(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(uint32_t), &phaseIndex);
+		vkCmdDispatch(commandBuffer, (m_MeshletCounts[frameIndex] + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+	}
+
+	void OcclusionCuller::RecordBuildPyramid(VkDevice device, VkCommandBuffer commandBuffer, DescriptorAllocator* frameAllocator)
+	{
+		// One set per level. Level 0 copies the depth image, every other level reads the view of the level above and
+		// writes its own view. They are only used by this command buffer, so they come from the frame's allocator and
+		// are written fresh, which keeps sets of pending frames untouched.
+		std::array<VkDescriptorSet, MAX_DEPTH_PYRAMID_LEVELS> levelSets;
+		std::vector<VkDescriptorImageInfo> imageInfos;
+		// Writes point into this vector, so it must not reallocate
+		imageInfos.reserve(2 * m_PyramidLevels);
+		std::vector<VkWriteDescriptorSet> writes;
+		for (uint32_t level = 0; level < m_PyramidLevels; level++)
+		{
+			if (level == 0)
+			{
+				levelSets[level] = frameAllocator->Allocate(device, m_PyramidCopySetLayout);
+				AddImageWrite(imageInfos, writes, levelSets[level], 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, m_DepthImageView,
+					VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+			}
+			else
+			{
+				levelSets[level] = frameAllocator->Allocate(device, m_PyramidSetLayout);
+				AddImageWrite(imageInfos, writes, levelSets[level], 0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, m_PyramidLevelViews[level - 1],
+					VK_IMAGE_LAYOUT_GENERAL);
+			}
+			AddImageWrite(imageInfos, writes, levelSets[level], 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, m_PyramidLevelViews[level],
+				VK_IMAGE_LAYOUT_GENERAL);
+		}
+		vkUpdateDescriptorSets(device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+
+		for (uint32_t level = 0; level < m_PyramidLevels; level++)
+		{
+			// The copy pipeline builds level 0, the reduction pipeline stays bound for the rest
+			ComputePipeline* pipeline = level == 0 ? m_PyramidCopyPipeline : m_PyramidPipeline;
+			if (level <= 1)
+				pipeline->Bind(commandBuffer);
+
+			// Each level reads the one written before it
+			if (level > 0)
+			{
+				VkImageMemoryBarrier barrier = {};
+				barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+				barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+				barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+				barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+				barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+				barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				barrier.image = m_Pyramid;
+				barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+				barrier.subresourceRange.baseMipLevel = level - 1;
+				barrier.subresourceRange.levelCount = 1;
+				barrier.subresourceRange.layerCount = 1;
+
+				vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+					0, nullptr, 0, nullptr, 1, &barrier);
+			}
+
+			uint32_t width = std::max(m_PyramidExtent.width >> level, 1u);
+			uint32_t height = std::max(m_PyramidExtent.height >> level, 1u);
+
+			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->GetLayout(), 0, 1, &levelSets[level], 0, nullptr);
+			vkCmdDispatch(commandBuffer, (width + PYRAMID_GROUP_SIZE - 1) / PYRAMID_GROUP_SIZE, (height + PYRAMID_GROUP_SIZE - 1) / PYRAMID_GROUP_SIZE, 1);
+		}
+	}
+} // namespace sge::vulkan
\ No newline at end of file
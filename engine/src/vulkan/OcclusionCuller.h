@@ -0,0 +1,162 @@
+#pragma once
+
+#include "ComputePipeline.h"
+#include "Buffer.h"
+#include "FrameGroup.h"
+#include "DescriptorAllocator.h"
+#include "base.h"
+
+#include <vulkan/vulkan.h>
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+#include <array>
+#include <vector>
+#include <string>
+
+namespace sge::vulkan
+{
+	constexpr uint32_t MAX_OBJECTS = 4096;
+	constexpr uint32_t MAX_MESHLETS = 65536;
+	// Enough for a 32768x32768 depth buffer
+	constexpr uint32_t MAX_DEPTH_PYRAMID_LEVELS = 16;
+
+	// Per-object data read by the vertex shaders and the culling shader. Must match 'shaders/object.glsl'.
+	struct ObjectData
+	{
+		glm::mat4 Model;
+		// Local space bounding box
+		glm::vec4 BoundsMin;
+		glm::vec4 BoundsMax;
+		uint32_t IndexCount;
+		// Index into the material table
+		uint32_t MaterialIndex;
+		uint32_t Padding[2];
+	};
+
+	// Per-meshlet data read by the meshlet culling shader. Must match 'shaders/culling.glsl'.
+	struct MeshletData
+	{
+		// Local space bounding sphere, center and radius
+		glm::vec4 Sphere;
+		// Axis of the cone containing every triangle's normal, and the sine of the cone's half angle (1 if it cannot cull)
+		glm::vec4 Cone;
+		// Range of the mesh's index buffer
+		uint32_t FirstIndex;
+		uint32_t IndexCount;
+		// Set by the renderer every frame
+		uint32_t ObjectIndex;
+		uint32_t Padding;
+	};
+
+	enum class CullPhase
+	{
+		// Objects tested against the previous frame's depth pyramid
+		Early,
+		// Objects the early phase found occluded, tested against this frame's depth pyramid
+		Late
+	};
+
+	// Two phase occlusion culling on the GPU. Every object gets an indirect draw command per phase, which has an
+	// instance count of 0 if the object was culled. The depth pyramid is built from the depth buffer after the
+	// early phase is drawn, for the late phase to test against, and again after the late phase is drawn, so the
+	// next frame's early phase tests against the complete depth of this frame.
+	// Each phase then culls the meshlets of the objects it kept, and the meshlet draw commands are what gets drawn.
+	class OcclusionCuller
+	{
+	public:
+		// The descriptor sets that live as long as the culler are allocated from 'descriptorAllocator'
+		OcclusionCuller(VkDevice device, MemoryAllocator* allocator, DescriptorAllocator* descriptorAllocator, VkCommandPool commandPool,
+			VkQueue queue, VkPipelineCache pipelineCache, VkImageView depthImageView, VkExtent2D extent, const std::string& shaderDirectory);
+#ifdef DEBUG
+		~OcclusionCuller()
+		{
+			SGE_ASSERTM(m_CleanedUp, "Occlusion culler was not cleaned up.");
+		}
+#endif // DEBUG
+		void Destroy(VkDevice device);
+		// Recreates the depth pyramid for a new depth image, the device must be idle
+		void Resize(VkDevice device, VkCommandPool commandPool, VkQueue queue, VkImageView depthImageView, VkExtent2D extent);
+
+		// 'previousViewProjection' is the camera of the frame the depth pyramid was last built in
+		void Update(VkDevice device, uint32_t frameIndex, const std::vector<ObjectData>& objects, const std::vector<MeshletData>& meshlets,
+			const glm::mat4& viewProjection, const glm::mat4& previousViewProjection, const glm::vec3& cameraPosition);
+		// Expects the depth pyramid to be readable by compute shaders and the phase's draw buffers to be writable
+		void RecordCull(VkCommandBuffer commandBuffer, uint32_t frameIndex, CullPhase phase);
+		// Expects the depth image to be readable by compute shaders and the depth pyramid to be in the general layout. The sets of
+		// the levels are allocated from 'frameAllocator', which must not be reset before the command buffer finished.
+		void RecordBuildPyramid(VkDevice device, VkCommandBuffer commandBuffer, DescriptorAllocator* frameAllocator);
+	public:
+		inline VkImage GetDepthPyramid() const { return m_Pyramid; }
+		inline VkImageView GetDepthPyramidView() const { return m_PyramidView; }
+		// Draw command of object 'i' is at offset 'i * sizeof(VkDrawIndexedIndirectCommand)'
+		inline VkBuffer GetDrawBuffer(CullPhase phase) const
+		{
+			return phase == CullPhase::Early ? m_EarlyDraws->GetBufferHandle() : m_LateDraws->GetBufferHandle();
+		}
+		// Draw command of meshlet 'i' is at offset 'i * sizeof(VkDrawIndexedIndirectCommand)'
+		inline VkBuffer GetMeshletDrawBuffer(CullPhase phase) const
+		{
+			return phase == CullPhase::Early ? m_EarlyMeshletDraws->GetBufferHandle() : m_LateMeshletDraws->GetBufferHandle();
+		}
+		inline VkBuffer GetVisibilityBuffer() const { return m_Visibility->GetBufferHandle(); }
+		inline const FrameGroup<StorageBuffer*>& GetObjectBuffers() const { return m_ObjectBuffers; }
+	private:
+		void InitPyramid(VkDevice device, VkCommandPool commandPool, VkQueue queue, VkImageView depthImageView, VkExtent2D extent);
+		void DestroyPyramid(VkDevice device);
+		// Adds a write of one image descriptor, 'imageInfos' must have reserved room for it
+		void AddImageWrite(std::vector<VkDescriptorImageInfo>& imageInfos, std::vector<VkWriteDescriptorSet>& writes, VkDescriptorSet set,
+			uint32_t binding, VkDescriptorType type, VkImageView view, VkImageLayout layout) const;
+	private:
+		struct CullUniforms
+		{
+			glm::mat4 ViewProjection;
+			glm::mat4 PreviousViewProjection;
+			float PyramidWidth;
+			float PyramidHeight;
+			uint32_t ObjectCount;
+			uint32_t MeshletCount;
+			glm::vec4 CameraPosition;
+			// World space, pointing inwards
+			glm::vec4 FrustumPlanes[6];
+		};
+
+		ComputePipeline* m_CullPipeline;
+		ComputePipeline* m_MeshletPipeline;
+		// Level 0 of the pyramid is copied from the depth image, the other levels are reduced from the level above
+		ComputePipeline* m_PyramidCopyPipeline;
+		ComputePipeline* m_PyramidPipeline;
+		VkDescriptorSetLayout m_CullSetLayout;
+		VkDescriptorSetLayout m_PyramidCopySetLayout;
+		VkDescriptorSetLayout m_PyramidSetLayout;
+		FrameGroup<VkDescriptorSet> m_CullSets;
+
+		FrameGroup<UniformBuffer*> m_UniformBuffers;
+		FrameGroup<StorageBuffer*> m_ObjectBuffers;
+		FrameGroup<uint32_t> m_ObjectCounts;
+		FrameGroup<StorageBuffer*> m_MeshletBuffers;
+		FrameGroup<uint32_t> m_MeshletCounts;
+		StorageBuffer* m_EarlyDraws;
+		StorageBuffer* m_LateDraws;
+		StorageBuffer* m_EarlyMeshletDraws;
+		StorageBuffer* m_LateMeshletDraws;
+		// Result of the early phase for every object, read by the late phase
+		StorageBuffer* m_Visibility;
+
+		MemoryAllocator* m_Allocator;
+		VkSampler m_Sampler;
+		// Source of pyramid level 0
+		VkImageView m_DepthImageView;
+		VkImage m_Pyramid;
+		Allocation m_PyramidMemory;
+		// View of all levels for culling, and one view per level for building
+		VkImageView m_PyramidView;
+		std::array<VkImageView, MAX_DEPTH_PYRAMID_LEVELS> m_PyramidLevelViews;
+		VkExtent2D m_PyramidExtent;
+		uint32_t m_PyramidLevels;
+#ifdef DEBUG
+		bool m_CleanedUp = false;
+#endif // DEBUG
+	};
+} // namespace sge::vulkan
\ No newline at end of file
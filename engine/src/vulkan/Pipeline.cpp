@@ -1,19 +1,70 @@
 #include "Pipeline.h"
+#include "Util.h"
 
 #include <glm/mat4x4.hpp>
 
+#include <bit>
+#include <algorithm>
+
 namespace sge::vulkan
 {
-	Pipeline::Pipeline(VkDevice device, VkRenderPass renderPass, Shader* shader, Swapchain* swapchain,
-		BufferLayout vertexBufferLayout, VkDescriptorSetLayout descriptorSetLayout)
-		: m_PipelineHandle(nullptr), m_Layout(nullptr), m_BufferLayout(vertexBufferLayout)
+	uint64_t HashPipelineKey(const Shader* shader, const BufferLayout& vertexBufferLayout, const PipelineState& state,
+		const ShaderVariant& variant)
+	{
+		uint64_t hash = shader->GetHash();
+
+		size_t stride = vertexBufferLayout.GetStride();
+		hash = HashBytes(&stride, sizeof(stride), hash);
+		for (const auto& attribute : vertexBufferLayout.GetAttributes())
+		{
+			hash = HashBytes(&attribute.Type, sizeof(attribute.Type), hash);
+			hash = HashBytes(&attribute.Offset, sizeof(attribute.Offset), hash);
+		}
+
+		hash = HashBytes(&state.Topology, sizeof(state.Topology), hash);
+		hash = HashBytes(&state.PolygonMode, sizeof(state.PolygonMode), hash);
+		hash = HashBytes(&state.CullMode, sizeof(state.CullMode), hash);
+		hash = HashBytes(&state.FrontFace, sizeof(state.FrontFace), hash);
+		hash = HashBytes(&state.DepthTest, sizeof(state.DepthTest), hash);
+		hash = HashBytes(&state.DepthWrite, sizeof(state.DepthWrite), hash);
+		hash = HashBytes(&state.DepthCompareOp, sizeof(state.DepthCompareOp), hash);
+		hash = HashBytes(&state.BlendEnable, sizeof(state.BlendEnable), hash);
+		hash = HashBytes(&state.ColorWrite, sizeof(state.ColorWrite), hash);
+
+		hash = HashBytes(&variant.Features, sizeof(variant.Features), hash);
+		hash = HashBytes(variant.Values.data(), variant.Values.size() * sizeof(float), hash);
+
+		return hash;
+	}
+
+	Pipeline::Pipeline(VkDevice device, VkRenderPass renderPass, Shader* shader,
+		BufferLayout vertexBufferLayout, VkPipelineLayout layout,
+		const PipelineState& state, const ShaderVariant& variant, VkPipelineCache pipelineCache)
+		: m_PipelineHandle(nullptr), m_Layout(layout), m_BufferLayout(vertexBufferLayout)
 	{
+		// Specialization constants, shared by both stages. Entries for IDs a shader does not declare are ignored.
+		std::vector<uint32_t> specializationData = { variant.Features };
+		std::vector<VkSpecializationMapEntry> specializationEntries = { { 0, 0, sizeof(uint32_t) } };
+		for (size_t i = 0; i < variant.Values.size(); i++)
+		{
+			uint32_t offset = static_cast<uint32_t>(specializationData.size() * sizeof(uint32_t));
+			specializationEntries.push_back({ static_cast<uint32_t>(i + 1), offset, sizeof(float) });
+			specializationData.push_back(std::bit_cast<uint32_t>(variant.Values[i]));
+		}
+
+		VkSpecializationInfo specializationInfo = {};
+		specializationInfo.mapEntryCount = static_cast<uint32_t>(specializationEntries.size());
+		specializationInfo.pMapEntries = specializationEntries.data();
+		specializationInfo.dataSize = specializationData.size() * sizeof(uint32_t);
+		specializationInfo.pData = specializationData.data();
+
 		// Vertex shader stage
 		VkPipelineShaderStageCreateInfo vertexShaderStageInfo = {};
 		vertexShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
 		vertexShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
 		vertexShaderStageInfo.module = shader->m_VertShaderModule;
 		vertexShaderStageInfo.pName = "main";
+		vertexShaderStageInfo.pSpecializationInfo = &specializationInfo;
 
 		// Fragment shader stage
 		VkPipelineShaderStageCreateInfo fragShaderStageInfo = {};
@@ -21,12 +72,20 @@ namespace sge::vulkan
 		fragShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
 		fragShaderStageInfo.module = shader->m_FragShaderModule;
 		fragShaderStageInfo.pName = "main";
+		fragShaderStageInfo.pSpecializationInfo = &specializationInfo;
 
 		VkPipelineShaderStageCreateInfo shaderStageInfos[2] = { vertexShaderStageInfo, fragShaderStageInfo };
 
-		// Vertex input
+		// Vertex input, attributes the shader does not read are dropped and every input it reads must be in the buffer layout
 		auto vertexInputBinding = vertexBufferLayout.GetBindingDescription();
-		auto vertexInputAttributes = vertexBufferLayout.GetAttributeDescriptions();
+		std::vector<VkVertexInputAttributeDescription> vertexInputAttributes;
+		const auto& inputLocations = shader->GetReflection().InputLocations;
+		for (const auto& attribute : vertexBufferLayout.GetAttributeDescriptions())
+		{
+			if (std::binary_search(inputLocations.begin(), inputLocations.end(), attribute.location))
+				vertexInputAttributes.push_back(attribute);
+		}
+		SGE_ASSERTM(vertexInputAttributes.size() == inputLocations.size(), "Vertex buffer layout is missing inputs of the vertex shader.");
 
 		VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
 		vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
@@ -38,28 +97,21 @@ namespace sge::vulkan
 		// Input assembly
 		VkPipelineInputAssemblyStateCreateInfo inputAssemblyInfo = {};
 		inputAssemblyInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-		inputAssemblyInfo.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+		inputAssemblyInfo.topology = state.Topology;
 		inputAssemblyInfo.primitiveRestartEnable = VK_FALSE;
 
-		// Viewport
-		VkViewport viewport = {};
-		viewport.x = 0.0f;
-		viewport.y = 0.0f;
-		viewport.width = static_cast<float>(swapchain->GetExtent().width);
-		viewport.height = static_cast<float>(swapchain->GetExtent().height);
-		viewport.minDepth = 0.0f;
-		viewport.maxDepth = 1.0f;
-
-		VkRect2D scissor = {};
-		scissor.offset = { 0, 0 };
-		scissor.extent = swapchain->GetExtent();
-
+		// Viewport, set when the render pass begins
 		VkPipelineViewportStateCreateInfo viewportInfo = {};
 		viewportInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
 		viewportInfo.viewportCount = 1;
-		viewportInfo.pViewports = &viewport;
 		viewportInfo.scissorCount = 1;
-		viewportInfo.pScissors = &scissor;
+
+		VkDynamicState dynamicStates[2] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+
+		VkPipelineDynamicStateCreateInfo dynamicStateInfo = {};
+		dynamicStateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+		dynamicStateInfo.dynamicStateCount = 2;
+		dynamicStateInfo.pDynamicStates = dynamicStates;
 
 		// Rasterizer
 		VkPipelineRasterizationStateCreateInfo rasterizationInfo = {};
@@ -67,11 +119,9 @@ namespace sge::vulkan
 		rasterizationInfo.depthClampEnable = VK_FALSE;
 		rasterizationInfo.depthBiasEnable = VK_FALSE;
 		rasterizationInfo.rasterizerDiscardEnable = VK_FALSE;
-		rasterizationInfo.cullMode = VK_CULL_MODE_BACK_BIT; // Enable backface culling
-		//rasterizationInfo.cullMode = VK_CULL_MODE_NONE;
-		rasterizationInfo.frontFace = VK_FRONT_FACE_CLOCKWISE;
-		rasterizationInfo.polygonMode = VK_POLYGON_MODE_FILL;
-		//rasterizationInfo.polygonMode = VK_POLYGON_MODE_LINE;
+		rasterizationInfo.cullMode = state.CullMode;
+		rasterizationInfo.frontFace = state.FrontFace;
+		rasterizationInfo.polygonMode = state.PolygonMode;
 		rasterizationInfo.lineWidth = 1.0f;
 
 		// Multisampling
@@ -83,17 +133,24 @@ namespace sge::vulkan
 		// Depth stencil
 		VkPipelineDepthStencilStateCreateInfo depthStencilInfo = {};
 		depthStencilInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
-		depthStencilInfo.depthTestEnable = VK_TRUE;
-		depthStencilInfo.depthWriteEnable = VK_TRUE;
-		depthStencilInfo.depthCompareOp = VK_COMPARE_OP_LESS;
+		depthStencilInfo.depthTestEnable = state.DepthTest;
+		depthStencilInfo.depthWriteEnable = state.DepthWrite;
+		depthStencilInfo.depthCompareOp = state.DepthCompareOp;
 		depthStencilInfo.depthBoundsTestEnable = VK_FALSE;
 		//depthStencilInfo.minDepthBounds = 0.0f;
 		//depthStencilInfo.maxDepthBounds = 1.0f;
 
 		// Blending
 		VkPipelineColorBlendAttachmentState blendAttachment = {};
-		blendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-		blendAttachment.blendEnable = VK_FALSE;
+		blendAttachment.colorWriteMask = state.ColorWrite
+			? VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT : 0;
+		blendAttachment.blendEnable = state.BlendEnable;
+		blendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+		blendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+		blendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+		blendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+		blendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+		blendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
 
 		VkPipelineColorBlendStateCreateInfo blendInfo = {};
 		blendInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
@@ -102,29 +159,6 @@ namespace sge::vulkan
 		blendInfo.attachmentCount = 1;
 		blendInfo.pAttachments = &blendAttachment;
 
-		// Pipeline layout
-		VkPushConstantRange pushConstantRange = {};
-		pushConstantRange.offset = 0;
-		pushConstantRange.size = static_cast<uint32_t>(128);
-		pushConstantRange.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-
-		VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
-		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-		pipelineLayoutInfo.pushConstantRangeCount = 1;
-		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
-		
-		pipelineLayoutInfo.setLayoutCount = MAX_FRAMES_IN_FLIGHT;
-		FrameGroup<VkDescriptorSetLayout> layouts;
-		for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
-			layouts[i] = descriptorSetLayout;
-		pipelineLayoutInfo.pSetLayouts = layouts.data();
-
-		if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &m_Layout) != VK_SUCCESS)
-		{
-			__debugbreak();
-			//SGE_DEBUG_BREAKM("Failed to create Vulkan pipeline layout.");
-		}
-
 		VkGraphicsPipelineCreateInfo pipelineInfo = {};
 		pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
 		pipelineInfo.stageCount = 2;
@@ -136,14 +170,14 @@ namespace sge::vulkan
 		pipelineInfo.pMultisampleState = &multisampleInfo;
 		pipelineInfo.pDepthStencilState = &depthStencilInfo;
 		pipelineInfo.pColorBlendState = &blendInfo;
-		pipelineInfo.pDynamicState = VK_NULL_HANDLE;
+		pipelineInfo.pDynamicState = &dynamicStateInfo;
 		pipelineInfo.layout = m_Layout;
 		pipelineInfo.renderPass = renderPass;
 		pipelineInfo.subpass = 0;
 		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 		pipelineInfo.basePipelineIndex = -1;
 
-		if (vkCreateGraphicsPipelines(device, nullptr, 1, &pipelineInfo, nullptr, &m_PipelineHandle) != VK_SUCCESS)
+		if (vkCreateGraphicsPipelines(device, pipelineCache, 1, &pipelineInfo, nullptr, &m_PipelineHandle) != VK_SUCCESS)
 		{
 			__debugbreak();
 			//SGE_DEBUG_BREAKM("Failed to create Vulkan graphics pipeline.");
@@ -152,7 +186,6 @@ namespace sge::vulkan
 
 	void Pipeline::Destroy(VkDevice device)
 	{
-		vkDestroyPipelineLayout(device, m_Layout, nullptr);
 		vkDestroyPipeline(device, m_PipelineHandle, nullptr);
 
 #ifdef DEBUG
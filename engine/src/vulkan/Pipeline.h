@@ -1,14 +1,53 @@
 #pragma once
 
-#include "Swapchain.h"
 #include "BufferLayout.h"
 #include "Shader.h"
 #include "base.h"
 
 #include <array>
+#include <vector>
 
 namespace sge::vulkan
 {
+	// Fixed-function state that can differ between pipelines using the same shader and vertex layout
+	struct PipelineState
+	{
+		VkPrimitiveTopology Topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+		VkPolygonMode PolygonMode = VK_POLYGON_MODE_FILL;
+		VkCullModeFlags CullMode = VK_CULL_MODE_BACK_BIT;
+		VkFrontFace FrontFace = VK_FRONT_FACE_CLOCKWISE;
+		VkBool32 DepthTest = VK_TRUE;
+		VkBool32 DepthWrite = VK_TRUE;
+		VkCompareOp DepthCompareOp = VK_COMPARE_OP_LESS;
+		VkBool32 BlendEnable = VK_FALSE;
+		// Disabled for depth-only passes
+		VkBool32 ColorWrite = VK_TRUE;
+
+		bool operator==(const PipelineState& other) const = default;
+	};
+
+	// Bits of 'ShaderVariant::Features', must match 'shaders/variant.glsl'
+	constexpr uint32_t SHADER_FEATURE_ALBEDO_MAP = 1 << 0;
+	constexpr uint32_t SHADER_FEATURE_NORMAL_MAP = 1 << 1;
+	// The Phong parameters are the first four values instead of being read from the material table
+	constexpr uint32_t SHADER_FEATURE_CONSTANT_PHONG = 1 << 2;
+
+	// Specialization constants of both shader stages. Every variant is its own pipeline, so the driver can fold branches on
+	// the features and the constant values into the shader code.
+	struct ShaderVariant
+	{
+		// Constant ID 0
+		uint32_t Features = 0;
+		// Constant IDs 1 and up, in order
+		std::vector<float> Values;
+	};
+
+	constexpr uint32_t INVALID_PIPELINE = UINT32_MAX;
+
+	// Pipelines with equal keys are interchangeable
+	uint64_t HashPipelineKey(const Shader* shader, const BufferLayout& vertexBufferLayout, const PipelineState& state,
+		const ShaderVariant& variant);
+
 	class Pipeline
 	{
 	private:
@@ -19,8 +58,11 @@ namespace sge::vulkan
 		bool m_CleanedUp = false;
 #endif // DEBUG
 	public:
-		Pipeline(VkDevice device, VkRenderPass renderPass, Shader* shader, Swapchain* swapchain,
-			BufferLayout vertexBufferLayout, VkDescriptorSetLayout descriptorSetLayout); // TODO: Use ref or pointer of buffer layout
+		// Viewport and scissor are dynamic state, so pipelines do not depend on the swap chain extent. 'layout' is owned by the
+		// caller and may be shared with other pipelines. Only the attributes of 'vertexBufferLayout' the shader reads are used.
+		Pipeline(VkDevice device, VkRenderPass renderPass, Shader* shader,
+			BufferLayout vertexBufferLayout, VkPipelineLayout layout, // TODO: Use ref or pointer of buffer layout
+			const PipelineState& state, const ShaderVariant& variant, VkPipelineCache pipelineCache);
 #ifdef DEBUG
 		~Pipeline()
 		{
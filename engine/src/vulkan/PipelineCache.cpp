@@ -0,0 +1,90 @@
+#include "PipelineCache.h"
+
+#include <fstream>
+#include <vector>
+#include <cstring>
+
+namespace sge::vulkan
+{
+	// Checks the header that every implementation writes at the start of the cache data
+	static bool IsCompatibleCacheData(VkPhysicalDevice physicalDevice, const std::vector<char>& data)
+	{
+		VkPipelineCacheHeaderVersionOne header;
+		if (data.size() < sizeof(header))
+			return false;
+
+		std::memcpy(&header, data.data(), sizeof(header));
+
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+		return header.headerSize >= sizeof(header)
+			&& header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+			&& header.vendorID == properties.vendorID
+			&& header.deviceID == properties.deviceID
+			&& std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+	}
+
+	PipelineCache::PipelineCache(VkDevice device, VkPhysicalDevice physicalDevice, const std::string& filepath)
+		: m_CacheHandle(nullptr), m_Filepath(filepath)
+	{
+		std::vector<char> data;
+
+		std::ifstream file(filepath, std::ios::ate | std::ios::binary);
+		if (file.is_open())
+		{
+			data.resize(static_cast<size_t>(file.tellg()));
+			file.seekg(0);
+			file.read(data.data(), data.size());
+
+			if (IsCompatibleCacheData(physicalDevice, data))
+				SGE_INFOF("Loaded pipeline cache '%s' (%zu bytes).", filepath.c_str(), data.size());
+			else
+			{
+				SGE_WARNF("Pipeline cache '%s' was created by a different driver or device, ignoring it.", filepath.c_str());
+				data.clear();
+			}
+		}
+
+		VkPipelineCacheCreateInfo createInfo = {};
+		createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+		createInfo.initialDataSize = data.size();
+		createInfo.pInitialData = data.empty() ? nullptr : data.data();
+
+		if (vkCreatePipelineCache(device, &createInfo, nullptr, &m_CacheHandle) != VK_SUCCESS)
+			SGE_DEBUG_BREAKM("Failed to create Vulkan pipeline cache.");
+	}
+
+	void PipelineCache::Destroy(VkDevice device)
+	{
+		Save(device);
+		vkDestroyPipelineCache(device, m_CacheHandle, nullptr);
+
+#ifdef DEBUG
+		m_CleanedUp = true;
+#endif // DEBUG
+	}
+
+	void PipelineCache::Save(VkDevice device)
+	{
+		size_t size = 0;
+		vkGetPipelineCacheData(device, m_CacheHandle, &size, nullptr);
+
+		std::vector<char> data(size);
+		if (vkGetPipelineCacheData(device, m_CacheHandle, &size, data.data()) != VK_SUCCESS)
+		{
+			SGE_WARN("Failed to get Vulkan pipeline cache data.");
+			return;
+		}
+
+		std::ofstream file(m_Filepath, std::ios::binary);
+		if (!file.is_open())
+		{
+			SGE_WARNF("Could not write pipeline cache '%s'.", m_Filepath.c_str());
+			return;
+		}
+
+		file.write(data.data(), size);
+		SGE_TRACEF("Saved pipeline cache '%s' (%zu bytes).", m_Filepath.c_str(), size);
+	}
+} // namespace sge::vulkan
\ No newline at end of file
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "base.h"
+
+#include <vulkan/vulkan.h>
+
+#include <string>
+
+namespace sge::vulkan
+{
+	// 'VkPipelineCache' backed by a file, so pipelines compiled in earlier runs don't have to be compiled by the driver again.
+	// Data written by a different driver or GPU is discarded when loading.
+	class PipelineCache
+	{
+	public:
+		PipelineCache(VkDevice device, VkPhysicalDevice physicalDevice, const std::string& filepath);
+#ifdef DEBUG
+		~PipelineCache()
+		{
+			SGE_ASSERTM(m_CleanedUp, "Pipeline cache was not cleaned up.");
+		}
+#endif // DEBUG
+		// Writes the cache to disk before destroying it
+		void Destroy(VkDevice device);
+		void Save(VkDevice device);
+	public:
+		inline VkPipelineCache GetHandle() const { return m_CacheHandle; }
+	private:
+		VkPipelineCache m_CacheHandle;
+		std::string m_Filepath;
+#ifdef DEBUG
+		bool m_CleanedUp = false;
+#endif // DEBUG
+	};
+} // namespace sge::vulkan
\ No newline at end of file
@@ -0,0 +1,501 @@
+#include "RenderGraph.h"
+#include "Util.h"
+
+#include <algorithm>
+
+namespace sge::vulkan
+{
+	struct UsageInfo
+	{
+		VkImageLayout Layout;
+		VkPipelineStageFlags Stages;
+		VkAccessFlags Access;
+		bool IsWrite;
+	};
+
+	static UsageInfo GetUsageInfo(ResourceUsage usage)
+	{
+		switch (usage)
+		{
+		case ResourceUsage::ColorAttachment:
+			return { VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+				VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, true };
+		case ResourceUsage::DepthAttachment:
+			return { VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+				VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+				VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, true };
+		case ResourceUsage::DepthRead:
+			return { VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+				VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+				VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT, false };
+		case ResourceUsage::SampledFragment:
+			return { VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, false };
+		case ResourceUsage::SampledCompute:
+			return { VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, false };
+		case ResourceUsage::StorageReadCompute:
+			return { VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, false };
+		case ResourceUsage::StorageWriteCompute:
+			return { VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, true };
+		case ResourceUsage::StorageReadGraphics:
+			return { VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+				VK_ACCESS_SHADER_READ_BIT, false };
+		case ResourceUsage::IndirectRead:
+			return { VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT, false };
+		case ResourceUsage::TransferSrc:
+			return { VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT, false };
+		case ResourceUsage::TransferDst:
+			return { VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, true };
+		case ResourceUsage::Present:
+			return { VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, false };
+		case ResourceUsage::None:
+		default:
+			return { VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0, false };
+		}
+	}
+
+	void PassBuilder::Read(ResourceID resource, ResourceUsage usage)
+	{
+		m_Accesses.push_back({ resource, usage, false });
+	}
+
+	void PassBuilder::Write(ResourceID resource, ResourceUsage usage)
+	{
+		m_Accesses.push_back({ resource, usage, true });
+	}
+
+	RenderGraph::RenderGraph()
+		: m_TransientPool(nullptr), m_BackbufferExtent({ 0, 0 })
+	{
+	}
+
+	void RenderGraph::Destroy(VkDevice device)
+	{
+		DestroyTransients(device);
+
+#ifdef DEBUG
+		m_CleanedUp = true;
+#endif // DEBUG
+	}
+
+	ResourceID RenderGraph::ImportImage(const std::string& name, VkImage image, VkImageView imageView, VkImageAspectFlags aspect,
+		ResourceUsage initialUsage, ResourceUsage finalUsage)
+	{
+		Resource resource = {};
+		resource.Name = name;
+		resource.IsImported = true;
+		resource.IsBuffer = false;
+		resource.Desc.Aspect = aspect;
+		resource.InitialUsage = initialUsage;
+		resource.FinalUsage = finalUsage;
+		resource.Image = image;
+		resource.ImageView = imageView;
+
+		m_Resources.push_back(resource);
+		return static_cast<ResourceID>(m_Resources.size() - 1);
+	}
+
+	ResourceID RenderGraph::ImportBuffer(const std::string& name, VkBuffer buffer, ResourceUsage initialUsage, ResourceUsage finalUsage)
+	{
+		Resource resource = {};
+		resource.Name = name;
+		resource.IsImported = true;
+		resource.IsBuffer = true;
+		resource.InitialUsage = initialUsage;
+		resource.FinalUsage = finalUsage;
+		resource.Buffer = buffer;
+
+		m_Resources.push_back(resource);
+		return static_cast<ResourceID>(m_Resources.size() - 1);
+	}
+
+	ResourceID RenderGraph::CreateImage(const std::string& name, const ImageDesc& desc)
+	{
+		Resource resource = {};
+		resource.Name = name;
+		resource.IsImported = false;
+		resource.IsBuffer = false;
+		resource.Desc = desc;
+		resource.InitialUsage = ResourceUsage::None;
+		resource.FinalUsage = ResourceUsage::None;
+
+		m_Resources.push_back(resource);
+		return static_cast<ResourceID>(m_Resources.size() - 1);
+	}
+
+	void RenderGraph::SetImportedImage(ResourceID resource, VkImage image, VkImageView imageView)
+	{
+		SGE_ASSERTM(m_Resources[resource].IsImported, "Only imported images can be replaced.");
+		m_Resources[resource].Image = image;
+		m_Resources[resource].ImageView = imageView;
+	}
+
+	void RenderGraph::SetImportedBuffer(ResourceID resource, VkBuffer buffer)
+	{
+		SGE_ASSERTM(m_Resources[resource].IsImported, "Only imported buffers can be replaced.");
+		m_Resources[resource].Buffer = buffer;
+	}
+
+	void RenderGraph::AddPass(const std::string& name, const PassSetupFunc& setup, const PassExecuteFunc& execute)
+	{
+		Pass pass = {};
+		pass.Name = name;
+		pass.Execute = execute;
+		pass.IsActive = false;
+		setup(pass.Builder);
+
+		m_Passes.push_back(std::move(pass));
+	}
+
+	bool RenderGraph::IsPassActive(const std::string& name) const
+	{
+		for (const auto& pass : m_Passes)
+		{
+			if (pass.Name == name)
+				return pass.IsActive;
+		}
+
+		return false;
+	}
+
+	void RenderGraph::Compile(VkDevice device, MemoryAllocator* allocator, VkExtent2D backbufferExtent)
+	{
+		// Compiling again (e.g. after a resize) replaces all transient images
+		DestroyTransients(device);
+		m_BackbufferExtent = backbufferExtent;
+
+		CullPasses();
+		AllocateTransients(device, allocator);
+		BuildBarriers();
+
+		uint32_t activeCount = 0;
+		for (const auto& pass : m_Passes)
+			activeCount += pass.IsActive ? 1 : 0;
+		SGE_TRACEF("Render graph compiled: %u of %u passes active, %u transient memory slots.", activeCount,
+			static_cast<uint32_t>(m_Passes.size()), static_cast<uint32_t>(m_MemorySlots.size()));
+	}
+
+	void RenderGraph::CullPasses()
+	{
+		// Walk backwards from the outputs (imported resources) and keep every pass that writes something needed
+		std::vector<bool> needed(m_Resources.size(), false);
+		for (size_t i = 0; i < m_Resources.size(); i++)
+			needed[i] = m_Resources[i].IsImported;
+
+		for (size_t i = m_Passes.size(); i > 0; i--)
+		{
+			Pass& pass = m_Passes[i - 1];
+			pass.IsActive = pass.Builder.m_SideEffects;
+
+			for (const auto& access : pass.Builder.m_Accesses)
+			{
+				if (access.IsWrite && needed[access.Resource])
+					pass.IsActive = true;
+			}
+
+			if (!pass.IsActive)
+				continue;
+
+			for (const auto& access : pass.Builder.m_Accesses)
+				needed[access.Resource] = true;
+		}
+
+		// Lifetimes in pass order
+		for (auto& resource : m_Resources)
+		{
+			resource.FirstPass = UINT32_MAX;
+			resource.LastPass = 0;
+		}
+
+		for (uint32_t i = 0; i < static_cast<uint32_t>(m_Passes.size()); i++)
+		{
+			if (!m_Passes[i].IsActive)
+				continue;
+
+			for (const auto& access : m_Passes[i].Builder.m_Accesses)
+			{
+				Resource& resource = m_Resources[access.Resource];
+				resource.FirstPass = std::min(resource.FirstPass, i);
+				resource.LastPass = std::max(resource.LastPass, i);
+			}
+		}
+	}
+
+	void RenderGraph::AllocateTransients(VkDevice device, MemoryAllocator* allocator)
+	{
+		std::vector<ResourceID> transients;
+		for (ResourceID id = 0; id < static_cast<ResourceID>(m_Resources.size()); id++)
+		{
+			const Resource& resource = m_Resources[id];
+			if (!resource.IsImported && resource.FirstPass != UINT32_MAX)
+				transients.push_back(id);
+		}
+
+		std::sort(transients.begin(), transients.end(), [this](ResourceID a, ResourceID b)
+		{
+			return m_Resources[a].FirstPass < m_Resources[b].FirstPass;
+		});
+
+		// Greedily place each image in the first memory slot whose current occupant is dead by the time it is first used
+		std::vector<std::vector<ResourceID>> slotResources;
+		for (ResourceID id : transients)
+		{
+			Resource& resource = m_Resources[id];
+			uint32_t width = resource.Desc.Width ? resource.Desc.Width : m_BackbufferExtent.width;
+			uint32_t height = resource.Desc.Height ? resource.Desc.Height : m_BackbufferExtent.height;
+
+			VkImageCreateInfo imageInfo = {};
+			imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+			imageInfo.imageType = VK_IMAGE_TYPE_2D;
+			imageInfo.extent = { width, height, 1 };
+			imageInfo.mipLevels = resource.Desc.MipLevels;
+			imageInfo.arrayLayers = 1;
+			imageInfo.format = resource.Desc.Format;
+			imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+			imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			imageInfo.usage = resource.Desc.Usage;
+			imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+			imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+			if (vkCreateImage(device, &imageInfo, nullptr, &resource.Image) != VK_SUCCESS)
+				SGE_DEBUG_BREAKM("Failed to create Vulkan transient image.");
+
+			VkMemoryRequirements memoryRequirements;
+			vkGetImageMemoryRequirements(device, resource.Image, &memoryRequirements);
+
+			uint32_t slotIndex = UINT32_MAX;
+			for (uint32_t i = 0; i < static_cast<uint32_t>(m_MemorySlots.size()); i++)
+			{
+				const MemorySlot& slot = m_MemorySlots[i];
+				if (m_Resources[slot.LastResource].LastPass < resource.FirstPass && (slot.MemoryTypeBits & memoryRequirements.memoryTypeBits))
+				{
+					slotIndex = i;
+					break;
+				}
+			}
+
+			if (slotIndex == UINT32_MAX)
+			{
+				slotIndex = static_cast<uint32_t>(m_MemorySlots.size());
+				m_MemorySlots.push_back({ {}, 0, 0, memoryRequirements.memoryTypeBits, id });
+				slotResources.emplace_back();
+			}
+
+			MemorySlot& slot = m_MemorySlots[slotIndex];
+			slot.Size = std::max(slot.Size, memoryRequirements.size);
+			slot.Alignment = std::max(slot.Alignment, memoryRequirements.alignment);
+			slot.MemoryTypeBits &= memoryRequirements.memoryTypeBits;
+			slot.LastResource = id;
+			slotResources[slotIndex].push_back(id);
+			resource.MemorySlotIndex = slotIndex;
+		}
+
+		if (m_MemorySlots.empty())
+			return;
+
+		// The slots share one linear pool, placed like any other allocation
+		VkMemoryRequirements poolRequirements = {};
+		poolRequirements.memoryTypeBits = UINT32_MAX;
+		for (const MemorySlot& slot : m_MemorySlots)
+		{
+			poolRequirements.alignment = std::max(poolRequirements.alignment, slot.Alignment);
+			poolRequirements.memoryTypeBits &= slot.MemoryTypeBits;
+		}
+		for (const MemorySlot& slot : m_MemorySlots)
+			poolRequirements.size += (slot.Size + poolRequirements.alignment - 1) / poolRequirements.alignment * poolRequirements.alignment;
+		SGE_ASSERTM(poolRequirements.memoryTypeBits, "Transient images have no memory type in common.");
+
+		m_TransientPool = new LinearPool(device, allocator, poolRequirements, MemoryUsage::GpuOnly, MemoryCategory::Attachments,
+			false);
+
+		for (uint32_t i = 0; i < static_cast<uint32_t>(m_MemorySlots.size()); i++)
+		{
+			MemorySlot& slot = m_MemorySlots[i];
+			slot.Memory = m_TransientPool->Allocate(slot.Size, slot.Alignment);
+
+			// Every image in a slot waits on the previous occupant; the first one waits on the last occupant of the previous frame
+			const auto& occupants = slotResources[i];
+			for (size_t j = 0; j < occupants.size(); j++)
+			{
+				Resource& resource = m_Resources[occupants[j]];
+				resource.AliasPredecessor = occupants[j == 0 ? occupants.size() - 1 : j - 1];
+
+				vkBindImageMemory(device, resource.Image, slot.Memory.Memory, slot.Memory.Offset);
+
+				VkImageViewCreateInfo viewInfo = {};
+				viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+				viewInfo.image = resource.Image;
+				viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+				viewInfo.format = resource.Desc.Format;
+				viewInfo.subresourceRange.aspectMask = resource.Desc.Aspect;
+				viewInfo.subresourceRange.levelCount = resource.Desc.MipLevels;
+				viewInfo.subresourceRange.layerCount = 1;
+
+				if (vkCreateImageView(device, &viewInfo, nullptr, &resource.ImageView) != VK_SUCCESS)
+					SGE_DEBUG_BREAKM("Failed to create Vulkan transient image view.");
+			}
+		}
+	}
+
+	void RenderGraph::BuildBarriers()
+	{
+		m_PassBarriers.assign(m_Passes.size(), {});
+		m_FinalBarriers.clear();
+
+		// Last state of every resource within a frame, used to synchronize with the previous frame
+		std::vector<ResourceUsage> lastUsages(m_Resources.size(), ResourceUsage::None);
+		for (const auto& pass : m_Passes)
+		{
+			if (!pass.IsActive)
+				continue;
+
+			for (const auto& access : pass.Builder.m_Accesses)
+				lastUsages[access.Resource] = access.Usage;
+		}
+
+		std::vector<ResourceUsage> states(m_Resources.size());
+		std::vector<bool> touched(m_Resources.size(), false);
+		for (size_t i = 0; i < m_Resources.size(); i++)
+			states[i] = m_Resources[i].InitialUsage;
+
+		for (size_t i = 0; i < m_Passes.size(); i++)
+		{
+			if (!m_Passes[i].IsActive)
+				continue;
+
+			for (const auto& access : m_Passes[i].Builder.m_Accesses)
+			{
+				const Resource& resource = m_Resources[access.Resource];
+				ResourceUsage oldUsage = states[access.Resource];
+				ResourceUsage srcUsage = oldUsage;
+
+				if (!touched[access.Resource] && oldUsage == ResourceUsage::None)
+				{
+					// Contents are discarded, but the memory may still be in use by the previous frame or by an aliased image
+					if (resource.IsImported)
+						srcUsage = resource.FinalUsage != ResourceUsage::None ? resource.FinalUsage : lastUsages[access.Resource];
+					else
+						srcUsage = lastUsages[resource.AliasPredecessor];
+				}
+
+				bool needsBarrier;
+				if (resource.IsBuffer)
+					needsBarrier = GetUsageInfo(srcUsage).IsWrite || GetUsageInfo(access.Usage).IsWrite;
+				else
+					needsBarrier = oldUsage != access.Usage || GetUsageInfo(access.Usage).IsWrite;
+
+				if (needsBarrier)
+					m_PassBarriers[i].push_back({ access.Resource, oldUsage, srcUsage, access.Usage });
+
+				states[access.Resource] = access.Usage;
+				touched[access.Resource] = true;
+			}
+		}
+
+		for (ResourceID id = 0; id < static_cast<ResourceID>(m_Resources.size()); id++)
+		{
+			const Resource& resource = m_Resources[id];
+			if (resource.IsImported && resource.FinalUsage != ResourceUsage::None && states[id] != resource.FinalUsage)
+				m_FinalBarriers.push_back({ id, states[id], states[id], resource.FinalUsage });
+		}
+	}
+
+	void RenderGraph::Execute(VkCommandBuffer commandBuffer, GpuProfiler* profiler)
+	{
+		for (size_t i = 0; i < m_Passes.size(); i++)
+		{
+			if (!m_Passes[i].IsActive)
+				continue;
+
+			RecordBarriers(commandBuffer, m_PassBarriers[i]);
+			GpuScope scope(profiler, commandBuffer, m_Passes[i].Name);
+			m_Passes[i].Execute(commandBuffer);
+		}
+
+		RecordBarriers(commandBuffer, m_FinalBarriers);
+	}
+
+	void RenderGraph::RecordBarriers(VkCommandBuffer commandBuffer, const std::vector<Barrier>& barriers)
+	{
+		if (barriers.empty())
+			return;
+
+		std::vector<VkImageMemoryBarrier> imageBarriers;
+		std::vector<VkBufferMemoryBarrier> bufferBarriers;
+		VkPipelineStageFlags srcStages = 0;
+		VkPipelineStageFlags dstStages = 0;
+
+		for (const auto& barrier : barriers)
+		{
+			const Resource& resource = m_Resources[barrier.Resource];
+			UsageInfo oldInfo = GetUsageInfo(barrier.OldUsage);
+			UsageInfo srcInfo = GetUsageInfo(barrier.SrcUsage);
+			UsageInfo newInfo = GetUsageInfo(barrier.NewUsage);
+
+			srcStages |= srcInfo.Stages;
+			dstStages |= newInfo.Stages;
+
+			if (resource.IsBuffer)
+			{
+				VkBufferMemoryBarrier bufferBarrier = {};
+				bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+				bufferBarrier.srcAccessMask = srcInfo.Access;
+				bufferBarrier.dstAccessMask = newInfo.Access;
+				bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				bufferBarrier.buffer = resource.Buffer;
+				bufferBarrier.offset = 0;
+				bufferBarrier.size = VK_WHOLE_SIZE;
+
+				bufferBarriers.push_back(bufferBarrier);
+			}
+			else
+			{
+				VkImageMemoryBarrier imageBarrier = {};
+				imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+				imageBarrier.srcAccessMask = srcInfo.Access;
+				imageBarrier.dstAccessMask = newInfo.Access;
+				imageBarrier.oldLayout = oldInfo.Layout;
+				imageBarrier.newLayout = newInfo.Layout;
+				imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				imageBarrier.image = resource.Image;
+				imageBarrier.subresourceRange.aspectMask = resource.Desc.Aspect;
+				imageBarrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+				imageBarrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+
+				imageBarriers.push_back(imageBarrier);
+			}
+		}
+
+		vkCmdPipelineBarrier(commandBuffer, srcStages, dstStages, 0, 0, nullptr,
+			static_cast<uint32_t>(bufferBarriers.size()), bufferBarriers.data(),
+			static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+	}
+
+	void RenderGraph::DestroyTransients(VkDevice device)
+	{
+		for (auto& resource : m_Resources)
+		{
+			if (resource.IsImported)
+				continue;
+
+			if (resource.ImageView)
+				vkDestroyImageView(device, resource.ImageView, nullptr);
+			if (resource.Image)
+				vkDestroyImage(device, resource.Image, nullptr);
+
+			resource.ImageView = nullptr;
+			resource.Image = nullptr;
+		}
+
+		if (m_TransientPool)
+		{
+			m_TransientPool->Destroy(device);
+			delete m_TransientPool;
+			m_TransientPool = nullptr;
+		}
+
+		m_MemorySlots.clear();
+	}
+} // namespace sge::vulkan
\ No newline at end of file
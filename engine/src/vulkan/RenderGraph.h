@@ -0,0 +1,176 @@
+#pragma once
+
+#include "GpuProfiler.h"
+#include "MemoryAllocator.h"
+#include "base.h"
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+#include <string>
+#include <functional>
+
+namespace sge::vulkan
+{
+	using ResourceID = uint32_t;
+	constexpr ResourceID INVALID_RESOURCE = UINT32_MAX;
+
+	// How a pass uses a resource. Every usage maps to an image layout, pipeline stages and access flags,
+	// which is all the graph needs to derive barriers between passes.
+	enum class ResourceUsage
+	{
+		None,
+		ColorAttachment,
+		DepthAttachment,
+		DepthRead,
+		SampledFragment,
+		SampledCompute,
+		StorageReadCompute,
+		StorageWriteCompute,
+		StorageReadGraphics,
+		IndirectRead,
+		TransferSrc,
+		TransferDst,
+		Present
+	};
+
+	struct ImageDesc
+	{
+		// A width or height of 0 means the size of the backbuffer
+		uint32_t Width = 0;
+		uint32_t Height = 0;
+		VkFormat Format = VK_FORMAT_UNDEFINED;
+		VkImageUsageFlags Usage = 0;
+		VkImageAspectFlags Aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+		uint32_t MipLevels = 1;
+	};
+
+	class PassBuilder
+	{
+	public:
+		void Read(ResourceID resource, ResourceUsage usage);
+		void Write(ResourceID resource, ResourceUsage usage);
+		// Passes with side effects outside the graph are never culled
+		inline void SetSideEffects() { m_SideEffects = true; }
+	private:
+		struct Access
+		{
+			ResourceID Resource;
+			ResourceUsage Usage;
+			bool IsWrite;
+		};
+
+		std::vector<Access> m_Accesses;
+		bool m_SideEffects = false;
+
+		friend class RenderGraph;
+	};
+
+	using PassSetupFunc = std::function<void(PassBuilder&)>;
+	using PassExecuteFunc = std::function<void(VkCommandBuffer)>;
+
+	// Frame graph: passes declare the resources they read and write, 'Compile' culls passes that do not
+	// contribute to an output, derives the barriers and layout transitions between passes, and places
+	// transient images whose lifetimes do not overlap in the same memory.
+	class RenderGraph
+	{
+	public:
+		RenderGraph();
+#ifdef DEBUG
+		~RenderGraph()
+		{
+			SGE_ASSERTM(m_CleanedUp, "Render graph was not cleaned up.");
+		}
+#endif // DEBUG
+		void Destroy(VkDevice device);
+
+		// Imported resources are owned outside the graph and are treated as outputs.
+		// 'initialUsage' is the state they are in when the graph starts executing,
+		// 'finalUsage' the state the graph leaves them in.
+		ResourceID ImportImage(const std::string& name, VkImage image, VkImageView imageView, VkImageAspectFlags aspect,
+			ResourceUsage initialUsage, ResourceUsage finalUsage);
+		ResourceID ImportBuffer(const std::string& name, VkBuffer buffer, ResourceUsage initialUsage, ResourceUsage finalUsage);
+		ResourceID CreateImage(const std::string& name, const ImageDesc& desc);
+		void SetImportedImage(ResourceID resource, VkImage image, VkImageView imageView);
+		void SetImportedBuffer(ResourceID resource, VkBuffer buffer);
+
+		void AddPass(const std::string& name, const PassSetupFunc& setup, const PassExecuteFunc& execute);
+
+		void Compile(VkDevice device, MemoryAllocator* allocator, VkExtent2D backbufferExtent);
+		// Every pass is measured as a scope of 'profiler' if one is given
+		void Execute(VkCommandBuffer commandBuffer, GpuProfiler* profiler = nullptr);
+	public:
+		inline VkImage GetImage(ResourceID resource) const { return m_Resources[resource].Image; }
+		inline VkImageView GetImageView(ResourceID resource) const { return m_Resources[resource].ImageView; }
+		inline VkBuffer GetBuffer(ResourceID resource) const { return m_Resources[resource].Buffer; }
+		inline VkExtent2D GetBackbufferExtent() const { return m_BackbufferExtent; }
+		bool IsPassActive(const std::string& name) const;
+	private:
+		struct Resource
+		{
+			std::string Name;
+			bool IsImported;
+			bool IsBuffer;
+			ImageDesc Desc;
+			ResourceUsage InitialUsage;
+			ResourceUsage FinalUsage;
+
+			VkImage Image = nullptr;
+			VkImageView ImageView = nullptr;
+			VkBuffer Buffer = nullptr;
+
+			// Compiled data
+			uint32_t FirstPass;
+			uint32_t LastPass;
+			uint32_t MemorySlotIndex;
+			// Resource that used the same memory before this one, if any
+			ResourceID AliasPredecessor;
+		};
+
+		struct Pass
+		{
+			std::string Name;
+			PassBuilder Builder;
+			PassExecuteFunc Execute;
+			bool IsActive;
+		};
+
+		struct Barrier
+		{
+			ResourceID Resource;
+			// 'OldUsage' determines the old layout, 'SrcUsage' the work to wait for. They differ on the first use
+			// of a resource in a frame, which has to wait for the previous frame or an aliased image.
+			ResourceUsage OldUsage;
+			ResourceUsage SrcUsage;
+			ResourceUsage NewUsage;
+		};
+
+		struct MemorySlot
+		{
+			Allocation Memory;
+			VkDeviceSize Size;
+			VkDeviceSize Alignment;
+			uint32_t MemoryTypeBits;
+			ResourceID LastResource;
+		};
+
+		void CullPasses();
+		void AllocateTransients(VkDevice device, MemoryAllocator* allocator);
+		void BuildBarriers();
+		void DestroyTransients(VkDevice device);
+		void RecordBarriers(VkCommandBuffer commandBuffer, const std::vector<Barrier>& barriers);
+	private:
+		std::vector<Resource> m_Resources;
+		std::vector<Pass> m_Passes;
+		std::vector<MemorySlot> m_MemorySlots;
+		// Holds every memory slot, null until the graph is compiled
+		LinearPool* m_TransientPool;
+		// Barriers recorded before each pass, and after the last one for imported resources
+		std::vector<std::vector<Barrier>> m_PassBarriers;
+		std::vector<Barrier> m_FinalBarriers;
+		VkExtent2D m_BackbufferExtent;
+#ifdef DEBUG
+		bool m_CleanedUp = false;
+#endif // DEBUG
+	};
+} // namespace sge::vulkan
\ No newline at end of file
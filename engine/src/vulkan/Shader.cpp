@@ -3,12 +3,18 @@
 
 namespace sge::vulkan
 {
-	Shader::Shader(VkDevice device, VkDescriptorPool descriptorPool, const std::string& vertPath, const std::string& fragPath)
+	Shader::Shader(VkDevice device, const std::string& vertPath, const std::string& fragPath)
 		: m_VertShaderModule(nullptr), m_FragShaderModule(nullptr)
 	{
 		auto vertBinary = LoadShaderBinary(vertPath);
 		auto fragBinary = LoadShaderBinary(fragPath);
 
+		m_Hash = HashBytes(vertBinary.data(), vertBinary.size());
+		m_Hash = HashBytes(fragBinary.data(), fragBinary.size(), m_Hash);
+
+		m_Reflection = ReflectSpirv(vertBinary, VK_SHADER_STAGE_VERTEX_BIT);
+		m_Reflection.Merge(ReflectSpirv(fragBinary, VK_SHADER_STAGE_FRAGMENT_BIT));
+
 		VkShaderModuleCreateInfo createInfo = {};
 		createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
 		createInfo.codeSize = vertBinary.size();
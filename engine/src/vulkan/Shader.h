@@ -4,6 +4,7 @@
 #include "Buffer.h"
 #include "Texture.h"
 #include "FrameGroup.h"
+#include "ShaderReflection.h"
 
 #include <vulkan/vulkan.h>
 
@@ -14,7 +15,7 @@ namespace sge::vulkan
 	class Shader
 	{
 	public:
-		Shader(VkDevice device, VkDescriptorPool descriptorPool, const std::string& vertPath, const std::string& fragPath);
+		Shader(VkDevice device, const std::string& vertPath, const std::string& fragPath);
 		void Destroy(VkDevice device);
 #ifdef DEBUG
 		~Shader()
@@ -22,9 +23,16 @@ namespace sge::vulkan
 			SGE_ASSERTM(m_CleanedUp, "Shader was not cleaned up.");
 		}
 #endif // DEBUG
+	public:
+		// Hash of the SPIR-V code, equal for shaders loaded from the same binaries
+		inline uint64_t GetHash() const { return m_Hash; }
+		// Resources of both stages
+		inline const ShaderReflection& GetReflection() const { return m_Reflection; }
 	private:
 		VkShaderModule m_VertShaderModule;
 		VkShaderModule m_FragShaderModule;
+		uint64_t m_Hash;
+		ShaderReflection m_Reflection;
 #ifdef DEBUG
 		bool m_CleanedUp = false;
 #endif // DEBUG
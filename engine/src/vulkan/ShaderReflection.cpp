@@ -0,0 +1,327 @@
+#include "ShaderReflection.h"
+
+#include <algorithm>
+
+namespace sge::vulkan
+{
+	// The part of the SPIR-V specification that reflection needs
+	namespace spv
+	{
+		constexpr uint32_t MAGIC = 0x07230203;
+		constexpr size_t HEADER_WORD_COUNT = 5;
+
+		// Opcodes
+		constexpr uint32_t OP_TYPE_INT = 21;
+		constexpr uint32_t OP_TYPE_FLOAT = 22;
+		constexpr uint32_t OP_TYPE_VECTOR = 23;
+		constexpr uint32_t OP_TYPE_MATRIX = 24;
+		constexpr uint32_t OP_TYPE_IMAGE = 25;
+		constexpr uint32_t OP_TYPE_SAMPLER = 26;
+		constexpr uint32_t OP_TYPE_SAMPLED_IMAGE = 27;
+		constexpr uint32_t OP_TYPE_ARRAY = 28;
+		constexpr uint32_t OP_TYPE_RUNTIME_ARRAY = 29;
+		constexpr uint32_t OP_TYPE_STRUCT = 30;
+		constexpr uint32_t OP_TYPE_POINTER = 32;
+		constexpr uint32_t OP_CONSTANT = 43;
+		constexpr uint32_t OP_SPEC_CONSTANT = 50;
+		constexpr uint32_t OP_VARIABLE = 59;
+		constexpr uint32_t OP_DECORATE = 71;
+		constexpr uint32_t OP_MEMBER_DECORATE = 72;
+
+		// Decorations
+		constexpr uint32_t DECORATION_BUFFER_BLOCK = 3;
+		constexpr uint32_t DECORATION_ARRAY_STRIDE = 6;
+		constexpr uint32_t DECORATION_MATRIX_STRIDE = 7;
+		constexpr uint32_t DECORATION_BUILT_IN = 11;
+		constexpr uint32_t DECORATION_LOCATION = 30;
+		constexpr uint32_t DECORATION_BINDING = 33;
+		constexpr uint32_t DECORATION_DESCRIPTOR_SET = 34;
+		constexpr uint32_t DECORATION_OFFSET = 35;
+
+		// Storage classes
+		constexpr uint32_t STORAGE_CLASS_UNIFORM_CONSTANT = 0;
+		constexpr uint32_t STORAGE_CLASS_INPUT = 1;
+		constexpr uint32_t STORAGE_CLASS_UNIFORM = 2;
+		constexpr uint32_t STORAGE_CLASS_PUSH_CONSTANT = 9;
+		constexpr uint32_t STORAGE_CLASS_STORAGE_BUFFER = 12;
+
+		constexpr uint32_t DIM_BUFFER = 5;
+		// 'Sampled' operand of 'OpTypeImage' for images that are read and written without a sampler
+		constexpr uint32_t IMAGE_STORAGE = 2;
+	} // namespace spv
+
+	// Everything known about one result ID
+	struct SpirvId
+	{
+		uint32_t Opcode = 0;
+		// Result type of constants and variables
+		uint32_t TypeId = 0;
+		// Operands after the result ID
+		std::vector<uint32_t> Operands;
+		uint32_t Set = UINT32_MAX;
+		uint32_t Binding = UINT32_MAX;
+		uint32_t Location = UINT32_MAX;
+		uint32_t ArrayStride = 0;
+		bool BufferBlock = false;
+		bool BuiltIn = false;
+		// Struct members
+		std::vector<uint32_t> MemberOffsets;
+		std::vector<uint32_t> MemberMatrixStrides;
+	};
+
+	// Bytes the type takes in a buffer with explicit layout. 'matrixStride' comes from the struct member a matrix is in.
+	static uint32_t GetTypeSize(const std::vector<SpirvId>& ids, uint32_t typeId, uint32_t matrixStride = 0)
+	{
+		const SpirvId& type = ids[typeId];
+		switch (type.Opcode)
+		{
+		case spv::OP_TYPE_INT:
+		case spv::OP_TYPE_FLOAT:
+			return type.Operands[0] / 8;
+		case spv::OP_TYPE_VECTOR:
+			return type.Operands[1] * GetTypeSize(ids, type.Operands[0]);
+		case spv::OP_TYPE_MATRIX:
+			return type.Operands[1] * (matrixStride ? matrixStride : GetTypeSize(ids, type.Operands[0]));
+		case spv::OP_TYPE_ARRAY:
+		{
+			uint32_t length = ids[type.Operands[1]].Operands[0];
+			return length * (type.ArrayStride ? type.ArrayStride : GetTypeSize(ids, type.Operands[0]));
+		}
+		case spv::OP_TYPE_STRUCT:
+		{
+			uint32_t size = 0;
+			for (size_t i = 0; i < type.Operands.size(); i++)
+			{
+				uint32_t offset = i < type.MemberOffsets.size() ? type.MemberOffsets[i] : 0;
+				uint32_t stride = i < type.MemberMatrixStrides.size() ? type.MemberMatrixStrides[i] : 0;
+				size = std::max(size, offset + GetTypeSize(ids, type.Operands[i], stride));
+			}
+			return size;
+		}
+		default:
+			// Runtime arrays have no fixed size
+			return 0;
+		}
+	}
+
+	static VkDescriptorType GetDescriptorType(const SpirvId& type, uint32_t storageClass)
+	{
+		switch (type.Opcode)
+		{
+		case spv::OP_TYPE_SAMPLED_IMAGE:
+			return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		case spv::OP_TYPE_SAMPLER:
+			return VK_DESCRIPTOR_TYPE_SAMPLER;
+		case spv::OP_TYPE_IMAGE:
+		{
+			bool storage = type.Operands[5] == spv::IMAGE_STORAGE;
+			if (type.Operands[1] == spv::DIM_BUFFER)
+				return storage ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+			return storage ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+		}
+		default:
+			// Blocks, older SPIR-V marks storage buffers as uniform buffer blocks
+			if (storageClass == spv::STORAGE_CLASS_STORAGE_BUFFER || type.BufferBlock)
+				return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		}
+	}
+
+	static void SortBindings(std::vector<VkDescriptorSetLayoutBinding>& bindings)
+	{
+		std::sort(bindings.begin(), bindings.end(),
+			[](const VkDescriptorSetLayoutBinding& a, const VkDescriptorSetLayoutBinding& b) { return a.binding < b.binding; });
+	}
+
+	void ShaderReflection::Merge(const ShaderReflection& other)
+	{
+		for (uint32_t set = 0; set < DESCRIPTOR_SET_COUNT; set++)
+		{
+			for (const auto& binding : other.Sets[set])
+			{
+				auto it = std::find_if(Sets[set].begin(), Sets[set].end(),
+					[&binding](const VkDescriptorSetLayoutBinding& b) { return b.binding == binding.binding; });
+				if (it == Sets[set].end())
+				{
+					Sets[set].push_back(binding);
+					continue;
+				}
+
+				SGE_ASSERTM(it->descriptorType == binding.descriptorType, "Shader stages use different descriptor types for the same binding.");
+				it->stageFlags |= binding.stageFlags;
+				it->descriptorCount = it->descriptorCount && binding.descriptorCount ? std::max(it->descriptorCount, binding.descriptorCount) : 0;
+			}
+			SortBindings(Sets[set]);
+		}
+
+		PushConstants.stageFlags |= other.PushConstants.stageFlags;
+		PushConstants.size = std::max(PushConstants.size, other.PushConstants.size);
+
+		InputLocations.insert(InputLocations.end(), other.InputLocations.begin(), other.InputLocations.end());
+		std::sort(InputLocations.begin(), InputLocations.end());
+		InputLocations.erase(std::unique(InputLocations.begin(), InputLocations.end()), InputLocations.end());
+	}
+
+	ShaderReflection ReflectSpirv(const std::vector<char>& code, VkShaderStageFlagBits stage)
+	{
+		ShaderReflection reflection;
+
+		const uint32_t* words = reinterpret_cast<const uint32_t*>(code.data());
+		size_t wordCount = code.size() / sizeof(uint32_t);
+		if (wordCount < spv::HEADER_WORD_COUNT || words[0] != spv::MAGIC)
+		{
+			SGE_ERROR("Shader binary is not SPIR-V.");
+			return reflection;
+		}
+
+		// The header holds the bound of the result IDs
+		std::vector<SpirvId> ids(words[3]);
+		for (size_t i = spv::HEADER_WORD_COUNT; i < wordCount;)
+		{
+			const uint32_t* instruction = words + i;
+			uint32_t opcode = instruction[0] & 0xFFFF;
+			uint32_t length = instruction[0] >> 16;
+			if (length == 0 || i + length > wordCount)
+			{
+				SGE_ERROR("Shader binary has a malformed SPIR-V instruction.");
+				break;
+			}
+			i += length;
+
+			switch (opcode)
+			{
+			case spv::OP_DECORATE:
+			{
+				SpirvId& target = ids[instruction[1]];
+				uint32_t value = length > 3 ? instruction[3] : 0;
+				switch (instruction[2])
+				{
+				case spv::DECORATION_DESCRIPTOR_SET: target.Set = value; break;
+				case spv::DECORATION_BINDING: target.Binding = value; break;
+				case spv::DECORATION_LOCATION: target.Location = value; break;
+				case spv::DECORATION_ARRAY_STRIDE: target.ArrayStride = value; break;
+				case spv::DECORATION_BUFFER_BLOCK: target.BufferBlock = true; break;
+				case spv::DECORATION_BUILT_IN: target.BuiltIn = true; break;
+				}
+				break;
+			}
+			case spv::OP_MEMBER_DECORATE:
+			{
+				if (length < 5)
+					break;
+
+				SpirvId& target = ids[instruction[1]];
+				uint32_t member = instruction[2];
+				if (instruction[3] == spv::DECORATION_OFFSET)
+				{
+					target.MemberOffsets.resize(std::max<size_t>(target.MemberOffsets.size(), member + 1));
+					target.MemberOffsets[member] = instruction[4];
+				}
+				else if (instruction[3] == spv::DECORATION_MATRIX_STRIDE)
+				{
+					target.MemberMatrixStrides.resize(std::max<size_t>(target.MemberMatrixStrides.size(), member + 1));
+					target.MemberMatrixStrides[member] = instruction[4];
+				}
+				break;
+			}
+			case spv::OP_TYPE_INT:
+			case spv::OP_TYPE_FLOAT:
+			case spv::OP_TYPE_VECTOR:
+			case spv::OP_TYPE_MATRIX:
+			case spv::OP_TYPE_IMAGE:
+			case spv::OP_TYPE_SAMPLER:
+			case spv::OP_TYPE_SAMPLED_IMAGE:
+			case spv::OP_TYPE_ARRAY:
+			case spv::OP_TYPE_RUNTIME_ARRAY:
+			case spv::OP_TYPE_STRUCT:
+			case spv::OP_TYPE_POINTER:
+			{
+				SpirvId& result = ids[instruction[1]];
+				result.Opcode = opcode;
+				result.Operands.assign(instruction + 2, instruction + length);
+				break;
+			}
+			case spv::OP_CONSTANT:
+			case spv::OP_SPEC_CONSTANT:
+			case spv::OP_VARIABLE:
+			{
+				SpirvId& result = ids[instruction[2]];
+				result.Opcode = opcode;
+				result.TypeId = instruction[1];
+				result.Operands.assign(instruction + 3, instruction + length);
+				break;
+			}
+			}
+		}
+
+		for (const SpirvId& variable : ids)
+		{
+			if (variable.Opcode != spv::OP_VARIABLE)
+				continue;
+
+			uint32_t storageClass = variable.Operands[0];
+			uint32_t typeId = ids[variable.TypeId].Operands[1];
+			switch (storageClass)
+			{
+			case spv::STORAGE_CLASS_INPUT:
+				if (stage == VK_SHADER_STAGE_VERTEX_BIT && !variable.BuiltIn && variable.Location != UINT32_MAX)
+					reflection.InputLocations.push_back(variable.Location);
+				break;
+			case spv::STORAGE_CLASS_PUSH_CONSTANT:
+				reflection.PushConstants.stageFlags = stage;
+				reflection.PushConstants.size = GetTypeSize(ids, typeId);
+				break;
+			case spv::STORAGE_CLASS_UNIFORM_CONSTANT:
+			case spv::STORAGE_CLASS_UNIFORM:
+			case spv::STORAGE_CLASS_STORAGE_BUFFER:
+			{
+				if (variable.Set == UINT32_MAX || variable.Binding == UINT32_MAX)
+					break;
+				if (variable.Set >= DESCRIPTOR_SET_COUNT)
+				{
+					SGE_ERRORF("Shader uses descriptor set %u, only %u sets are supported.", variable.Set, DESCRIPTOR_SET_COUNT);
+					break;
+				}
+
+				// Arrays of descriptors, runtime arrays have 0 descriptors
+				uint32_t descriptorCount = 1;
+				while (ids[typeId].Opcode == spv::OP_TYPE_ARRAY || ids[typeId].Opcode == spv::OP_TYPE_RUNTIME_ARRAY)
+				{
+					const SpirvId& array = ids[typeId];
+					descriptorCount = array.Opcode == spv::OP_TYPE_ARRAY ? descriptorCount * ids[array.Operands[1]].Operands[0] : 0;
+					typeId = array.Operands[0];
+				}
+
+				VkDescriptorSetLayoutBinding binding = {};
+				binding.binding = variable.Binding;
+				binding.descriptorType = GetDescriptorType(ids[typeId], storageClass);
+				binding.descriptorCount = descriptorCount;
+				binding.stageFlags = stage;
+				reflection.Sets[variable.Set].push_back(binding);
+				break;
+			}
+			}
+		}
+
+		for (auto& bindings : reflection.Sets)
+			SortBindings(bindings);
+		std::sort(reflection.InputLocations.begin(), reflection.InputLocations.end());
+
+		return reflection;
+	}
+
+	bool FitsSetLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings,
+		const std::vector<VkDescriptorSetLayoutBinding>& layoutBindings)
+	{
+		for (const auto& binding : bindings)
+		{
+			auto it = std::find_if(layoutBindings.begin(), layoutBindings.end(),
+				[&binding](const VkDescriptorSetLayoutBinding& b) { return b.binding == binding.binding; });
+			if (it == layoutBindings.end() || it->descriptorType != binding.descriptorType || (binding.stageFlags & ~it->stageFlags)
+				|| binding.descriptorCount > it->descriptorCount)
+				return false;
+		}
+
+		return true;
+	}
+} // namespace sge::vulkan
\ No newline at end of file
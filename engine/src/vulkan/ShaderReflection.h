@@ -0,0 +1,31 @@
+#pragma once
+
+#include "DescriptorAllocator.h"
+#include "base.h"
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <vector>
+
+namespace sge::vulkan
+{
+	// Resources used by SPIR-V code, read from its decorations. Descriptor sets are numbered by 'DESCRIPTOR_SET_*'.
+	struct ShaderReflection
+	{
+		// Bindings of each set, sorted by binding number. 'descriptorCount' is 0 for runtime arrays, e.g. the texture table.
+		std::array<std::vector<VkDescriptorSetLayoutBinding>, DESCRIPTOR_SET_COUNT> Sets;
+		// 'size' is 0 if there are no push constants
+		VkPushConstantRange PushConstants = {};
+		// Locations of the vertex shader's inputs, sorted
+		std::vector<uint32_t> InputLocations;
+
+		// Combines the stages of one pipeline, bindings used by both get both stage flags
+		void Merge(const ShaderReflection& other);
+	};
+
+	ShaderReflection ReflectSpirv(const std::vector<char>& code, VkShaderStageFlagBits stage);
+	// True if every binding in 'bindings' is in 'layoutBindings' with the same type, enough descriptors and its stages
+	bool FitsSetLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings,
+		const std::vector<VkDescriptorSetLayoutBinding>& layoutBindings);
+} // namespace sge::vulkan
\ No newline at end of file
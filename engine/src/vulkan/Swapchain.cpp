@@ -6,30 +6,30 @@
 namespace sge::vulkan
 {
 	Swapchain::Swapchain(VkDevice device, VkSurfaceKHR surface, GLFWwindow* windowHandle,
-		SwapchainSupportDetails&& supportDetails, const QueueFamilyIndices& queueFamilyIndices)
-		: m_SwapchainHandle(nullptr), m_FramebufferResized(false)
+		SwapchainSupportDetails&& supportDetails, const QueueFamilyIndices& queueFamilyIndices, VkPresentModeKHR presentMode,
+		uint32_t imageCount, VkSwapchainKHR oldSwapchain)
+		: m_SwapchainHandle(nullptr), m_Allocator(nullptr), m_FramebufferResized(false)
 	{
 		VkSurfaceFormatKHR surfaceFormat = ChooseSurfaceFormat(supportDetails.Formats);
-		VkPresentModeKHR presentMode = ChoosePresentMode(supportDetails.PresentModes);
+		m_PresentMode = ChoosePresentMode(supportDetails.PresentModes, presentMode);
 		VkExtent2D extent = ChooseExtent(supportDetails.Capabilities, windowHandle);
-
-		uint32_t imageCount = supportDetails.Capabilities.minImageCount + 1;
-		if (supportDetails.Capabilities.maxImageCount > 0 && imageCount > supportDetails.Capabilities.maxImageCount)
-			imageCount = supportDetails.Capabilities.maxImageCount;
+		imageCount = ChooseImageCount(supportDetails.Capabilities, imageCount);
 
 		VkSwapchainCreateInfoKHR createInfo = {};
 		createInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
 		createInfo.surface = surface;
 		createInfo.imageFormat = surfaceFormat.format;
 		createInfo.imageColorSpace = surfaceFormat.colorSpace;
-		createInfo.presentMode = presentMode;
+		createInfo.presentMode = m_PresentMode;
 		createInfo.imageExtent = extent;
 		createInfo.imageArrayLayers = 1;
 		createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+		uint32_t indices[2] = { queueFamilyIndices.GraphicsFamily.value(), queueFamilyIndices.PresentFamily.value() };
 		if (queueFamilyIndices.GraphicsFamily != queueFamilyIndices.PresentFamily)
 		{
 			createInfo.imageSharingMode = VK_SHARING_MODE_CONCURRENT;
 			createInfo.queueFamilyIndexCount = 2;
+			createInfo.pQueueFamilyIndices = indices;
 		}
 		else
 			createInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
@@ -37,7 +37,8 @@ namespace sge::vulkan
 		createInfo.preTransform = supportDetails.Capabilities.currentTransform;
 		createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
 		createInfo.clipped = VK_TRUE;
-		createInfo.oldSwapchain = VK_NULL_HANDLE;
+		// Lets the driver reuse resources of the swap chain being replaced
+		createInfo.oldSwapchain = oldSwapchain;
 
 		if (vkCreateSwapchainKHR(device, &createInfo, nullptr, &m_SwapchainHandle) != VK_SUCCESS)
 			SGE_DEBUG_BREAKM("Failed to create Vulkan swap chain.");
@@ -49,6 +50,21 @@ namespace sge::vulkan
 		m_Extent = extent;
 	}
 
+	Swapchain::Swapchain(VkDevice device, MemoryAllocator* allocator, VkExtent2D extent, uint32_t imageCount)
+		: m_SwapchainHandle(nullptr), m_Allocator(allocator), m_ImageFormat(VK_FORMAT_R8G8B8A8_SRGB), m_Extent(extent), m_PresentMode(VK_PRESENT_MODE_FIFO_KHR),
+		m_FramebufferResized(false)
+	{
+		m_Images.resize(imageCount);
+		m_ImageMemory.resize(imageCount);
+
+		for (uint32_t i = 0; i < imageCount; i++)
+		{
+			CreateImage(device, allocator, extent.width, extent.height, m_ImageFormat, VK_IMAGE_TILING_OPTIMAL,
+				VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, MemoryUsage::GpuOnly,
+				MemoryCategory::Attachments, &m_Images[i], &m_ImageMemory[i]);
+		}
+	}
+
 	void Swapchain::Destroy(VkDevice device)
 	{
 		for (auto framebuffer : m_Framebuffers)
@@ -58,11 +74,20 @@ namespace sge::vulkan
 
 		//vkDestroyRenderPass(m_Device, m_RenderPass, nullptr);
 
-		vkDestroySwapchainKHR(device, m_SwapchainHandle, nullptr);
-
 		for (auto imageView : m_ImageViews)
 			vkDestroyImageView(device, imageView, nullptr);
 
+		if (IsHeadless())
+		{
+			for (size_t i = 0; i < m_Images.size(); i++)
+			{
+				vkDestroyImage(device, m_Images[i], nullptr);
+				m_Allocator->Free(device, m_ImageMemory[i]);
+			}
+		}
+		else
+			vkDestroySwapchainKHR(device, m_SwapchainHandle, nullptr);
+
 #ifdef DEBUG
 		m_CleanedUp = true;
 #endif
@@ -109,17 +134,29 @@ namespace sge::vulkan
 		return availableFormats[0];
 	}
 
-	VkPresentModeKHR Swapchain::ChoosePresentMode(const std::vector<VkPresentModeKHR>& availableModes)
+	VkPresentModeKHR Swapchain::ChoosePresentMode(const std::vector<VkPresentModeKHR>& availableModes, VkPresentModeKHR preferredMode)
 	{
 		for (const auto& mode : availableModes)
 		{
-			if (mode == VK_PRESENT_MODE_MAILBOX_KHR)
+			if (mode == preferredMode)
 				return mode;
 		}
 
+		SGE_WARNF("Present mode %d is not supported, falling back to FIFO.", static_cast<int>(preferredMode));
 		return VK_PRESENT_MODE_FIFO_KHR;
 	}
 
+	uint32_t Swapchain::ChooseImageCount(const VkSurfaceCapabilitiesKHR& capabilities, uint32_t preferredCount)
+	{
+		uint32_t imageCount = preferredCount ? preferredCount : capabilities.minImageCount + 1;
+		if (imageCount < capabilities.minImageCount)
+			imageCount = capabilities.minImageCount;
+		if (capabilities.maxImageCount > 0 && imageCount > capabilities.maxImageCount)
+			imageCount = capabilities.maxImageCount;
+
+		return imageCount;
+	}
+
 	VkExtent2D Swapchain::ChooseExtent(const VkSurfaceCapabilitiesKHR& capabilities, GLFWwindow* window)
 	{
 		if (capabilities.currentExtent.width != UINT_MAX)
@@ -16,9 +16,13 @@ namespace sge::vulkan
 	private:
 		VkSwapchainKHR m_SwapchainHandle;
 		std::vector<VkImage> m_Images;
+		// Only used by headless swap chains, which own their images
+		MemoryAllocator* m_Allocator;
+		std::vector<Allocation> m_ImageMemory;
 		std::vector<VkImageView> m_ImageViews;
 		VkFormat m_ImageFormat;
 		VkExtent2D m_Extent;
+		VkPresentModeKHR m_PresentMode;
 		std::vector<VkFramebuffer> m_Framebuffers;
 		bool m_FramebufferResized;
 #ifdef DEBUG
@@ -26,7 +30,10 @@ namespace sge::vulkan
 #endif // DEBUG
 	public:
 		Swapchain(VkDevice device, VkSurfaceKHR surface, GLFWwindow* windowHandle,
-			SwapchainSupportDetails&& supportDetails, const QueueFamilyIndices& queueFamilyIndices);
+			SwapchainSupportDetails&& supportDetails, const QueueFamilyIndices& queueFamilyIndices, VkPresentModeKHR presentMode,
+			uint32_t imageCount, VkSwapchainKHR oldSwapchain = nullptr);
+		// Headless swap chain: offscreen images that can be copied from, with no surface to present to
+		Swapchain(VkDevice device, MemoryAllocator* allocator, VkExtent2D extent, uint32_t imageCount);
 #ifdef DEBUG
 		~Swapchain()
 		{
@@ -42,11 +49,18 @@ namespace sge::vulkan
 		inline VkFormat GetImageFormat() const { return m_ImageFormat; }
 		inline VkExtent2D GetExtent() const { return m_Extent; }
 		inline VkFramebuffer FramebufferAt(uint32_t index) const { return m_Framebuffers[index]; }
+		inline VkImage ImageAt(uint32_t index) const { return m_Images[index]; }
+		inline VkImageView ImageViewAt(uint32_t index) const { return m_ImageViews[index]; }
 		inline void SetFramebufferResized(bool b) { m_FramebufferResized = b; }
 		inline uint32_t GetImageCount() const { return static_cast<uint32_t>(m_Images.size()); }
+		inline bool IsHeadless() const { return !m_SwapchainHandle; }
+		inline VkPresentModeKHR GetPresentMode() const { return m_PresentMode; }
 
 		VkSurfaceFormatKHR ChooseSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats);
-		VkPresentModeKHR ChoosePresentMode(const std::vector<VkPresentModeKHR>& availableModes);
+		// Falls back to FIFO, the only mode every device supports
+		VkPresentModeKHR ChoosePresentMode(const std::vector<VkPresentModeKHR>& availableModes, VkPresentModeKHR preferredMode);
+		// 0 requests one more image than the minimum, the count is clamped to what the surface supports
+		uint32_t ChooseImageCount(const VkSurfaceCapabilitiesKHR& capabilities, uint32_t preferredCount);
 		VkExtent2D ChooseExtent(const VkSurfaceCapabilitiesKHR& capabilities, GLFWwindow* window);
 	};
 } // namespace sge::vulkan
\ No newline at end of file
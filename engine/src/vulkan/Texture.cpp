@@ -1,53 +1,118 @@
 #include "Texture.h"
-#include "Buffer.h"
 #include "Util.h"
+#include "Ktx2.h"
 
 #include <stb_image/stb_image.h>
 
+#include <algorithm>
+#include <filesystem>
+
 // TODO: Interpret normal map data properly
 
 namespace sge::vulkan
 {
-	Texture::Texture(VkDevice device, VkPhysicalDevice physicalDevice, VkCommandPool commandPool, VkQueue graphicsQueue,
-		const std::string& filepath)
-		: m_Image(nullptr), m_ImageMemory(nullptr), m_ImageView(nullptr), m_Sampler(nullptr)
+	constexpr VkFormat IMAGE_FORMAT = VK_FORMAT_R8G8B8A8_SRGB;
+
+	// Block compressed levels from the KTX2 file next to 'filepath', written by the texture compressor
+	static bool LoadCompressedTexture(VkPhysicalDevice physicalDevice, const std::string& filepath, Ktx2Texture& texture)
+	{
+		std::string compressedPath = std::filesystem::path(filepath).replace_extension(".ktx2").string();
+		if (!std::filesystem::exists(compressedPath))
+			return false;
+
+		VkPhysicalDeviceFeatures features;
+		vkGetPhysicalDeviceFeatures(physicalDevice, &features);
+		if (!features.textureCompressionBC)
+		{
+			SGE_WARNF("Device does not support BC textures, decoding '%s' instead.", filepath.c_str());
+			return false;
+		}
+
+		if (!LoadKtx2(compressedPath, texture))
+			return false;
+
+		SGE_INFOF("Loaded '%s' (%u mips).", compressedPath.c_str(), static_cast<uint32_t>(texture.Levels.size()));
+		return true;
+	}
+
+	// Resident right away: every use of the texture is submitted after the upload, whose final barrier covers it
+	Texture::Texture(VkDevice device, VkPhysicalDevice physicalDevice, MemoryAllocator* allocator, UploadContext& uploads,
+		const std::string& filepath, bool streamed)
+		: Texture(device, physicalDevice, allocator)
 	{
+		RecordLoad(device, uploads, Decode(physicalDevice, filepath), streamed);
+		m_IsResident = true;
+	}
+
+	Texture::Texture(VkDevice device, VkPhysicalDevice physicalDevice, MemoryAllocator* allocator, UploadContext& uploads, TextureData&& data)
+		: Texture(device, physicalDevice, allocator)
+	{
+		RecordLoad(device, uploads, std::move(data), false);
+		m_IsResident = true;
+	}
+
+	Texture::Texture(VkDevice device, VkPhysicalDevice physicalDevice, MemoryAllocator* allocator)
+		: m_Allocator(allocator), m_Image(nullptr), m_ImageView(nullptr), m_Sampler(nullptr), m_Format(IMAGE_FORMAT),
+		m_Width(0), m_Height(0), m_MipCount(1), m_LayerCount(1), m_ResidentMip(0), m_MaxResidentMip(0), m_IsResident(false)
+	{
+		InitSampler(device, physicalDevice);
+	}
+
+	TextureData Texture::Decode(VkPhysicalDevice physicalDevice, const std::string& filepath)
+	{
+		TextureData data;
+		Ktx2Texture compressed;
+		if (LoadCompressedTexture(physicalDevice, filepath, compressed))
+		{
+			data.Format = compressed.Format;
+			data.Width = compressed.Width;
+			data.Height = compressed.Height;
+			data.LayerCount = compressed.LayerCount;
+			data.Mips = std::move(compressed.Levels);
+			return data;
+		}
+
 		// Load image
-		stbi_set_flip_vertically_on_load(1);
+		// Decoded on the texture loader's threads, the global flag would be shared between them
+		stbi_set_flip_vertically_on_load_thread(1);
 		int width, height, channels;
 		constexpr int desiredChannels = 4;
-		constexpr VkFormat imageFormat = VK_FORMAT_R8G8B8A8_SRGB;
 
 		uint8_t* imageData = stbi_load(filepath.c_str(), &width, &height, &channels, desiredChannels);
 		SGE_ASSERTF(imageData, "Failed to load texture '%s'.", filepath.c_str());
 		size_t size = static_cast<size_t>(desiredChannels * width * height);
 		SGE_INFOF("Size of '%s': %d bytes.", filepath.c_str(), size);
 
-		Buffer stagingBuffer(device, physicalDevice, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, size);
-		void* data;
-		vkMapMemory(device, stagingBuffer.GetDeviceMemory(), 0, size, 0, &data);
-		memcpy(data, imageData, size);
-		vkUnmapMemory(device, stagingBuffer.GetDeviceMemory());
-
+		data.Format = IMAGE_FORMAT;
+		data.Width = static_cast<uint32_t>(width);
+		data.Height = static_cast<uint32_t>(height);
+		data.Mips = GenerateMipChain(imageData, data.Width, data.Height, true);
 		stbi_image_free(imageData);
 
-		CreateImage(device, physicalDevice, static_cast<uint32_t>(width), static_cast<uint32_t>(height), imageFormat,
-			VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &m_Image, &m_ImageMemory);
-
-		TransitionImageLayout(device, commandPool, graphicsQueue, m_Image, imageFormat,
-			VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-		CopyBufferToImage(device, commandPool, graphicsQueue, stagingBuffer.GetBufferHandle(), m_Image,
-			static_cast<uint32_t>(width), static_cast<uint32_t>(height));
-		TransitionImageLayout(device, commandPool, graphicsQueue, m_Image, imageFormat,
-			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-
-		stagingBuffer.Destroy(device);
+		return data;
+	}
 
-		// Create image view
-		m_ImageView = CreateImageView(device, m_Image, imageFormat, VK_IMAGE_ASPECT_COLOR_BIT);
+	void Texture::RecordLoad(VkDevice device, UploadContext& uploads, TextureData&& data, bool streamed)
+	{
+		m_Format = data.Format;
+		m_Width = data.Width;
+		m_Height = data.Height;
+		m_LayerCount = data.LayerCount;
+		m_MipCount = static_cast<uint32_t>(data.Mips.size());
+
+		// Coarsest mip that still has 'MIN_STREAMED_MIP_SIZE' texels along its longer side
+		m_MaxResidentMip = 0;
+		while (m_MaxResidentMip + 1 < m_MipCount && (std::max(m_Width, m_Height) >> m_MaxResidentMip) > MIN_STREAMED_MIP_SIZE)
+			m_MaxResidentMip++;
+
+		m_ResidentMip = streamed ? m_MaxResidentMip : 0;
+		RecordUpload(device, uploads, data.Mips, m_ResidentMip);
+		if (streamed)
+			m_Mips = std::move(data.Mips);
+	}
 
-		// Create sampler
+	void Texture::InitSampler(VkDevice device, VkPhysicalDevice physicalDevice)
+	{
 		VkSamplerCreateInfo samplerInfo = {};
 		samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
 		samplerInfo.minFilter = VK_FILTER_LINEAR;
@@ -69,6 +134,9 @@ namespace sge::vulkan
 		samplerInfo.compareEnable = VK_FALSE;
 		samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
 		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+		// Levels are relative to the image view, which starts at the finest resident mip
+		samplerInfo.minLod = 0.0f;
+		samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
 
 		if (vkCreateSampler(device, &samplerInfo, nullptr, &m_Sampler) != VK_SUCCESS)
 			SGE_DEBUG_BREAKM("Failed to create Vulkan sampler.");
@@ -79,10 +147,86 @@ namespace sge::vulkan
 		vkDestroySampler(device, m_Sampler, nullptr);
 		vkDestroyImageView(device, m_ImageView, nullptr);
 		vkDestroyImage(device, m_Image, nullptr);
-		vkFreeMemory(device, m_ImageMemory, nullptr);
+		m_Allocator->Free(device, m_ImageMemory);
 
 #ifdef DEBUG
 		m_CleanedUp = true;
 #endif // DEBUG
 	}
+
+	RetiredImage Texture::SetResidentMip(VkDevice device, UploadContext& uploads, uint32_t mip)
+	{
+		SGE_ASSERTM(IsStreamed(), "Only streamed textures can change their resident mips.");
+		mip = std::min(mip, m_MaxResidentMip);
+
+		RetiredImage retired = { m_Image, m_ImageMemory, m_ImageView };
+		RecordUpload(device, uploads, m_Mips, mip);
+		m_ResidentMip = mip;
+
+		return retired;
+	}
+
+	void Texture::DestroyRetiredImage(VkDevice device, MemoryAllocator* allocator, const RetiredImage& image)
+	{
+		vkDestroyImageView(device, image.ImageView, nullptr);
+		vkDestroyImage(device, image.Image, nullptr);
+		allocator->Free(device, image.Memory);
+	}
+
+	void Texture::RecordUpload(VkDevice device, UploadContext& uploads, const MipChain& mips, uint32_t firstMip)
+	{
+		const uint32_t levelCount = static_cast<uint32_t>(mips.size()) - firstMip;
+		const uint32_t width = std::max(m_Width >> firstMip, 1u);
+		const uint32_t height = std::max(m_Height >> firstMip, 1u);
+
+		size_t size = 0;
+		for (uint32_t i = firstMip; i < mips.size(); i++)
+			size += mips[i].size();
+
+		// Aligned for the largest texel block, level sizes are whole blocks
+		StagingAllocation staging = uploads.Allocate(device, size, 16);
+		std::vector<VkBufferImageCopy> regions;
+		size_t offset = 0;
+		for (uint32_t i = firstMip; i < mips.size(); i++)
+		{
+			memcpy(staging.Data + offset, mips[i].data(), mips[i].size());
+
+			VkBufferImageCopy region = {};
+			region.bufferOffset = staging.Offset + offset;
+			region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			region.imageSubresource.mipLevel = i - firstMip;
+			region.imageSubresource.layerCount = m_LayerCount;
+			region.imageExtent = { std::max(m_Width >> i, 1u), std::max(m_Height >> i, 1u), 1 };
+			regions.push_back(region);
+
+			offset += mips[i].size();
+		}
+
+		CreateImage(device, m_Allocator, width, height, m_Format, VK_IMAGE_TILING_OPTIMAL,
+			VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, MemoryUsage::GpuOnly, MemoryCategory::Textures,
+			&m_Image, &m_ImageMemory, levelCount, m_LayerCount);
+
+		VkImageMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = m_Image;
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.levelCount = levelCount;
+		barrier.subresourceRange.layerCount = m_LayerCount;
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		VkCommandBuffer commandBuffer = uploads.GetCommandBuffer(device);
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		vkCmdCopyBufferToImage(commandBuffer, staging.Buffer, m_Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			static_cast<uint32_t>(regions.size()), regions.data());
+
+		uploads.ReleaseImage(device, m_Image, barrier.subresourceRange);
+
+		m_ImageView = CreateImageView(device, m_Image, m_Format, VK_IMAGE_ASPECT_COLOR_BIT, 0, levelCount, VK_IMAGE_VIEW_TYPE_2D_ARRAY,
+			m_LayerCount);
+	}
 } // namespace sge::vulkan
\ No newline at end of file
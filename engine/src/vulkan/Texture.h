@@ -1,18 +1,50 @@
 #pragma once
 
+#include "UploadContext.h"
+#include "TextureCompression.h"
 #include "base.h"
 
 #include <vulkan/vulkan.h>
 
 #include <string>
+#include <vector>
 
 namespace sge::vulkan
 {
+	// Streamed textures always keep the mips up to this size resident
+	constexpr uint32_t MIN_STREAMED_MIP_SIZE = 64;
+
+	// GPU objects of a texture that was replaced, destroyed once no frame in flight uses them anymore
+	struct RetiredImage
+	{
+		VkImage Image = nullptr;
+		Allocation Memory;
+		VkImageView ImageView = nullptr;
+	};
+
+	// Decoded image with its mip chain, level 0 first. Each level holds every layer, one after the other.
+	struct TextureData
+	{
+		VkFormat Format = VK_FORMAT_UNDEFINED;
+		uint32_t Width = 0;
+		uint32_t Height = 0;
+		uint32_t LayerCount = 1;
+		MipChain Mips;
+	};
+
+	// Always viewed as a 2D array, so that the texture packer's arrays and single textures share the texture table
 	class Texture
 	{
 	public:
-		Texture(VkDevice device, VkPhysicalDevice physicalDevice, VkCommandPool commandPool, VkQueue graphicsQueue,
-			const std::string& filepath);
+		// Loads the block compressed KTX2 file with the same name instead of 'filepath' if there is one (see the
+		// texture compressor), otherwise the full mip chain is generated when the image is loaded. Streamed textures
+		// keep it in memory and start with only their coarse mips on the GPU, see 'SetResidentMip'.
+		// The upload is recorded into 'uploads', frames submitted after its next flush can sample the texture.
+		Texture(VkDevice device, VkPhysicalDevice physicalDevice, MemoryAllocator* allocator, UploadContext& uploads,
+			const std::string& filepath, bool streamed = false);
+		Texture(VkDevice device, VkPhysicalDevice physicalDevice, MemoryAllocator* allocator, UploadContext& uploads, TextureData&& data);
+		// Texture without an image, which 'RecordLoad' creates. Used by 'TextureLoader'.
+		Texture(VkDevice device, VkPhysicalDevice physicalDevice, MemoryAllocator* allocator);
 		void Destroy(VkDevice device);
 #ifdef DEBUG
 		~Texture()
@@ -20,17 +52,56 @@ namespace sge::vulkan
 			SGE_ASSERTM(m_CleanedUp, "Texture was not cleaned up.");
 		}
 #endif // DEBUG
+		// Streamed only: replaces the image with one holding the mips from 'mip' down to 1x1. The previous image is returned,
+		// since frames in flight may still sample it. The texture's descriptor must be rewritten afterwards.
+		RetiredImage SetResidentMip(VkDevice device, UploadContext& uploads, uint32_t mip);
+		static void DestroyRetiredImage(VkDevice device, MemoryAllocator* allocator, const RetiredImage& image);
+
+		// Reads the image at 'filepath' as described for the constructor, safe to call from any thread
+		static TextureData Decode(VkPhysicalDevice physicalDevice, const std::string& filepath);
+		// Creates the image and records its upload into 'uploads', the texture is not marked resident
+		void RecordLoad(VkDevice device, UploadContext& uploads, TextureData&& data, bool streamed);
+		inline void SetResident() { m_IsResident = true; }
 	public:
 		inline VkImageView GetImageView() const { return m_ImageView; }
 		inline VkSampler GetSampler() const { return m_Sampler; }
+		inline VkFormat GetFormat() const { return m_Format; }
+		inline uint32_t GetWidth() const { return m_Width; }
+		inline uint32_t GetHeight() const { return m_Height; }
+		inline uint32_t GetMipCount() const { return m_MipCount; }
+		inline uint32_t GetLayerCount() const { return m_LayerCount; }
+		// Finest mip on the GPU
+		inline uint32_t GetResidentMip() const { return m_ResidentMip; }
+		// Coarsest mip a streamed texture may be reduced to
+		inline uint32_t GetMaxResidentMip() const { return m_MaxResidentMip; }
+		// Device memory of the resident mips
+		inline VkDeviceSize GetMemorySize() const { return m_ImageMemory.Size; }
+		inline bool IsStreamed() const { return !m_Mips.empty(); }
+		// False while the image is still being uploaded
+		inline bool IsResident() const { return m_IsResident; }
+	private:
+		void InitSampler(VkDevice device, VkPhysicalDevice physicalDevice);
+		// Creates the image and records the upload of 'mips' into it, starting at level 'firstMip'
+		void RecordUpload(VkDevice device, UploadContext& uploads, const MipChain& mips, uint32_t firstMip);
 	private:
 #ifdef DEBUG
 		bool m_CleanedUp = false;
 #endif // DEBUG
+		MemoryAllocator* m_Allocator;
 		VkImage m_Image;
-		VkDeviceMemory m_ImageMemory;
+		Allocation m_ImageMemory;
 		VkImageView m_ImageView;
 		VkSampler m_Sampler;
+		VkFormat m_Format;
+		uint32_t m_Width;
+		uint32_t m_Height;
+		uint32_t m_MipCount;
+		uint32_t m_LayerCount;
+		uint32_t m_ResidentMip;
+		uint32_t m_MaxResidentMip;
+		bool m_IsResident;
+		// Data of every mip in 'm_Format', only kept for streamed textures
+		MipChain m_Mips;
 	};
 
 } // sge::vulkan
\ No newline at end of file
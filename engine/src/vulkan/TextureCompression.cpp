@@ -0,0 +1,469 @@
+#include "TextureCompression.h"
+
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+namespace sge::vulkan
+{
+	static float SrgbToLinear(uint8_t value)
+	{
+		// Mip chains are generated on the texture loader's threads, static locals are initialized once even then
+		static const std::array<float, 256> table = []()
+		{
+			std::array<float, 256> values;
+			for (uint32_t i = 0; i < 256; i++)
+			{
+				float c = i / 255.0f;
+				values[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+			}
+			return values;
+		}();
+
+		return table[value];
+	}
+
+	static uint8_t LinearToSrgb(float value)
+	{
+		float c = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+		return static_cast<uint8_t>(std::clamp(c * 255.0f + 0.5f, 0.0f, 255.0f));
+	}
+
+	MipChain GenerateMipChain(const uint8_t* pixels, uint32_t width, uint32_t height, bool srgb)
+	{
+		MipChain mips;
+		mips.emplace_back(pixels, pixels + static_cast<size_t>(width) * height * 4);
+
+		while (width > 1 || height > 1)
+		{
+			const std::vector<uint8_t>& source = mips.back();
+			uint32_t mipWidth = std::max(width / 2, 1u);
+			uint32_t mipHeight = std::max(height / 2, 1u);
+			std::vector<uint8_t> mip(static_cast<size_t>(mipWidth) * mipHeight * 4);
+
+			for (uint32_t y = 0; y < mipHeight; y++)
+			{
+				for (uint32_t x = 0; x < mipWidth; x++)
+				{
+					// Odd sizes clamp to the last row or column
+					uint32_t x0 = std::min(2 * x, width - 1), x1 = std::min(2 * x + 1, width - 1);
+					uint32_t y0 = std::min(2 * y, height - 1), y1 = std::min(2 * y + 1, height - 1);
+					const uint8_t* texels[4] = {
+						&source[4 * (static_cast<size_t>(y0) * width + x0)], &source[4 * (static_cast<size_t>(y0) * width + x1)],
+						&source[4 * (static_cast<size_t>(y1) * width + x0)], &source[4 * (static_cast<size_t>(y1) * width + x1)]
+					};
+
+					uint8_t* destination = &mip[4 * (static_cast<size_t>(y) * mipWidth + x)];
+					for (uint32_t c = 0; c < 4; c++)
+					{
+						if (srgb && c < 3)
+						{
+							float sum = 0.0f;
+							for (const uint8_t* texel : texels)
+								sum += SrgbToLinear(texel[c]);
+							destination[c] = LinearToSrgb(0.25f * sum);
+						}
+						else
+							destination[c] = static_cast<uint8_t>((texels[0][c] + texels[1][c] + texels[2][c] + texels[3][c] + 2) / 4);
+					}
+				}
+			}
+
+			mips.push_back(std::move(mip));
+			width = mipWidth;
+			height = mipHeight;
+		}
+
+		return mips;
+	}
+
+	uint32_t GetBlockSize(VkFormat format)
+	{
+		switch (format)
+		{
+		case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+			return 8;
+		case VK_FORMAT_BC5_UNORM_BLOCK:
+		case VK_FORMAT_BC7_UNORM_BLOCK:
+		case VK_FORMAT_BC7_SRGB_BLOCK:
+			return 16;
+		default:
+			return 0;
+		}
+	}
+
+	size_t GetImageSize(VkFormat format, uint32_t width, uint32_t height)
+	{
+		uint32_t blockSize = GetBlockSize(format);
+		if (blockSize == 0)
+			return static_cast<size_t>(width) * height * 4;
+
+		return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * blockSize;
+	}
+
+	// 4x4 texels starting at ('x', 'y'), texels outside the image repeat the last row or column
+	static void LoadBlock(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t x, uint32_t y, uint8_t block[16][4])
+	{
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			uint32_t texelX = std::min(x + i % 4, width - 1);
+			uint32_t texelY = std::min(y + i / 4, height - 1);
+			memcpy(block[i], &pixels[4 * (static_cast<size_t>(texelY) * width + texelX)], 4);
+		}
+	}
+
+	// Endpoints of the line through the block's first 'N' channels along their principal axis, spanning every texel
+	template<uint32_t N>
+	static void FitLine(const uint8_t block[16][4], float endpoint0[4], float endpoint1[4])
+	{
+		float mean[N] = {};
+		for (uint32_t i = 0; i < 16; i++)
+			for (uint32_t c = 0; c < N; c++)
+				mean[c] += block[i][c] / 16.0f;
+
+		float covariance[N][N] = {};
+		for (uint32_t i = 0; i < 16; i++)
+			for (uint32_t a = 0; a < N; a++)
+				for (uint32_t b = 0; b < N; b++)
+					covariance[a][b] += (block[i][a] - mean[a]) * (block[i][b] - mean[b]);
+
+		// Power iteration, a block of a single colour keeps a zero axis
+		float axis[N];
+		std::fill(axis, axis + N, 1.0f);
+		for (uint32_t iteration = 0; iteration < 8; iteration++)
+		{
+			float next[N] = {};
+			float length = 0.0f;
+			for (uint32_t a = 0; a < N; a++)
+			{
+				for (uint32_t b = 0; b < N; b++)
+					next[a] += covariance[a][b] * axis[b];
+				length += next[a] * next[a];
+			}
+
+			length = std::sqrt(length);
+			for (uint32_t c = 0; c < N; c++)
+				axis[c] = length > 1e-6f ? next[c] / length : 0.0f;
+		}
+
+		float minT = FLT_MAX, maxT = -FLT_MAX;
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			float t = 0.0f;
+			for (uint32_t c = 0; c < N; c++)
+				t += (block[i][c] - mean[c]) * axis[c];
+			minT = std::min(minT, t);
+			maxT = std::max(maxT, t);
+		}
+
+		for (uint32_t c = 0; c < 4; c++)
+		{
+			endpoint0[c] = c < N ? std::clamp(mean[c] + axis[c] * minT, 0.0f, 255.0f) : 255.0f;
+			endpoint1[c] = c < N ? std::clamp(mean[c] + axis[c] * maxT, 0.0f, 255.0f) : 255.0f;
+		}
+	}
+
+	template<uint32_t N>
+	static uint32_t NearestColor(const uint8_t texel[4], const int (*palette)[4], uint32_t paletteSize)
+	{
+		uint32_t best = 0;
+		int bestError = INT32_MAX;
+		for (uint32_t i = 0; i < paletteSize; i++)
+		{
+			int error = 0;
+			for (uint32_t c = 0; c < N; c++)
+				error += (texel[c] - palette[i][c]) * (texel[c] - palette[i][c]);
+			if (error < bestError)
+			{
+				best = i;
+				bestError = error;
+			}
+		}
+
+		return best;
+	}
+
+	static uint16_t PackRgb565(const float color[4])
+	{
+		uint32_t r = static_cast<uint32_t>(std::lround(color[0] * 31.0f / 255.0f));
+		uint32_t g = static_cast<uint32_t>(std::lround(color[1] * 63.0f / 255.0f));
+		uint32_t b = static_cast<uint32_t>(std::lround(color[2] * 31.0f / 255.0f));
+		return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+	}
+
+	static void UnpackRgb565(uint16_t packed, int color[4])
+	{
+		int r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+		color[0] = (r << 3) | (r >> 2);
+		color[1] = (g << 2) | (g >> 4);
+		color[2] = (b << 3) | (b >> 2);
+		color[3] = 255;
+	}
+
+	// Opaque four colour mode, which requires the first endpoint to be the larger one
+	static void EncodeBC1Block(const uint8_t block[16][4], uint8_t* output)
+	{
+		float endpoint0[4], endpoint1[4];
+		FitLine<3>(block, endpoint0, endpoint1);
+		uint16_t color0 = PackRgb565(endpoint1);
+		uint16_t color1 = PackRgb565(endpoint0);
+		if (color0 < color1)
+			std::swap(color0, color1);
+
+		uint32_t indices = 0;
+		if (color0 != color1)
+		{
+			int palette[4][4];
+			UnpackRgb565(color0, palette[0]);
+			UnpackRgb565(color1, palette[1]);
+			for (uint32_t c = 0; c < 4; c++)
+			{
+				palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+			}
+
+			for (uint32_t i = 0; i < 16; i++)
+				indices |= NearestColor<3>(block[i], palette, 4) << (2 * i);
+		}
+
+		output[0] = static_cast<uint8_t>(color0);
+		output[1] = static_cast<uint8_t>(color0 >> 8);
+		output[2] = static_cast<uint8_t>(color1);
+		output[3] = static_cast<uint8_t>(color1 >> 8);
+		for (uint32_t i = 0; i < 4; i++)
+			output[4 + i] = static_cast<uint8_t>(indices >> (8 * i));
+	}
+
+	// Eight value mode of one channel, the 6 interpolated values lie between the block's minimum and maximum
+	static void EncodeBC4Block(const uint8_t block[16][4], uint32_t channel, uint8_t* output)
+	{
+		uint8_t minValue = 255, maxValue = 0;
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			minValue = std::min(minValue, block[i][channel]);
+			maxValue = std::max(maxValue, block[i][channel]);
+		}
+
+		uint64_t indices = 0;
+		if (minValue != maxValue)
+		{
+			int palette[8];
+			palette[0] = maxValue;
+			palette[1] = minValue;
+			for (int i = 2; i < 8; i++)
+				palette[i] = ((8 - i) * maxValue + (i - 1) * minValue + 3) / 7;
+
+			for (uint32_t i = 0; i < 16; i++)
+			{
+				uint64_t best = 0;
+				int bestError = INT32_MAX;
+				for (uint32_t j = 0; j < 8; j++)
+				{
+					int error = std::abs(block[i][channel] - palette[j]);
+					if (error < bestError)
+					{
+						best = j;
+						bestError = error;
+					}
+				}
+				indices |= best << (3 * i);
+			}
+		}
+
+		output[0] = maxValue;
+		output[1] = minValue;
+		for (uint32_t i = 0; i < 6; i++)
+			output[2 + i] = static_cast<uint8_t>(indices >> (8 * i));
+	}
+
+	static void EncodeBC5Block(const uint8_t block[16][4], uint8_t* output)
+	{
+		EncodeBC4Block(block, 0, output);
+		EncodeBC4Block(block, 1, output + 8);
+	}
+
+	// Writes 'count' bits of 'value' at 'offset', least significant bit first. 'output' must be zeroed.
+	static void WriteBits(uint8_t* output, uint32_t& offset, uint32_t value, uint32_t count)
+	{
+		for (uint32_t i = 0; i < count; i++, offset++)
+		{
+			if ((value >> i) & 1)
+				output[offset / 8] |= static_cast<uint8_t>(1 << (offset % 8));
+		}
+	}
+
+	// Quantizes to 7 bits per channel plus the endpoint's p-bit, which is shared by all channels
+	static void QuantizeBC7Endpoint(const float endpoint[4], uint8_t quantized[4], uint32_t& pBit)
+	{
+		float bestError = FLT_MAX;
+		for (uint32_t p = 0; p < 2; p++)
+		{
+			uint8_t candidate[4];
+			float error = 0.0f;
+			for (uint32_t c = 0; c < 4; c++)
+			{
+				candidate[c] = static_cast<uint8_t>(std::clamp(std::lround((endpoint[c] - p) / 2.0f), 0l, 127l));
+				float difference = static_cast<float>((candidate[c] << 1) | p) - endpoint[c];
+				error += difference * difference;
+			}
+
+			if (error < bestError)
+			{
+				memcpy(quantized, candidate, 4);
+				pBit = p;
+				bestError = error;
+			}
+		}
+	}
+
+	constexpr int BC7_WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	// Picks the closest of the 16 interpolated colours for every texel, returns the total squared error
+	static int FindBC7Indices(const uint8_t block[16][4], const uint8_t quantized[2][4], const uint32_t pBits[2], uint32_t indices[16])
+	{
+		int palette[16][4];
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			for (uint32_t c = 0; c < 4; c++)
+			{
+				int e0 = (quantized[0][c] << 1) | pBits[0];
+				int e1 = (quantized[1][c] << 1) | pBits[1];
+				palette[i][c] = ((64 - BC7_WEIGHTS[i]) * e0 + BC7_WEIGHTS[i] * e1 + 32) >> 6;
+			}
+		}
+
+		int totalError = 0;
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			indices[i] = NearestColor<4>(block[i], palette, 16);
+			for (uint32_t c = 0; c < 4; c++)
+				totalError += (block[i][c] - palette[indices[i]][c]) * (block[i][c] - palette[indices[i]][c]);
+		}
+
+		return totalError;
+	}
+
+	// Mode 6: a single subset with 7-bit RGBA endpoints, a p-bit per endpoint and 4-bit indices
+	static void EncodeBC7Block(const uint8_t block[16][4], uint8_t* output)
+	{
+		float endpoint0[4], endpoint1[4];
+		FitLine<4>(block, endpoint0, endpoint1);
+
+		uint8_t quantized[2][4];
+		uint32_t pBits[2];
+		QuantizeBC7Endpoint(endpoint0, quantized[0], pBits[0]);
+		QuantizeBC7Endpoint(endpoint1, quantized[1], pBits[1]);
+
+		uint32_t indices[16];
+		int error = FindBC7Indices(block, quantized, pBits, indices);
+
+		// Least squares endpoints for the chosen indices, kept while they lower the error
+		for (uint32_t iteration = 0; iteration < 2 && error > 0; iteration++)
+		{
+			float a = 0.0f, b = 0.0f, c = 0.0f;
+			float sum0[4] = {}, sum1[4] = {};
+			for (uint32_t i = 0; i < 16; i++)
+			{
+				float w = BC7_WEIGHTS[indices[i]] / 64.0f;
+				a += (1.0f - w) * (1.0f - w);
+				b += (1.0f - w) * w;
+				c += w * w;
+				for (uint32_t channel = 0; channel < 4; channel++)
+				{
+					sum0[channel] += (1.0f - w) * block[i][channel];
+					sum1[channel] += w * block[i][channel];
+				}
+			}
+
+			float determinant = a * c - b * b;
+			if (std::abs(determinant) < 1e-6f)
+				break;
+
+			for (uint32_t channel = 0; channel < 4; channel++)
+			{
+				endpoint0[channel] = std::clamp((c * sum0[channel] - b * sum1[channel]) / determinant, 0.0f, 255.0f);
+				endpoint1[channel] = std::clamp((a * sum1[channel] - b * sum0[channel]) / determinant, 0.0f, 255.0f);
+			}
+
+			uint8_t refined[2][4];
+			uint32_t refinedPBits[2];
+			uint32_t refinedIndices[16];
+			QuantizeBC7Endpoint(endpoint0, refined[0], refinedPBits[0]);
+			QuantizeBC7Endpoint(endpoint1, refined[1], refinedPBits[1]);
+			int refinedError = FindBC7Indices(block, refined, refinedPBits, refinedIndices);
+			if (refinedError >= error)
+				break;
+
+			memcpy(quantized, refined, sizeof(quantized));
+			memcpy(pBits, refinedPBits, sizeof(pBits));
+			memcpy(indices, refinedIndices, sizeof(indices));
+			error = refinedError;
+		}
+
+		// The first index is stored without its most significant bit, which therefore has to be 0
+		if (indices[0] & 8)
+		{
+			std::swap(quantized[0], quantized[1]);
+			std::swap(pBits[0], pBits[1]);
+			for (uint32_t& index : indices)
+				index = 15 - index;
+		}
+
+		memset(output, 0, 16);
+		uint32_t offset = 0;
+		WriteBits(output, offset, 1 << 6, 7);
+		for (uint32_t c = 0; c < 4; c++)
+		{
+			WriteBits(output, offset, quantized[0][c], 7);
+			WriteBits(output, offset, quantized[1][c], 7);
+		}
+		WriteBits(output, offset, pBits[0], 1);
+		WriteBits(output, offset, pBits[1], 1);
+		WriteBits(output, offset, indices[0], 3);
+		for (uint32_t i = 1; i < 16; i++)
+			WriteBits(output, offset, indices[i], 4);
+	}
+
+	std::vector<uint8_t> CompressImage(VkFormat format, const uint8_t* pixels, uint32_t width, uint32_t height, ThreadPool& threadPool)
+	{
+		const uint32_t blockSize = GetBlockSize(format);
+		SGE_ASSERTM(blockSize != 0, "Format is not block compressed.");
+
+		const uint32_t blocksX = (width + 3) / 4;
+		const uint32_t blocksY = (height + 3) / 4;
+		std::vector<uint8_t> output(static_cast<size_t>(blocksX) * blocksY * blockSize);
+
+		for (uint32_t blockY = 0; blockY < blocksY; blockY++)
+		{
+			threadPool.Submit([=, &output]()
+			{
+				uint8_t block[16][4];
+				for (uint32_t blockX = 0; blockX < blocksX; blockX++)
+				{
+					LoadBlock(pixels, width, height, 4 * blockX, 4 * blockY, block);
+					uint8_t* destination = &output[(static_cast<size_t>(blockY) * blocksX + blockX) * blockSize];
+
+					switch (format)
+					{
+					case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+					case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+						EncodeBC1Block(block, destination);
+						break;
+					case VK_FORMAT_BC5_UNORM_BLOCK:
+						EncodeBC5Block(block, destination);
+						break;
+					default:
+						EncodeBC7Block(block, destination);
+						break;
+					}
+				}
+			});
+		}
+		threadPool.Wait();
+
+		return output;
+	}
+} // namespace sge::vulkan
\ No newline at end of file
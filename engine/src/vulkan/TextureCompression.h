@@ -0,0 +1,26 @@
+#pragma once
+
+#include "ThreadPool.h"
+#include "base.h"
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+
+namespace sge::vulkan
+{
+	using MipChain = std::vector<std::vector<uint8_t>>;
+
+	// Box filtered RGBA8 mip chain down to 1x1, starting with a copy of 'pixels'. With 'srgb' the colour channels are
+	// averaged in linear space, alpha is always averaged as is.
+	MipChain GenerateMipChain(const uint8_t* pixels, uint32_t width, uint32_t height, bool srgb);
+
+	// Bytes per 4x4 block of a block compressed format, 0 for uncompressed formats
+	uint32_t GetBlockSize(VkFormat format);
+	// Bytes of one RGBA8 or block compressed image
+	size_t GetImageSize(VkFormat format, uint32_t width, uint32_t height);
+
+	// Encodes RGBA8 pixels to BC1 (RGB), BC5 (red and green) or BC7 (RGBA), in rows of blocks spread over 'threadPool'.
+	// The sRGB and UNORM variants of a format produce the same blocks, the format only changes how they are sampled.
+	std::vector<uint8_t> CompressImage(VkFormat format, const uint8_t* pixels, uint32_t width, uint32_t height, ThreadPool& threadPool);
+} // namespace sge::vulkan
\ No newline at end of file
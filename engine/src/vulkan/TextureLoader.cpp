@@ -0,0 +1,136 @@
+#include "TextureLoader.h"
+
+#include <iterator>
+
+namespace sge::vulkan
+{
+	constexpr uint32_t TEXTURE_DECODER_THREADS = 2;
+
+	TextureLoader::TextureLoader(VkDevice device, VkPhysicalDevice physicalDevice, MemoryAllocator* allocator, UploadContext* uploads,
+		TextureTable* textureTable)
+		: m_Allocator(allocator), m_Uploads(uploads), m_TextureTable(textureTable), m_Placeholder(nullptr), m_Decoder(nullptr), m_PendingCount(0)
+	{
+		// 1x1 mid grey
+		TextureData placeholderData;
+		placeholderData.Format = VK_FORMAT_R8G8B8A8_SRGB;
+		placeholderData.Width = 1;
+		placeholderData.Height = 1;
+		placeholderData.Mips = { { 128, 128, 128, 255 } };
+		m_Placeholder = new Texture(device, physicalDevice, allocator, *uploads, std::move(placeholderData));
+		m_TextureTable->SetPlaceholder(m_Placeholder);
+
+		m_Decoder = new ThreadPool(TEXTURE_DECODER_THREADS);
+	}
+
+	void TextureLoader::Destroy(VkDevice device)
+	{
+		// Finishes queued decodes before joining the threads, their results are dropped
+		delete m_Decoder;
+		m_Decoded.clear();
+		m_Batches.clear();
+
+		m_TextureTable->SetPlaceholder(nullptr);
+		m_Placeholder->Destroy(device);
+		delete m_Placeholder;
+
+#ifdef DEBUG
+		m_CleanedUp = true;
+#endif // DEBUG
+	}
+
+	Texture* TextureLoader::LoadAsync(VkDevice device, VkPhysicalDevice physicalDevice, const std::string& filepath, bool streamed,
+		const TextureLoadedFunc& onLoaded)
+	{
+		Texture* texture = new Texture(device, physicalDevice, m_Allocator);
+		m_PendingCount++;
+
+		m_Decoder->Submit([this, physicalDevice, texture, filepath, streamed, onLoaded]()
+		{
+			Request request = { texture, streamed, onLoaded, Texture::Decode(physicalDevice, filepath) };
+
+			std::lock_guard<std::mutex> lock(m_DecodedMutex);
+			m_Decoded.push_back(std::move(request));
+		});
+
+		return texture;
+	}
+
+	void TextureLoader::Update(VkDevice device)
+	{
+		for (auto it = m_Batches.begin(); it != m_Batches.end();)
+		{
+			if (!m_Uploads->IsComplete(device, it->Submission))
+			{
+				it++;
+				continue;
+			}
+
+			Complete(*it);
+			it = m_Batches.erase(it);
+		}
+
+		Record(device, false);
+	}
+
+	void TextureLoader::WaitIdle(VkDevice device)
+	{
+		if (m_PendingCount == 0)
+			return;
+
+		m_Decoder->Wait();
+		Record(device, true);
+
+		for (Batch& batch : m_Batches)
+		{
+			m_Uploads->Wait(device, batch.Submission);
+			Complete(batch);
+		}
+		m_Batches.clear();
+	}
+
+	void TextureLoader::Record(VkDevice device, bool ignoreBudget)
+	{
+		std::vector<Request> decoded;
+		{
+			std::lock_guard<std::mutex> lock(m_DecodedMutex);
+			decoded.swap(m_Decoded);
+		}
+
+		// The decoded data is no longer needed once it is in the staging ring, streamed textures keep their own copy
+		Batch batch = {};
+		size_t recorded = 0;
+		for (; recorded < decoded.size() && (ignoreBudget || m_Uploads->HasBudget()); recorded++)
+		{
+			Request& request = decoded[recorded];
+			request.Target->RecordLoad(device, *m_Uploads, std::move(request.Data), request.Streamed);
+			batch.Requests.push_back(std::move(request));
+		}
+
+		// The rest waits for the budget of a later frame
+		if (recorded < decoded.size())
+		{
+			std::lock_guard<std::mutex> lock(m_DecodedMutex);
+			m_Decoded.insert(m_Decoded.begin(), std::make_move_iterator(decoded.begin() + recorded),
+				std::make_move_iterator(decoded.end()));
+		}
+
+		if (batch.Requests.empty())
+			return;
+
+		SGE_TRACEF("Recorded %u texture uploads.", static_cast<uint32_t>(batch.Requests.size()));
+		batch.Submission = m_Uploads->GetPendingSubmission();
+		m_Batches.push_back(std::move(batch));
+	}
+
+	void TextureLoader::Complete(Batch& batch)
+	{
+		for (Request& request : batch.Requests)
+		{
+			request.Target->SetResident();
+			m_TextureTable->Refresh(request.Target);
+			if (request.OnLoaded)
+				request.OnLoaded(request.Target);
+			m_PendingCount--;
+		}
+	}
+} // namespace sge::vulkan
\ No newline at end of file
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "Texture.h"
+#include "TextureTable.h"
+#include "UploadContext.h"
+#include "ThreadPool.h"
+#include "base.h"
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+#include <string>
+#include <mutex>
+#include <functional>
+
+namespace sge::vulkan
+{
+	using TextureLoadedFunc = std::function<void(Texture*)>;
+
+	// Decodes textures on worker threads and records their uploads into the upload context from the main thread, as many
+	// per frame as the upload budget allows. Until a texture is resident its entry in the texture table shows a placeholder.
+	class TextureLoader
+	{
+	public:
+		TextureLoader(VkDevice device, VkPhysicalDevice physicalDevice, MemoryAllocator* allocator, UploadContext* uploads,
+			TextureTable* textureTable);
+#ifdef DEBUG
+		~TextureLoader()
+		{
+			SGE_ASSERTM(m_CleanedUp, "Texture loader was not cleaned up.");
+		}
+#endif // DEBUG
+		// Call when the device is idle
+		void Destroy(VkDevice device);
+
+		// Returns a texture that is not resident yet right away. 'onLoaded' is called from 'Update' once it is.
+		Texture* LoadAsync(VkDevice device, VkPhysicalDevice physicalDevice, const std::string& filepath, bool streamed,
+			const TextureLoadedFunc& onLoaded = {});
+		// Records the uploads of textures that finished decoding and completes the uploads that finished, called once per frame
+		void Update(VkDevice device);
+		// Blocks until every texture requested so far is resident
+		void WaitIdle(VkDevice device);
+	public:
+		inline uint32_t GetPendingCount() const { return m_PendingCount; }
+	private:
+		struct Request
+		{
+			Texture* Target;
+			bool Streamed;
+			TextureLoadedFunc OnLoaded;
+			TextureData Data;
+		};
+
+		// Requests whose uploads are part of the same submission of the upload context
+		struct Batch
+		{
+			uint64_t Submission;
+			std::vector<Request> Requests;
+		};
+
+		// Requests over the upload budget stay queued unless 'ignoreBudget' is set
+		void Record(VkDevice device, bool ignoreBudget);
+		void Complete(Batch& batch);
+	private:
+		MemoryAllocator* m_Allocator;
+		UploadContext* m_Uploads;
+		TextureTable* m_TextureTable;
+		Texture* m_Placeholder;
+		ThreadPool* m_Decoder;
+		// Requests that finished decoding and were not recorded yet, filled by the decoder threads
+		std::mutex m_DecodedMutex;
+		std::vector<Request> m_Decoded;
+		std::vector<Batch> m_Batches;
+		// Textures requested that are not resident yet
+		uint32_t m_PendingCount;
+#ifdef DEBUG
+		bool m_CleanedUp = false;
+#endif // DEBUG
+	};
+} // namespace sge::vulkan
\ No newline at end of file
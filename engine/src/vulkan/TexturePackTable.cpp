@@ -0,0 +1,120 @@
+#include "TexturePackTable.h"
+
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+
+namespace sge::vulkan
+{
+	void TexturePackTable::Destroy(VkDevice device)
+	{
+		for (Texture* image : m_Images)
+		{
+			image->Destroy(device);
+			delete image;
+		}
+		m_Images.clear();
+		m_Textures.clear();
+
+#ifdef DEBUG
+		m_CleanedUp = true;
+#endif // DEBUG
+	}
+
+	bool TexturePackTable::Load(VkDevice device, VkPhysicalDevice physicalDevice, TextureLoader& loader, TextureTable& textureTable,
+		const std::string& filepath)
+	{
+		std::ifstream file(filepath);
+		if (!file.is_open())
+		{
+			SGE_WARNF("Could not open texture pack '%s'.", filepath.c_str());
+			return false;
+		}
+
+		// The packer only writes block compressed arrays
+		VkPhysicalDeviceFeatures features;
+		vkGetPhysicalDeviceFeatures(physicalDevice, &features);
+		if (!features.textureCompressionBC)
+		{
+			SGE_WARNF("Device does not support BC textures, not using texture pack '%s'.", filepath.c_str());
+			return false;
+		}
+
+		// Array paths are relative to the manifest
+		const std::filesystem::path directory = std::filesystem::path(filepath).parent_path();
+		struct Entry
+		{
+			std::string SourcePath;
+			std::string ImagePath;
+			PackedTexture Texture;
+		};
+		std::vector<Entry> entries;
+		// Each array is loaded and registered once, its source images share the table entry
+		std::unordered_map<std::string, PackedTexture> images;
+
+		std::string line;
+		while (std::getline(file, line))
+		{
+			if (line.empty() || line[0] == '#')
+				continue;
+
+			std::istringstream fields(line);
+			Entry entry;
+			uint32_t format = 0;
+			std::getline(fields, entry.SourcePath, '\t');
+			std::getline(fields, entry.ImagePath, '\t');
+			fields >> format >> entry.Texture.Layer >> entry.Texture.Rect.x >> entry.Texture.Rect.y >> entry.Texture.Rect.z
+				>> entry.Texture.Rect.w;
+			if (fields.fail())
+			{
+				SGE_WARNF("Invalid line in texture pack '%s': '%s'.", filepath.c_str(), line.c_str());
+				continue;
+			}
+
+			entry.Texture.Format = static_cast<VkFormat>(format);
+			entry.ImagePath = (directory / entry.ImagePath).string();
+			images.try_emplace(entry.ImagePath);
+			entries.push_back(entry);
+		}
+
+		for (auto& [imagePath, image] : images)
+		{
+			image.Image = loader.LoadAsync(device, physicalDevice, imagePath, false);
+			image.TableIndex = textureTable.Register(device, image.Image);
+			m_Images.push_back(image.Image);
+		}
+
+		for (Entry& entry : entries)
+		{
+			const PackedTexture& image = images[entry.ImagePath];
+			entry.Texture.Image = image.Image;
+			entry.Texture.TableIndex = image.TableIndex;
+			m_Textures[NormalizeTexturePath(entry.SourcePath)] = entry.Texture;
+		}
+
+		SGE_INFOF("Loaded texture pack '%s': %u textures in %u images.", filepath.c_str(), static_cast<uint32_t>(entries.size()),
+			static_cast<uint32_t>(images.size()));
+		return true;
+	}
+
+	const PackedTexture* TexturePackTable::Find(const std::string& sourcePath) const
+	{
+		auto it = m_Textures.find(NormalizeTexturePath(sourcePath));
+		return it != m_Textures.end() ? &it->second : nullptr;
+	}
+
+	std::string FormatPackManifestLine(const std::string& sourcePath, const std::string& imagePath, VkFormat format, uint32_t layer,
+		const glm::vec4& rect)
+	{
+		std::ostringstream line;
+		line.precision(9);
+		line << NormalizeTexturePath(sourcePath) << '\t' << imagePath << '\t' << static_cast<uint32_t>(format) << '\t' << layer
+			<< '\t' << rect.x << '\t' << rect.y << '\t' << rect.z << '\t' << rect.w;
+		return line.str();
+	}
+
+	std::string NormalizeTexturePath(const std::string& path)
+	{
+		return std::filesystem::path(path).lexically_normal().generic_string();
+	}
+} // namespace sge::vulkan
\ No newline at end of file
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "Texture.h"
+#include "TextureTable.h"
+#include "TextureLoader.h"
+#include "base.h"
+
+#include <vulkan/vulkan.h>
+#include <glm/vec4.hpp>
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+namespace sge::vulkan
+{
+	// Where a source image ended up in a texture pack
+	struct PackedTexture
+	{
+		// Shared by every source image in the same array, owned by the pack table
+		Texture* Image = nullptr;
+		uint32_t TableIndex = INVALID_TEXTURE_INDEX;
+		VkFormat Format = VK_FORMAT_UNDEFINED;
+		uint32_t Layer = 0;
+		// Offset in xy and size in zw, in texture coordinates of the layer
+		glm::vec4 Rect = { 0.0f, 0.0f, 1.0f, 1.0f };
+	};
+
+	// Texture packs written by the texture packer: arrays with one layer per source image for images of the same size, and
+	// atlases whose layers hold many small images. A tab separated manifest maps each source image to its array, layer and
+	// rectangle. Materials look their textures up here before loading them on their own, so that the materials of a pack
+	// share one image and one texture table entry.
+	class TexturePackTable
+	{
+	public:
+		TexturePackTable() = default;
+#ifdef DEBUG
+		~TexturePackTable()
+		{
+			SGE_ASSERTM(m_CleanedUp, "Texture pack table was not cleaned up.");
+		}
+#endif // DEBUG
+		// Call when the device is idle, after the texture loader was destroyed
+		void Destroy(VkDevice device);
+
+		// Reads the manifest at 'filepath' and loads its arrays in the background. Returns false if the pack cannot be used,
+		// its source images are then loaded on their own.
+		bool Load(VkDevice device, VkPhysicalDevice physicalDevice, TextureLoader& loader, TextureTable& textureTable,
+			const std::string& filepath);
+		// Null if 'sourcePath' is not part of a loaded pack
+		const PackedTexture* Find(const std::string& sourcePath) const;
+	private:
+		std::vector<Texture*> m_Images;
+		// Normalized source path to its place in a pack
+		std::unordered_map<std::string, PackedTexture> m_Textures;
+#ifdef DEBUG
+		bool m_CleanedUp = false;
+#endif // DEBUG
+	};
+
+	// Manifest line of one source image, written by the texture packer
+	std::string FormatPackManifestLine(const std::string& sourcePath, const std::string& imagePath, VkFormat format, uint32_t layer,
+		const glm::vec4& rect);
+	// Same form of 'path' for the packer and the materials that look it up
+	std::string NormalizeTexturePath(const std::string& path);
+} // namespace sge::vulkan
\ No newline at end of file
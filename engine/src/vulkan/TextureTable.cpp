@@ -0,0 +1,163 @@
+#include "TextureTable.h"
+
+#include <algorithm>
+
+namespace sge::vulkan
+{
+	TextureTable::TextureTable(VkDevice device, VkPhysicalDevice physicalDevice, DescriptorAllocator* descriptorAllocator)
+		: m_Layout(nullptr), m_Capacity(MAX_BINDLESS_TEXTURES), m_Placeholder(nullptr)
+	{
+		// Clamp capacity to what the device allows for update-after-bind descriptors
+		VkPhysicalDeviceDescriptorIndexingProperties indexingProperties = {};
+		indexingProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+
+		VkPhysicalDeviceProperties2 properties = {};
+		properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		properties.pNext = &indexingProperties;
+		vkGetPhysicalDeviceProperties2(physicalDevice, &properties);
+
+		m_Capacity = std::min({ m_Capacity, indexingProperties.maxDescriptorSetUpdateAfterBindSampledImages,
+			indexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages,
+			indexingProperties.maxPerStageDescriptorUpdateAfterBindSamplers });
+		SGE_INFOF("Bindless texture table capacity: %u.", m_Capacity);
+
+		// Layout
+		VkDescriptorSetLayoutBinding binding = {};
+		binding.binding = 0;
+		binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		binding.descriptorCount = m_Capacity;
+		binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+		// Slots that have not been registered yet are never read, and new slots can be written while
+		// command buffers that use the set are still pending
+		VkDescriptorBindingFlags bindingFlags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT
+			| VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+
+		VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo = {};
+		bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+		bindingFlagsInfo.bindingCount = 1;
+		bindingFlagsInfo.pBindingFlags = &bindingFlags;
+
+		VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+		layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		layoutInfo.pNext = &bindingFlagsInfo;
+		layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+		layoutInfo.bindingCount = 1;
+		layoutInfo.pBindings = &binding;
+
+		if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &m_Layout) != VK_SUCCESS)
+			SGE_DEBUG_BREAKM("Failed to create Vulkan bindless descriptor set layout.");
+
+		// One set per frame in flight. The allocator's pools are created update-after-bind, see 'Instance'.
+		for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+			m_DescriptorSets[i] = descriptorAllocator->Allocate(device, m_Layout, { { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, m_Capacity } });
+	}
+
+	void TextureTable::Destroy(VkDevice device)
+	{
+		// The descriptor sets are freed with the allocator
+		vkDestroyDescriptorSetLayout(device, m_Layout, nullptr);
+
+#ifdef DEBUG
+		m_CleanedUp = true;
+#endif // DEBUG
+	}
+
+	uint32_t TextureTable::Register(VkDevice device, Texture* texture)
+	{
+		auto it = m_Indices.find(texture);
+		if (it != m_Indices.end())
+			return it->second;
+
+		SGE_ASSERTM(m_Textures.size() < m_Capacity, "Bindless texture table is full.");
+
+		uint32_t index = static_cast<uint32_t>(m_Textures.size());
+		m_Textures.push_back(texture);
+		m_Indices[texture] = index;
+
+		Texture* source = texture->IsResident() ? texture : m_Placeholder;
+		SGE_ASSERTM(source, "Texture is not resident and there is no placeholder.");
+
+		VkDescriptorImageInfo imageInfo = {};
+		imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		imageInfo.imageView = source->GetImageView();
+		imageInfo.sampler = source->GetSampler();
+
+		FrameGroup<VkWriteDescriptorSet> writes = {};
+		for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+		{
+			writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writes[i].dstSet = m_DescriptorSets[i];
+			writes[i].dstBinding = 0;
+			writes[i].dstArrayElement = index;
+			writes[i].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+			writes[i].descriptorCount = 1;
+			writes[i].pImageInfo = &imageInfo;
+		}
+
+		vkUpdateDescriptorSets(device, MAX_FRAMES_IN_FLIGHT, writes.data(), 0, nullptr);
+
+		return index;
+	}
+
+	void TextureTable::Refresh(Texture* texture)
+	{
+		auto it = m_Indices.find(texture);
+		if (it == m_Indices.end())
+			return;
+
+		for (std::vector<uint32_t>& dirtyIndices : m_DirtyIndices)
+		{
+			if (std::find(dirtyIndices.begin(), dirtyIndices.end(), it->second) == dirtyIndices.end())
+				dirtyIndices.push_back(it->second);
+		}
+	}
+
+	void TextureTable::Update(VkDevice device, uint32_t frameIndex)
+	{
+		std::vector<uint32_t>& dirtyIndices = m_DirtyIndices[frameIndex];
+		if (dirtyIndices.empty())
+			return;
+
+		std::vector<VkDescriptorImageInfo> imageInfos(dirtyIndices.size());
+		std::vector<VkWriteDescriptorSet> writes(dirtyIndices.size());
+		for (size_t i = 0; i < dirtyIndices.size(); i++)
+		{
+			Texture* texture = m_Textures[dirtyIndices[i]];
+			if (!texture->IsResident())
+				texture = m_Placeholder;
+			imageInfos[i] = {};
+			imageInfos[i].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			imageInfos[i].imageView = texture->GetImageView();
+			imageInfos[i].sampler = texture->GetSampler();
+
+			writes[i] = {};
+			writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writes[i].dstSet = m_DescriptorSets[frameIndex];
+			writes[i].dstBinding = 0;
+			writes[i].dstArrayElement = dirtyIndices[i];
+			writes[i].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+			writes[i].descriptorCount = 1;
+			writes[i].pImageInfo = &imageInfos[i];
+		}
+
+		vkUpdateDescriptorSets(device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+		dirtyIndices.clear();
+	}
+
+	bool SupportsBindlessTextures(VkPhysicalDevice physicalDevice)
+	{
+		VkPhysicalDeviceDescriptorIndexingFeatures indexingFeatures = {};
+		indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+
+		VkPhysicalDeviceFeatures2 features = {};
+		features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		features.pNext = &indexingFeatures;
+		vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+
+		return indexingFeatures.runtimeDescriptorArray && indexingFeatures.shaderSampledImageArrayNonUniformIndexing
+			&& indexingFeatures.descriptorBindingPartiallyBound
+			&& indexingFeatures.descriptorBindingSampledImageUpdateAfterBind
+			&& indexingFeatures.descriptorBindingUpdateUnusedWhilePending;
+	}
+} // namespace sge::vulkan
\ No newline at end of file
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Texture.h"
+#include "FrameGroup.h"
+#include "DescriptorAllocator.h"
+#include "base.h"
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+#include <unordered_map>
+
+namespace sge::vulkan
+{
+	constexpr uint32_t MAX_BINDLESS_TEXTURES = 4096;
+	constexpr uint32_t INVALID_TEXTURE_INDEX = UINT32_MAX;
+	constexpr uint32_t TEXTURE_TABLE_SET = DESCRIPTOR_SET_MATERIAL;
+
+	// Global array of combined image samplers (set 'TEXTURE_TABLE_SET', binding 0) shared by every pipeline.
+	// Textures are registered once and keep the same index for their whole lifetime. A texture whose image
+	// changes (e.g. when its resident mips are streamed) is refreshed, and each frame's set picks up the new
+	// image in 'Update', once that frame is no longer in flight. Textures that are still loading show the placeholder.
+	class TextureTable
+	{
+	public:
+		// The sets are allocated from 'descriptorAllocator', whose pools must be created update-after-bind
+		TextureTable(VkDevice device, VkPhysicalDevice physicalDevice, DescriptorAllocator* descriptorAllocator);
+		void Destroy(VkDevice device);
+#ifdef DEBUG
+		~TextureTable()
+		{
+			SGE_ASSERTM(m_CleanedUp, "Texture table was not cleaned up.");
+		}
+#endif // DEBUG
+		uint32_t Register(VkDevice device, Texture* texture);
+		// Does nothing for textures that are not registered
+		void Refresh(Texture* texture);
+		// Call after the fence of 'frameIndex' has been waited on
+		void Update(VkDevice device, uint32_t frameIndex);
+		// Shown in place of textures that are not resident yet
+		inline void SetPlaceholder(Texture* placeholder) { m_Placeholder = placeholder; }
+	public:
+		inline VkDescriptorSetLayout GetLayout() const { return m_Layout; }
+		inline VkDescriptorSet GetDescriptorSet(uint32_t frameIndex) const { return m_DescriptorSets[frameIndex]; }
+		inline uint32_t GetCapacity() const { return m_Capacity; }
+		inline uint32_t GetCount() const { return static_cast<uint32_t>(m_Textures.size()); }
+	private:
+		VkDescriptorSetLayout m_Layout;
+		FrameGroup<VkDescriptorSet> m_DescriptorSets;
+		uint32_t m_Capacity;
+		Texture* m_Placeholder;
+		std::vector<Texture*> m_Textures;
+		std::unordered_map<Texture*, uint32_t> m_Indices;
+		// Indices whose descriptor in that frame's set is out of date
+		FrameGroup<std::vector<uint32_t>> m_DirtyIndices;
+#ifdef DEBUG
+		bool m_CleanedUp = false;
+#endif // DEBUG
+	};
+
+	bool SupportsBindlessTextures(VkPhysicalDevice physicalDevice);
+} // namespace sge::vulkan
\ No newline at end of file
@@ -0,0 +1,325 @@
+#include "UploadContext.h"
+
+namespace sge::vulkan
+{
+	static uint64_t AlignUp(uint64_t value, uint64_t alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	static VkCommandPool CreateTransientCommandPool(VkDevice device, uint32_t queueFamily)
+	{
+		VkCommandPoolCreateInfo createInfo = {};
+		createInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		createInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+		createInfo.queueFamilyIndex = queueFamily;
+
+		VkCommandPool commandPool;
+		if (vkCreateCommandPool(device, &createInfo, nullptr, &commandPool) != VK_SUCCESS)
+			SGE_DEBUG_BREAKM("Failed to create Vulkan command pool for uploads.");
+
+		return commandPool;
+	}
+
+	static VkCommandBuffer BeginCommandBuffer(VkDevice device, VkCommandPool commandPool)
+	{
+		VkCommandBufferAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandPool = commandPool;
+		allocInfo.commandBufferCount = 1;
+
+		VkCommandBuffer commandBuffer;
+		if (vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer) != VK_SUCCESS)
+			SGE_DEBUG_BREAKM("Failed to allocate Vulkan command buffer for uploads.");
+
+		VkCommandBufferBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		vkBeginCommandBuffer(commandBuffer, &beginInfo);
+
+		return commandBuffer;
+	}
+
+	UploadContext::UploadContext(VkDevice device, MemoryAllocator* allocator, uint32_t transferFamily, VkQueue transferQueue,
+		uint32_t graphicsFamily, VkQueue graphicsQueue, VkDeviceSize ringSize, VkDeviceSize frameBudget)
+		: m_Allocator(allocator), m_TransferFamily(transferFamily), m_GraphicsFamily(graphicsFamily), m_TransferQueue(transferQueue), m_GraphicsQueue(graphicsQueue),
+		m_TransferCommandPool(nullptr), m_GraphicsCommandPool(nullptr), m_Ring(nullptr), m_RingSize(ringSize),
+		m_Head(0), m_Tail(0), m_CommandBuffer(nullptr), m_NextSubmission(1), m_CompletedSubmission(0), m_FrameBudget(frameBudget),
+		m_FrameBytes(0)
+	{
+		m_TransferCommandPool = CreateTransientCommandPool(device, transferFamily);
+		if (HasDedicatedQueue())
+			m_GraphicsCommandPool = CreateTransientCommandPool(device, graphicsFamily);
+
+		m_Ring = new Buffer(device, allocator, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, ringSize);
+	}
+
+	void UploadContext::Destroy(VkDevice device)
+	{
+		Flush(device);
+		for (Submission& submission : m_Submissions)
+		{
+			vkWaitForFences(device, 1, &submission.Fence, VK_TRUE, UINT64_MAX);
+			Release(device, submission);
+		}
+		m_Submissions.clear();
+
+		m_Ring->Destroy(device);
+		delete m_Ring;
+
+		vkDestroyCommandPool(device, m_TransferCommandPool, nullptr);
+		if (m_GraphicsCommandPool)
+			vkDestroyCommandPool(device, m_GraphicsCommandPool, nullptr);
+
+#ifdef DEBUG
+		m_CleanedUp = true;
+#endif // DEBUG
+	}
+
+	StagingAllocation UploadContext::Allocate(VkDevice device, VkDeviceSize size, VkDeviceSize alignment)
+	{
+		m_FrameBytes += size;
+
+		if (size > m_RingSize)
+		{
+			Buffer* buffer = new Buffer(device, m_Allocator, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, size);
+			m_DedicatedBuffers.push_back(buffer);
+			return { buffer->GetBufferHandle(), 0, buffer->GetData() };
+		}
+
+		// Allocations do not wrap around the end of the ring
+		uint64_t start = AlignUp(m_Head, alignment);
+		if (start % m_RingSize + size > m_RingSize)
+			start = AlignUp(start, m_RingSize);
+
+		while (start + size - m_Tail > m_RingSize)
+		{
+			// The space is held by work that has not been submitted yet, or by the oldest submission
+			if (m_Submissions.empty())
+			{
+				if (m_CommandBuffer)
+					Flush(device);
+				else
+				{
+					// Everything is free, start over at the beginning of the ring
+					m_Head = AlignUp(m_Head, m_RingSize);
+					m_Tail = m_Head;
+					start = m_Head;
+					continue;
+				}
+			}
+
+			vkWaitForFences(device, 1, &m_Submissions.front().Fence, VK_TRUE, UINT64_MAX);
+			Retire(device);
+		}
+
+		m_Head = start + size;
+		VkDeviceSize offset = start % m_RingSize;
+		return { m_Ring->GetBufferHandle(), offset, m_Ring->GetData() + offset };
+	}
+
+	VkCommandBuffer UploadContext::GetCommandBuffer(VkDevice device)
+	{
+		if (!m_CommandBuffer)
+			m_CommandBuffer = BeginCommandBuffer(device, m_TransferCommandPool);
+
+		return m_CommandBuffer;
+	}
+
+	void UploadContext::CopyBuffer(VkDevice device, VkBuffer destination, const void* data, VkDeviceSize size, VkDeviceSize destinationOffset)
+	{
+		StagingAllocation staging = Allocate(device, size, 4);
+		memcpy(staging.Data, data, size);
+
+		VkBufferCopy bufferCopy = {};
+		bufferCopy.srcOffset = staging.Offset;
+		bufferCopy.dstOffset = destinationOffset;
+		bufferCopy.size = size;
+		vkCmdCopyBuffer(GetCommandBuffer(device), staging.Buffer, destination, 1, &bufferCopy);
+
+		ReleaseBuffer(device, destination);
+	}
+
+	void UploadContext::ReleaseBuffer(VkDevice device, VkBuffer buffer)
+	{
+		// On a single queue the barrier at the end of the submission is enough
+		if (!HasDedicatedQueue())
+			return;
+
+		VkBufferMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = 0;
+		barrier.srcQueueFamilyIndex = m_TransferFamily;
+		barrier.dstQueueFamilyIndex = m_GraphicsFamily;
+		barrier.buffer = buffer;
+		barrier.offset = 0;
+		barrier.size = VK_WHOLE_SIZE;
+		vkCmdPipelineBarrier(GetCommandBuffer(device), VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr,
+			1, &barrier, 0, nullptr);
+
+		// The acquire repeats the release, the semaphore wait covers the copies
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+		m_BufferAcquires.push_back(barrier);
+	}
+
+	void UploadContext::ReleaseImage(VkDevice device, VkImage image, const VkImageSubresourceRange& subresourceRange)
+	{
+		VkImageMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.image = image;
+		barrier.subresourceRange = subresourceRange;
+
+		if (!HasDedicatedQueue())
+		{
+			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			vkCmdPipelineBarrier(GetCommandBuffer(device), VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr,
+				0, nullptr, 1, &barrier);
+			return;
+		}
+
+		barrier.dstAccessMask = 0;
+		barrier.srcQueueFamilyIndex = m_TransferFamily;
+		barrier.dstQueueFamilyIndex = m_GraphicsFamily;
+		vkCmdPipelineBarrier(GetCommandBuffer(device), VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr,
+			0, nullptr, 1, &barrier);
+
+		// The layout transition happens once, between the release and the acquire
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		m_ImageAcquires.push_back(barrier);
+	}
+
+	void UploadContext::Flush(VkDevice device)
+	{
+		Retire(device);
+		if (!m_CommandBuffer)
+			return;
+
+		Submission submission = {};
+		submission.ID = m_NextSubmission++;
+		submission.CommandBuffer = m_CommandBuffer;
+		submission.RingEnd = m_Head;
+		submission.DedicatedBuffers.swap(m_DedicatedBuffers);
+		m_CommandBuffer = nullptr;
+
+		// The last command buffer on the graphics queue makes the writes visible to the later submissions on it, i.e. the
+		// frames that use the uploaded resources. With a dedicated queue that is done by the acquires.
+		VkCommandBuffer graphicsCommandBuffer = submission.CommandBuffer;
+		if (HasDedicatedQueue())
+		{
+			vkEndCommandBuffer(submission.CommandBuffer);
+
+			VkSemaphoreCreateInfo semaphoreInfo = {};
+			semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+			if (vkCreateSemaphore(device, &semaphoreInfo, nullptr, &submission.Semaphore) != VK_SUCCESS)
+				SGE_DEBUG_BREAKM("Failed to create Vulkan semaphore for uploads.");
+
+			VkSubmitInfo submitInfo = {};
+			submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+			submitInfo.commandBufferCount = 1;
+			submitInfo.pCommandBuffers = &submission.CommandBuffer;
+			submitInfo.signalSemaphoreCount = 1;
+			submitInfo.pSignalSemaphores = &submission.Semaphore;
+
+			if (vkQueueSubmit(m_TransferQueue, 1, &submitInfo, nullptr) != VK_SUCCESS)
+				SGE_DEBUG_BREAKM("Failed to submit uploads.");
+
+			submission.AcquireCommandBuffer = BeginCommandBuffer(device, m_GraphicsCommandPool);
+			vkCmdPipelineBarrier(submission.AcquireCommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr,
+				static_cast<uint32_t>(m_BufferAcquires.size()), m_BufferAcquires.data(),
+				static_cast<uint32_t>(m_ImageAcquires.size()), m_ImageAcquires.data());
+			m_BufferAcquires.clear();
+			m_ImageAcquires.clear();
+			graphicsCommandBuffer = submission.AcquireCommandBuffer;
+		}
+		else
+		{
+			VkMemoryBarrier barrier = {};
+			barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+			vkCmdPipelineBarrier(graphicsCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &barrier,
+				0, nullptr, 0, nullptr);
+		}
+		vkEndCommandBuffer(graphicsCommandBuffer);
+
+		VkFenceCreateInfo fenceInfo = {};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		if (vkCreateFence(device, &fenceInfo, nullptr, &submission.Fence) != VK_SUCCESS)
+			SGE_DEBUG_BREAKM("Failed to create Vulkan fence for uploads.");
+
+		VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+		VkSubmitInfo submitInfo = {};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &graphicsCommandBuffer;
+		if (submission.Semaphore)
+		{
+			submitInfo.waitSemaphoreCount = 1;
+			submitInfo.pWaitSemaphores = &submission.Semaphore;
+			submitInfo.pWaitDstStageMask = &waitStage;
+		}
+
+		if (vkQueueSubmit(m_GraphicsQueue, 1, &submitInfo, submission.Fence) != VK_SUCCESS)
+			SGE_DEBUG_BREAKM("Failed to submit uploads.");
+
+		m_Submissions.push_back(std::move(submission));
+	}
+
+	bool UploadContext::IsComplete(VkDevice device, uint64_t submission)
+	{
+		// Nothing was recorded for it
+		if (submission == m_NextSubmission && !m_CommandBuffer)
+			return true;
+
+		Retire(device);
+		return submission <= m_CompletedSubmission;
+	}
+
+	void UploadContext::Wait(VkDevice device, uint64_t submission)
+	{
+		if (submission == m_NextSubmission)
+			Flush(device);
+
+		while (!m_Submissions.empty() && m_CompletedSubmission < submission)
+		{
+			vkWaitForFences(device, 1, &m_Submissions.front().Fence, VK_TRUE, UINT64_MAX);
+			Retire(device);
+		}
+	}
+
+	void UploadContext::Retire(VkDevice device)
+	{
+		while (!m_Submissions.empty() && vkGetFenceStatus(device, m_Submissions.front().Fence) == VK_SUCCESS)
+		{
+			Submission& submission = m_Submissions.front();
+			m_Tail = submission.RingEnd;
+			m_CompletedSubmission = submission.ID;
+			Release(device, submission);
+			m_Submissions.pop_front();
+		}
+	}
+
+	void UploadContext::Release(VkDevice device, Submission& submission)
+	{
+		for (Buffer* buffer : submission.DedicatedBuffers)
+		{
+			buffer->Destroy(device);
+			delete buffer;
+		}
+		vkFreeCommandBuffers(device, m_TransferCommandPool, 1, &submission.CommandBuffer);
+		if (submission.AcquireCommandBuffer)
+			vkFreeCommandBuffers(device, m_GraphicsCommandPool, 1, &submission.AcquireCommandBuffer);
+		if (submission.Semaphore)
+			vkDestroySemaphore(device, submission.Semaphore, nullptr);
+		vkDestroyFence(device, submission.Fence, nullptr);
+	}
+} // namespace sge::vulkan
\ No newline at end of file
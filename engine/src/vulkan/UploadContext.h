@@ -0,0 +1,115 @@
+#pragma once
+
+#include "Buffer.h"
+#include "base.h"
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+#include <deque>
+
+namespace sge::vulkan
+{
+	// Staging memory for one upload, 'Data' is mapped
+	struct StagingAllocation
+	{
+		VkBuffer Buffer;
+		VkDeviceSize Offset;
+		uint8_t* Data;
+	};
+
+	// Records uploads from a persistently mapped staging ring into one command buffer, which 'Flush' submits with a fence.
+	// Resources can be used by any graphics work submitted after the flush without waiting on the CPU: every submission
+	// ends with a barrier that makes its writes visible to all later work on the graphics queue.
+	// With a dedicated transfer queue the copies run on it, next to rendering. Their resources are released to the graphics
+	// family, and a second submission on the graphics queue waits for the copies with a semaphore and acquires them.
+	class UploadContext
+	{
+	public:
+		UploadContext(VkDevice device, MemoryAllocator* allocator, uint32_t transferFamily, VkQueue transferQueue,
+			uint32_t graphicsFamily, VkQueue graphicsQueue, VkDeviceSize ringSize, VkDeviceSize frameBudget);
+#ifdef DEBUG
+		~UploadContext()
+		{
+			SGE_ASSERTM(m_CleanedUp, "Upload context was not cleaned up.");
+		}
+#endif // DEBUG
+		// Call when the device is idle
+		void Destroy(VkDevice device);
+
+		// Reserves 'size' bytes of staging memory, flushing and waiting for earlier submissions while the ring is full.
+		// Uploads larger than the ring get a dedicated buffer that is freed with their submission.
+		StagingAllocation Allocate(VkDevice device, VkDeviceSize size, VkDeviceSize alignment = 16);
+		// Command buffer of the next submission, for copies from staging allocations and the barriers around them
+		VkCommandBuffer GetCommandBuffer(VkDevice device);
+		// Copies 'data' into 'destination' and releases it, see 'ReleaseBuffer'
+		void CopyBuffer(VkDevice device, VkBuffer destination, const void* data, VkDeviceSize size, VkDeviceSize destinationOffset = 0);
+		// Hands a buffer written by the recorded copies to the graphics queue, call once all of them are recorded
+		void ReleaseBuffer(VkDevice device, VkBuffer buffer);
+		// Hands an image written by the recorded copies to the graphics queue and transitions it from
+		// 'VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL' to 'VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL'
+		void ReleaseImage(VkDevice device, VkImage image, const VkImageSubresourceRange& subresourceRange);
+
+		void Flush(VkDevice device);
+		// Submissions are numbered in order, work recorded now is part of 'GetPendingSubmission'
+		bool IsComplete(VkDevice device, uint64_t submission);
+		// Flushes first if 'submission' is still being recorded
+		void Wait(VkDevice device, uint64_t submission);
+
+		// Starts counting the bytes uploaded against the per-frame budget
+		inline void BeginFrame() { m_FrameBytes = 0; }
+	public:
+		inline uint64_t GetPendingSubmission() const { return m_NextSubmission; }
+		// Work that can wait for a later frame should only be recorded while this is true
+		inline bool HasBudget() const { return m_FrameBytes < m_FrameBudget; }
+		inline VkDeviceSize GetFrameBytes() const { return m_FrameBytes; }
+		inline bool HasDedicatedQueue() const { return m_TransferFamily != m_GraphicsFamily; }
+	private:
+		struct Submission
+		{
+			uint64_t ID;
+			VkCommandBuffer CommandBuffer;
+			// Only with a dedicated transfer queue
+			VkCommandBuffer AcquireCommandBuffer;
+			VkSemaphore Semaphore;
+			// Signaled by the last submission on the graphics queue
+			VkFence Fence;
+			// Ring position after the submission's last allocation
+			uint64_t RingEnd;
+			std::vector<Buffer*> DedicatedBuffers;
+		};
+
+		// Frees the resources of finished submissions, oldest first
+		void Retire(VkDevice device);
+		void Release(VkDevice device, Submission& submission);
+	private:
+		MemoryAllocator* m_Allocator;
+		uint32_t m_TransferFamily;
+		uint32_t m_GraphicsFamily;
+		VkQueue m_TransferQueue;
+		VkQueue m_GraphicsQueue;
+		VkCommandPool m_TransferCommandPool;
+		// Null without a dedicated transfer queue
+		VkCommandPool m_GraphicsCommandPool;
+		Buffer* m_Ring;
+		VkDeviceSize m_RingSize;
+		// Total bytes allocated from and released to the ring, the ring offset is the position modulo its size
+		uint64_t m_Head;
+		uint64_t m_Tail;
+
+		VkCommandBuffer m_CommandBuffer;
+		std::vector<Buffer*> m_DedicatedBuffers;
+		// Acquire halves of the ownership transfers recorded into 'm_CommandBuffer'
+		std::vector<VkBufferMemoryBarrier> m_BufferAcquires;
+		std::vector<VkImageMemoryBarrier> m_ImageAcquires;
+		std::deque<Submission> m_Submissions;
+		uint64_t m_NextSubmission;
+		uint64_t m_CompletedSubmission;
+
+		VkDeviceSize m_FrameBudget;
+		VkDeviceSize m_FrameBytes;
+#ifdef DEBUG
+		bool m_CleanedUp = false;
+#endif // DEBUG
+	};
+} // namespace sge::vulkan
\ No newline at end of file
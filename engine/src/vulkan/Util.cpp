@@ -7,11 +7,16 @@
 
 namespace sge::vulkan
 {
-	std::vector<const char*> GetRequiredExtensions()
+	std::vector<const char*> GetRequiredExtensions(bool headless)
 	{
-		uint32_t glfwExtensionCount = 0;
-		const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-		std::vector<const char*> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+		std::vector<const char*> extensions;
+		// Without a window there is no surface, so the windowing extensions are not needed
+		if (!headless)
+		{
+			uint32_t glfwExtensionCount = 0;
+			const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+			extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+		}
 #ifdef SGE_USING_VALIDATION_LAYERS
 		extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
 #endif // SGE_USING_VALIDATION_LAYERS
@@ -124,6 +129,19 @@ namespace sge::vulkan
 		return binary;
 	}
 
+	uint64_t HashBytes(const void* data, size_t size, uint64_t seed)
+	{
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		uint64_t hash = seed;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+
+		return hash;
+	}
+
 	QueueFamilyIndices FindQueueFamilies(VkPhysicalDevice device, VkSurfaceKHR surface)
 	{
 		constexpr VkQueueFlags desiredFlags = VK_QUEUE_GRAPHICS_BIT;
@@ -140,12 +158,24 @@ namespace sge::vulkan
 			if (!indices.GraphicsFamily.has_value() && queueFamily.queueFlags & desiredFlags)
 				indices.GraphicsFamily = i;
 
-			VkBool32 presentSupport = VK_FALSE;
-			vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
+			// Headless instances never present, so any family will do
+			VkBool32 presentSupport = VK_TRUE;
+			if (surface)
+				vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
 
 			if (!indices.PresentFamily.has_value() && presentSupport)
 				indices.PresentFamily = i;
 
+			// Transfer only families are usually the copy engines, every other family supports transfers as well
+			constexpr VkQueueFlags transferExcluded = VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT;
+			if (!indices.TransferFamily.has_value() && queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT
+				&& !(queueFamily.queueFlags & transferExcluded))
+				indices.TransferFamily = i;
+
+			if (!indices.ComputeFamily.has_value() && queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT
+				&& !(queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT))
+				indices.ComputeFamily = i;
+
 			i++;
 		}
 
@@ -159,8 +189,8 @@ namespace sge::vulkan
 		QueueFamilyIndices indices = FindQueueFamilies(device, surface);
 
 		bool extensionSupport = CheckDeviceExtensionSupport(device, requiredExtensions);
-		bool isSwapchainSuitable = false;
-		if (extensionSupport)
+		bool isSwapchainSuitable = !surface;
+		if (extensionSupport && surface)
 		{
 			SwapchainSupportDetails details = QuerySwapchainSupport(device, surface);
 			isSwapchainSuitable = !details.Formats.empty() && !details.PresentModes.empty();
@@ -169,7 +199,8 @@ namespace sge::vulkan
 		VkPhysicalDeviceFeatures features;
 		vkGetPhysicalDeviceFeatures(device, &features);
 
-		if (indices.IsComplete() && isSwapchainSuitable && features.samplerAnisotropy)
+		// Indirect draws pass the object index as first instance
+		if (indices.IsComplete() && isSwapchainSuitable && features.samplerAnisotropy && features.drawIndirectFirstInstance)
 		{
 			queueFamilyIndices = indices;
 			return true;
@@ -201,8 +232,9 @@ namespace sge::vulkan
 		return details;
 	}
 
-	void CreateImage(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling,
-		VkImageUsageFlags usageFlags, VkMemoryPropertyFlags memoryPropertyFlags, VkImage* image, VkDeviceMemory* deviceMemory)
+	void CreateImage(VkDevice device, MemoryAllocator* allocator, uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling,
+		VkImageUsageFlags usageFlags, MemoryUsage memoryUsage, MemoryCategory category, VkImage* image, Allocation* allocation, uint32_t mipLevels,
+		uint32_t arrayLayers)
 	{
 		VkImageCreateInfo imageInfo = {};
 		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -212,8 +244,8 @@ namespace sge::vulkan
 		imageInfo.extent.height = height;
 		imageInfo.extent.depth = 1;
 
-		imageInfo.mipLevels = 1;
-		imageInfo.arrayLayers = 1;
+		imageInfo.mipLevels = mipLevels;
+		imageInfo.arrayLayers = arrayLayers;
 		imageInfo.format = format;
 		imageInfo.tiling = tiling;
 		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
@@ -227,28 +259,23 @@ namespace sge::vulkan
 		VkMemoryRequirements memoryRequirements;
 		vkGetImageMemoryRequirements(device, *image, &memoryRequirements);
 
-		VkMemoryAllocateInfo allocInfo = {};
-		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocInfo.allocationSize = memoryRequirements.size;
-		allocInfo.memoryTypeIndex = FindMemoryType(physicalDevice, memoryRequirements.memoryTypeBits, memoryPropertyFlags);
-
-		if (vkAllocateMemory(device, &allocInfo, nullptr, deviceMemory) != VK_SUCCESS)
-			SGE_DEBUG_BREAKM("Failed to allocate Vulkan memory.");
-
-		vkBindImageMemory(device, *image, *deviceMemory, 0);
+		*allocation = allocator->Allocate(device, memoryRequirements, memoryUsage, category, tiling == VK_IMAGE_TILING_LINEAR);
+		vkBindImageMemory(device, *image, allocation->Memory, allocation->Offset);
 	}
 
-	VkImageView CreateImageView(VkDevice device, VkImage image, VkFormat format, VkImageAspectFlags aspectFlags)
+	VkImageView CreateImageView(VkDevice device, VkImage image, VkFormat format, VkImageAspectFlags aspectFlags,
+		uint32_t baseMipLevel, uint32_t levelCount, VkImageViewType viewType, uint32_t layerCount)
 	{
 		VkImageViewCreateInfo viewInfo = {};
 		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
 		viewInfo.image = image;
-		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.viewType = viewType;
 		viewInfo.format = format;
 
 		viewInfo.subresourceRange.aspectMask = aspectFlags;
-		viewInfo.subresourceRange.levelCount = 1;
-		viewInfo.subresourceRange.layerCount = 1;
+		viewInfo.subresourceRange.baseMipLevel = baseMipLevel;
+		viewInfo.subresourceRange.levelCount = levelCount;
+		viewInfo.subresourceRange.layerCount = layerCount;
 
 		VkImageView imageView;
 		if (vkCreateImageView(device, &viewInfo, nullptr, &imageView) != VK_SUCCESS)
@@ -274,20 +301,6 @@ namespace sge::vulkan
 		EndOneTimeCommandBuffer(device, commandPool, commandBuffer, graphicsQueue);
 	}
 
-	uint32_t FindMemoryType(VkPhysicalDevice physicalDevice, uint32_t typeFilter, VkMemoryPropertyFlags flags)
-	{
-		VkPhysicalDeviceMemoryProperties properties;
-		vkGetPhysicalDeviceMemoryProperties(physicalDevice, &properties);
-
-		for (uint32_t i = 0; i < properties.memoryTypeCount; i++)
-		{
-			if ((typeFilter & (1 << i)) && (properties.memoryTypes[i].propertyFlags & flags) == flags)
-				return i;
-		}
-
-		SGE_DEBUG_BREAKM("Failed to find suitable memory type.");
-	}
-
 	VkFormat FindSupportedFormat(VkPhysicalDevice physicalDevice, const std::vector<VkFormat>& formats, VkImageTiling tiling, VkFormatFeatureFlags featureFlags)
 	{
 		for (VkFormat format : formats)
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "base.h"
+#include "MemoryAllocator.h"
 
 #include <glm/mat4x4.hpp>
 #include <vulkan/vulkan.h>
@@ -14,6 +15,9 @@ namespace sge::vulkan
 	{
 		std::optional<uint32_t> GraphicsFamily;
 		std::optional<uint32_t> PresentFamily;
+		// Families without graphics support, if the device has them. Their queues run next to the graphics queue.
+		std::optional<uint32_t> TransferFamily;
+		std::optional<uint32_t> ComputeFamily;
 
 		inline bool IsComplete()
 		{
@@ -28,7 +32,7 @@ namespace sge::vulkan
 		std::vector<VkPresentModeKHR> PresentModes;
 	};
 
-	std::vector<const char*> GetRequiredExtensions();
+	std::vector<const char*> GetRequiredExtensions(bool headless);
 
 #ifdef SGE_USING_VALIDATION_LAYERS
 	VKAPI_ATTR VkBool32 VKAPI_CALL VulkanDebugCallback(
@@ -49,13 +53,17 @@ namespace sge::vulkan
 	bool IsSuitablePhysicalDevice(VkPhysicalDevice device, VkSurfaceKHR surface,
 		const std::vector<const char*>& requiredExtensions, QueueFamilyIndices& queueFamilyIndices);
 	SwapchainSupportDetails QuerySwapchainSupport(VkPhysicalDevice device, VkSurfaceKHR surface);
-	void CreateImage(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling,
-		VkImageUsageFlags usageFlags, VkMemoryPropertyFlags memoryPropertyFlags, VkImage* image, VkDeviceMemory* deviceMemory);
-	VkImageView CreateImageView(VkDevice device, VkImage image, VkFormat format, VkImageAspectFlags aspectFlags);
+	void CreateImage(VkDevice device, MemoryAllocator* allocator, uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling,
+		VkImageUsageFlags usageFlags, MemoryUsage memoryUsage, MemoryCategory category, VkImage* image, Allocation* allocation, uint32_t mipLevels = 1,
+		uint32_t arrayLayers = 1);
+	VkImageView CreateImageView(VkDevice device, VkImage image, VkFormat format, VkImageAspectFlags aspectFlags,
+		uint32_t baseMipLevel = 0, uint32_t levelCount = 1, VkImageViewType viewType = VK_IMAGE_VIEW_TYPE_2D, uint32_t layerCount = 1);
 	void CopyBufferToImage(VkDevice device, VkCommandPool commandPool, VkQueue graphicsQueue, VkBuffer buffer, VkImage image, uint32_t width, uint32_t height);
 
 	std::vector<char> LoadShaderBinary(const std::string& filepath);
-	uint32_t FindMemoryType(VkPhysicalDevice physicalDevice, uint32_t typeFilter, VkMemoryPropertyFlags flags);
+	// 64-bit FNV-1a, pass the previous result as 'seed' to hash several blocks of data
+	constexpr uint64_t HASH_SEED = 14695981039346656037ull;
+	uint64_t HashBytes(const void* data, size_t size, uint64_t seed = HASH_SEED);
 	VkFormat FindSupportedFormat(VkPhysicalDevice physicalDevice, const std::vector<VkFormat>& formats, VkImageTiling tiling, VkFormatFeatureFlags featureFlags);
 	VkFormat FindDepthFormat(VkPhysicalDevice physicalDevice);
 	bool HasStencilComponent(VkFormat format);
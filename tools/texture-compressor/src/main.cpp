@@ -0,0 +1,85 @@
+#include "vulkan/TextureCompression.h"
+#include "vulkan/Ktx2.h"
+
+#include <stb_image/stb_image.h>
+
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <chrono>
+#include <filesystem>
+
+// Compresses an image to a KTX2 file with a full mip chain, which 'vulkan::Texture' loads instead of the image
+// when it is next to it.
+// Usage: texture-compressor [--bc1|--bc5|--bc7] [--threads <count>] <input> [<output>]
+//   --bc7 (default) sRGB colour with alpha, e.g. albedo textures
+//   --bc1           sRGB colour without alpha, half the size of BC7
+//   --bc5           two linear channels, for normal maps
+int main(int argc, char** argv)
+{
+	VkFormat format = VK_FORMAT_BC7_SRGB_BLOCK;
+	uint32_t threadCount = 0;
+	std::string inputPath;
+	std::string outputPath;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--bc1") == 0)
+			format = VK_FORMAT_BC1_RGB_SRGB_BLOCK;
+		else if (strcmp(argv[i], "--bc5") == 0)
+			format = VK_FORMAT_BC5_UNORM_BLOCK;
+		else if (strcmp(argv[i], "--bc7") == 0)
+			format = VK_FORMAT_BC7_SRGB_BLOCK;
+		else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+			threadCount = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		else if (inputPath.empty())
+			inputPath = argv[i];
+		else
+			outputPath = argv[i];
+	}
+
+	if (inputPath.empty())
+	{
+		SGE_ERROR("Usage: texture-compressor [--bc1|--bc5|--bc7] [--threads <count>] <input> [<output>]");
+		return EXIT_FAILURE;
+	}
+	if (outputPath.empty())
+		outputPath = std::filesystem::path(inputPath).replace_extension(".ktx2").string();
+
+	// Same orientation as the images 'vulkan::Texture' decodes
+	stbi_set_flip_vertically_on_load(1);
+	int width, height, channels;
+	uint8_t* pixels = stbi_load(inputPath.c_str(), &width, &height, &channels, 4);
+	if (!pixels)
+	{
+		SGE_ERRORF("Failed to load image '%s'.", inputPath.c_str());
+		return EXIT_FAILURE;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+
+	sge::vulkan::Ktx2Texture texture;
+	texture.Format = format;
+	texture.Width = static_cast<uint32_t>(width);
+	texture.Height = static_cast<uint32_t>(height);
+
+	// Normal maps are filtered as linear data
+	bool srgb = format != VK_FORMAT_BC5_UNORM_BLOCK;
+	sge::vulkan::MipChain mips = sge::vulkan::GenerateMipChain(pixels, texture.Width, texture.Height, srgb);
+	stbi_image_free(pixels);
+
+	sge::ThreadPool threadPool(threadCount);
+	for (uint32_t i = 0; i < mips.size(); i++)
+	{
+		uint32_t mipWidth = std::max(texture.Width >> i, 1u);
+		uint32_t mipHeight = std::max(texture.Height >> i, 1u);
+		texture.Levels.push_back(sge::vulkan::CompressImage(format, mips[i].data(), mipWidth, mipHeight, threadPool));
+	}
+
+	sge::vulkan::WriteKtx2(outputPath, texture);
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	SGE_INFOF("Compressed '%s' (%ux%u, %u mips) in %.2f s on %u threads.", inputPath.c_str(), texture.Width, texture.Height,
+		static_cast<uint32_t>(mips.size()), seconds, threadPool.GetThreadCount());
+
+	return EXIT_SUCCESS;
+}
\ No newline at end of file
@@ -0,0 +1,244 @@
+#include "vulkan/TextureCompression.h"
+#include "vulkan/TexturePackTable.h"
+#include "vulkan/Ktx2.h"
+
+#include <stb_image/stb_image.h>
+
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <fstream>
+#include <filesystem>
+#include <map>
+#include <utility>
+
+struct SourceImage
+{
+	std::string Path;
+	uint32_t Width;
+	uint32_t Height;
+	// Side of the square, power of two tile the image takes up in an atlas
+	uint32_t TileSize;
+	std::vector<uint8_t> Pixels;
+};
+
+static uint32_t NextPowerOfTwo(uint32_t value)
+{
+	uint32_t result = 1;
+	while (result < value)
+		result <<= 1;
+	return result;
+}
+
+static uint32_t Log2(uint32_t value)
+{
+	uint32_t result = 0;
+	while (value >>= 1)
+		result++;
+	return result;
+}
+
+// Inverse of interleaving the bits of x (even bits) and y (odd bits)
+static uint32_t CompactBits(uint64_t value)
+{
+	uint32_t result = 0;
+	for (uint32_t bit = 0; bit < 32; bit++)
+		result |= static_cast<uint32_t>((value >> (2 * bit)) & 1) << bit;
+	return result;
+}
+
+// Copies an RGBA8 image into a larger one at 'x', 'y'
+static void Blit(const uint8_t* source, uint32_t width, uint32_t height, uint8_t* destination, uint32_t destinationWidth,
+	uint32_t x, uint32_t y)
+{
+	for (uint32_t row = 0; row < height; row++)
+		memcpy(destination + 4 * ((y + row) * destinationWidth + x), source + 4 * row * width, 4 * width);
+}
+
+// Packs same sized images into the layers of texture arrays, and images up to 'maxTileSize' into the layers of an atlas, so that
+// materials using them share one image and one texture table entry. Writes block compressed KTX2 arrays next to the manifest,
+// which 'vulkan::Instance::LoadTexturePack' loads. Materials whose textures are in a loaded pack use it automatically.
+// Usage: texture-packer [--bc1|--bc5|--bc7] [--page <size>] [--max-tile <size>] [--threads <count>] <manifest> <inputs...>
+//   --bc1, --bc5, --bc7  format of every array, see texture-compressor. Pack albedo and normal maps separately.
+//   --page               side of the atlas layers, 1024 by default
+//   --max-tile           longest side of images that go into the atlas, 256 by default. Larger images are put into an array
+//                        with the other images of the same size, or left unpacked if there are none.
+int main(int argc, char** argv)
+{
+	VkFormat format = VK_FORMAT_BC7_SRGB_BLOCK;
+	uint32_t pageSize = 1024;
+	uint32_t maxTileSize = 256;
+	uint32_t threadCount = 0;
+	std::string manifestPath;
+	std::vector<std::string> inputPaths;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--bc1") == 0)
+			format = VK_FORMAT_BC1_RGB_SRGB_BLOCK;
+		else if (strcmp(argv[i], "--bc5") == 0)
+			format = VK_FORMAT_BC5_UNORM_BLOCK;
+		else if (strcmp(argv[i], "--bc7") == 0)
+			format = VK_FORMAT_BC7_SRGB_BLOCK;
+		else if (strcmp(argv[i], "--page") == 0 && i + 1 < argc)
+			pageSize = NextPowerOfTwo(static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10)));
+		else if (strcmp(argv[i], "--max-tile") == 0 && i + 1 < argc)
+			maxTileSize = NextPowerOfTwo(static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10)));
+		else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+			threadCount = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		else if (manifestPath.empty())
+			manifestPath = argv[i];
+		else
+			inputPaths.push_back(argv[i]);
+	}
+
+	if (manifestPath.empty() || inputPaths.empty())
+	{
+		SGE_ERROR("Usage: texture-packer [--bc1|--bc5|--bc7] [--page <size>] [--max-tile <size>] [--threads <count>] <manifest> <inputs...>");
+		return EXIT_FAILURE;
+	}
+	// Tiles are at least one block, and an atlas layer holds at least one tile
+	maxTileSize = std::clamp(maxTileSize, 4u, pageSize);
+
+	// Same orientation as the images 'vulkan::Texture' decodes
+	stbi_set_flip_vertically_on_load(1);
+	std::vector<SourceImage> atlasImages;
+	// Images too large for the atlas, by size
+	std::map<std::pair<uint32_t, uint32_t>, std::vector<SourceImage>> arrayImages;
+	for (const std::string& inputPath : inputPaths)
+	{
+		int width, height, channels;
+		uint8_t* pixels = stbi_load(inputPath.c_str(), &width, &height, &channels, 4);
+		if (!pixels)
+		{
+			SGE_ERRORF("Failed to load image '%s'.", inputPath.c_str());
+			return EXIT_FAILURE;
+		}
+
+		SourceImage image;
+		image.Path = inputPath;
+		image.Width = static_cast<uint32_t>(width);
+		image.Height = static_cast<uint32_t>(height);
+		image.TileSize = std::max(NextPowerOfTwo(std::max(image.Width, image.Height)), 4u);
+		image.Pixels.assign(pixels, pixels + 4 * static_cast<size_t>(width) * height);
+		stbi_image_free(pixels);
+
+		if (image.TileSize <= maxTileSize)
+			atlasImages.push_back(std::move(image));
+		else
+			arrayImages[{ image.Width, image.Height }].push_back(std::move(image));
+	}
+
+	// Normal maps are filtered as linear data
+	const bool srgb = format != VK_FORMAT_BC5_UNORM_BLOCK;
+	const std::filesystem::path directory = std::filesystem::path(manifestPath).parent_path();
+	const std::string name = std::filesystem::path(manifestPath).stem().string();
+	sge::ThreadPool threadPool(threadCount);
+	std::vector<std::string> manifest = { "# source\timage\tformat\tlayer\tx\ty\twidth\theight" };
+
+	// Same sized images, one layer each
+	for (const auto& [size, images] : arrayImages)
+	{
+		if (images.size() < 2)
+		{
+			SGE_INFOF("No other image is %ux%u, leaving '%s' unpacked.", size.first, size.second, images[0].Path.c_str());
+			continue;
+		}
+
+		sge::vulkan::Ktx2Texture array;
+		array.Format = format;
+		array.Width = size.first;
+		array.Height = size.second;
+		array.LayerCount = static_cast<uint32_t>(images.size());
+		const std::string imageName = name + "_" + std::to_string(size.first) + "x" + std::to_string(size.second) + ".ktx2";
+
+		for (uint32_t layer = 0; layer < array.LayerCount; layer++)
+		{
+			sge::vulkan::MipChain mips = sge::vulkan::GenerateMipChain(images[layer].Pixels.data(), array.Width, array.Height, srgb);
+			array.Levels.resize(mips.size());
+			for (uint32_t i = 0; i < mips.size(); i++)
+			{
+				std::vector<uint8_t> blocks = sge::vulkan::CompressImage(format, mips[i].data(), std::max(array.Width >> i, 1u),
+					std::max(array.Height >> i, 1u), threadPool);
+				array.Levels[i].insert(array.Levels[i].end(), blocks.begin(), blocks.end());
+			}
+
+			manifest.push_back(sge::vulkan::FormatPackManifestLine(images[layer].Path, imageName, format, layer, { 0.0f, 0.0f, 1.0f, 1.0f }));
+		}
+
+		sge::vulkan::WriteKtx2((directory / imageName).string(), array);
+	}
+
+	if (!atlasImages.empty())
+	{
+		// Largest first, every tile then starts at a multiple of its own area along the Z-order curve, which places it
+		// at a multiple of its size without gaps
+		std::stable_sort(atlasImages.begin(), atlasImages.end(), [](const SourceImage& a, const SourceImage& b)
+		{
+			return a.TileSize > b.TileSize;
+		});
+
+		// Each image's mips are generated on their own and stay inside the image's tile, down to the level at which the
+		// smallest tile is one block
+		const uint32_t levelCount = Log2(atlasImages.back().TileSize) - 1;
+		const std::string imageName = name + "_atlas.ktx2";
+		std::vector<sge::vulkan::MipChain> layers;
+		uint64_t cursor = static_cast<uint64_t>(pageSize) * pageSize;
+		for (const SourceImage& image : atlasImages)
+		{
+			const uint64_t area = static_cast<uint64_t>(image.TileSize) * image.TileSize;
+			if (cursor + area > static_cast<uint64_t>(pageSize) * pageSize)
+			{
+				sge::vulkan::MipChain& layer = layers.emplace_back(levelCount);
+				for (uint32_t i = 0; i < levelCount; i++)
+					layer[i].resize(4 * static_cast<size_t>(pageSize >> i) * (pageSize >> i));
+				cursor = 0;
+			}
+
+			const uint32_t x = CompactBits(cursor);
+			const uint32_t y = CompactBits(cursor >> 1);
+			cursor += area;
+
+			sge::vulkan::MipChain mips = sge::vulkan::GenerateMipChain(image.Pixels.data(), image.Width, image.Height, srgb);
+			for (uint32_t i = 0; i < levelCount && i < mips.size(); i++)
+			{
+				Blit(mips[i].data(), std::max(image.Width >> i, 1u), std::max(image.Height >> i, 1u), layers.back()[i].data(), pageSize >> i,
+					x >> i, y >> i);
+			}
+
+			const float scale = 1.0f / static_cast<float>(pageSize);
+			manifest.push_back(sge::vulkan::FormatPackManifestLine(image.Path, imageName, format, static_cast<uint32_t>(layers.size() - 1),
+				{ x * scale, y * scale, image.Width * scale, image.Height * scale }));
+		}
+
+		sge::vulkan::Ktx2Texture atlas;
+		atlas.Format = format;
+		atlas.Width = pageSize;
+		atlas.Height = pageSize;
+		atlas.LayerCount = static_cast<uint32_t>(layers.size());
+		atlas.Levels.resize(levelCount);
+		for (const sge::vulkan::MipChain& layer : layers)
+		{
+			for (uint32_t i = 0; i < levelCount; i++)
+			{
+				std::vector<uint8_t> blocks = sge::vulkan::CompressImage(format, layer[i].data(), pageSize >> i, pageSize >> i, threadPool);
+				atlas.Levels[i].insert(atlas.Levels[i].end(), blocks.begin(), blocks.end());
+			}
+		}
+
+		sge::vulkan::WriteKtx2((directory / imageName).string(), atlas);
+		SGE_INFOF("Packed %u images into %u atlas layers of %ux%u.", static_cast<uint32_t>(atlasImages.size()), atlas.LayerCount,
+			pageSize, pageSize);
+	}
+
+	std::ofstream file(manifestPath);
+	if (!file.is_open())
+	{
+		SGE_ERRORF("Could not open file '%s'.", manifestPath.c_str());
+		return EXIT_FAILURE;
+	}
+	for (const std::string& line : manifest)
+		file << line << '\n';
+
+	SGE_INFOF("Wrote '%s' (%u textures).", manifestPath.c_str(), static_cast<uint32_t>(manifest.size() - 1));
+	return EXIT_SUCCESS;
+}
\ No newline at end of file